@@ -27,6 +27,10 @@
 // eutelescope includes ".h"
 #include "EUTelExceptions.h"
 #include "EUTELESCOPE.h"
+#include "EUTelGenericSparsePixel.h"
+#include "EUTelMatrixDecoder.h"
+#include "EUTelThreadPool.h"
+#include "EUTelHotPixelMap.h"
 
 // marlin includes ".h"
 #include "marlin/EventModifier.h"
@@ -44,6 +48,7 @@
 
 // lcio includes <.h>
 #include <IMPL/TrackerRawDataImpl.h>
+#include <IMPL/TrackerDataImpl.h>
 #include <IMPL/LCCollectionVec.h>
 
 // system includes <>
@@ -52,6 +57,7 @@
 #include <cmath>
 #include <vector>
 #include <list>
+#include <memory>
 
 namespace eutelescope {
 
@@ -65,7 +71,7 @@ namespace eutelescope {
     }
     
     CMSPixelClusteringProcessor();
-    ~CMSPixelClusteringProcessor() { };
+    ~CMSPixelClusteringProcessor();
     CMSPixelClusteringProcessor(const CMSPixelClusteringProcessor&);
 
     void operator=(const CMSPixelClusteringProcessor&);
@@ -78,12 +84,6 @@ namespace eutelescope {
     virtual void check (LCEvent * evt);
     virtual void end();
     
-    //! initialize HotPixelMapVec
-    /*! values from hotpixel DB file are read into a vector of mapped
-     * unique pixel index
-     */
-    void initializeHotPixelMapVec();
-
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 	void bookHistos();
 	void fillHistos(LCEvent * evt);
@@ -107,6 +107,78 @@ namespace eutelescope {
     void initializeGeometry( LCEvent * event ) throw ( marlin::SkipEventException );
     
     protected:
+
+	//! Clustering of the zero suppressed data of one sensor plane
+	/*! The pixels of the plane are stored in a grid covering the
+	 *  bounding box of the hit pixels, so that the neighbours of every
+	 *  pixel are found by looking at the cells within _minXDistance and
+	 *  _minYDistance instead of comparing all pixel pairs. Neighbouring
+	 *  pixels are merged with a union-find structure, which joins the
+	 *  complete clusters of both pixels. The clustering therefore runs
+	 *  in linear time in the number of hit pixels.
+	 *
+	 *  The clusterer only fills its own buffers, so the clusterers of
+	 *  the different planes can run concurrently on the thread pool.
+	 *  The grid and the other work buffers are kept across events.
+	 */
+	class PlaneClusterer : public EUTelThreadPool::Task {
+	public:
+		PlaneClusterer();
+
+		//! Set the input of the next run()
+		/*! @param zsData zero suppressed data of the plane
+		 *  @param hotPixels hot pixels of this plane, or 0 if there
+		 *  are none
+		 */
+		void setInput( IMPL::TrackerDataImpl * zsData, const EUTelHotPixelMap::SensorMap * hotPixels,
+		               int minXDistance, int minYDistance, int minDiagDistance );
+
+		//! Cluster the input plane
+		virtual void run();
+
+		//! Number of clusters found by the last run()
+		unsigned int getNumberOfClusters() const { return _clusterStart.empty() ? 0 : _clusterStart.size() - 1; }
+
+		//! Pixels of the clusters, sorted by cluster
+		/*! The pixels of cluster i are found between
+		 *  getClusterStart(i) and getClusterStart(i+1)
+		 */
+		const std::vector< EUTelGenericSparsePixel > & getClusterPixels() const { return _clusterPixels; }
+
+		//! Offset of the first pixel of a cluster in getClusterPixels()
+		unsigned int getClusterStart( unsigned int iCluster ) const { return _clusterStart[ iCluster ]; }
+
+	private:
+		DISALLOW_COPY_AND_ASSIGN(PlaneClusterer)
+
+		//! Find the representative of the pixel with path halving
+		int findRoot( int iPixel );
+
+		//! Merge the clusters of two pixels, the lower index becomes the root
+		void unite( int aPixel, int bPixel );
+
+		IMPL::TrackerDataImpl * _zsData;
+		const EUTelHotPixelMap::SensorMap * _hotPixels;
+		int _minXDistance;
+		int _minYDistance;
+		int _minDiagDistance;
+
+		//! Hit pixels of the plane after hot pixel removal
+		std::vector< EUTelGenericSparsePixel > _pixels;
+		//! Union-find parent of every pixel
+		std::vector< int > _parent;
+		//! Cluster number of every pixel
+		std::vector< int > _label;
+		//! Pixel index for every cell of the bounding box, -1 if empty
+		std::vector< int > _grid;
+		//! Set while run() has cells of _grid in use, so that a run
+		//! left by an exception is cleaned up by the next one
+		bool _gridInUse;
+
+		std::vector< EUTelGenericSparsePixel > _clusterPixels;
+		std::vector< unsigned int > _clusterStart;
+	};
+
 	void Clustering(LCEvent * evt, LCCollectionVec * pulse);
 	std::string _zsDataCollectionName;
 	std::string _clusterCollectionName;
@@ -124,17 +196,8 @@ namespace eutelescope {
 	int _minCharge;
 	bool _fillHistos;
 	
-    //! Hot Pixel Collection 
-    LCCollectionVec *hotPixelCollectionVec;
-    
-    //! Vector of map arrays, keeps record of hit pixels 
-    /*! The vector elements are sorted by Detector ID
-     *  For each Detector unique ID element a map of pixels is created. 
-     *  Key <int> is the sequential (counter) id of a hit,
-     *  Value <int> - always status value = firing pixel
-     */
-
-    std::vector< std::map< int, int > > _hitIndexMapVec;          
+    //! Hot pixels, shared with the other processors
+    EUTelHotPixelMap * _hotPixelMap;
     
 	unsigned int _noOfDetector;
 	bool _isGeometryReady;
@@ -151,6 +214,18 @@ namespace eutelescope {
 	std::vector<int > _clusterSpectraNxNVector;
 	std::map<std::string , AIDA::IBaseHistogram * > _aidaHistoMap;
 
+	//! Number of threads used to cluster the planes concurrently
+	/*! 1 (default) clusters the planes one after the other, 0 uses one
+	 *  thread per CPU core.
+	 */
+	int _nThreads;
+
+	//! Thread pool used to run the plane clusterers
+	EUTelThreadPool * _threadPool;
+
+	//! One clusterer per plane, reused from event to event
+	std::vector< PlaneClusterer * > _planeClusterers;
+
 
   };
 
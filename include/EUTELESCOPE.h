@@ -81,6 +81,14 @@ namespace eutelescope
 
 	//! Parameter to store the telescope ROOT geometry file
 	static const std::string GEOFILENAME;
+
+	//! Marlin global parameter with the name of the geometry snapshot file
+	/*! Optional: without it the plane layout is always read from GEAR.
+	 */
+	static const std::string GEOSNAPSHOTFILE;
+
+	//! Marlin global parameter switching on the heap monitoring of EUTelProcessorMonitor
+	static const std::string MONITORHEAP;
 	
     //! Parameter key to store/recall the header version number
     static const char * HEADERVERSION;
@@ -3,14 +3,14 @@
 
 #include "marlin/Processor.h"
 
+// eutelescope includes ".h"
+#include "EUTelTupleWriter.h"
+
 // system includes <>
+#include <memory>
 #include <string>
 #include <vector>
 
-#include <TFile.h>
-#include <TTree.h>
-#include <TVectorT.h>
-
 namespace eutelescope {
   class EUTelAPIXTbTrackTuple : public marlin::Processor {
   
@@ -42,6 +42,15 @@ namespace eutelescope {
 
     std::string _path2file;
 
+    //! ROOT compression level of the output file
+    int _compressionLevel;
+    //! Basket size in bytes of the branches
+    int _basketSize;
+    //! Number of events handed over at once to the writer thread
+    int _writeBatchSize;
+    //! Write the n-tuple in a background thread
+    bool _asyncWrite;
+
     std::vector<int> _DUTIDs;
     std::map<int, float> _xSensSize;
     std::map<int, float> _ySensSize;
@@ -55,37 +64,45 @@ namespace eutelescope {
 
     bool _isFirstEvent;
     
-    TFile* _file;
+    //! The n-tuple file, the trees and columns below are indices in it
+    std::auto_ptr<EUTelTupleWriter> _writer;
 
-    TTree* _eutracks;
+    unsigned int _eutracks;
     int _nTrackParams;
-    std::vector<double> *_xPos;
-    std::vector<double> *_yPos;
-    std::vector<double> *_dxdz;
-    std::vector<double> *_dydz;
-    std::vector<int>    *_trackIden;
-    std::vector<int>    *_trackNum;
-    std::vector<double> *_chi2;
-    std::vector<double> *_ndof;    
-
-    TTree* _zstree;
+    unsigned int _nTrackParamsCol;
+    unsigned int _trackEvtCol;
+    unsigned int _xPos;
+    unsigned int _yPos;
+    unsigned int _dxdz;
+    unsigned int _dydz;
+    unsigned int _trackIden;
+    unsigned int _trackNum;
+    unsigned int _chi2;
+    unsigned int _ndof;
+
+    unsigned int _zstree;
     int _nPixHits;
-    std::vector<int> *p_col;
-    std::vector<int> *p_row;
-    std::vector<int> *p_tot;
-    std::vector<int> *p_iden;
-    std::vector<int> *p_lv1;
-    std::vector<int> *p_chip;
-
-    TTree* _euhits;
+    unsigned int _nPixHitsCol;
+    unsigned int _zsEvtCol;
+    unsigned int p_col;
+    unsigned int p_row;
+    unsigned int p_tot;
+    unsigned int p_iden;
+    unsigned int p_lv1;
+
+    unsigned int _euhits;
     int _nHits;
-    std::vector<double> *_hitXPos;
-    std::vector<double> *_hitYPos;
-    std::vector<double> *_hitZPos;
-    std::vector<int>    *_hitSensorId;
+    unsigned int _nHitsCol;
+    unsigned int _hitXPos;
+    unsigned int _hitYPos;
+    unsigned int _hitZPos;
+    unsigned int _hitSensorId;
+
+    unsigned int _versionTree;
+    unsigned int _versionNo;
 
-    TTree* _versionTree;
-    std::vector<double>* _versionNo;
+  private:
+    DISALLOW_COPY_AND_ASSIGN(EUTelAPIXTbTrackTuple)
   };
 
   //! A global instance of the processor.
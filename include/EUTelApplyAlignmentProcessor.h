@@ -16,6 +16,7 @@
 #include "EUTelEventImpl.h"
 #include "EUTelReferenceHit.h"
 #include "EUTelExceptions.h"
+#include "EUTelGeometrySnapshot.h"
 
 
 // marlin includes ".h"
@@ -34,6 +35,7 @@
 // AIDA includes <.h>
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 #include <AIDA/IBaseHistogram.h>
+#include <AIDA/IHistogram2D.h>
 #endif
 
 // ROOT includes
@@ -185,6 +187,12 @@ namespace eutelescope {
      
     void TransformToLocalFrame(TrackerHitImpl* outputHit);
     void revertAlignment(double & x, double & y, double & z) ;
+
+    //! Apply the current alignment collection to all the input hits
+    /*! Used by Direct() and Reverse(), @a reverse selects the
+     *  direction.
+     */
+    void alignHits(bool reverse);
  
     //! Perform Euler rotations
     void _EulerRotation(double* _telPos, double* _gRotation);
@@ -361,6 +369,34 @@ namespace eutelescope {
     //! boolean to mark the first processed event
     bool _fevent;
 
+    //! Alignment of one sensor compiled into an affine transform
+    /*! The hit position relative to the sensor reference point is
+     *  mapped to the output position by transform.local2Master. The
+     *  transform combines the alignment constants of the sensor, the
+     *  correction method and the direction, so no angle or look up
+     *  is evaluated per hit.
+     */
+    struct SensorAlignment {
+      int sensorID;
+      //! Reference point subtracted from the input hit position
+      double reference[3];
+      geo::EUTelPlaneTransform transform;
+#if (defined(USE_AIDA) || defined(MARLIN_USE_AIDA))
+      AIDA::IHistogram2D * histoBeforeAlign;
+      AIDA::IHistogram2D * histoAfterAlign;
+#endif
+    };
+
+    //! Sensor alignments of the current alignment collection
+    /*! Filled when the first hit of a sensor is found and cleared for
+     *  every alignment collection of every event, as the reference
+     *  hits are taken from the event.
+     */
+    std::vector< SensorAlignment > _sensorAlignments;
+
+    //! Position in _sensorAlignments of the given sensor, adding it if needed
+    size_t getSensorAlignment(int sensorID, bool reverse, const std::map< int, int >& lookUpTable);
+
 #if (defined(USE_AIDA) || defined(MARLIN_USE_AIDA))
     //! AIDA histogram map
     /*! Instead of putting several pointers to AIDA histograms as
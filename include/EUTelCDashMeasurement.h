@@ -89,7 +89,7 @@ public:
   // only show output when precompiler flag is set
 #ifdef DO_TESTING
 
-  friend ostream& operator<<( ostream& os, const CDashMeasurement& cdm )
+  friend std::ostream& operator<<( std::ostream& os, const CDashMeasurement& cdm )
   {
 
     // example output:
@@ -104,7 +104,7 @@ public:
   }
 #else
   // no output case (if testing precompiler flag is not set:)
-  friend ostream& operator<<( ostream& os, const CDashMeasurement& )
+  friend std::ostream& operator<<( std::ostream& os, const CDashMeasurement& )
   {
     return os;
   }
@@ -18,13 +18,17 @@
 // AIDA includes <.h>
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 #include <AIDA/IBaseHistogram.h>
+#include <AIDA/IHistogram1D.h>
 #endif
 
 // lcio includes <.h>
+#include <IMPL/TrackerDataImpl.h>
+#include <IMPL/TrackerRawDataImpl.h>
 
 // system includes <>
 #include <string>
 #include <map>
+#include <vector>
 
 namespace eutelescope {
 
@@ -433,6 +437,42 @@ namespace eutelescope {
      */
     bool _isGeometryReady;
 
+    //! Calibration constants of one sensor, ready for the kernels
+    /*! The noise and status frames are turned into a threshold and a
+     *  good pixel mask at every event, since the pedestal and noise
+     *  can be updated in place (see EUTelUpdatePedestalNoiseProcessor)
+     *  or replaced by the conditions handler. The histograms of the
+     *  sensor are looked up only once.
+     *
+     *  @see eutelescope::CalibrationKernel
+     */
+    struct SensorCalibration {
+      SensorCalibration();
+
+      //! Hit rejection threshold, _hitRejectionCut times the noise
+      std::vector< float > threshold;
+
+      //! 1 for good pixels, 0 for the others
+      std::vector< float > goodMask;
+
+      //! Common mode of each row (row wise algorithm only), a float as it always was
+      std::vector< float > rowCommonMode;
+
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+      AIDA::IHistogram1D * rawDataDistHisto;
+      AIDA::IHistogram1D * dataDistHisto;
+      AIDA::IHistogram1D * commonModeDistHisto;
+      AIDA::IHistogram1D * skippedPixelDistHisto;
+#endif
+    };
+
+    //! Get the calibration of a sensor, filled from the current conditions
+    SensorCalibration & getSensorCalibration( int sensorID, const IMPL::TrackerDataImpl * noise,
+                                              const IMPL::TrackerRawDataImpl * status );
+
+    //! Calibration of each sensor, the key is the sensor ID
+    std::map< int, SensorCalibration > _sensorCalibrationMap;
+
   };
 
   //! A global instance of the processor
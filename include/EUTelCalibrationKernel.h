@@ -0,0 +1,89 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef EUTELCALIBRATIONKERNEL_H
+#define EUTELCALIBRATIONKERNEL_H 1
+
+// system includes <>
+#include <cstddef>
+
+namespace eutelescope {
+
+  //! Frame calibration kernels
+  /*! The calibration of non zero suppressed frames (pedestal
+   *  subtraction, common mode and bad pixel masking) touches every
+   *  pixel of every frame. These routines work on whole frames, or on
+   *  whole rows, stored as plain arrays, so that the same loops can be
+   *  used by all the processors calibrating NZS data.
+   *
+   *  On x86 they use SSE2, eight pixels at a time, with a plain loop
+   *  for the remaining pixels and for the other architectures. The
+   *  per-pixel results are identical to the scalar arithmetic, only
+   *  the order of the additions in the common mode sum changes.
+   *
+   *  A typical full frame calibration:
+   *  @code
+   *  CalibrationKernel::subtractPedestal( raw, pedestal, data, nPixel );
+   *  CalibrationKernel::Sum sum = CalibrationKernel::maskedSum( data, threshold, goodMask, nPixel );
+   *  if ( sum.nGood != 0 ) CalibrationKernel::subtractCommonMode( data, nPixel, sum.sum / sum.nGood );
+   *  @endcode
+   *
+   *  and a zero suppression of a raw frame:
+   *  @code
+   *  size_t nHit = CalibrationKernel::sparsify( raw, pedestal, threshold, nPixel, index, signal );
+   *  @endcode
+   */
+  namespace CalibrationKernel {
+
+    //! Result of a masked reduction
+    struct Sum {
+      //! Sum of the good pixels below threshold
+      double sum;
+      //! Number of good pixels below threshold
+      int nGood;
+      //! Number of pixels above threshold, good or not
+      int nHit;
+    };
+
+    //! data[i] = raw[i] - pedestal[i]
+    void subtractPedestal( const short * raw, const float * pedestal, float * data, size_t n );
+
+    //! Sum of the pixels usable for the common mode
+    /*! A pixel is a hit if data[i] > threshold[i]. Pixels that are not
+     *  hits and have goodMask[i] == 1 enter the sum; goodMask has to
+     *  be 1.f for good pixels and 0.f for the bad ones.
+     */
+    Sum maskedSum( const float * data, const float * threshold, const float * goodMask, size_t n );
+
+    //! data[i] = data[i] - commonMode, computed in double precision
+    void subtractCommonMode( float * data, size_t n, double commonMode );
+
+    //! data[i] = data[i] - commonMode, computed in single precision
+    /*! As the row wise common mode, which is kept as a float.
+     */
+    void subtractCommonMode( float * data, size_t n, float commonMode );
+
+    //! Threshold zero suppression of a raw frame
+    /*! Computes raw[i] - pedestal[i] and keeps the pixels for which it
+     *  is above threshold[i]. Index and signal of the surviving pixels
+     *  are packed, in increasing index order, at the beginning of @a
+     *  index and @a signal, that have to be large enough for n
+     *  entries. Bad pixels are skipped giving them an infinite
+     *  threshold.
+     *
+     *  @return The number of pixels above threshold
+     */
+    size_t sparsify( const short * raw, const float * pedestal, const float * threshold, size_t n,
+                     int * index, float * signal );
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef EUTELCLUSTERSUMMARY_H
+#define EUTELCLUSTERSUMMARY_H 1
+
+// eutelescope includes ".h"
+#include "EUTELESCOPE.h"
+
+// lcio includes <.h>
+#include <lcio.h>
+#include <EVENT/LCEvent.h>
+#include <EVENT/TrackerData.h>
+#include <IMPL/LCGenericObjectImpl.h>
+
+// system includes <>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Per event summary of the clusters of one pulse collection
+  /*! Several processors (correlator, eta calculation, hit maker...)
+   *  need the same handful of numbers for every cluster: the sensor,
+   *  the centre of gravity, the total and seed charge, the size, the
+   *  quality and the pixel span. Getting them means instantiating the
+   *  right EUTelVirtualCluster implementation for the cluster type and
+   *  walking through the pixel payload, which used to be done again
+   *  in every processor, and for every pair of clusters in the
+   *  correlator.
+   *
+   *  This object holds these numbers for all the clusters of one
+   *  TrackerPulse collection, in the same order as the collection. It
+   *  is computed the first time a processor asks for it in an event
+   *  and stored in the event as a transient collection named after
+   *  the pulse collection plus SUFFIX, so all the following
+   *  processors of the same event get it for free:
+   *
+   *  @code
+   *  const EUTelClusterSummary & summary = EUTelClusterSummary::get( event, _clusterCollectionName );
+   *  for ( size_t i = 0; i < summary.size(); ++i ) {
+   *    const EUTelClusterSummary::Entry & cluster = summary[i];
+   *    if ( !cluster.valid ) continue;
+   *    ...
+   *  }
+   *  @endcode
+   *
+   *  Clusters of a type without a EUTelVirtualCluster implementation
+   *  (e.g. kEUTelGenericSparseClusterImpl) are kept with valid set to
+   *  false and only sensorID and type filled.
+   */
+  class EUTelClusterSummary : public IMPL::LCGenericObjectImpl {
+
+  public:
+
+    //! Summary of one cluster
+    struct Entry {
+      //! False if the cluster type is not supported
+      bool valid;
+      int sensorID;
+      ClusterType type;
+      //! Number of pixels (sparse) or cells of the fixed frame
+      int size;
+      int quality;
+      int xSeed, ySeed;
+      //! Pixel span, inclusive
+      int xMin, xMax, yMin, yMax;
+      //! Centre of gravity in pixel units
+      float xCoG, yCoG;
+      float totalCharge;
+      float seedCharge;
+      //! The cluster data the entry was computed from
+      const EVENT::TrackerData * data;
+    };
+
+    //! Suffix of the transient collection holding the summary
+    static const std::string SUFFIX;
+
+    //! Summary of a pulse collection in the given event
+    /*! Computed and attached to the event on the first call for a
+     *  given collection, simply retrieved afterwards. It is computed
+     *  again if the number of pulses has changed since, e.g. when a
+     *  clustering processor has appended its clusters to the
+     *  collection: the references to entries taken before are then
+     *  invalid.
+     *
+     *  @throw lcio::DataNotAvailableException if the pulse
+     *  collection is not in the event.
+     */
+    static const EUTelClusterSummary & get( EVENT::LCEvent * event, const std::string & pulseCollectionName );
+
+    //! Number of clusters
+    size_t size() const { return _entries.size(); }
+
+    //! Summary of the i-th cluster of the pulse collection
+    const Entry & operator[]( size_t i ) const { return _entries[i]; }
+
+    //! Summary of the cluster made of the given data, 0 if not found
+    const Entry * find( const EVENT::TrackerData * data ) const;
+
+    //! Destructor
+    virtual ~EUTelClusterSummary() { }
+
+  private:
+    DISALLOW_COPY_AND_ASSIGN(EUTelClusterSummary)
+
+    //! Computes the summary of all the pulses of a collection
+    explicit EUTelClusterSummary( EVENT::LCCollection * pulseCollection );
+
+    //! Fills the entries, one per pulse of the collection
+    void summarize( EVENT::LCCollection * pulseCollection );
+
+    std::vector< Entry > _entries;
+    std::map< const EVENT::TrackerData *, size_t > _index;
+  };
+
+}
+
+#endif
@@ -17,6 +17,8 @@
 #include "EUTelExceptions.h"
 #include "EUTELESCOPE.h"
 #include "EUTelGeometryTelescopeGeoDescription.h"
+#include "EUTelThreadPool.h"
+#include "EUTelSparseClusterFinder.h"
 
 // marlin includes ".h"
 #include "marlin/EventModifier.h"
@@ -134,6 +136,11 @@ namespace eutelescope {
    *  @param HistoInfoFileName This is the name of the XML file
    *  containing the histogram booking information.
    *
+   *  @param NumberOfThreads Number of threads used by the
+   *  EUTELESCOPE::SPARSECLUSTER algorithms to cluster the sensors of
+   *  an event concurrently. 1 (default) means serial processing, 0
+   *  one thread per CPU core. The output does not depend on it.
+   *
    *  @since Since version v00-00-09, this processor requires GEAR to
    *  be initialized because the geometry information are no more
    *  taken from the input file Run Header but they are gathered from
@@ -300,6 +307,9 @@ namespace eutelescope {
     //! Default constructor
     EUTelClusteringProcessor ();
 
+    //! Default destructor
+    virtual ~EUTelClusteringProcessor ();
+
     //! Called at the job beginning.
     /*! This is executed only once in the whole execution. It prints
      *  out the processor parameters and reset all needed data
@@ -893,6 +903,18 @@ namespace eutelescope {
     std::vector< std::map< int, int > > _hitIndexMapVec;
 
     int ID;
+
+    //! Clustering of the hit pixels of one sensor
+    typedef EUTelSparseClusterFinder< EUTelGenericSparsePixel, EUTelPixelDistanceCut > SensorClusterFinder;
+
+    //! Number of threads used to cluster the sensors concurrently
+    int _nThreads;
+
+    //! Thread pool running the cluster finders
+    EUTelThreadPool * _threadPool;
+
+    //! One cluster finder per sensor, reused from event to event
+    std::vector< SensorClusterFinder * > _clusterFinders;
   };
 
   //! A global instance of the processor
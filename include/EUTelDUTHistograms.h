@@ -257,6 +257,22 @@ protected:
  
     std::vector<float > _DUTalign;
 
+    //! Measured hits of the event sorted by their matching grid cell
+    /*! Each entry is the (x, y) cell of a hit and its index in
+     *  _measuredX. The cells are _distMax wide, so only the hits of
+     *  the few cells around a fitted position can be matched to it.
+     */
+    std::vector< std::pair< std::pair< int, int >, int > > _hitGrid;
+
+    //! Measured hits of the event already matched to a track
+    std::vector< bool > _hitMatched;
+
+    //! Fills _hitGrid with the measured hits of the event
+    void fillHitGrid();
+
+    //! Matching grid cell of a coordinate
+    int getGridCell( double position ) const;
+
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
     //! AIDA histogram maps
@@ -284,6 +300,40 @@ protected:
     std::map< projAxis, AIDA::IBaseHistogram*> _NoiseHistos;
     std::map< projAxis, AIDA::IBaseHistogram*> _BgShiftHistos;
 
+    //! The X, Y and XY histograms of one quantity, already cast
+    /*! The maps above keep the histograms as IBaseHistogram; the ones
+     *  filled for every fit or hit are cast once after booking.
+     */
+    template< class Histo1D, class Histo2D >
+    struct HistoSet {
+      Histo1D * x;
+      Histo1D * y;
+      Histo2D * xy;
+      HistoSet() : x(NULL), y(NULL), xy(NULL) { }
+      void set( const std::map< projAxis, AIDA::IBaseHistogram* >& histos ) {
+        x  = dynamic_cast< Histo1D* >( histos.at(projX) );
+        y  = dynamic_cast< Histo1D* >( histos.at(projY) );
+        xy = dynamic_cast< Histo2D* >( histos.at(projXY) );
+      }
+    };
+    typedef HistoSet< AIDA::IHistogram1D, AIDA::IHistogram2D > PositionHistoSet;
+    typedef HistoSet< AIDA::IProfile1D, AIDA::IProfile2D > ProfileHistoSet;
+
+    PositionHistoSet _ClusterSizeHistoSet[FullDetector+1];
+    PositionHistoSet _ShiftHistoSet[FullDetector+1][HistoMaxClusterSize+1];
+    PositionHistoSet _MeasuredHistoSet;
+    PositionHistoSet _MatchedHistoSet;
+    PositionHistoSet _UnMatchedHistoSet;
+    PositionHistoSet _FittedHistoSet;
+    ProfileHistoSet  _EfficiencyHistoSet;
+    ProfileHistoSet  _NoiseHistoSet;
+
+    //! Cast the histograms of the maps into the HistoSets
+    void setHistoSets();
+
+    //! Sub matrix of a hit as an index of the HistoSet arrays
+    detMatrix getHitSubMatrix( int ihit ) const;
+
     AIDA::IProfile1D* _ShiftXvsYHisto;
     AIDA::IProfile1D* _ShiftYvsXHisto;
     AIDA::IProfile1D* _ShiftXvsXHisto;
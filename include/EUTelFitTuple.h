@@ -13,6 +13,9 @@
 
 #include "marlin/Processor.h"
 
+// eutelescope includes ".h"
+#include "EUTelTupleWriter.h"
+
 // gear includes <.h>
 #include <gear/SiPlanesParameters.h>
 #include <gear/SiPlanesLayerLayout.h>
@@ -27,6 +30,7 @@
 #endif
 
 // system includes <>
+#include <memory>
 #include <string>
 #include <vector>
 #include <map>
@@ -72,6 +76,21 @@ namespace eutelescope {
    * \param MissingValue Value (double) which is used for missing
    *        measurements.
    *
+   * \param OutputPath If not empty, the n-tuple is written as a
+   *        TTree to this ROOT file by a EUTelTupleWriter instead of
+   *        being booked as an AIDA tuple.
+   *
+   * \param CompressionLevel ROOT compression level of the OutputPath
+   *        file.
+   *
+   * \param BasketSize Basket size in bytes of the OutputPath branches.
+   *
+   * \param WriteBatchSize Number of events handed over at once to the
+   *        n-tuple writer.
+   *
+   * \param AsyncWrite Compress and write the OutputPath file in a
+   *        background thread.
+   *
 
    * \author A.F.Zarnecki, University of Warsaw
    * @version $Id$
@@ -227,6 +246,37 @@ namespace eutelescope {
 
 #endif
 
+    //! Fill one column of the current row, AIDA or ROOT n-tuple
+    void fillColumn( int icol, int value );
+    void fillColumn( int icol, long int value );
+    void fillColumn( int icol, float value );
+    void fillColumn( int icol, double value );
+
+    //! ROOT output file, the AIDA tuple is used if empty
+    std::string _outputPath;
+
+    //! ROOT compression level of the output file
+    int _compressionLevel;
+
+    //! Basket size in bytes of the branches
+    int _basketSize;
+
+    //! Number of events handed over at once to the writer
+    int _writeBatchSize;
+
+    //! Write the ROOT n-tuple in a background thread
+    bool _asyncWrite;
+
+    //! Writer of the ROOT n-tuple
+    std::auto_ptr<EUTelTupleWriter> _writer;
+
+    //! Tree of the ROOT n-tuple
+    unsigned int _fitTree;
+
+    //! Writer columns, in the order of the AIDA tuple columns
+    std::vector<unsigned int> _fitColumns;
+
+
   } ;
 
 
@@ -17,6 +17,7 @@
 #include "EUTelTrack.h"
 #include "EUTelState.h"
 #include "EUTelMillepede.h"
+#include "EUTelGBLWorkspace.h"
 
 // EVENT includes
 #include <IMPL/TrackerHitImpl.h>
@@ -61,7 +62,7 @@ namespace eutelescope {
 			//SET
 			void setMomentsAndStartEndScattering(EUTelState& state);
 			void setInformationForGBLPointList(EUTelTrack& track, std::vector< gbl::GblPoint >& pointList);
-			void setMeasurementGBL(gbl::GblPoint& point, const double *hitPos, double statePos[3], double combinedCov[4], TMatrixD projection);
+			void setMeasurementGBL(gbl::GblPoint& point, const double *hitPos, double statePos[3], double combinedCov[4], const TMatrixD& projection);
 			void getKinkInformationToTrack(gbl::GblTrajectory* traj, std::vector< gbl::GblPoint >& pointList,EUTelTrack &track);
             TMatrixD getFullJacobian(TVector3 momStart, TVector3 momEnd, int locationStart, int locationEnd, double distance, double min );
 			void setPointVec( std::vector< gbl::GblPoint >& pointList, gbl::GblPoint& point);
@@ -69,9 +70,9 @@ namespace eutelescope {
 			void setPairMeasurementStateAndPointLabelVec(std::vector< gbl::GblPoint >& pointList);
 			void setAlignmentToMeasurementJacobian(std::vector< gbl::GblPoint >& pointList);
 			void setScattererGBL(gbl::GblPoint& point,EUTelState & state );
-			void setScattererGBL(gbl::GblPoint& point,EUTelState & state,  float variance, TVectorD scat );
+			void setScattererGBL(gbl::GblPoint& point,EUTelState & state,  float variance, const TVectorD& scat );
 			void setLocalDerivativesToPoint(gbl::GblPoint& point, float distanceFromKinkTargetToNextPlane );
-			void setPointListWithNewScatterers(std::vector< gbl::GblPoint >& pointList,EUTelState & state, std::vector<float> variance );
+			void setPointListWithNewScatterers(std::vector< gbl::GblPoint >& pointList,EUTelState & state, const float (&variance)[2] );
 			void setMeasurementCov(EUTelState& state);
 			inline void setAlignmentMode( int number) {
 				this->_alignmentMode = number;
@@ -98,11 +99,15 @@ namespace eutelescope {
 			void setMEstimatorType( const std::string& _mEstimatorType );
 			//GET
 			float getPositionOfSecondScatter(float start, float end);
-			gbl::GblPoint getLabelToPoint(std::vector<gbl::GblPoint> & pointList, unsigned  int label);
-			void getResidualOfTrackandHits(gbl::GblTrajectory* traj, std::vector< gbl::GblPoint > pointList, EUTelTrack& track, std::map< int, std::map< float, float > > & SensorResidual, std::map< int, std::map< float, float > >& sensorResidualError, std::map< int, int> & planes);
+			const gbl::GblPoint& getLabelToPoint(const std::vector<gbl::GblPoint> & pointList, unsigned  int label);
+			void getResidualOfTrackandHits(gbl::GblTrajectory* traj, const std::vector< gbl::GblPoint >& pointList, EUTelTrack& track, std::map< int, std::map< float, float > > & SensorResidual, std::map< int, std::map< float, float > >& sensorResidualError, std::map< int, int> & planes);
 			inline int getAlignmentMode() const {
 				return _alignmentMode;
 			}
+			//! Point list and trajectory to be reused for each track fitted
+			inline EUTelGBLWorkspace& getWorkspace() {
+				return _workspace;
+			}
 			inline double getBeamEnergy() const {
 				return _eBeam;
 			}
@@ -125,11 +130,11 @@ namespace eutelescope {
 			void testDistanceBetweenPoints(double* position1,double* position2);
 			//COMPUTE
 			void computeTrajectoryAndFit(gbl::GblTrajectory* traj, double* chi2, int* ndf, int & ierr);
-			std::vector<float> computeVarianceForEachScatterer(EUTelState & state);
+			void computeVarianceForEachScatterer(const EUTelState & state, float (&variance)[2]);
 			//OTHER FUNCTIONS
 			void resetPerTrack();
 			void findScattersZPositionBetweenTwoStates();
-			TMatrixD findScattersJacobians(EUTelState state, EUTelState nextTrack);
+			TMatrixD findScattersJacobians(const EUTelState& state, const EUTelState& nextTrack);
 			void updateTrackFromGBLTrajectory(gbl::GblTrajectory* traj, EUTelTrack& track, std::map<int,std::vector<double> >& mapSensorIDToCorrectionVec );
 			void prepareLCIOTrack( gbl::GblTrajectory*, std::vector<const IMPL::TrackImpl*>::const_iterator&, double, int); 
 			void prepareMilleOut( gbl::GblTrajectory* );
@@ -181,6 +186,7 @@ namespace eutelescope {
 			unsigned int _counter_num_pointer;
 			bool _kinkAngleEstimation; //This used to determine if the correction matrix from the GBL fit is 5 or 7 elements long. 
 			EUTelMillepede* _MilleInterface;
+			EUTelGBLWorkspace _workspace;
         
     };
 }
@@ -0,0 +1,94 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifdef USE_GBL
+
+#ifndef EUTELGBLWORKSPACE_H
+#define	EUTELGBLWORKSPACE_H
+
+// eutelescope includes ".h"
+#include "EUTelUtility.h"
+
+// ROOT
+#if defined(USE_ROOT) || defined(MARLIN_USE_ROOT)
+#include "TMatrixD.h"
+#include "TVector3.h"
+#else
+#error *** You need ROOT to compile this code.  ***
+#endif
+
+// GBL
+#include "include/GblPoint.h"
+#include "include/GblTrajectory.h"
+
+// system includes <>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace eutelescope {
+
+	//! Scratch space of a GBL fitter, reused from track to track
+	/*! Holds the GBL point list and the trajectory of the track being
+	 *  fitted. The point list keeps its capacity from track to track and
+	 *  the trajectory is released when the next one is built. The points
+	 *  and the trajectory themselves are built again for every track:
+	 *  GBL has no way to reset a trajectory.
+	 *
+	 *  It also caches the geometry the Jacobians need: per plane, the
+	 *  rotation matrix and the global to local vector transformation,
+	 *  and the magnetic field. The Jacobians themselves depend on the
+	 *  direction of each track and are computed per track from these.
+	 *  The caches are cleared when the TGeo description is built again
+	 *  (see EUTelGeometryTelescopeGeoDescription::getGeoVersion).
+	 *
+	 *  A workspace must not be shared between threads; each fitter
+	 *  owns its own.
+	 */
+	class EUTelGBLWorkspace {
+
+		private:
+			DISALLOW_COPY_AND_ASSIGN(EUTelGBLWorkspace)
+
+		public:
+			EUTelGBLWorkspace();
+			~EUTelGBLWorkspace();
+
+			//! The point list for a new track, emptied
+			std::vector< gbl::GblPoint >& newPointList();
+			//! Build the trajectory of the current point list
+			/*! The previous trajectory is deleted; the returned one
+			 *  stays valid until the next call.
+			 */
+			gbl::GblTrajectory* newTrajectory(bool curved);
+			//! Rotation matrix of the plane, as geo::gGeometry().getRotMatrix
+			const TMatrixD& getRotMatrix(int location);
+			//! Global to local vector transformation, as geo::gGeometry().master2LocalVec
+			TVector3 transVecGlobalToLocal(const TVector3& input, int location);
+			//! Magnetic field, as taken by EUTelNav::getPropagationJacobianGlobalToGlobal
+			const TVector3& getMagneticField();
+			//! Forget the cached geometry, done when the geometry version changes
+			void clearGeometry();
+
+		private:
+			//! Clear the caches if the TGeo description was built again since they were filled
+			void checkGeometry();
+
+			std::vector< gbl::GblPoint > _pointList;
+			std::auto_ptr< gbl::GblTrajectory > _trajectory;
+			std::map< int, TMatrixD > _rotMatrix;
+			std::map< int, TMatrixD > _master2LocalVec;
+			TVector3 _magneticField;
+			bool _hasMagneticField;
+			//! Geometry version the caches were filled with
+			unsigned int _geoVersion;
+	};
+}
+#endif	/* EUTELGBLWORKSPACE_H */
+#endif
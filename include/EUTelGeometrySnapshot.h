@@ -0,0 +1,146 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELGEOMETRYSNAPSHOT_H
+#define EUTELGEOMETRYSNAPSHOT_H 1
+
+// system includes <>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace eutelescope {
+namespace geo {
+
+struct EUTelPlane
+{
+	/**Spatial location*/
+	double xPos, yPos, zPos;
+	/**Spatial location errors/uncertainties*/
+	//double xPosErr, yPosErr, zPosErr;
+	/**Euler rotations*/
+	double alpha, beta, gamma;
+	/**Euler uncertainties*/
+	//double alphaErr, betaErr, gammaErr;
+	/**Pixel geometry name*/
+	std::string pixGeoName;
+	/**2D flip entries*/
+	double r1, r2, r3, r4;
+	/**Size of plane*/
+	double xSize, ySize, zSize;
+	/**Pixel counts*/
+	int xPixelNo, yPixelNo;
+	/**Pixel pitch*/
+	double xPitch, yPitch;
+	/**Radiation length TODO: UNIT*/
+	double radLength;
+	/**Resolution of sensor*/
+	double xRes, yRes;
+};
+
+/** Local to global transformation of one plane
+ * Same convention as the TGeoCombiTrans built for the plane in
+ * EUTelGeometryTelescopeGeoDescription::translateSiPlane2TGeo:
+ * global = rotation * local + translation, rotation stored row-major.
+ */
+struct EUTelPlaneTransform
+{
+	double rotation[9];
+	double translation[3];
+
+	void local2Master( const double local[], double master[] ) const;
+	void master2Local( const double master[], double local[] ) const;
+	void local2MasterVec( const double local[], double master[] ) const;
+	void master2LocalVec( const double master[], double local[] ) const;
+};
+
+/** @class EUTelGeometrySnapshot
+ * Everything the telescope geometry needs from GEAR, in a form which
+ * can be written to and read back from a small binary file: the plane
+ * parameters (positions, rotations, pixel counts and pitches, material),
+ * the local to global transformations, the sensor ID list and the
+ * ordering along the beam axis.
+ *
+ * A snapshot is identified only by the hash of the GEAR file content it
+ * was made from: an aligned GEAR file differs from the nominal one and
+ * gets its own snapshot, but alignment applied later through the plane
+ * setters is not part of the file. The stored hash of the plane
+ * positions and rotations is only a consistency check of the file.
+ *
+ * Reading it back replaces the parsing of the plane layout and nothing
+ * else: initializeTGeoDescription() still builds the TGeo volumes and
+ * loads the pixel geometry libraries, and there are no pixel level
+ * tables in the snapshot. Only code running before the TGeo geometry
+ * is built takes its plane transformations from here.
+ */
+class EUTelGeometrySnapshot
+{
+  public:
+	EUTelGeometrySnapshot();
+
+	/** Forget all content */
+	void clear();
+
+	/** Fill the snapshot, the transformations are computed from the planes */
+	void set( uint64_t gearHash, int layoutID, size_t nPlanes,
+		  const std::vector<int>& sensorIDs,
+		  const std::map<int,int>& sensorIDVecMap,
+		  const std::map<int,int>& zOrderToID,
+		  const std::map<int,EUTelPlane>& planes );
+
+	/** Write the snapshot to a file, returns false on failure */
+	bool write( const std::string& filename ) const;
+
+	/** Read a snapshot from a file, returns false (and leaves the
+	 *  snapshot empty) if the file is missing or not valid */
+	bool read( const std::string& filename );
+
+	/** Has the snapshot been filled or read? */
+	bool isValid() const { return _valid; }
+
+	uint64_t gearHash() const { return _gearHash; }
+	uint64_t alignmentHash() const { return _alignmentHash; }
+	int layoutID() const { return _layoutID; }
+	size_t nPlanes() const { return _nPlanes; }
+	const std::vector<int>& sensorIDs() const { return _sensorIDs; }
+	const std::map<int,int>& sensorIDVecMap() const { return _sensorIDVecMap; }
+	const std::map<int,int>& zOrderToID() const { return _zOrderToID; }
+	const std::map<int,EUTelPlane>& planes() const { return _planes; }
+
+	/** Transformation of the given plane, throws if unknown */
+	const EUTelPlaneTransform& transform( int sensorID ) const;
+
+	/** Material budget of the given plane: thickness over radiation length */
+	double materialBudget( int sensorID ) const;
+
+	/** FNV-1a hash of the content of a file, 0 if it cannot be read */
+	static uint64_t hashFile( const std::string& filename );
+
+	/** Hash of the positions, rotations and flips of the planes */
+	static uint64_t hashAlignment( const std::map<int,EUTelPlane>& planes );
+
+	/** Compute the local to global transformation of a plane */
+	static void computeTransform( const EUTelPlane& plane, EUTelPlaneTransform& transform );
+
+  private:
+	bool _valid;
+	uint64_t _gearHash;
+	uint64_t _alignmentHash;
+	int _layoutID;
+	size_t _nPlanes;
+	std::vector<int> _sensorIDs;
+	std::map<int,int> _sensorIDVecMap;
+	std::map<int,int> _zOrderToID;
+	std::map<int,EUTelPlane> _planes;
+	std::map<int,EUTelPlaneTransform> _transforms;
+};
+
+} // namespace geo
+} // namespace eutelescope
+#endif // EUTELGEOMETRYSNAPSHOT_H
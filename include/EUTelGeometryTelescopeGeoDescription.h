@@ -23,6 +23,7 @@
 // EUTELESCOPE
 #include "EUTelUtility.h"
 #include "EUTelGenericPixGeoMgr.h"
+#include "EUTelGeometrySnapshot.h"
 
 
 // ROOT
@@ -53,32 +54,6 @@
 namespace eutelescope {
 namespace geo{
 
-struct EUTelPlane
-{
-	/**Spatial location*/
-	double xPos, yPos, zPos;
-	/**Spatial location errors/uncertainties*/
-	//double xPosErr, yPosErr, zPosErr;
-	/**Euler rotations*/
-	double alpha, beta, gamma;
-	/**Euler uncertainties*/
-	//double alphaErr, betaErr, gammaErr;
-	/**Pixel geometry name*/
-	std::string pixGeoName;
-	/**2D flip entries*/
-	double r1, r2, r3, r4;
-	/**Size of plane*/
-	double xSize, ySize, zSize;
-	/**Pixel counts*/
-	int xPixelNo, yPixelNo;
-	/**Pixel pitch*/
-	double xPitch, yPitch;
-	/**Radiation length TODO: UNIT*/
-	double radLength;
-	/**Resolution of sensor*/
-	double xRes, yRes;
-};
-
 // Iterate over registered GEAR objects and construct their TGeo representation
 const Double_t PI     = 3.141592653589793;
 const Double_t DEG    = 180./PI; 
@@ -172,6 +147,15 @@ class EUTelGeometryTelescopeGeoDescription
 	/** */
 	static unsigned _counter;
 
+	/** Plane layout and transformations in serializable form */
+	EUTelGeometrySnapshot _snapshot;
+
+	/** Set if plane parameters changed after _snapshot was filled */
+	bool _snapshotOutdated;
+
+	/** Number of times the TGeo description was built or imported */
+	unsigned int _geoVersion;
+
   public:
 	/** Retrieves the instanstance of geometry.
 	 * Performs lazy intialization if necessary.
@@ -204,31 +188,31 @@ class EUTelGeometryTelescopeGeoDescription
 
   /** set methods */
 	/** set X position  */
-	void setPlaneXPosition(int sensorID, double value){ _planeSetup[sensorID].xPos = value; };
+	void setPlaneXPosition(int sensorID, double value){ _planeSetup[sensorID].xPos = value; _snapshotOutdated = true; };
 
 	/** set Y position  */
-	void setPlaneYPosition(int sensorID, double value){ _planeSetup[sensorID].yPos = value; };
+	void setPlaneYPosition(int sensorID, double value){ _planeSetup[sensorID].yPos = value; _snapshotOutdated = true; };
 
 	/** set Z position  */
-	void setPlaneZPosition(int sensorID, double value){ _planeSetup[sensorID].zPos = value; };
+	void setPlaneZPosition(int sensorID, double value){ _planeSetup[sensorID].zPos = value; _snapshotOutdated = true; };
 
 	/** set X rotation  */
-	void setPlaneXRotation(int sensorID, double value){ _planeSetup[sensorID].alpha = value; };
+	void setPlaneXRotation(int sensorID, double value){ _planeSetup[sensorID].alpha = value; _snapshotOutdated = true; };
 
 	/** set Y rotation  */
-	void setPlaneYRotation(int sensorID, double value){ _planeSetup[sensorID].beta = value; };
+	void setPlaneYRotation(int sensorID, double value){ _planeSetup[sensorID].beta = value; _snapshotOutdated = true; };
 
 	/** set Z rotation  */
-	void setPlaneZRotation(int sensorID, double value){ _planeSetup[sensorID].gamma = value; };
+	void setPlaneZRotation(int sensorID, double value){ _planeSetup[sensorID].gamma = value; _snapshotOutdated = true; };
 
 	/** set X rotation  */
-	void setPlaneXRotationRadians(int sensorID, double value /* in Radians */){ _planeSetup[sensorID].alpha = value*DEG; };
+	void setPlaneXRotationRadians(int sensorID, double value /* in Radians */){ _planeSetup[sensorID].alpha = value*DEG; _snapshotOutdated = true; };
 
 	/** set Y rotation  */
-	void setPlaneYRotationRadians(int sensorID, double value /* in Radians */){ _planeSetup[sensorID].beta = value*DEG; };
+	void setPlaneYRotationRadians(int sensorID, double value /* in Radians */){ _planeSetup[sensorID].beta = value*DEG; _snapshotOutdated = true; };
 
 	/** set Z rotation  */
-	void setPlaneZRotationRadians(int sensorID, double value /* in Radians */){ _planeSetup[sensorID].gamma = value*DEG; };
+	void setPlaneZRotationRadians(int sensorID, double value /* in Radians */){ _planeSetup[sensorID].gamma = value*DEG; _snapshotOutdated = true; };
 	//GETTER
 	/** */ 
 	float siPlaneRotation1(int sensorID){ return _planeSetup.at(sensorID).r1; };
@@ -302,6 +286,9 @@ class EUTelGeometryTelescopeGeoDescription
 	/** Sensor medium radiation length */
 	double siPlaneRadLength(int sensorID){ return _planeSetup.at(sensorID).radLength; };
 
+	/** Sensor material budget, thickness over radiation length */
+	double siPlaneMaterialBudget(int sensorID){ return getSnapshot().materialBudget(sensorID); };
+
 	/** Name of pixel geometry library */
 	std::string geoLibName(int sensorID){ return _planeSetup.at(sensorID).pixGeoName; };
 
@@ -349,6 +336,20 @@ class EUTelGeometryTelescopeGeoDescription
 
 	void writeGEARFile(std::string filename);
 
+	/** Snapshot of the current plane layout, see EUTelGeometrySnapshot
+	 * Refreshed if plane parameters were changed with the setters.
+	 */
+	const EUTelGeometrySnapshot& getSnapshot();
+
+	/** Write the geometry snapshot for the given GEAR file to a file */
+	bool writeSnapshot( const std::string& snapshotFileName, const std::string& gearFileName );
+
+	/** Take the plane layout from a snapshot file instead of GEAR
+	 * The snapshot is only used if it was made from a GEAR file with
+	 * the same content as gearFileName. Returns false otherwise.
+	 */
+	bool readSnapshot( const std::string& snapshotFileName, const std::string& gearFileName );
+
 	virtual ~EUTelGeometryTelescopeGeoDescription();
 	
 	/** Initialize TGeo geometry 
@@ -362,6 +363,11 @@ class EUTelGeometryTelescopeGeoDescription
 
 	void initializeTGeoDescription( std::string& geomName, bool dumpRoot );
 
+	/** Changes each time the TGeo description is built or imported, so
+	 * that caches of the TGeo transformations know when to be refilled
+	 */
+	unsigned int getGeoVersion() const { return _geoVersion; };
+
 	// Geometry operations
     float findRad( const double globalPosStart[], const double globalPosFinish[], std::map< const int, double> &sensors, 	std::map< const int, double> &air );
 	int getSensorID(float const globalPos[] ) const;
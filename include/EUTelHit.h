@@ -18,7 +18,7 @@ namespace eutelescope {
 			EUTelHit(EUTelHit* hit);
             void setPosition(const double * position);
             void setID(int id);
-            void setTrackFromLCIOVec(std::vector<double> input);
+            void setTrackFromLCIOVec(const std::vector<double>& input);
 
             //get
             int getID() const;
@@ -26,7 +26,9 @@ namespace eutelescope {
 
 		    double _position[3];	
             int _id; //This is used to keep a track of all the hits for track removal.
-            std::vector<double> getLCIOOutput(); 
+            std::vector<double> getLCIOOutput() const;
+            //! Fill output with the LCIO representation, reusing its storage
+            void getLCIOOutput(std::vector<double>& output) const;
   	private:
 	};
 
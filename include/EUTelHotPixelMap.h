@@ -0,0 +1,148 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef EUTELHOTPIXELMAP_H
+#define EUTELHOTPIXELMAP_H 1
+
+// eutelescope includes ".h"
+#include "EUTELESCOPE.h"
+
+// lcio includes <.h>
+#include <lcio.h>
+#include <EVENT/LCEvent.h>
+#include <IMPL/TrackerDataImpl.h>
+#include <IMPL/TrackerHitImpl.h>
+
+// system includes <>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Hot pixel database shared by all the processors of a job
+  /*! The hot pixel DB is a collection of sparse pixel TrackerData,
+   *  one per sensor, usually loaded by the conditions processor.
+   *  Several processors (pre-alignment, Mille, hit filter, CMS pixel
+   *  clustering...) used to convert it into their own lookup
+   *  structure: vectors searched linearly, maps keyed by strings
+   *  made with sprintf or by matrix decoder indices.
+   *
+   *  This class keeps one dense bitmap per sensor, covering the
+   *  bounding box of the hot pixels of that sensor, so that testing a
+   *  pixel is a bounds check and a bit lookup. There is one instance
+   *  per hot pixel collection name, filled the first time a processor
+   *  calls load() with an event holding the collection, and shared
+   *  by every processor of the job asking for the same collection:
+   *
+   *  @code
+   *  if ( isFirstEvent() ) {
+   *    _hotPixelMap = &EUTelHotPixelMap::getInstance( _hotPixelCollectionName );
+   *    _hotPixelMap->load( event );
+   *  }
+   *  ...
+   *  if ( _hotPixelMap->containsHot( hit ) ) continue;
+   *  @endcode
+   */
+  class EUTelHotPixelMap {
+
+  public:
+
+    //! Hot pixels of one sensor
+    class SensorMap {
+
+    public:
+      SensorMap();
+
+      //! Is the pixel hot?
+      inline bool isHot( int x, int y ) const {
+        if ( x < _xMin || y < _yMin || x >= _xMin + _width || y >= _yMin + _height ) return false;
+        return _bits[ static_cast< size_t >( y - _yMin ) * _width + ( x - _xMin ) ];
+      }
+
+      //! Number of hot pixels
+      size_t size() const { return _nHot; }
+
+    private:
+      friend class EUTelHotPixelMap;
+
+      //! Builds the bitmap from the list of hot pixels
+      void fill( const std::vector< std::pair< int, int > > & pixels );
+
+      int _xMin;
+      int _yMin;
+      int _width;
+      int _height;
+      size_t _nHot;
+      std::vector< bool > _bits;
+    };
+
+    //! The map of the given hot pixel collection
+    /*! The instance is created empty on the first call, load() has to
+     *  be called before it holds anything.
+     */
+    static EUTelHotPixelMap & getInstance( const std::string & collectionName );
+
+    //! Fills the map from the event, only once per job
+    /*! Does nothing if the map has already been loaded. Otherwise the
+     *  collection is searched in the event; if it is not there, the
+     *  map stays empty and the next call will try again.
+     *
+     *  @return true if the map is loaded
+     */
+    bool load( EVENT::LCEvent * event );
+
+    //! Has the hot pixel collection been found and read?
+    bool isLoaded() const { return _isLoaded; }
+
+    //! Is there no hot pixel at all?
+    bool empty() const { return _nHot == 0; }
+
+    //! Total number of hot pixels
+    size_t size() const { return _nHot; }
+
+    //! Name of the hot pixel collection
+    const std::string & getCollectionName() const { return _collectionName; }
+
+    //! Hot pixels of a sensor, 0 if the sensor has none
+    const SensorMap * getSensorMap( int sensorID ) const;
+
+    //! Is the pixel of the given sensor hot?
+    bool isHot( int sensorID, int x, int y ) const;
+
+    //! Does the sparse pixel data of a sensor contain a hot pixel?
+    bool containsHot( int sensorID, IMPL::TrackerDataImpl * sparseData ) const;
+
+    //! Is one of the pixels of the hit cluster hot?
+    /*! Only hits made of sparse clusters (kEUTelSparseClusterImpl)
+     *  carry the list of their pixels, false is returned for all the
+     *  other types.
+     *
+     *  @throw UnknownDataTypeException if the raw hit of a sparse
+     *  hit is not a TrackerData.
+     */
+    bool containsHot( const IMPL::TrackerHitImpl * hit ) const;
+
+  private:
+    DISALLOW_COPY_AND_ASSIGN(EUTelHotPixelMap)
+
+    //! Use getInstance()
+    explicit EUTelHotPixelMap( const std::string & collectionName );
+
+    std::string _collectionName;
+    bool _isLoaded;
+    size_t _nHot;
+
+    //! Indexed by sensor ID
+    std::vector< SensorMap > _sensorMaps;
+  };
+
+}
+
+#endif
@@ -14,6 +14,8 @@
 #ifdef USE_GEAR
 // eutelescope includes ".h"
 #include "EUTelUtility.h"
+#include "EUTelHotPixelMap.h"
+#include "EUTelMilleTrackFinder.h"
 
 //#include "TrackerHitImpl2.h"
 #include "IMPL/TrackerHitImpl.h"
@@ -207,27 +209,7 @@ namespace eutelescope {
     };
 
     //! Variables for hit parameters
-    class HitsInPlane {
-    public:
-      HitsInPlane(){
-        measuredX = 0.0;
-        measuredY = 0.0;
-        measuredZ = 0.0;
-      }
-      HitsInPlane(double x, double y, double z)
-      {
-        measuredX = x;
-        measuredY = y;
-        measuredZ = z;
-      }
-      bool operator<(const HitsInPlane& b) const
-      {
-        return (measuredZ < b.measuredZ);
-      }
-      double measuredX;
-      double measuredY;
-      double measuredZ;
-    };
+    typedef EUTelMilleTrackFinder::HitsInPlane HitsInPlane;
 
     virtual void FitTrack(
                           unsigned int nPlanesFitter,
@@ -243,17 +225,6 @@ namespace eutelescope {
                           );
 
 
-    //recursive method which searches for track candidates - with omits!
-    virtual void findtracks2(
-                            int missinghits,
-                            std::vector<IntVec > &indexarray, //resulting vector of hit indizes
-                            IntVec vec, //for internal use
-                            std::vector<std::vector<EUTelMille::HitsInPlane> > &_hitsArray, //contains all hits for each plane
-                            unsigned int i, //plane number
-                            int y //hit index number
-                            );
-
-
     //recursive method which searches for track candidates
     virtual void findtracks(
                             std::vector<IntVec > &indexarray, //resulting vector of hit indizes
@@ -385,16 +356,11 @@ namespace eutelescope {
      */
     std::string _hotPixelCollectionName;
 
-    //! Vector of map arrays, keeps record of hit pixels 
-    /*! The vector elements are sorted by Detector ID
-     *  For each Detector unique ID element a map of pixels is created. 
-     *  first level key   sensor unique 
-     *              value sensor map
-     *  sensor map key    unique row number
-     *             value  vector of column numbers.
+    //! Hot pixels of the hot pixel collection
+    /*! Shared with the other processors using the same collection,
+     *  0 until the first event.
      */
-    
-    std::map<std::string, bool > _hotPixelMap;
+    EUTelHotPixelMap * _hotPixelMap;
 
     //! Sensor ID vector
     IntVec _sensorIDVec;
@@ -420,6 +386,8 @@ namespace eutelescope {
     int _maxTrackCandidatesTotal;
 
     std::string _binaryFilename;
+    //! Text file listing the Millepede binaries of other jobs, read by pede after _binaryFilename
+    std::string _binaryManifest;
 
     float _telescopeResolution;
     bool _onlySingleHitEvents;
@@ -453,6 +421,9 @@ namespace eutelescope {
 
     int _inputMode;
     int _allowedMissingHits;
+
+    //! Track candidate search, configured in init()
+    EUTelMilleTrackFinder _trackFinder;
     int _mimosa26ClusterChargeMin;
 
     float _testModeSensorResolution;
@@ -0,0 +1,97 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef EUTELMILLETRACKFINDER_H
+#define EUTELMILLETRACKFINDER_H 1
+
+// system includes <>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Track candidate search of EUTelMille
+  /*! The planes are walked in their order along the beam and every
+   *  combination of hits is tried, one hit per plane: a hit is
+   *  accepted if its residuals, in x and in y, with respect to the
+   *  hit taken on the previous plane are within the residual cuts of
+   *  that pair of planes, otherwise the plane is counted as missing.
+   *  Combinations with more missing planes than allowed are dropped.
+   *
+   *  The finder does not depend on the processor, so that it can be
+   *  driven on its own, e.g. by the benchmarks in test/benchmark.
+   */
+  class EUTelMilleTrackFinder {
+
+  public:
+
+    //! Variables for hit parameters
+    class HitsInPlane {
+    public:
+      HitsInPlane(){
+        measuredX = 0.0;
+        measuredY = 0.0;
+        measuredZ = 0.0;
+      }
+      HitsInPlane(double x, double y, double z)
+      {
+        measuredX = x;
+        measuredY = y;
+        measuredZ = z;
+      }
+      bool operator<(const HitsInPlane& b) const
+      {
+        return (measuredZ < b.measuredZ);
+      }
+      double measuredX;
+      double measuredY;
+      double measuredZ;
+    };
+
+    //! Default constructor
+    EUTelMilleTrackFinder();
+
+    //! Number of planes a candidate may miss
+    void setAllowedMissingHits( int allowedMissingHits ) { _allowedMissingHits = allowedMissingHits; }
+
+    //! Maximal number of candidates returned for an event
+    void setMaxTrackCandidates( int maxTrackCandidates ) { _maxTrackCandidates = maxTrackCandidates; }
+
+    //! Residual windows, one entry per pair of consecutive planes
+    void setResidualCuts( const std::vector< float > & xMin, const std::vector< float > & xMax,
+                          const std::vector< float > & yMin, const std::vector< float > & yMax );
+
+    //! Find the track candidates
+    /*! For each candidate the index of its hit in each plane of
+     *  allHitsArray is appended to indexArray, -1 for a missing hit.
+     */
+    void findTracks( std::vector< std::vector< int > > & indexArray,
+                     const std::vector< std::vector< HitsInPlane > > & allHitsArray ) const;
+
+  private:
+
+    //! Recursive step of findTracks(), taking hit y of plane i-1 and going on with plane i
+    void findtracks2( int missinghits,
+                      std::vector< std::vector< int > > & indexarray,
+                      std::vector< int > vec,
+                      const std::vector< std::vector< HitsInPlane > > & _allHitsArray,
+                      unsigned int i,
+                      int y ) const;
+
+    int _allowedMissingHits;
+    int _maxTrackCandidates;
+
+    std::vector< float > _residualsXMin;
+    std::vector< float > _residualsXMax;
+    std::vector< float > _residualsYMin;
+    std::vector< float > _residualsYMax;
+  };
+
+}
+
+#endif
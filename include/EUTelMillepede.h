@@ -67,6 +67,8 @@ public:
 	void setZRotationsFixed(std::vector<int> zRotfixed){ _fixedAlignmentZRotationPlaneIds = zRotfixed; }
 	void setPlanesExclude(std::vector<int> exclude){ _alignmentPlaneIdsExclude = exclude; }
 	void setBinaryFileName(std::string binary){ _milleBinaryFilename = binary; }
+	//Binaries given to pede, in this order. If empty pede reads the binary set above.
+	void setBinaryInputFiles(const std::vector<std::string>& binaries){ _milleBinaryInputFiles = binaries; }
 	void setSteeringFileName(std::string name){ _milleSteeringFilename = name; }
 	void setResultsFileName(std::string name){ _milleResultFileName = name; }
 
@@ -78,6 +80,8 @@ public:
 	bool findTooManyRejects(std::string output);
 	gbl::MilleBinary * _milleGBL;
 	void CreateBinary();
+	//Flushes and closes the binary, it can then be read by pede
+	void closeBinary();
 
 protected:
 	TMatrixD _jacobian; //Remember you need to create the object before you point ot it
@@ -95,6 +99,8 @@ protected:
 	int _iteration;
 
 	std::string _milleBinaryFilename;
+	//All the binaries read by pede, e.g. the shards written by several jobs
+	std::vector<std::string> _milleBinaryInputFiles;
 	//the results file
 	std::string _milleResultFileName;
 
@@ -10,6 +10,7 @@
 
 // eutelescope includes ".h"
 #include "EUTelUtility.h"
+#include "EUTelMissingCoordinateMatcher.h"
 
 
 // marlin includes ".h"
@@ -187,6 +188,9 @@ namespace eutelescope {
 	
 	//! Count number of created hit per DUT Hit
 	std::vector<unsigned int> _numberOfCreatedHitPerDUTHit; 
+
+        //! DUT hits of the event, sorted along the known coordinate
+        EUTelMissingCoordinateMatcher _matcher;
     };
     
     //! A global instance of the processor
@@ -0,0 +1,108 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef EUTELMISSINGCOORDINATEMATCHER_H
+#define EUTELMISSINGCOORDINATEMATCHER_H
+
+// system includes <>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace eutelescope {
+
+    //! Search of the DUT hits correlated to a reference hit pair
+    /*! Used by EUTelMissingCoordinateEstimator. The DUT hits of an event
+     *  are added once and sorted, per sensor, along the known
+     *  coordinate. For each pair of reference hits only the DUT hits
+     *  whose known coordinate is within the maximum residual of the
+     *  straight line through the pair, anywhere in the z range of the
+     *  sensor, are then tested. The test itself is the one of the
+     *  processor, so the matched hits are exactly those of a loop over
+     *  all the DUT hits:
+     *
+     *  @code
+     *  t     = ( dut[2] - ref1[2] ) / ( ref2[2] - ref1[2] );
+     *  match = fabs( ref1[known] + ( ref2[known] - ref1[known] ) * t - dut[known] ) < maxResidual;
+     *  @endcode
+     *
+     *  The hits are identified by the order in which they were added.
+     *
+     *  Sorting and the binary searches only pay off with enough DUT
+     *  hits: below kDefaultSortedSearchMinHits hits per event (set from
+     *  test/benchmark/missingcoordinate) all the hits are tested, as a
+     *  plain loop does.
+     */
+    class EUTelMissingCoordinateMatcher {
+
+    public:
+        //! Number of DUT hits from which the sorted search is faster than the loop
+        static const size_t kDefaultSortedSearchMinHits = 64;
+
+        EUTelMissingCoordinateMatcher();
+
+        //! Use the sorted search only from this number of DUT hits in the event
+        void setSortedSearchMinHits( size_t minHits ) { _sortedSearchMinHits = minHits; }
+
+        //! Index (0 for X, 1 for Y) of the coordinate measured by the DUT
+        void setKnownCoordinate( unsigned int knownHitPos ) { _knownHitPos = knownHitPos; }
+
+        //! Maximum residual, in the known coordinate, of a correlated hit
+        void setMaxResidual( double maxResidual ) { _maxResidual = maxResidual; }
+
+        //! Forget the hits of the previous event
+        void clear();
+
+        //! Add a DUT hit, it gets the next index
+        void addHit( int sensorID, const double * position );
+
+        //! Sort the hits if there are enough of them, to be called after the last addHit()
+        void prepare();
+
+        //! Find the DUT hits correlated to a reference hit pair
+        /*! @a matches is filled with the indices of the correlated DUT
+         *  hits, in increasing order.
+         */
+        void findMatches( const double * refHit1Pos, const double * refHit2Pos, std::vector< unsigned int > & matches ) const;
+
+    private:
+        //! The DUT hits of a sensor, sorted along the known coordinate
+        struct Plane {
+            int sensorID;
+            double zMin;
+            double zMax;
+            std::vector< std::pair< double, unsigned int > > known;
+        };
+
+        //! Positions of all the DUT hits, three values per hit
+        std::vector< double > _positions;
+
+        //! Sensor of each DUT hit
+        std::vector< int > _sensorIDs;
+
+        //! Sensors with DUT hits in this event
+        std::vector< Plane > _planes;
+
+        //! Number of entries of _planes in use
+        /*! The planes are kept from event to event to reuse their storage */
+        size_t _nPlanes;
+
+        unsigned int _knownHitPos;
+
+        double _maxResidual;
+
+        size_t _sortedSearchMinHits;
+
+        //! Whether prepare() sorted the hits of this event
+        bool _sorted;
+    };
+
+}
+
+#endif
@@ -16,9 +16,11 @@ class EUTelNav
 		static TMatrixD getLocalToCurvilinearTransformMatrix(TVector3 globalMomentum, int  planeID, float charge);
 		static TMatrixD getLocalToCurvilinearTransformMatrixLimit(TVector3 globalMomentum, int  planeID, float charge);
 		static TMatrixD getMeasToGlobal(TVector3 t1w, int  planeID);
+		static TMatrixD getMeasToGlobal(TVector3 t1w, const TMatrixD& TRotMatrix);
 
 		static TMatrixD getPropagationJacobianCurvilinear(float ds, float qbyp, TVector3 t1w, TVector3 t2w);
 		static TMatrixD getPropagationJacobianGlobalToGlobal(float ds, TVector3 t1w);
+		static TMatrixD getPropagationJacobianGlobalToGlobal(float ds, TVector3 t1w, const TVector3& b);
 		static TVector3 getPositionfromArcLength(TVector3 pos, TVector3 pVec, float beamQ, double s);
 		static TVector3 getMomentumfromArcLength(TVector3 momentum, float charge, float arcLength);
 		static TVector3 getMomentumfromArcLengthLocal(TVector3 pVec, TVector3 pos, float beamQ, float s, int  planeID);
@@ -64,12 +64,18 @@ namespace eutelescope {
    *  file will allow to remove all the intermediate EORE and leaving
    *  only the last one.
    *
+   *  The SIO records are compressed with zlib at the LCIO default
+   *  level unless LCIOCompressionLevel is set: lower levels trade
+   *  file size for writing time, 0 switches the compression off.
+   *
    *  @see marlin::LCIOOutputProcessor
    *  @see eutelescope::EventType
    *  @see eutelescope::EUTelEventImpl
    *
    *  @param All parameters available in LCIOOutputProcessir
    *  @param SkipIntermediateEORE Remove EORE in between following runs.
+   *  @param LCIOCompressionLevel zlib level of the output file, LCIO
+   *  default if negative.
    *
    *
    *  @author Antonio Bulgheroni, INFN <mailto:antonio.bulgheroni@gmail.com>
@@ -98,6 +104,11 @@ namespace eutelescope {
     /*! This is executed only once in the whole execution. It opens
      *  the output file with the mode flag specified in the steering
      *  files and prints out the processor parameters.
+     *
+     *  The compression level is only used when the file is opened,
+     *  so if LCIOCompressionLevel is given the writer opened by
+     *  LCIOOutputProcessor::init() is closed and opened again with it,
+     *  before anything is written.
      */
     virtual void init() ;
 
@@ -151,6 +162,11 @@ namespace eutelescope {
      * 
      */ 
     bool _skipIntermediateEORESwitch;
+
+    //! The zlib compression level of the output file
+    /*! A negative value leaves the LCIO default.
+     */
+    int _compressionLevel;
       
 
   } ;
@@ -28,6 +28,7 @@
 #include "EUTelGeometryTelescopeGeoDescription.h"
 #include "EUTelTrack.h"
 #include "EUTelState.h"
+#include "EUTelScatteringTable.h"
 
 //LCIO
 #include "lcio.h"
@@ -72,6 +73,9 @@ namespace eutelescope {
 			return _numberOfTracksAfterPruneCut;
 		}
 
+		//The number of seeds of this event, each propagated by findTrackCandidates().
+		int getNumberOfSeeds() const;
+
 		//SETTERS
 		void setHitsVecPerPlane();
 
@@ -105,10 +109,15 @@ namespace eutelescope {
 		inline void setBeamCharge(double q) {
 			this->_beamQ = q;
 		}
+
+		//The maximal difference between the slopes (dx/dz,dy/dz) of a pair of seed hits and the beam. Empty to use every hit as a seed.
+		inline void setSeedSlopeWindow(EVENT::FloatVec seedSlopeWindow) {
+			this->_seedSlopeWindow = seedSlopeWindow;
+		}
         std::vector<EUTelTrack> getSeedTracks();
         bool seedTrackOuterHits(EUTelTrack track, EUTelTrack & trackOut);
 
-		TVector3 getGlobalMomBetweenStates(EUTelState firstState, EUTelState lastState);
+		TVector3 getGlobalMomBetweenStates(const EUTelState& firstState, const EUTelState& lastState);
 
 		//Here if the user does not set a create seeds from planes x. The we set it automatically to the first plane travelling as the beam travels. 
 		//This has the best of both world. No reduction on functionality. User does not even know this is here. 	
@@ -180,8 +189,17 @@ private:
 		 * from track's ref. point*/
 
 		void setNewState(float position[],float momentum[],  EUTelState& newState);
+
+		/** Find the hit on the next planes which forms a pair within the slope window with the seed, and take the direction of the seed from the pair */
+		bool pairSeed(EUTelState& seed, const double seedPosGlobal[], const TVector3& momentum);
+
+		/** Fill the scattering table for this momentum, with the material along the reference line: parallel to the z axis through the centre of the first plane */
+		bool buildScatteringTable(double momentum);
 		
-		void setRadLengths(EUTelTrack & track,std::map<const int,double>  mapSensor, std::map<const int ,double>  mapAir, double rad );
+		void setRadLengths(EUTelTrack & track);
+
+		/** Set the scattering of the track from the material found along its seed, when there is no scattering table */
+		void setRadLengths(EUTelTrack & track, std::map<const int,double>& mapSensor, std::map<const int ,double>& mapAir, double rad);
 
 
 		
@@ -231,6 +249,18 @@ private:
 		
 		/** Beam angular spread (horizontal,vertical) [mr] */
 		EVENT::FloatVec _beamAngularSpread;
+
+		/** Scattering variances of the planes per incidence, built along the reference line of buildScatteringTable() */
+		EUTelScatteringTable _scatteringTable;
+
+		/** Set if the reference line of buildScatteringTable() missed some material, the scattering is then found per seed */
+		bool _scatteringTableFailed;
+
+		/** Maximal difference between the slopes of a seed pair and the beam (dx/dz,dy/dz), empty for no pairing */
+		EVENT::FloatVec _seedSlopeWindow;
+
+		/** Global positions (x,y,z) of the hits on each plane, filled when pairing the seeds */
+		std::map<int, std::vector<double> > _mapGlobalHitPositionsPerPlane;
 		
 private:
 /** Track parameters propagation jacobian matrix */
@@ -11,6 +11,7 @@
 
 // eutelescope includes ".h"
 #include "EUTelReferenceHit.h"
+#include "EUTelHotPixelMap.h"
 
 //ROOT includes
 #include "TVector3.h"
@@ -109,6 +110,30 @@ namespace eutelescope {
     float getPeakY(){
       return( (getMaxBin(histoY) * pitchY) + minX) ;
     }
+    //! Add the histogram content of another PreAligner of the same sensor
+    /*! Used to combine the PreAligners filled on different event
+     *  shards. Returns false if the binning is not the same.
+     */
+    bool merge(const PreAligner& other){
+      if( other.iden != iden || other.histoX.size() != histoX.size() || other.histoY.size() != histoY.size() ) return false;
+      for(size_t ii = 0; ii < histoX.size(); ii++) histoX[ii] += other.histoX[ii];
+      for(size_t ii = 0; ii < histoY.size(); ii++) histoY[ii] += other.histoY[ii];
+      return true;
+    }
+    //! Write the histograms as one text line each for X and Y
+    void write(std::ostream& os) const {
+      os << iden << " " << histoX.size() << " " << histoY.size() << "\n";
+      for(size_t ii = 0; ii < histoX.size(); ii++) os << histoX[ii] << (ii + 1 < histoX.size() ? " " : "\n");
+      for(size_t ii = 0; ii < histoY.size(); ii++) os << histoY[ii] << (ii + 1 < histoY.size() ? " " : "\n");
+    }
+    //! Read histograms written by write() into a PreAligner of the same binning
+    bool read(std::istream& is){
+      size_t nX(0), nY(0);
+      if( !(is >> iden >> nX >> nY) || nX != histoX.size() || nY != histoY.size() ) return false;
+      for(size_t ii = 0; ii < histoX.size(); ii++) is >> histoX[ii];
+      for(size_t ii = 0; ii < histoY.size(); ii++) is >> histoY[ii];
+      return !is.fail();
+    }
 
 
   }; // class PreAligner
@@ -143,14 +168,11 @@ namespace eutelescope {
      */
     std::string _hotPixelCollectionName;
 
-    //! map of vectors, keeps record of hit pixels 
-    /*! 
-     *  For each Detector a vector is stored in a map.
-     *  Each vector holds pairs of integers (representing X and Y pixel array positions).
-     *  If an element (i.e. the X and Y position of a pixel) is present in the vector,
-     *  this indicates that the corresponding pixel was marked "hot"
+    //! Hot pixels of the hot pixel collection
+    /*! Shared with the other processors using the same collection,
+     *  0 until the first event.
      */
-    std::map<int, std::vector<std::pair<short, short> > > _hotPixelMap;
+    EUTelHotPixelMap * _hotPixelMap;
  
     //! How many events are needed to get reasonable correlation plots 
     /*! (and Offset DB values) 
@@ -204,6 +226,37 @@ namespace eutelescope {
     //! Boolean for turning histogram creation on and off
     bool _fillHistos;
 
+    //! File where the PreAligner histograms of this job are written
+    /*! Lets the prealignment of a run be split into event shards
+     *  processed in parallel, the histograms being merged afterwards.
+     */
+    std::string _histogramShardFile;
+
+    //! Files with PreAligner histograms of other shards to add in end()
+    std::vector< std::string > _mergeHistogramShardFiles;
+
+    //! Position in _preAligners of every sensor, the fixed plane is not in
+    std::map< int, size_t > _preAlignerIndex;
+
+    //! Residual window of every PreAligner, in the order of _preAligners
+    std::vector< double > _windowXMin, _windowXMax, _windowYMin, _windowYMax;
+
+    //! Hits of the current event, bucketed by PreAligner
+    /*! Reused from event to event to avoid reallocations. Hits
+     *  with hot pixels are not put in.
+     */
+    std::vector< std::vector< double > > _bucketX, _bucketY;
+
+    //! Hits of the current event on the fixed plane
+    std::vector< double > _refX, _refY;
+
+    //! Correlations of the current reference hit passing the windows
+    std::vector< float > _residX, _residY;
+    std::vector< size_t > _residPreAligner;
+
+    //! Adds the histograms of the shard files to the PreAligners
+    void mergeHistogramShards();
+
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA) 
     std::map<unsigned int, AIDA::IBaseHistogram * > _hitXCorr;
     std::map<unsigned int, AIDA::IBaseHistogram * > _hitYCorr;
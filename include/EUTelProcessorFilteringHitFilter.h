@@ -8,6 +8,7 @@
 #include "marlin/Processor.h"
 
 #include "IMPL/TrackerHitImpl.h"
+#include "EUTelHotPixelMap.h"
 #include <IMPL/LCCollectionVec.h>
 #include <IMPL/TrackImpl.h>
 
@@ -62,8 +63,8 @@ namespace eutelescope {
         int _nProcessedRuns;
         int _nProcessedEvents;
 
-        // treat hits with hotpixels
-        std::map<std::string, bool > _hotPixelMap;
+        // treat hits with hotpixels, shared with the other processors
+        EUTelHotPixelMap * _hotPixelMap;
  
     };
 
@@ -92,6 +92,12 @@ namespace eutelescope {
 				double _eBeam;
 
 				bool _createBinary;
+				/** Run pede at the end of the job */
+				bool _runPede;
+				/** Text file listing the Millepede binaries of other jobs */
+				std::string _milleBinaryManifest;
+				/** Millepede binaries of other jobs */
+				lcio::StringVec _milleBinaryInputFiles;
         /** Outlier downweighting option */
         std::string _mEstimatorType;
 
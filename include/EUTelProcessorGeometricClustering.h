@@ -13,6 +13,9 @@
 // eutelescope includes ".h"
 #include "EUTelExceptions.h"
 #include "EUTELESCOPE.h"
+#include "EUTelThreadPool.h"
+#include "EUTelSparseClusterFinder.h"
+#include "EUTelGeometricPixel.h"
 
 // marlin includes ".h"
 #include "marlin/EventModifier.h"
@@ -89,6 +92,13 @@ namespace eutelescope {
    *  @param HistoInfoFileName This is the name of the XML file
    *  containing the histogram booking information.
    *
+   *  @param NumberOfThreads Number of threads used to cluster the
+   *  sensors of an event concurrently. 1 (default) means serial
+   *  processing, 0 one thread per CPU core. The pixel positions are
+   *  always taken from the geometry in the main thread, since TGeo
+   *  navigation is not thread safe; only the neighbour search runs in
+   *  parallel.
+   *
    */
 
 class EUTelProcessorGeometricClustering :public marlin::Processor , public marlin::EventModifier {
@@ -111,6 +121,9 @@ public:
     //! Default constructor
     EUTelProcessorGeometricClustering ();
 
+    //! Default destructor
+    virtual ~EUTelProcessorGeometricClustering ();
+
     //! Called at the job beginning.
     /*! This is executed only once in the whole execution. It prints
      *  out the processor parameters and reset all needed data
@@ -345,6 +358,18 @@ private:
     
     //! pulse Collection 
     LCCollectionVec* _pulseCollectionVec;
+
+    //! Clustering of the hit pixels of one sensor
+    typedef EUTelSparseClusterFinder< EUTelGeometricPixel, EUTelGeometricPixelCut > SensorClusterFinder;
+
+    //! Number of threads used to cluster the sensors concurrently
+    int _nThreads;
+
+    //! Thread pool running the cluster finders
+    EUTelThreadPool * _threadPool;
+
+    //! One cluster finder per sensor, reused from event to event
+    std::vector< SensorClusterFinder * > _clusterFinders;
   
 };
 
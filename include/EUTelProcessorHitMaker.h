@@ -12,7 +12,9 @@
 // built only if GEAR is available
 #ifdef USE_GEAR
 // eutelescope includes ".h"
+#include "EUTELESCOPE.h"
 #include "EUTelUtility.h"
+#include "EUTelThreadPool.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -32,6 +34,8 @@
 #endif
 
 #include <IMPL/LCCollectionVec.h>
+#include <IMPL/TrackerDataImpl.h>
+#include <IMPL/TrackerPulseImpl.h>
 
 
 // system includes <>
@@ -224,6 +228,12 @@ namespace eutelescope {
    *  amount of memory and consequently slowing down the full
    *  processing. 
    *
+   *  @param NumberOfThreads Number of threads used to compute the
+   *  cluster centres of the different sensors concurrently. 1
+   *  (default) means serial processing, 0 one thread per CPU
+   *  core. The hits are always made in the order of the input
+   *  clusters.
+   *
    *  @author Antonio Bulgheroni, INFN <mailto:antonio.bulgheroni@gmail.com>
    *  @version $Id$
    *
@@ -251,6 +261,9 @@ namespace eutelescope {
     //! Default constructor
     EUTelProcessorHitMaker ();
 
+    //! Default destructor
+    virtual ~EUTelProcessorHitMaker ();
+
     //! Called at the job beginning.
     /*! This is executed only once in the whole execution. It prints
      *  out the processor parameters and check that the GEAR
@@ -440,6 +453,66 @@ namespace eutelescope {
      */
     std::vector< int > _orderedSensorIDVec;
 
+    //! A cluster of the current event and its position
+    /*! Everything needed to compute the cluster centre is collected
+     *  here in the main thread, so that the centres can be computed
+     *  without touching LCIO decoders or the geometry.
+     */
+    struct ClusterCentre {
+      IMPL::TrackerPulseImpl * pulse;
+      IMPL::TrackerDataImpl * trackerData;
+      int sensorID;
+      ClusterType clusterType;
+      SparsePixelType pixelType;
+
+      //! True if the centre of gravity in pixel units is already known
+      bool hasCoG;
+      float xCoG;
+      float yCoG;
+
+      double xSize;
+      double ySize;
+      double xPitch;
+      double yPitch;
+      double resolutionX;
+      double resolutionY;
+
+      //! Cluster centre in the local frame of the sensor
+      double telPos[3];
+    };
+
+    //! Computes the local position of the clusters of one sensor
+    class SensorCentreFinder : public EUTelThreadPool::Task {
+    public:
+      SensorCentreFinder();
+
+      //! The clusters of the event
+      void setClusters( std::vector< ClusterCentre > * clusters ) { _clusters = clusters; }
+
+      //! The indices of the clusters of this sensor
+      std::vector< int > & clusterIndices() { return _clusterIndices; }
+
+      //! Fill ClusterCentre::telPos of the clusters of this sensor
+      virtual void run();
+
+    private:
+      DISALLOW_COPY_AND_ASSIGN(SensorCentreFinder)
+
+      std::vector< ClusterCentre > * _clusters;
+      std::vector< int > _clusterIndices;
+    };
+
+    //! Number of threads used to compute the cluster centres
+    int _nThreads;
+
+    //! Thread pool running the centre finders
+    EUTelThreadPool * _threadPool;
+
+    //! One centre finder per sensor, reused from event to event
+    std::vector< SensorCentreFinder * > _centreFinders;
+
+    //! The clusters of the current event, in the input order
+    std::vector< ClusterCentre > _clusterCentres;
    
     void DumpReferenceHitDB();
  
@@ -0,0 +1,122 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELPROCESSORMONITOR_H
+#define EUTELPROCESSORMONITOR_H 1
+
+// eutelescope includes ".h"
+#include "EUTELESCOPE.h"
+
+// marlin includes ".h"
+#include "marlin/Processor.h"
+
+// system includes <>
+#include <map>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Per processor timing of a job
+  /*! The processors put a Scope on the stack at the beginning of their
+   *  init(), processEvent() and end(): the wall time, the CPU time of
+   *  the process (worker threads included) and the number of calls are
+   *  summed up per processor and per phase. If the Marlin global
+   *  parameter MonitorHeap is true, the heap growth over each call is
+   *  summed up as well; it is the memory still allocated when the call
+   *  returns (e.g. the collections added to the event), taken from
+   *  the malloc statistics, and is only available with glibc.
+   *
+   *  When the last monitored processor leaves its end(), a summary
+   *  table is printed and the numbers are written out as
+   *  CDashMeasurement, so that they are collected by the nightly tests.
+   *
+   *  @code
+   *  void MyProcessor::processEvent( LCEvent * event ) {
+   *    EUTelProcessorMonitor::Scope monitor( this, EUTelProcessorMonitor::kProcessEvent );
+   *    ...
+   *  @endcode
+   */
+  class EUTelProcessorMonitor {
+
+  public:
+
+    //! The monitored methods of a processor
+    enum Phase { kInit = 0, kProcessEvent, kEnd, kNPhases };
+
+    //! Measures one call of a processor, from construction to destruction
+    class Scope {
+    public:
+      Scope( const marlin::Processor * processor, Phase phase );
+      ~Scope();
+
+    private:
+      DISALLOW_COPY_AND_ASSIGN(Scope)
+
+      const marlin::Processor * _processor;
+      Phase _phase;
+      double _wall;
+      double _cpu;
+      long _heap;
+    };
+
+    //! The monitor of the job
+    static EUTelProcessorMonitor & instance();
+
+    //! Switch the heap monitoring on or off, by default taken from the MonitorHeap global parameter
+    void setHeapMonitoring( bool heap ) { _heap = heap; }
+    bool getHeapMonitoring() const { return _heap; }
+
+    //! Print the summary table and the CDash measurements
+    void report() const;
+
+    //! Wall time in s
+    static double wallTime();
+
+    //! CPU time of the process in s
+    static double cpuTime();
+
+    //! Bytes allocated on the heap, 0 if not available
+    static long heapInUse();
+
+  private:
+    DISALLOW_COPY_AND_ASSIGN(EUTelProcessorMonitor)
+
+    EUTelProcessorMonitor();
+
+    //! Sums of one phase of a processor
+    struct Counters {
+      long calls;
+      double wall;
+      double cpu;
+      double heap;
+    };
+
+    //! Sums of a processor
+    struct Entry {
+      const marlin::Processor * processor;
+      Counters phases[ kNPhases ];
+    };
+
+    //! Add one call, called by ~Scope()
+    void record( const marlin::Processor * processor, Phase phase, double wall, double cpu, long heap );
+
+    //! The processors in the order of their first call
+    std::vector< Entry > _entries;
+
+    //! Position of each processor in _entries
+    std::map< const marlin::Processor *, size_t > _index;
+
+    //! Number of processors which have left their end()
+    size_t _nEnded;
+
+    //! Heap monitoring switch
+    bool _heap;
+  };
+
+}
+#endif
@@ -158,6 +158,9 @@ namespace eutelescope {
 		EVENT::IntVec _excludePlanes;         
 		EVENT::IntVec _planeDimension;
 
+		/** Slope window of the seed pairs (dx/dz,dy/dz) */
+		EVENT::FloatVec _seedSlopeWindow;
+
 		private:
 		DISALLOW_COPY_AND_ASSIGN(EUTelProcessorPatternRecognition)   // prevent users from making (default) copies of processors
      
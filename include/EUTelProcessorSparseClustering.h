@@ -13,6 +13,8 @@
 // eutelescope includes ".h"
 #include "EUTelExceptions.h"
 #include "EUTELESCOPE.h"
+#include "EUTelThreadPool.h"
+#include "EUTelSparseClusterFinder.h"
 
 // marlin includes ".h"
 #include "marlin/EventModifier.h"
@@ -89,6 +91,11 @@ namespace eutelescope {
    *  @param HistoInfoFileName This is the name of the XML file
    *  containing the histogram booking information.
    *
+   *  @param NumberOfThreads Number of threads used to cluster the
+   *  sensors of an event concurrently. 1 (default) means serial
+   *  processing, 0 one thread per CPU core. The output does not depend
+   *  on it.
+   *
    */
 
 class EUTelProcessorSparseClustering :public marlin::Processor , public marlin::EventModifier {
@@ -111,6 +118,9 @@ public:
     //! Default constructor
     EUTelProcessorSparseClustering ();
 
+    //! Default destructor
+    virtual ~EUTelProcessorSparseClustering ();
+
     //! Called at the job beginning.
     /*! This is executed only once in the whole execution. It prints
      *  out the processor parameters and reset all needed data
@@ -348,6 +358,18 @@ private:
  
     //! Squared cut value for distance in pixel index count (integer!)
     int _sparseMinDistanceSquared;
+
+    //! Clustering of the hit pixels of one sensor
+    typedef EUTelSparseClusterFinder< EUTelGenericSparsePixel, EUTelPixelDistanceCut > SensorClusterFinder;
+
+    //! Number of threads used to cluster the sensors concurrently
+    int _nThreads;
+
+    //! Thread pool running the cluster finders
+    EUTelThreadPool * _threadPool;
+
+    //! One cluster finder per sensor, reused from event to event
+    std::vector< SensorClusterFinder * > _clusterFinders;
 };
 
 //! A global instance of the processor
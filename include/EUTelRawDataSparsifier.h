@@ -16,6 +16,8 @@
 #include "marlin/Processor.h"
 
 // lcio includes <.h>
+#include <IMPL/TrackerDataImpl.h>
+#include <IMPL/TrackerRawDataImpl.h>
 
 // system includes <>
 #include <vector>
@@ -262,6 +264,27 @@ namespace eutelescope {
      *  file
      */
     size_t _noOfDetector;
+
+    //! Get the zero suppression threshold of a detector
+    /*! The sigma cut times the noise of each pixel, with an infinite
+     *  threshold for the pixels that are not good, ready for
+     *  CalibrationKernel::sparsify. It is refilled from the current
+     *  conditions at every event, since the noise can be updated in
+     *  place without its object changing.
+     */
+    const std::vector< float > & getThreshold( size_t iDetector, const IMPL::TrackerDataImpl * noise,
+                                               const IMPL::TrackerRawDataImpl * status );
+
+    //! Threshold of each detector, in the input collection order
+    /*! Kept between events only to reuse the storage.
+     */
+    std::vector< std::vector< float > > _thresholdVec;
+
+    //! Index of the pixels above threshold, scratch buffer
+    std::vector< int > _hitIndex;
+
+    //! Signal of the pixels above threshold, scratch buffer
+    std::vector< float > _hitSignal;
   };
 
   //! A global instance of the processor
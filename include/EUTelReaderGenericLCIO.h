@@ -42,7 +42,7 @@ namespace eutelescope {
 	class  EUTelReaderGenericLCIO{
 		public: 
 			EUTelReaderGenericLCIO();
-            void getColVec( std::vector<EUTelTrack> tracks,LCEvent* evt,std::string colName );
+            void getColVec( const std::vector<EUTelTrack>& tracks,LCEvent* evt,std::string colName );
             std::vector<EUTelTrack> getTracks( LCEvent* evt, std::string colName);
 
   	private:
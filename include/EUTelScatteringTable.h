@@ -0,0 +1,97 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef EUTELSCATTERINGTABLE_H
+#define EUTELSCATTERINGTABLE_H 1
+
+// system includes <>
+#include <map>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Multiple scattering variances of the planes, per incidence slope
+  /*! For a given beam momentum, the material of the telescope (the
+   *  X/X0 of each plane and of the air in front of it, as found by
+   *  EUTelGeometryTelescopeGeoDescription::calculateTotalRadiationLengthAndWeights())
+   *  is the same for all the tracks, and the material they cross only
+   *  depends on their incidence: it scales with
+   *  sqrt(1 + (dx/dz)^2 + (dy/dz)^2). The Highland variance of the
+   *  whole path and its share for each plane and each air gap are
+   *  computed once per bin of the incidence slope, so that setting up
+   *  the scattering of a track is a lookup.
+   *
+   *  @code
+   *  if ( !table.isBuiltFor( momentum ) ) table.build( momentum, mapSensor, mapAir, rad );
+   *  const int bin = table.getSlopeBin( dxdz, dydz );
+   *  const int plane = table.getPlaneIndex( sensorID );
+   *  state.setRadFrac( table.getSensorVariance( bin, plane ), table.getAirVariance( bin, plane ) );
+   *  @endcode
+   */
+  class EUTelScatteringTable {
+
+  public:
+
+    //! Table for incidence slopes from 0 to maxSlope in nSlopeBins bins
+    EUTelScatteringTable( double maxSlope = 0.1, int nSlopeBins = 100 );
+
+    //! Fill the table
+    /*! mapSensor and mapAir hold the X/X0 of each plane and of the air
+     *  in front of it for a track at normal incidence, rad their sum.
+     */
+    void build( double momentum, const std::map< const int, double > & mapSensor,
+                const std::map< const int, double > & mapAir, double rad );
+
+    //! Forget the content, e.g. when the geometry has changed
+    void clear();
+
+    bool isBuilt() const { return !_totalVariance.empty(); }
+
+    //! Whether the table is filled for this momentum
+    bool isBuiltFor( double momentum ) const;
+
+    //! Bin of the incidence slope, the last bin for slopes beyond the table
+    int getSlopeBin( double slopeX, double slopeY ) const;
+
+    //! Index of a plane in the table, -1 if it has no material in the table
+    int getPlaneIndex( int sensorID ) const;
+
+    //! Highland variance of the whole path
+    double getTotalVariance( int bin ) const { return _totalVariance[ bin ]; }
+
+    //! Share of the variance of the plane itself
+    double getSensorVariance( int bin, int plane ) const { return _sensorVariance[ bin * _nPlanes + plane ]; }
+
+    //! Share of the variance of the air in front of the plane
+    double getAirVariance( int bin, int plane ) const { return _airVariance[ bin * _nPlanes + plane ]; }
+
+    double getMaxSlope() const { return _maxSlope; }
+    int getNumberOfSlopeBins() const { return _nSlopeBins; }
+
+  private:
+
+    double _maxSlope;
+    int _nSlopeBins;
+    double _momentum;
+    int _nPlanes;
+
+    //! Index in the table of each sensor ID
+    std::map< int, int > _planeIndex;
+
+    //! One entry per slope bin
+    std::vector< double > _totalVariance;
+
+    //! nPlanes entries per slope bin
+    std::vector< double > _sensorVariance;
+    std::vector< double > _airVariance;
+  };
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef EUTELSPARSECLUSTERFINDER_H
+#define EUTELSPARSECLUSTERFINDER_H 1
+
+// eutelescope includes ".h"
+#include "EUTELESCOPE.h"
+#include "EUTelThreadPool.h"
+#include "EUTelGenericSparsePixel.h"
+#include "EUTelGeometricPixel.h"
+
+// system includes <>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Neighbour search on the hit pixels of one sensor
+  /*! This is the clustering shared by the processors working on
+   *  sparsified data: a cluster is started with the first pixel not
+   *  yet used, and every pixel passing the NeighbourCut with one of
+   *  the pixels already in the cluster is added to it, until no more
+   *  pixels can be added.
+   *
+   *  The clusters are found in the order of their first pixel in the
+   *  input, and the pixels of a cluster are in the order they have
+   *  been added. Every cluster pixel scans the remaining pixels only
+   *  once.
+   *
+   *  The finder only works on its own buffers, so the finders of the
+   *  different sensors of an event can run concurrently on an
+   *  EUTelThreadPool. The caller fills pixels(), submits the finder
+   *  and, after EUTelThreadPool::wait(), converts the clusters into
+   *  LCIO objects. The buffers are kept from event to event.
+   *
+   *  The NeighbourCut is a functor with a
+   *  @code
+   *  bool operator()( const PixelType & clusterPixel, const PixelType & candidate ) const;
+   *  @endcode
+   *  method, returning true if the candidate belongs to the cluster.
+   */
+  template < class PixelType, class NeighbourCut >
+  class EUTelSparseClusterFinder : public EUTelThreadPool::Task {
+
+  public:
+
+    //! Default constructor
+    EUTelSparseClusterFinder();
+
+    //! Set the cut used to decide if two pixels are neighbours
+    void setCut( const NeighbourCut & cut ) { _cut = cut; }
+
+    //! Pixels to be clustered by the next run()
+    /*! The vector is consumed by run().
+     */
+    std::vector< PixelType > & pixels() { return _pixels; }
+
+    //! Cluster the pixels
+    virtual void run();
+
+    //! Number of clusters found by the last run()
+    unsigned int getNumberOfClusters() const { return _clusterStart.empty() ? 0 : _clusterStart.size() - 1; }
+
+    //! Pixels of the clusters, sorted by cluster
+    /*! The pixels of cluster i are found between getClusterStart(i)
+     *  and getClusterStart(i+1)
+     */
+    const std::vector< PixelType > & getClusterPixels() const { return _clusterPixels; }
+
+    //! Offset of the first pixel of a cluster in getClusterPixels()
+    unsigned int getClusterStart( unsigned int iCluster ) const { return _clusterStart[ iCluster ]; }
+
+  private:
+    DISALLOW_COPY_AND_ASSIGN(EUTelSparseClusterFinder)
+
+    NeighbourCut _cut;
+    std::vector< PixelType > _pixels;
+    std::vector< PixelType > _clusterPixels;
+    std::vector< unsigned int > _clusterStart;
+  };
+
+  //! Neighbour cut on the distance of the pixel indices
+  /*! Two pixels are neighbours if dx*dx + dy*dy is not larger than
+   *  maxDistanceSquared, 2 meaning touching pixels.
+   */
+  struct EUTelPixelDistanceCut {
+    EUTelPixelDistanceCut() : maxDistanceSquared( 2 ) { }
+    explicit EUTelPixelDistanceCut( int distanceSquared ) : maxDistanceSquared( distanceSquared ) { }
+
+    bool operator()( const EUTelGenericSparsePixel & clusterPixel, const EUTelGenericSparsePixel & candidate ) const {
+      int dX = clusterPixel.getXCoord() - candidate.getXCoord();
+      int dY = clusterPixel.getYCoord() - candidate.getYCoord();
+      return dX * dX + dY * dY <= maxDistanceSquared;
+    }
+
+    int maxDistanceSquared;
+  };
+
+  //! Neighbour cut of the geometric pixels
+  /*! The pixel boundaries have to touch, within 1% to account for
+   *  the precision of the geometry framework, and the time
+   *  difference has to be within the time cut.
+   */
+  struct EUTelGeometricPixelCut {
+    EUTelGeometricPixelCut() : cutT( 0. ) { }
+    explicit EUTelGeometricPixelCut( float timeCut ) : cutT( timeCut ) { }
+
+    bool operator()( const EUTelGeometricPixel & clusterPixel, const EUTelGeometricPixel & candidate ) const {
+      float dX = clusterPixel.getPosX() - candidate.getPosX();
+      float dY = clusterPixel.getPosY() - candidate.getPosY();
+      float dT = clusterPixel.getTime() - candidate.getTime();
+      float cutX = ( clusterPixel.getBoundaryX() + candidate.getBoundaryX() ) * 1.01;
+      float cutY = ( clusterPixel.getBoundaryY() + candidate.getBoundaryY() ) * 1.01;
+      return ( dX * dX <= cutX * cutX ) && ( dY * dY <= cutY * cutY ) && ( dT * dT <= cutT * cutT );
+    }
+
+    float cutT;
+  };
+
+}
+
+// template implementation
+#include "EUTelSparseClusterFinder.tcc"
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef EUTELSPARSECLUSTERFINDER_TCC
+#define EUTELSPARSECLUSTERFINDER_TCC
+
+namespace eutelescope {
+
+  template < class PixelType, class NeighbourCut >
+  EUTelSparseClusterFinder< PixelType, NeighbourCut >::EUTelSparseClusterFinder() :
+    EUTelThreadPool::Task(),
+    _cut(),
+    _pixels(),
+    _clusterPixels(),
+    _clusterStart() {
+  }
+
+  template < class PixelType, class NeighbourCut >
+  void EUTelSparseClusterFinder< PixelType, NeighbourCut >::run() {
+
+    _clusterPixels.clear();
+    _clusterPixels.reserve( _pixels.size() );
+    _clusterStart.clear();
+
+    while ( !_pixels.empty() ) {
+
+      // the first pixel not yet used starts a new cluster
+      size_t next = _clusterPixels.size();
+      _clusterStart.push_back( next );
+      _clusterPixels.push_back( _pixels.front() );
+      _pixels.erase( _pixels.begin() );
+
+      // the cluster pixels not yet compared with the remaining ones
+      // are the ones after next. Each of them moves its neighbours, in
+      // their order, to the cluster and the others to the front of
+      // the pixel vector.
+      for ( ; next < _clusterPixels.size() && !_pixels.empty(); ++next ) {
+        size_t nLeft = 0;
+        for ( size_t iPixel = 0; iPixel < _pixels.size(); ++iPixel ) {
+          if ( _cut( _clusterPixels[ next ], _pixels[ iPixel ] ) ) {
+            _clusterPixels.push_back( _pixels[ iPixel ] );
+          } else {
+            if ( nLeft != iPixel ) _pixels[ nLeft ] = _pixels[ iPixel ];
+            ++nLeft;
+          }
+        }
+        _pixels.resize( nLeft );
+      }
+    }
+    _clusterStart.push_back( _clusterPixels.size() );
+  }
+
+}
+
+#endif
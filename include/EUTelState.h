@@ -15,46 +15,57 @@
 
 namespace eutelescope {
 
+	//! State of a track on a plane
+	/*! The state is a plain value: the kinks and the hit are kept in
+	 *  fixed size arrays inside the state, so that a copy is a plain
+	 *  member-wise copy, and the accessors return references or fill
+	 *  the objects they are given. A track still allocates the vector
+	 *  of its states when it is copied, see EUTelTrack::swapStates().
+	 */
 	class  EUTelState{
 		public: 
 			EUTelState();
 			EUTelState(EUTelState *state);
 			//getters
-			EUTelHit getHit();
+			const EUTelHit& getHit() const;
 			int getDimensionSize() const ;
 			int	getLocation() const;
-			TMatrixDSym getStateCov() const;
-			TVectorD getStateVec();
-            TVector3 getMomLocal();
+			const TMatrixDSym& getStateCov() const;
+			TVectorD getStateVec() const;
+            TVector3 getMomLocal() const;
 			float getMomLocalX() const {return _momLocalX;}
 			float getMomLocalY() const {return _momLocalY;}
 			float getMomLocalZ() const {return _momLocalZ;}
 			TVector3 getMomGlobal() const ;
-            std::vector<double> getLCIOOutput();
+            std::vector<double> getLCIOOutput() const;
+            //! Fill output with the LCIO representation, reusing its storage
+            void getLCIOOutput(std::vector<double>& output) const;
 			float getArcLengthToNextState() const {return _arcLength;} 
 			const float* getPosition() const ; 
 			TVector3 getPositionGlobal() const; 
 			void getCombinedHitAndStateCovMatrixInLocalFrame(double (&cov)[4]) const;
 			bool getStateHasHit() const;
-			TMatrixD getProjectionMatrix() const;
-			TVector3 getIncidenceUnitMomentumVectorInLocalFrame();
-			TMatrixDSym getScatteringVarianceInLocalFrame();
-			TMatrixDSym getScatteringVarianceInLocalFrame(float variance);
-			TVectorD getKinks() const;
-			TVectorD getKinksMedium1() const;
-			TVectorD getKinksMedium2() const;
+			const TMatrixD& getProjectionMatrix() const;
+			//! Precision matrix of the scattering in the sensor, filled into precisionMatrix
+			void getScatteringVarianceInLocalFrame(TMatrixDSym& precisionMatrix) const;
+			//! Precision matrix of the scattering for the given variance, filled into precisionMatrix
+			void getScatteringVarianceInLocalFrame(float variance, TMatrixDSym& precisionMatrix) const;
+			//! Kink angles (d(dx/dz),d(dy/dz)), 2 elements
+			const double* getKinks() const;
+			const double* getKinksMedium1() const;
+			const double* getKinksMedium2() const;
 			double getRadFracAir() const ;
 			double getRadFracSensor() const ;
 			//setters
-            void setHit(EUTelHit hit);
+            void setHit(const EUTelHit& hit);
             void setHit(EVENT::TrackerHit* hit);
 			void setDimensionSize(int dimension);
 			void setLocation(int location);
 			void setMomLocalX(float momX);
 			void setMomLocalY(float momY);
 			void setMomLocalZ(float momZ);
-			void setLocalMomentumGlobalMomentum(TVector3 momentumIn);
-            void setTrackFromLCIOVec(std::vector<double> input);
+			void setLocalMomentumGlobalMomentum(const TVector3& momentumIn);
+            void setTrackFromLCIOVec(const std::vector<double>& input);
             //!Template input for setting local position of hit  
             /*!
              * @param position of hit on plane
@@ -63,11 +74,11 @@ namespace eutelescope {
 			void setPositionLocal(double position[]);
 			void setPositionGlobal(float positionGlobal[]);
 			void setCombinedHitAndStateCovMatrixInLocalFrame(double cov[4]);
-			void setStateUsingCorrection(TVectorD stateVec);
+			void setStateUsingCorrection(const TVectorD& stateVec);
 			void setArcLengthToNextState(float arcLength){_arcLength = arcLength;} 
-			void setKinks(TVectorD kinks);
-			void setKinksMedium1(TVectorD kinks);
-			void setKinksMedium2(TVectorD kinks);
+			void setKinks(const TVectorD& kinks);
+			void setKinksMedium1(const TVectorD& kinks);
+			void setKinksMedium2(const TVectorD& kinks);
 			void setRadFrac(double plane, double air);
 
 			//initialise
@@ -83,9 +94,9 @@ namespace eutelescope {
             int _location; 
             float _position[3];
             bool _stateHasHit;
-            TVectorD _kinks;
-            TVectorD _kinksMedium1;
-            TVectorD _kinksMedium2;
+            double _kinks[2];
+            double _kinksMedium1[2];
+            double _kinksMedium2[2];
             float _momLocalX;
             float _momLocalY;
             float _momLocalZ; 
@@ -94,15 +105,18 @@ namespace eutelescope {
             float _arcLength;
 
 			//print
-			void print();
+			void print() const;
             //clear
             void clear();
 
-			bool operator<(const EUTelState compareState ) const;
-			bool operator==(const EUTelState compareState ) const;
-			bool operator!=(const EUTelState compareState ) const;
+			bool operator<(const EUTelState& compareState ) const;
+			bool operator==(const EUTelState& compareState ) const;
+			bool operator!=(const EUTelState& compareState ) const;
 
   	private:
+			//! Scattering precision matrix for the given precision
+			void fillScatteringPrecision(float scatPrecision, TMatrixDSym& precisionMatrix) const;
+
 			float _covCombinedMatrix[4];
 	};
 }
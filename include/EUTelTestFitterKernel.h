@@ -0,0 +1,51 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef EUTELTESTFITTERKERNEL_H
+#define EUTELTESTFITTERKERNEL_H 1
+
+namespace eutelescope {
+
+  //! Analytic track fit of EUTelTestFitter
+  /*! The fit of the particle positions in one projection (XZ or YZ),
+   *  taking into account multiple scattering in the planes and,
+   *  optionally, the beam constraint. It works on the plane arrays
+   *  prepared in EUTelTestFitter::init(), so that it can be driven
+   *  without the processor, e.g. by the benchmarks in test/benchmark.
+   *
+   *  @code
+   *  int status = TestFitterKernel::analyticFit( nPlanes, isActive, planeDist, planeScat,
+   *                                              useBeamConstraint, fitArray, pos, err, slope );
+   *  @endcode
+   */
+  namespace TestFitterKernel {
+
+    //! Fit the positions in one projection
+    /*! On input pos and err hold the measured positions and their
+     *  errors for each of the nPlanes planes, on output the fitted
+     *  positions and their errors. planeDist holds the inverse
+     *  distances between consecutive planes and planeScat the inverse
+     *  scattering variances. fitArray is a work area of nPlanes *
+     *  nPlanes elements. Returns 0 on success and 1 if the matrix is
+     *  singular, in which case all the errors are set to 0.
+     */
+    int analyticFit( int nPlanes, const bool * isActive, const double * planeDist, const double * planeScat,
+                     bool useBeamConstraint, double * fitArray, double * pos, double * err, double slope );
+
+    //! Solve the matrix equation alfa * x = beta with Gauss-Jordan elimination
+    /*! On output beta holds the solution and alfa its inverse. Returns
+     *  1 if the matrix is singular, 0 otherwise.
+     */
+    int gaussjSolve( double * alfa, double * beta, int n );
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELTHREADPOOL_H
+#define EUTELTHREADPOOL_H 1
+
+// eutelescope includes ".h"
+#include "EUTELESCOPE.h"
+
+// system includes <>
+#include <pthread.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Minimal fixed size pool of worker threads
+  /*! Marlin calls the processors of a job strictly one after the
+   *  other, but inside one event a processor often has independent
+   *  pieces of work, typically one per sensor plane. This pool lets a
+   *  processor hand those pieces to a set of POSIX threads and wait
+   *  until all of them are done before it continues with the event.
+   *
+   *  Work is submitted as EUTelThreadPool::Task objects. The pool does
+   *  not take ownership of the tasks, so the caller can keep them (and
+   *  their output buffers) alive across events and only reset them.
+   *  Tasks must not touch shared state such as LCIO collections,
+   *  histograms or streamlog: the usual pattern is to let the tasks
+   *  fill private buffers and to merge those into the event in a fixed
+   *  order after wait() returned.
+   *
+   *  A pool created with less than two threads does not start any
+   *  thread at all and runs every task directly in submit(), so that
+   *  processors can use the same code path for the serial mode.
+   */
+  class EUTelThreadPool {
+
+  public:
+
+    //! Unit of work executed by the pool
+    class Task {
+    public:
+      virtual ~Task() { }
+      //! Executed by one of the worker threads
+      virtual void run() = 0;
+    };
+
+    //! Constructor
+    /*! @param nThreads Number of worker threads. 0 means one thread
+     *  per online CPU core, 1 means serial execution in the calling
+     *  thread.
+     */
+    explicit EUTelThreadPool( unsigned int nThreads );
+
+    //! Destructor, waits for the pending tasks and joins the workers
+    ~EUTelThreadPool();
+
+    //! Queue a task for execution
+    void submit( Task * task );
+
+    //! Block until all submitted tasks have been executed
+    /*! If one of the tasks threw an exception, it is reported here
+     *  as an lcio::Exception once all tasks are finished.
+     */
+    void wait();
+
+    //! Number of worker threads (1 for the serial mode)
+    unsigned int size() const { return _nThreads; }
+
+    //! Number of online CPU cores
+    static unsigned int hardwareConcurrency();
+
+  private:
+    DISALLOW_COPY_AND_ASSIGN(EUTelThreadPool)
+
+    //! Entry point of the worker threads
+    static void * workerEntry( void * pool );
+
+    //! Worker loop
+    void workerLoop();
+
+    //! Runs a task and records a possible failure
+    void execute( Task * task );
+
+    unsigned int _nThreads;
+    std::vector< pthread_t > _workers;
+    std::deque< Task * > _queue;
+    unsigned int _nPending;
+    bool _stop;
+    std::string _failure;
+
+    pthread_mutex_t _mutex;
+    pthread_cond_t _workAvailable;
+    pthread_cond_t _workDone;
+  };
+
+}
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELTOYEVENTGENERATOR_H
+#define EUTELTOYEVENTGENERATOR_H 1
+
+// personal includes ".h"
+#include "EUTelToyGenerator.h"
+#include "EUTelUtility.h"
+
+// marlin includes ".h"
+#include "marlin/DataSourceProcessor.h"
+
+// lcio includes <.h>
+#include <IMPL/LCEventImpl.h>
+
+// system includes <>
+#include <string>
+
+namespace eutelescope {
+
+  //!  Toy telescope event generator
+  /*!  This data source produces synthetic telescope events with
+   *   EUTelToyGenerator, using the GEAR geometry: straight tracks with
+   *   Highland multiple scattering in the planes, binary pixel
+   *   digitization and noise pixels. The events are passed straight to
+   *   the following processors, so that the whole chain (clustering,
+   *   pattern recognition, fitting, alignment) can be run without any
+   *   input file; a LCIOOutputProcessor in the chain writes them out.
+   *
+   *   <h4>Input collection</h4>
+   *   None
+   *
+   *   <h4>Output</h4>
+   *   LCEvent with a zero suppressed TrackerData collection of
+   *   EUTelGenericSparsePixel, one element per plane, and optionally
+   *   the crossing points of the tracks in global coordinates.
+   *
+   *   @param RunNumber Run number of the generated events
+   *
+   *   @param BeamEnergy Beam momentum in GeV
+   *
+   *   @param TracksPerEvent Mean number of tracks per event
+   *
+   *   @param NoiseOccupancy Noise occupancy per pixel and event
+   *
+   *   The number of events is given by the MaxRecordNumber global
+   *   parameter.
+   */
+  class EUTelToyEventGenerator : public marlin::DataSourceProcessor {
+
+  private:
+    DISALLOW_COPY_AND_ASSIGN(EUTelToyEventGenerator)
+
+  public:
+    //! Default constructor
+    EUTelToyEventGenerator ();
+
+    //! New processor
+    /*! Return a new instance of a EUTelToyEventGenerator. It is
+     *  called by the Marlin execution framework and shouldn't be used
+     *  by the final user.
+     */
+    virtual EUTelToyEventGenerator * newProcessor ();
+
+    //! Generates the events
+    /*! Sends a run header, @a numEvents data events and an end of run
+     *  event through the processor chain.
+     */
+    virtual void readDataSource (int numEvents);
+
+    //! Init method
+    /*! It is called at the beginning of the cycle and it prints out
+     *  the parameters.
+     */
+    virtual void init ();
+
+    //! End method
+    virtual void end ();
+
+  protected:
+    //! Send the run header through the chain
+    void sendRunHeader();
+
+    //! Fill the collections of one event
+    void fillEvent( IMPL::LCEventImpl * event );
+
+    //! Run number
+    int _runNumber;
+
+    //! Beam momentum in GeV
+    float _beamEnergy;
+
+    //! Beam profile, gaussian sigma in mm
+    float _beamSizeX;
+    float _beamSizeY;
+
+    //! Gaussian sigma of the beam slopes in rad
+    float _beamDivergence;
+
+    //! Mean number of tracks per event
+    float _tracksPerEvent;
+
+    //! Noise occupancy per pixel and event
+    float _noiseOccupancy;
+
+    //! Distance from the crossing point within which pixels fire, in mm
+    float _chargeSpread;
+
+    //! Plane efficiency
+    float _efficiency;
+
+    //! Switch for multiple scattering in the planes
+    bool _multipleScattering;
+
+    //! Seed of the random numbers
+    int _randomSeed;
+
+    //! Name of the zero suppressed data collection
+    std::string _zsDataCollectionName;
+
+    //! Name of the collection of the track crossing points, empty for none
+    std::string _truthHitCollectionName;
+
+    //! The generator itself
+    EUTelToyGenerator _generator;
+
+    //! Number of generated tracks
+    long _nTracks;
+  };
+
+  //! A global instance of the processor
+  EUTelToyEventGenerator gEUTelToyEventGenerator;
+
+}
+#endif
@@ -0,0 +1,154 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef EUTELTOYGENERATOR_H
+#define EUTELTOYGENERATOR_H 1
+
+// eutelescope includes ".h"
+#include "EUTelGeometrySnapshot.h"
+
+// system includes <>
+#include <stdint.h>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Fast toy generator of telescope events
+  /*! Straight tracks are shot through the planes of a geometry snapshot,
+   *  in their order along the beam. At each plane the crossing point is
+   *  digitized and the track is deflected according to Highland's
+   *  formula for the material budget of the plane. Noise pixels are
+   *  added with a given occupancy. There is no magnetic field and no
+   *  energy loss.
+   *
+   *  The generator does not depend on Marlin or LCIO: it is driven by
+   *  the EUTelToyEventGenerator data source, and can be used on its
+   *  own to feed benchmarks.
+   *
+   *  @code
+   *  EUTelToyGenerator generator;
+   *  generator.setGeometry( geo::gGeometry().getSnapshot() );
+   *  generator.generate();
+   *  for ( size_t i = 0; i < generator.sensors().size(); ++i ) ... generator.sensors()[i].pixels ...
+   *  @endcode
+   */
+  class EUTelToyGenerator {
+
+  public:
+
+    //! Beam and detector response
+    struct Config {
+      //! Beam momentum in GeV
+      double beamEnergy;
+      //! Beam profile, gaussian sigma in mm, centred on the beam axis
+      double beamSizeX;
+      double beamSizeY;
+      //! Beam divergence, gaussian sigma of the slopes in rad
+      double beamDivergence;
+      //! Mean number of tracks per event, poissonian
+      double meanTracks;
+      //! Probability for a pixel to fire without a track
+      double noiseOccupancy;
+      //! Every pixel within this distance, in x and in y, of the crossing point fires, in mm
+      double chargeSpread;
+      //! Probability for a plane to see a track crossing it
+      double efficiency;
+      //! Deflect the tracks in the planes
+      bool multipleScattering;
+
+      Config();
+    };
+
+    //! A fired pixel, binary readout
+    struct Pixel {
+      short x;
+      short y;
+    };
+
+    //! The fired pixels of a plane, sorted and unique
+    struct Sensor {
+      int sensorID;
+      int xPixelNo;
+      int yPixelNo;
+      std::vector< Pixel > pixels;
+    };
+
+    //! Crossing point of a generated track with a plane
+    struct TruthHit {
+      int sensorID;
+      int track;
+      double local[3];
+      double global[3];
+    };
+
+    EUTelToyGenerator();
+
+    void setConfig( const Config & config );
+    const Config & getConfig() const { return _config; }
+
+    //! Seed of the random numbers, the same seed gives the same events
+    void setSeed( uint64_t seed );
+
+    //! Take the planes, ordered along the beam, from a snapshot
+    void setGeometry( const geo::EUTelGeometrySnapshot & snapshot );
+
+    //! Generate the next event
+    void generate();
+
+    //! Number of tracks of the last event
+    int getNTracks() const { return _nTracks; }
+
+    //! Fired pixels of the last event, in the order of the planes along the beam
+    const std::vector< Sensor > & sensors() const { return _sensors; }
+
+    //! Crossing points of the tracks of the last event
+    const std::vector< TruthHit > & truthHits() const { return _truthHits; }
+
+  private:
+
+    //! A plane as seen by the generator
+    struct Plane {
+      int sensorID;
+      geo::EUTelPlaneTransform transform;
+      double normal[3];
+      double halfXSize;
+      double halfYSize;
+      double xPitch;
+      double yPitch;
+      int xPixelNo;
+      int yPixelNo;
+      //! Thickness over radiation length
+      double materialBudget;
+      //! Highland angle for a track at normal incidence, 0 without scattering
+      double theta0;
+    };
+
+    //! Uniform in [0,1), xorshift64*
+    double uniform();
+    double gauss();
+    int poisson( double mean );
+
+    void addTrack( int track );
+    void addCluster( const Plane & plane, Sensor & sensor, double x, double y );
+    void addNoise( Sensor & sensor );
+    void updateScattering();
+
+    Config _config;
+    std::vector< Plane > _planes;
+    std::vector< Sensor > _sensors;
+    std::vector< TruthHit > _truthHits;
+    int _nTracks;
+    uint64_t _state;
+    bool _hasGauss;
+    double _nextGauss;
+  };
+
+}
+
+#endif
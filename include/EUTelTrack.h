@@ -16,6 +16,11 @@
 
 namespace eutelescope {
 
+	//! Track as a sequence of EUTelState
+	/*! The states are kept by value in one vector: hand them over with
+	 *  swapStates() or swap() instead of copying them when the source is
+	 *  not needed any more.
+	 */
 	class  EUTelTrack{
 		public: 
 			EUTelTrack();
@@ -28,18 +33,25 @@ namespace eutelescope {
 			unsigned int getNumberOfHitsOnTrack() const;
             //Must return reference to change the contents.
 			std::vector<EUTelState>& getStates();
+			const std::vector<EUTelState>& getStates() const;
             std::vector<EUTelState> getStatesCopy() const;
-            std::vector<double> getLCIOOutput();
+            std::vector<double> getLCIOOutput() const;
+            //! Fill output with the LCIO representation, reusing its storage
+            void getLCIOOutput(std::vector<double>& output) const;
 			//setters
-            void setState(EUTelState state);
-            void setStates(std::vector<EUTelState> states);
+            void setState(const EUTelState& state);
+            void setStates(const std::vector<EUTelState>& states);
+            //! Exchange the states with the given ones, without copying them
+            void swapStates(std::vector<EUTelState>& states);
+            //! Exchange the contents of the two tracks, without copying the states
+            void swap(EUTelTrack& track);
 			void setTotalVariance(double rad);
             void setChi2(float chi2);
             void setNdf(float nDF);
-            void setTrackFromLCIOVec(std::vector<double> input);
+            void setTrackFromLCIOVec(const std::vector<double>& input);
 
 			//print
-			void print();
+			void print() const;
             //
             std::vector<EUTelState> _states;
             double _var;
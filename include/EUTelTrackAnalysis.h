@@ -37,12 +37,12 @@ namespace eutelescope {
 
 		template<typename T>
 		std::string numberToString(T number);
-		void plotResidualVsPosition(EUTelTrack);
-		void plotBeamEnergy(EUTelTrack);
-		void plotIncidenceAngles(EUTelTrack track);
-		void plotPValueWithPosition(EUTelTrack track);
-		void plotPValueWithIncidenceAngles(EUTelTrack track);
-		void plotPValueVsBeamEnergy(EUTelTrack track);
+		void plotResidualVsPosition(const EUTelTrack& track);
+		void plotBeamEnergy(const EUTelTrack& track);
+		void plotIncidenceAngles(const EUTelTrack& track);
+		void plotPValueWithPosition(const EUTelTrack& track);
+		void plotPValueWithIncidenceAngles(const EUTelTrack& track);
+		void plotPValueVsBeamEnergy(const EUTelTrack& track);
 		void setBeamEnergy(AIDA::IHistogram1D *  beamEnergy){ _beamEnergy = beamEnergy; }
 		void setPValueBeamEnergy(AIDA::IProfile1D *  pValueVsBeamEnergy){ _pValueVsBeamEnergy = pValueVsBeamEnergy; }
 		void setSensorIDTo2DResidualHistogramX(std::map< int,  AIDA::IProfile2D*> mapFromSensorIDToHistogramX){_mapFromSensorIDToHistogramX=mapFromSensorIDToHistogramX;}
@@ -57,7 +57,7 @@ namespace eutelescope {
 		AIDA::IHistogram1D * _beamEnergy;
 		AIDA::IProfile1D   * _pValueBeamEnergy;
 		AIDA::IProfile1D * _pValueVsBeamEnergy;
-		float calculatePValueForChi2(EUTelTrack track);
+		float calculatePValueForChi2(const EUTelTrack& track);
  //       std::string _histoInfoFileName;
 
 
@@ -0,0 +1,220 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELTUPLEWRITER_H
+#define EUTELTUPLEWRITER_H 1
+
+// eutelescope includes ".h"
+#include "EUTELESCOPE.h"
+
+// system includes <>
+#include <pthread.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+class TFile;
+class TTree;
+
+namespace eutelescope {
+
+  //! Column oriented n-tuple output with a background writer thread
+  /*! The analysis n-tuple processors used to fill their TTrees
+   *  directly in processEvent(), so that every basket compression
+   *  and every write to disk was paid by the reconstruction thread.
+   *
+   *  With this class a processor declares its trees and columns
+   *  once, then builds each row with the set*() and push*() methods
+   *  and ends it with fill(). The rows of a tree are kept in plain
+   *  column buffers; once batchSize rows are collected the batch is
+   *  handed over to a writer thread, which copies them into the
+   *  branches, fills the TTree and lets ROOT compress and write the
+   *  baskets. A few batches can be in flight, the reconstruction
+   *  thread only waits when the writer falls behind by more than that.
+   *
+   *  The file is written and closed by close(). Errors of the writer
+   *  thread are reported there as an lcio::Exception.
+   *
+   *  @code
+   *  EUTelTupleWriter writer( "tuple.root", 1, 32000, 1000, true );
+   *  unsigned int hits = writer.addTree( "hits", "hits" );
+   *  unsigned int nHit = writer.addColumn( hits, "nHits", EUTelTupleWriter::kInt );
+   *  unsigned int xPos = writer.addColumn( hits, "xPos", EUTelTupleWriter::kDoubleVector );
+   *  ... for every event:
+   *  writer.pushDouble( xPos, x );
+   *  writer.setInt( nHit, n );
+   *  writer.fill( hits );
+   *  ... at the end:
+   *  writer.close();
+   *  @endcode
+   *
+   *  The background thread needs a thread safe ROOT (6.06 or later). With
+   *  older versions, or if asked for, the batches are written directly
+   *  in the calling thread.
+   */
+  class EUTelTupleWriter {
+
+  public:
+
+    //! Type of a column
+    enum ColumnType {
+      kInt,
+      kLong,
+      kDouble,
+      kIntVector,
+      kDoubleVector
+    };
+
+    //! Constructor, opens (recreates) the output file
+    /*! @param fileName the ROOT output file
+     *  @param compressionLevel ROOT compression level of the file
+     *  @param basketSize basket size in bytes of every branch, ROOT
+     *  default if not positive
+     *  @param batchSize number of rows of a tree handed over at once
+     *  to the writer thread
+     *  @param async write in a background thread
+     */
+    EUTelTupleWriter( const std::string & fileName, int compressionLevel, int basketSize,
+                      unsigned int batchSize, bool async );
+
+    //! Destructor, closes the file if close() was not called
+    ~EUTelTupleWriter();
+
+    //! Book a new tree, returns its index
+    unsigned int addTree( const std::string & name, const std::string & title );
+
+    //! Book a new column of a tree, returns its index
+    /*! All the columns have to be booked before the first fill() */
+    unsigned int addColumn( unsigned int tree, const std::string & name, ColumnType type );
+
+    //! Make a tree friend of another one
+    void addFriend( unsigned int tree, unsigned int friendTree );
+
+    //! Set the value of a scalar column for the current row
+    void setInt( unsigned int column, int value );
+    void setLong( unsigned int column, long long value );
+    void setDouble( unsigned int column, double value );
+
+    //! Append a value to a vector column for the current row
+    void pushInt( unsigned int column, int value );
+    void pushDouble( unsigned int column, double value );
+
+    //! End the current row of a tree
+    void fill( unsigned int tree );
+
+    //! Forget the values pushed to the current row of a tree
+    void discard( unsigned int tree );
+
+    //! Number of rows filled in a tree so far
+    unsigned long long getEntries( unsigned int tree ) const;
+
+    //! Is the writing done in a background thread?
+    bool isAsync() const { return _async; }
+
+    //! Write all the pending rows, the trees and close the file
+    /*! @throw lcio::Exception if the writing failed
+     */
+    void close();
+
+  private:
+    DISALLOW_COPY_AND_ASSIGN(EUTelTupleWriter)
+
+    //! Rows of one column
+    struct ColumnBuffer {
+      ColumnBuffer();
+      ColumnType type;
+      std::vector< int > ints;
+      std::vector< long long > longs;
+      std::vector< double > doubles;
+      //! End of every row in ints or doubles, vector columns only
+      std::vector< size_t > ends;
+    };
+
+    //! Rows of one tree handed over to the writer
+    struct Batch {
+      Batch();
+      unsigned int tree;
+      size_t nRows;
+      std::vector< ColumnBuffer > columns;
+      void clear();
+    };
+
+    //! Branch addresses of one column
+    struct Slot {
+      Slot();
+      ~Slot();
+      ColumnType type;
+      int intValue;
+      long long longValue;
+      double doubleValue;
+      std::vector< int > * intVector;
+      std::vector< double > * doubleVector;
+    private:
+      DISALLOW_COPY_AND_ASSIGN(Slot)
+    };
+
+    //! Where a column is, and its value in the current row
+    struct Column {
+      Column();
+      unsigned int tree;
+      unsigned int index;
+      ColumnType type;
+      int currentInt;
+      long long currentLong;
+      double currentDouble;
+    };
+
+    //! Get the batch collecting the rows of a tree
+    Batch * currentBatch( unsigned int tree );
+
+    //! Hand a batch over to the writer
+    void submit( Batch * batch );
+
+    //! Fill the rows of a batch into its tree
+    void write( Batch * batch );
+
+    //! Write a batch and give it back to the free list
+    void writeAndRecycle( Batch * batch );
+
+    static void * workerEntry( void * writer );
+    void workerLoop();
+
+    TFile * _file;
+    int _basketSize;
+    unsigned int _batchSize;
+    bool _async;
+    bool _closed;
+
+    std::vector< TTree * > _trees;
+    std::vector< std::vector< Slot * > > _slots;
+    std::vector< Column > _columns;
+    //! Columns of every tree, in booking order
+    std::vector< std::vector< unsigned int > > _treeColumns;
+    std::vector< unsigned long long > _entries;
+
+    //! Batch collecting the rows of every tree, 0 if none yet
+    std::vector< Batch * > _current;
+
+    //! Batches waiting for the writer
+    std::deque< Batch * > _queue;
+    //! Batches ready to be reused
+    std::vector< Batch * > _free;
+    //! Maximum number of batches waiting for the writer
+    size_t _maxQueued;
+
+    pthread_t _worker;
+    bool _workerStarted;
+    bool _stop;
+    std::string _failure;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _queueChanged;
+  };
+
+}
+
+#endif
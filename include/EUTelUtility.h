@@ -221,6 +221,12 @@ namespace eutelescope {
         /** */ 
         const float* HitCDoubleShiftCFloat(const double* , TVectorD& );
 
+        /** Read a manifest of Millepede binary files
+         * One file name per line, in the order pede has to read them.
+         * Empty lines and lines starting with '#' are skipped.
+         */
+        std::vector< std::string > readMilleManifest( const std::string& manifestFilename );
+
         /** Tokenize string */
                 /**
          * String tokenizer
@@ -13,7 +13,12 @@
 #ifndef TDSIntegrationStorage_H
 #define TDSIntegrationStorage_H 1
 
-#include <map>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
 
 namespace TDS {
 
@@ -24,6 +29,15 @@ namespace TDS {
    Divide each pixel into sectors (segments) -- integration results are stored and reused.
    <br>
    Only even numbers should be considered for L and W (therefore (val/2)*2).
+   <br>
+   The results are kept in a dense table indexed directly by (segment L,
+   segment W, segment H, neighbour pixel L, neighbour pixel W). Thanks to
+   the symmetry of the charge distribution only half of the segments along
+   L and W are stored. The table can be filled completely in advance with
+   TDSPixelsChargeMap::fillIntegrationStorage(), written to a file with
+   writeToFile() and reused by later jobs with readFromFile(). A table read
+   from file is only used if it was produced for the same pixel pitch,
+   layer height, charge distribution parameters and integration range.
 
    @author Piotr Niezurawski
 
@@ -37,27 +51,14 @@ namespace TDS {
     public:
 
     //! Constructor
-    TDSIntegrationStorage(const unsigned int val_integPixelSegmentsAlongL=0, const unsigned int val_integPixelSegmentsAlongW=0, const unsigned int val_integPixelSegmentsAlongH=0)  
+    TDSIntegrationStorage(const unsigned int val_integPixelSegmentsAlongL=0, const unsigned int val_integPixelSegmentsAlongW=0, const unsigned int val_integPixelSegmentsAlongH=0) :
+      integPixelSegmentsAlongL(0), integPixelSegmentsAlongW(0), integPixelSegmentsAlongH(0),
+      integPixelsAlongL(0), integPixelsAlongW(0), responseParameters(), integResultsTable()
       { 
         // Number of one pixel segments - for integration-results storage (DEFAULT: No storage)
-        integPixelSegmentsAlongL = (val_integPixelSegmentsAlongL/2)*2;
-        if (integPixelSegmentsAlongL > 2000)
-          {
-            std::cout << "Too many pixel segments along length (for integration storage)!" << std::endl;
-            exit(1);
-          }
-        integPixelSegmentsAlongW = (val_integPixelSegmentsAlongW/2)*2;
-        if (integPixelSegmentsAlongW > 2000)
-          {
-            std::cout << "Too many pixel segments along width (for integration storage)!" << std::endl;
-            exit(1);
-          }
-        integPixelSegmentsAlongH = val_integPixelSegmentsAlongH;
-        if (integPixelSegmentsAlongH > 1000)
-          {
-            std::cout << "Too many pixel segments along height (for integration storage)!" << std::endl;
-            exit(1);
-          }
+        setIntegPixelSegmentsAlongL(val_integPixelSegmentsAlongL);
+        setIntegPixelSegmentsAlongW(val_integPixelSegmentsAlongW);
+        setIntegPixelSegmentsAlongH(val_integPixelSegmentsAlongH);
 
         // If only one is != 0 then other dimensions have just 1 segment each!!!
       };
@@ -76,6 +77,7 @@ namespace TDS {
             std::cout << "Too many pixel segments along length (for integration storage)!" << std::endl;
             exit(1);
           }
+        integResultsTable.clear();
       };
 
 
@@ -88,6 +90,7 @@ namespace TDS {
             std::cout << "Too many pixel segments along width (for integration storage)!" << std::endl;
             exit(1);
           }
+        integResultsTable.clear();
       };
 
 
@@ -100,61 +103,179 @@ namespace TDS {
             std::cout << "Too many pixel segments along height (for integration storage)!" << std::endl;
             exit(1);
           }
+        integResultsTable.clear();
       };
 
 
     //! Is the result already stored?
-    inline bool isResultStored(const unsigned long long int integSegmentID)
+    inline bool isResultStored(const unsigned int segmentL, const unsigned int segmentW, const unsigned int segmentH, const unsigned int pixelL, const unsigned int pixelW) const
       {
-        return integResultsForSegments.find(integSegmentID) != integResultsForSegments.end();
+        return integResultsTable[ tableIndex(segmentL, segmentW, segmentH, pixelL, pixelW) ] >= 0.;
       };
 
     //! Store a charge deposit from the segment in the pixel
     /*! Caller should determine pixel's segment for integration results storage
      */
-    inline void rememberResult(const unsigned long long int integSegmentID, double integrationResult)
+    inline void rememberResult(const unsigned int segmentL, const unsigned int segmentW, const unsigned int segmentH, const unsigned int pixelL, const unsigned int pixelW, double integrationResult)
       {
-        integResultsForSegments[ integSegmentID ] = integrationResult;
+        integResultsTable[ tableIndex(segmentL, segmentW, segmentH, pixelL, pixelW) ] = integrationResult;
       };
 
 
     //! Return a stored result
-    inline double getResult(const unsigned long long int integSegmentID)
+    inline double getResult(const unsigned int segmentL, const unsigned int segmentW, const unsigned int segmentH, const unsigned int pixelL, const unsigned int pixelW) const
       {
-        return integResultsForSegments[ integSegmentID ];
+        return integResultsTable[ tableIndex(segmentL, segmentW, segmentH, pixelL, pixelW) ];
       };
 
+    //! Number of stored segments along L (half of the pixel segments thanks to the symmetry)
+    inline unsigned int getStoredSegmentsAlongL() const { return integPixelSegmentsAlongL > 0 ? integPixelSegmentsAlongL/2 : 1; }
 
-    private:
+    //! Number of stored segments along W (half of the pixel segments thanks to the symmetry)
+    inline unsigned int getStoredSegmentsAlongW() const { return integPixelSegmentsAlongW > 0 ? integPixelSegmentsAlongW/2 : 1; }
 
+    //! Number of stored segments along H (the point at the layer bottom has its own segment)
+    inline unsigned int getStoredSegmentsAlongH() const { return integPixelSegmentsAlongH + 1; }
 
-    //! For integration-results storage - number of segments/divisions of ONE pixel 
-    unsigned int integPixelSegmentsAlongL, integPixelSegmentsAlongW, integPixelSegmentsAlongH;
+    //! Number of results already stored in the table
+    inline unsigned long int getNumberOfStoredResults() const
+      {
+        unsigned long int n = 0;
+        for ( size_t i = 0; i < integResultsTable.size(); ++i ) if ( integResultsTable[i] >= 0. ) ++n;
+        return n;
+      }
 
-    //! Map for storing the results of integration
-    /*! Function integSegmentID() is used as a key 
-      map< segmentL*1000000000000 + segmentW*1000000000 + segmentH*1000000 + pixelL*1000 + pixelW , charge> 
+    //! Write the table of integration results to a binary file
+    inline bool writeToFile(const std::string & filename) const
+      {
+        std::ofstream fout(filename.c_str(), std::ios::binary);
+        if ( !fout )
+          {
+            std::cout << "Cannot open integration storage file " << filename << " for writing!" << std::endl;
+            return false;
+          }
+        unsigned int header[6] = { fileVersion, integPixelSegmentsAlongL, integPixelSegmentsAlongW, integPixelSegmentsAlongH, integPixelsAlongL, integPixelsAlongW };
+        unsigned long int tableSize = integResultsTable.size();
+        fout.write(fileMagic(), 8);
+        fout.write(reinterpret_cast< const char* >(header), sizeof(header));
+        fout.write(reinterpret_cast< const char* >(&responseParameters), sizeof(responseParameters));
+        fout.write(reinterpret_cast< const char* >(&tableSize), sizeof(tableSize));
+        if ( tableSize > 0 ) fout.write(reinterpret_cast< const char* >(&integResultsTable[0]), tableSize*sizeof(double));
+        return fout.good();
+      }
+
+    //! Read a table of integration results written by writeToFile()
+    /*! The segmentation of this storage is replaced by the one found in
+     *  the file. Returns false (and leaves the storage untouched) if the
+     *  file cannot be read.
      */
-    std::map<unsigned long long int, double> integResultsForSegments;
+    inline bool readFromFile(const std::string & filename)
+      {
+        std::ifstream fin(filename.c_str(), std::ios::binary);
+        if ( !fin )
+          {
+            std::cout << "Cannot open integration storage file " << filename << "!" << std::endl;
+            return false;
+          }
+        char magic[8];
+        unsigned int header[6];
+        ResponseParameters parameters;
+        unsigned long int tableSize = 0;
+        fin.read(magic, 8);
+        fin.read(reinterpret_cast< char* >(header), sizeof(header));
+        fin.read(reinterpret_cast< char* >(&parameters), sizeof(parameters));
+        fin.read(reinterpret_cast< char* >(&tableSize), sizeof(tableSize));
+        if ( !fin || std::memcmp(magic, fileMagic(), 8) != 0 || header[0] != fileVersion )
+          {
+            std::cout << "File " << filename << " is not a valid integration storage file!" << std::endl;
+            return false;
+          }
+        std::vector<double> table(tableSize);
+        if ( tableSize > 0 ) fin.read(reinterpret_cast< char* >(&table[0]), tableSize*sizeof(double));
+        if ( !fin )
+          {
+            std::cout << "Integration storage file " << filename << " is truncated!" << std::endl;
+            return false;
+          }
+        integPixelSegmentsAlongL = header[1];
+        integPixelSegmentsAlongW = header[2];
+        integPixelSegmentsAlongH = header[3];
+        integPixelsAlongL = header[4];
+        integPixelsAlongW = header[5];
+        responseParameters = parameters;
+        integResultsTable.swap(table);
+        if ( integResultsTable.size() != tableSizeForCurrentLayout() )
+          {
+            std::cout << "Integration storage file " << filename << " has an inconsistent table size!" << std::endl;
+            integResultsTable.clear();
+            return false;
+          }
+        return true;
+      }
 
-  };
 
+    private:
 
-//! Key/hash for storage of integration results. Global TDS function
-  inline unsigned long long int integSegmentID(const unsigned int segmentL, const unsigned int segmentW, const unsigned int segmentH, const unsigned int pixelL, const unsigned int pixelW)
+    //! Parameters the stored integration results depend on
+    struct ResponseParameters
     {
-      if(0)
+      double pixelLength, pixelWidth, height, lambda, reflectedContribution;
+      unsigned int detectorTypeHash;
+      ResponseParameters() : pixelLength(0.), pixelWidth(0.), height(0.), lambda(0.), reflectedContribution(0.), detectorTypeHash(0) { }
+      bool operator==(const ResponseParameters & other) const
       {
-      std::cout << " W " <<  pixelW << std::endl;
-      std::cout << " LW " <<  pixelL*1000 + pixelW << std::endl;
-      std::cout << " HLW " <<  segmentH << " = " << segmentH*1000000ULL << " " << pixelL*1000  << " " << pixelW << std::endl;
-      std::cout << " WHLW " <<  segmentW*1000000000ULL + segmentH*1000000ULL + pixelL*1000 + pixelW << std::endl;
-      std::cout << " LWHLW " << segmentL*1000000000000ULL + segmentW*1000000000ULL + segmentH*1000000ULL + pixelL*1000 + pixelW << std::endl;
+        return pixelLength == other.pixelLength && pixelWidth == other.pixelWidth && height == other.height &&
+          lambda == other.lambda && reflectedContribution == other.reflectedContribution && detectorTypeHash == other.detectorTypeHash;
       }
+    };
 
-      return segmentL*1000000000000ULL + segmentW*1000000000ULL + segmentH*1000000ULL + pixelL*1000 + pixelW;
-    }
-  
+    //! Prepare the table for the given response parameters and integration range
+    /*! Results already stored (or read from file) are kept if they were
+     *  obtained with the same parameters, otherwise the table is reset.
+     */
+    inline void configure(const ResponseParameters & parameters, const unsigned int pixelsAlongL, const unsigned int pixelsAlongW)
+      {
+        if ( !integResultsTable.empty() && parameters == responseParameters &&
+             pixelsAlongL == integPixelsAlongL && pixelsAlongW == integPixelsAlongW ) return;
+
+        if ( !integResultsTable.empty() )
+          {
+            std::cout << "Integration storage was filled with different parameters, it is reset!" << std::endl;
+          }
+        responseParameters = parameters;
+        integPixelsAlongL = pixelsAlongL;
+        integPixelsAlongW = pixelsAlongW;
+        integResultsTable.assign(tableSizeForCurrentLayout(), -1.);
+      }
+
+    inline unsigned long int tableSizeForCurrentLayout() const
+      {
+        return static_cast< unsigned long int >(getStoredSegmentsAlongL()) * getStoredSegmentsAlongW() * getStoredSegmentsAlongH() * integPixelsAlongL * integPixelsAlongW;
+      }
+
+    inline unsigned long int tableIndex(const unsigned int segmentL, const unsigned int segmentW, const unsigned int segmentH, const unsigned int pixelL, const unsigned int pixelW) const
+      {
+        return ( ( ( static_cast< unsigned long int >(segmentL) * getStoredSegmentsAlongW() + segmentW ) * getStoredSegmentsAlongH() + segmentH ) * integPixelsAlongL + pixelL ) * integPixelsAlongW + pixelW;
+      }
+
+    static const char * fileMagic() { return "TDSINTEG"; }
+    static const unsigned int fileVersion = 1;
+
+    //! For integration-results storage - number of segments/divisions of ONE pixel 
+    unsigned int integPixelSegmentsAlongL, integPixelSegmentsAlongW, integPixelSegmentsAlongH;
+
+    //! Number of neighbour pixels considered in the integration (integMaxNumberPixelsAlongL/W)
+    unsigned int integPixelsAlongL, integPixelsAlongW;
+
+    //! Parameters the stored results were obtained with
+    ResponseParameters responseParameters;
+
+    //! Dense table of integration results, -1 for results not yet computed
+    /*! Indexed by tableIndex(segmentL, segmentW, segmentH, pixelL, pixelW)
+     */
+    std::vector<double> integResultsTable;
+
+  };
 
 }
 
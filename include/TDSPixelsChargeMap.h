@@ -25,6 +25,7 @@
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <vector>
 #include <iterator>
 #include <string>
 #include <cmath>
@@ -297,6 +298,25 @@ namespace TDS {
 
     void update(const TDSStep & step);
 
+    //! Add charge contributions of many steps to pixels
+    /*! Same as calling update(const TDSStep &) for every step, but the
+     *  contributions of all the steps are first accumulated in a dense
+     *  buffer covering the pixels they reach and only then added to the
+     *  pixels' charge map, once per pixel. Steps of one track through the
+     *  sensor should be passed together.
+     */
+    void update(const std::vector<TDSStep> & steps);
+
+    //! Fill the whole integration storage in advance
+    /*! All segments of the attached integration storage are integrated
+     *  at their centre, so that later calls of update() never run the
+     *  numerical integration. Together with
+     *  TDSIntegrationStorage::writeToFile() and
+     *  TDSIntegrationStorage::readFromFile() the table has to be
+     *  computed only once for a given sensor type.
+     */
+    void fillIntegrationStorage();
+
 
     //! Print collected charges to ASCII file
 
@@ -594,6 +614,26 @@ namespace TDS {
     TDSIntegrationStorage * integrationStorage;
     bool useIntegrationStorage;
 
+    // Make sure the integration storage is set up for the current parameters
+    void prepareIntegrationStorage();
+
+    // Split a step into integration points. Returns the number of points
+    // and sets the point before the first one, the distance between the
+    // points and the charge per point.
+    unsigned int prepareStepIntegration(const TDSStep & step, double startPoint[3], double & integStep, double & integChargePerStep) const;
+
+    // Fraction of the charge of one point collected in each of the
+    // pixels [pointIMin,pointIMax]x[pointJMin,pointJMax] around it, stored
+    // in pointResponse (W index running fastest). Returns false if the
+    // point is outside of the sensitive volume.
+    bool integratePoint(const double currentPoint[3]);
+
+    unsigned long int pointIMin, pointIMax, pointJMin, pointJMax;
+    std::vector<double> pointResponse;
+
+    // Dense charge buffer used by update(const std::vector<TDSStep> &)
+    std::vector<double> batchCharge;
+
 
     // Integration part variables (GSL - C library)
     const gsl_rng_type *gsl_T;
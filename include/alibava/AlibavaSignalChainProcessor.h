@@ -0,0 +1,169 @@
+/*
+ * Fused pedestal subtraction, common mode correction and charge
+ * calibration for alibava data
+ *  (2015 DESY)
+ */
+
+#ifndef ALIBAVASIGNALCHAINPROCESSOR_H
+#define ALIBAVASIGNALCHAINPROCESSOR_H 1
+
+// alibava includes ".h"
+#include "AlibavaBaseProcessor.h"
+#include "ALIBAVA.h"
+
+// marlin includes ".h"
+#include "marlin/Processor.h"
+
+// lcio includes <.h>
+#include <IMPL/LCRunHeaderImpl.h>
+#include <IMPL/TrackerDataImpl.h>
+
+// system includes <>
+#include <string>
+#include <map>
+
+
+namespace alibava {
+
+	//! Fused alibava signal chain processor for Marlin.
+	/*! This processor replaces the chain
+	 *  AlibavaPedestalSubtraction -> AlibavaConstantCommonModeProcessor
+	 *  -> AlibavaCommonModeSubtraction (-> charge calibration) with a
+	 *  single pass over every chip. The per chip constants (pedestal,
+	 *  channel mask and gain) are unpacked once per run into contiguous
+	 *  arrays of ALIBAVA::NOOFCHANNELS floats, and every event is then
+	 *  processed with branch free loops over these arrays, which the
+	 *  compiler can turn into SIMD code. No intermediate collection is
+	 *  created: the only output is one TrackerData collection holding
+	 *  the pedestal, common mode subtracted and (optionally) calibrated
+	 *  signal of every selected chip.
+	 *
+	 *  The common mode is computed in the same way as in
+	 *  AlibavaConstantCommonModeProcessor: the mean of the unmasked
+	 *  channels is calculated _Niteration times, every iteration
+	 *  excluding the channels deviating from the previous mean by more
+	 *  than _NoiseDeviation times the previous spread. Masked channels
+	 *  are set to zero in the output, exactly as in the individual
+	 *  processors.
+	 *
+	 *  If a charge calibration file is given, the charge calibration
+	 *  values are used as multiplicative factors per channel, otherwise
+	 *  the signal stays in ADC counts.
+	 */
+
+	class AlibavaSignalChainProcessor:public alibava::AlibavaBaseProcessor   {
+
+	public:
+
+
+		//! Returns a new instance of AlibavaSignalChainProcessor
+		/*! This method returns an new instance of the this processor.  It
+		 *  is called by Marlin execution framework and it shouldn't be
+		 *  called/used by the final user.
+		 *
+		 *  @return a new AlibavaSignalChainProcessor.
+		 */
+		virtual Processor * newProcessor () {
+			return new AlibavaSignalChainProcessor;
+		}
+
+		//! Default constructor
+		AlibavaSignalChainProcessor ();
+
+		//! Called at the job beginning.
+		/*! This is executed only once in the whole execution. It prints
+		 *  out the processor parameters and reads the global channel
+		 *  masking and event skipping parameters.
+		 */
+		virtual void init ();
+
+		//! Called for every run.
+		/*! Reads the chip selection from the run header, loads the
+		 *  pedestal and (if requested) the charge calibration values
+		 *  and unpacks them into the per chip constant arrays.
+		 *
+		 *  @param run the LCRunHeader of the this current run
+		 */
+		virtual void processRunHeader (LCRunHeader * run);
+
+		//! Called every event
+		/*! Applies pedestal subtraction, common mode correction,
+		 *  masking and charge calibration to every chip of the input
+		 *  collection and stores the result in the output collection.
+		 *
+		 *  @param evt the current LCEvent event as passed by the
+		 *  ProcessMgr
+		 */
+		virtual void processEvent (LCEvent * evt);
+
+
+		//! Check event method
+		/*! Does Nothing
+		 *
+		 */
+		virtual void check (LCEvent * evt);
+
+
+		//! Called after data processing.
+		/*! Prints the number of skipped events.
+		 */
+		virtual void end();
+
+
+		//! Common Mode Calculation Iteration
+		/*! The number of iteration that should be used in common mode
+		 *  calculation. Set to 0 to switch off common mode correction.
+		 */
+		int _Niteration;
+
+		//! Noise Deviation
+		/*! The limit to the deviation of noise. The data exceeds this
+		 *  deviation will be considered as signal and not be included
+		 *  in common mode calculation
+		 */
+		float _NoiseDeviation;
+
+
+	protected:
+
+		//! Per chip constants unpacked into contiguous arrays
+		/*! _weight is 0 for masked channels and 1 otherwise, _gain
+		 *  holds the charge calibration factor (1 if no calibration is
+		 *  applied).
+		 */
+		struct ChipConstants {
+			float _pedestal[ALIBAVA::NOOFCHANNELS];
+			float _weight[ALIBAVA::NOOFCHANNELS];
+			float _gain[ALIBAVA::NOOFCHANNELS];
+		};
+
+		//! Fills _chipConstants from the pedestal, mask and calibration values
+		void prepareChipConstants();
+
+		//! Computes the iterative common mode of a pedestal subtracted chip
+		/*! @param signal pedestal subtracted signal of the chip
+		 *  @param weight channel weights, 0 for masked channels
+		 *  @return the common mode of this chip
+		 */
+		float calculateCommonMode(const float * signal, const float * weight);
+
+		//! Constants of every selected chip, keyed by chip number
+		std::map<int, ChipConstants> _chipConstants;
+
+		//! Pedestal subtracted signal buffer, reused for every chip
+		float _signalBuffer[ALIBAVA::NOOFCHANNELS];
+
+		//! Selection buffer for the common mode iterations
+		float _selectionBuffer[ALIBAVA::NOOFCHANNELS];
+
+		//! Is charge calibration applied
+		bool _applyCalibration;
+
+	};
+
+	//! A global instance of the processor
+	AlibavaSignalChainProcessor gAlibavaSignalChainProcessor;
+
+}
+
+#endif
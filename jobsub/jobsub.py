@@ -327,6 +327,271 @@ def zipLogs(path, filename):
         log.error("Input/Output error: Could not create log and steering file archive ("+os.path.join(path, filename)+".zip"+")!")
 
 
+# Outputs which every shard of a run (--shards) writes to a file of its
+# own: processor type -> list of (parameter name, kind). The kind tells
+# how the files of the shards are merged afterwards.
+shardOutputs = {
+    "LCIOOutputProcessor":            [("LCIOOutputFile", "lcio")],
+    "EUTelOutputProcessor":           [("LCIOOutputFile", "lcio")],
+    "AIDAProcessor":                  [("FileName", "histo")],
+    "EUTelProcessorNoisyPixelFinder": [("HotPixelDBFile", "db")],
+    "EUTelPedestalNoiseProcessor":    [("OutputPedeFile", "db")],
+    "EUTelMille":                     [("BinaryFilename", "mille"), ("PedeSteerfileName", "shard")],
+    "EUTelProcessorGBLAlign":         [("MilleBinaryFilename", "mille"), ("MilleSteeringFilename", "shard")],
+    }
+
+# processors needing all the events of a run in one job
+shardForbidden = ["EUTelAlign", "EUTelDafAlign", "EUTelPedeGEAR"]
+
+# processors whose histograms are added up by the last shard of a run,
+# which then runs after all the other ones
+shardMergedInLast = ["EUTelPreAlign"]
+
+def shardFileName(filename, shard):
+    """ inserts the shard number into a file name, before its extension if it has a known one """
+    import os.path
+    base, ext = os.path.splitext(filename)
+    if ext.lower() in [".slcio", ".root", ".bin", ".txt", ".xml"]:
+        return base+"-shard"+str(shard)+ext
+    return filename+"-shard"+str(shard)
+
+def getSteerParameter(element, name):
+    """ returns the parameter element with the given name of a steering file section, None if not found """
+    for parameter in element.findall("parameter"):
+        if parameter.get("name") == name:
+            return parameter
+    return None
+
+def getSteerValue(parameter):
+    """ value of a steering file parameter, given as attribute or as text """
+    if parameter.get("value") is not None:
+        return parameter.get("value").strip()
+    return (parameter.text or "").strip()
+
+def setSteerValue(parameter, value):
+    """ sets the value of a steering file parameter, in the same form it was given """
+    if parameter.get("value") is not None:
+        parameter.set("value", value)
+    else:
+        parameter.text = " "+value+" "
+
+def shardPreAlign(processor, shard, nShards, offset, count, changed, outputs):
+    """
+    sets up an EUTelPreAlign processor for one shard: all the shards write
+    their correlation histograms to a file of their own, the last one adds
+    up those of the other shards and writes the constants. The events used
+    (Events) are the first ones of the run, as without sharding. Returns
+    None if the processor has no AlignmentConstantLCIOFile parameter.
+    """
+    import os.path
+    import xml.etree.ElementTree as ElementTree
+    def parameter(name, default):
+        element = getSteerParameter(processor, name)
+        if element is None:
+            element = ElementTree.SubElement(processor, "parameter", name=name, value=default)
+        changed.append((element, getSteerValue(element)))
+        return element
+    constantsParameter = getSteerParameter(processor, "AlignmentConstantLCIOFile")
+    if constantsParameter is None:
+        return None
+    constantsFile = getSteerValue(constantsParameter)
+    histogramFile = os.path.splitext(constantsFile)[0]+"-histograms.txt"
+    eventsParameter = parameter("Events", "50000")
+    try:
+        events = int(getSteerValue(eventsParameter))
+    except ValueError:
+        events = 50000
+    setSteerValue(eventsParameter, str(max(0, min(count, events - offset))))
+    if shard == nShards - 1:
+        setSteerValue(parameter("HistogramShardFile", ""), "")
+        setSteerValue(parameter("MergeHistogramShardFiles", ""), " ".join([shardFileName(histogramFile, other) for other in range(shard)]))
+        return processor
+    # only the last shard writes the constants and the GEAR file
+    setSteerValue(parameter("HistogramShardFile", ""), shardFileName(histogramFile, shard))
+    setSteerValue(parameter("MergeHistogramShardFiles", ""), "")
+    setSteerValue(parameter("DumpGEAR", "false"), "false")
+    changed.append((constantsParameter, constantsFile))
+    setSteerValue(constantsParameter, shardFileName(constantsFile, shard))
+    scratch = outputs.setdefault(histogramFile, ("scratch", []))[1]
+    scratch.extend([shardFileName(histogramFile, shard), shardFileName(constantsFile, shard)])
+    return processor
+
+def shardSteering(steeringString, nShards, jobtask):
+    """
+    splits a steering file into nShards steering files, each processing
+    its own range of events and writing its own output files. Returns
+    the list of steering file contents, the list of outputs as
+    (kind, final file name, [shard file names]) and whether the last
+    shard has to run after the other ones, or None if the job cannot
+    be sharded.
+
+    """
+    import xml.etree.ElementTree as ElementTree
+    log = logging.getLogger('jobsub.' + jobtask)
+    try:
+        root = ElementTree.fromstring(steeringString)
+    except Exception, e:
+        log.error("Could not parse the steering file for sharding: "+str(e))
+        return None
+    globalSection = root.find("global")
+    if globalSection is None:
+        log.error("No <global> section in the steering file, cannot shard")
+        return None
+
+    # the events of the run are split evenly; MaxRecordNumber counts the
+    # run header as well, which every shard reads again
+    skipParameter = getSteerParameter(globalSection, "SkipNEvents")
+    maxParameter = getSteerParameter(globalSection, "MaxRecordNumber")
+    try:
+        firstEvent = int(getSteerValue(skipParameter)) if skipParameter is not None else 0
+        nEvents = int(getSteerValue(maxParameter)) - 1 if maxParameter is not None else 0
+    except ValueError:
+        log.error("SkipNEvents and MaxRecordNumber have to be integers for sharding")
+        return None
+    if nEvents <= 0:
+        log.error("Sharding needs the number of events of the run: please set MaxRecordNumber")
+        return None
+    if skipParameter is None:
+        skipParameter = ElementTree.SubElement(globalSection, "parameter", name="SkipNEvents", value="0")
+    eventsPerShard = (nEvents + nShards - 1) / nShards
+
+    # active processors, also those of the groups in the execute section
+    executed = set()
+    execute = root.find("execute")
+    if execute is not None:
+        for element in execute.getiterator("processor"):
+            executed.add(element.get("name"))
+        for element in execute.getiterator("group"):
+            for group in root.findall("group"):
+                if group.get("name") == element.get("name"):
+                    executed.update([p.get("name") for p in group.findall("processor")])
+    processors = [p for p in root.getiterator("processor") if p.get("name") in executed and p.get("type") is not None]
+    for processor in processors:
+        if processor.get("type") in shardForbidden:
+            log.error("Processor "+processor.get("name")+" of type "+processor.get("type")+" needs all the events of the run, cannot shard")
+            return None
+
+    nShards = min(nShards, (nEvents + eventsPerShard - 1) / eventsPerShard)
+    mergedInLast = [p for p in processors if p.get("type") in shardMergedInLast]
+
+    steerings = []
+    outputs = {}
+    for shard in range(nShards):
+        first = firstEvent + shard * eventsPerShard
+        count = min(eventsPerShard, firstEvent + nEvents - first)
+        setSteerValue(skipParameter, str(first))
+        setSteerValue(maxParameter, str(count + 1))
+        changed = []
+        for processor in mergedInLast:
+            if shardPreAlign(processor, shard, nShards, first - firstEvent, count, changed, outputs) is None:
+                log.error("Processor "+processor.get("name")+" has no AlignmentConstantLCIOFile parameter, cannot shard")
+                return None
+        for processor in processors:
+            for name, kind in shardOutputs.get(processor.get("type"), []):
+                parameter = getSteerParameter(processor, name)
+                if parameter is None:
+                    log.warning("Processor "+processor.get("name")+" has no "+name+" parameter, its default file name is shared by all the shards")
+                    continue
+                filename = getSteerValue(parameter)
+                changed.append((parameter, filename))
+                setSteerValue(parameter, shardFileName(filename, shard))
+                if kind == "shard":
+                    continue
+                # file names as written by the processors
+                final, written = filename, shardFileName(filename, shard)
+                if kind in ["lcio", "db"] and not final.lower().endswith(".slcio"):
+                    final, written = final+".slcio", written+".slcio"
+                elif kind == "histo":
+                    final, written = final+".root", written+".root"
+                outputs.setdefault(final, (kind, []))[1].append(written)
+            # the alignment is solved once, from the binaries of all the shards
+            if processor.get("type") in ["EUTelMille", "EUTelProcessorGBLAlign"]:
+                parameter = getSteerParameter(processor, "RunPede")
+                if parameter is None:
+                    parameter = ElementTree.SubElement(processor, "parameter", name="RunPede", value="")
+                changed.append((parameter, getSteerValue(parameter)))
+                setSteerValue(parameter, "false" if processor.get("type") == "EUTelProcessorGBLAlign" else "0")
+        steerings.append(ElementTree.tostring(root))
+        # restore the original values for the next shard
+        for parameter, value in changed:
+            setSteerValue(parameter, value)
+
+    log.info("Run split into "+str(len(steerings))+" shards of "+str(eventsPerShard)+" events")
+    if mergedInLast and len(steerings) > 1:
+        log.info("The last shard adds up the prealignment histograms of the other shards, it runs after them")
+    return steerings, [(kind, final, written) for final, (kind, written) in sorted(outputs.items())], len(mergedInLast) > 0
+
+def mergeShards(outputs, jobtask):
+    """ merges the output files of the shards of a run; returns the number of failures """
+    import os
+    import os.path
+    from subprocess import call
+    log = logging.getLogger('jobsub.' + jobtask)
+    failures = 0
+    for kind, final, written in outputs:
+        written = [f for f in written if os.path.exists(f)]
+        if not written:
+            log.warning("No shard wrote "+final)
+            continue
+        if kind == "mille":
+            # the binaries are read by pede directly, through a manifest
+            manifest = final+".manifest"
+            manifestFile = open(manifest, "w")
+            try:
+                manifestFile.write("\n".join(written)+"\n")
+            finally:
+                manifestFile.close()
+            log.info("Millepede binaries of the shards listed in "+manifest+": give it as BinaryManifest (EUTelMille) or MilleBinaryManifest (EUTelProcessorGBLAlign) to the job running pede")
+            continue
+        if kind == "lcio":
+            cmd = ["lcio_merge_files", final] + written
+        elif kind == "histo":
+            cmd = ["hadd", "-f", final] + written
+        elif kind == "scratch":
+            # written by a shard for the final pass only
+            for f in written:
+                os.remove(f)
+            continue
+        else:
+            cmd = ["pedestalmerge", "--shards", "-o", final] + written
+        if not check_program(cmd[0]):
+            log.error(cmd[0]+" not found in PATH, the shards of "+final+" are left unmerged")
+            failures = failures + 1
+            continue
+        log.info("Merging "+str(len(written))+" shards into "+final)
+        log.debug("Executing: "+" ".join(cmd))
+        if call(cmd) == 0:
+            for f in written:
+                os.remove(f)
+        else:
+            log.error("Merging into "+final+" failed, the shard files are kept")
+            failures = failures + 1
+    return failures
+
+def runShards(basefilenames, jobtask, silent, lastAfterOthers=False):
+    """
+    runs one Marlin process per shard concurrently, the last one after
+    the other ones have finished if lastAfterOthers is set; returns the
+    list of return codes
+    """
+    from threading import Thread
+    rcodes = [None] * len(basefilenames)
+    def runShard(shard):
+        rcodes[shard] = runMarlin(basefilenames[shard], jobtask+".shard"+str(shard), silent)
+    concurrent = len(basefilenames) - 1 if lastAfterOthers else len(basefilenames)
+    threads = [Thread(target=runShard, args=(shard,)) for shard in range(concurrent)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    if concurrent < len(basefilenames):
+        if [rcode for rcode in rcodes[:concurrent] if rcode != 0]:
+            rcodes[concurrent] = -1 # the other shards failed, not run
+        else:
+            runShard(concurrent)
+    return rcodes
+
+
 def main(argv=None):
     """  main routine of jobsub: a tool for EUTelescope job submission to Marlin """
     log = logging.getLogger('jobsub') # set up logging
@@ -383,6 +648,7 @@ def main(argv=None):
     parser.add_argument("jobtask", help="Which task to submit (e.g. convert, hitmaker, align); task names are arbitrary and can be set up by the user; they determine e.g. the config section and default steering file names.")
     parser.add_argument("runs", help="The runs to be analyzed; can be a list of single runs and/or a range, e.g. 1056-1060.", nargs='*')
     parser.add_argument("-g", "--graphic", action="store_true", default=False)
+    parser.add_argument("--shards", type=int, default=1, metavar="N", help="Split each run into N event ranges, processed by N Marlin processes running concurrently, each writing its own output files; the outputs are merged when all of them are done. The number of records of the run, run header included, is taken from MaxRecordNumber.")
     args = parser.parse_args(argv)
 
     #if desired, import the colorer module
@@ -578,22 +844,46 @@ def main(argv=None):
 
         log.debug ("Writing steering file for run number "+runnr)
         basefilename = args.jobtask+"-"+runnr
-        steeringFile = open(basefilename+".xml", "w")
-        try:
-            steeringFile.write(steeringString)
-        finally:
-            steeringFile.close()
+
+        # one steering file per shard, or the one of the run
+        shardOutputFiles = []
+        if args.shards > 1:
+            sharded = shardSteering(steeringString, args.shards, args.jobtask)
+            if sharded is None:
+                return 1
+            steeringStrings, shardOutputFiles, lastShardAfterOthers = sharded
+            basefilenames = [basefilename+"-shard"+str(shard) for shard in range(len(steeringStrings))]
+        else:
+            steeringStrings, basefilenames = [steeringString], [basefilename]
+
+        for shard in range(len(basefilenames)):
+            steeringFile = open(basefilenames[shard]+".xml", "w")
+            try:
+                steeringFile.write(steeringStrings[shard])
+            finally:
+                steeringFile.close()
 
         # bail out if running a dry run
         if args.dry_run:
-            log.info("Dry run: skipping Marlin execution. Steering file written to "+basefilename+'.xml')
-        else:
+            log.info("Dry run: skipping Marlin execution. Steering file written to "+', '.join([b+'.xml' for b in basefilenames]))
+        elif len(basefilenames) == 1:
             rcode = runMarlin(basefilename, args.jobtask, args.silent) # start Marlin execution
             if rcode == 0:
                 log.info("Marlin execution done")
             else:
                 log.error("Marlin returned with error code "+str(rcode))
             zipLogs(parameters["logpath"], basefilename)
+        else:
+            rcodes = runShards(basefilenames, args.jobtask, args.silent, lastShardAfterOthers) # start Marlin executions
+            failed = [str(shard) for shard in range(len(rcodes)) if rcodes[shard] != 0]
+            if failed:
+                log.error("Marlin returned with an error for shard(s) "+', '.join(failed)+", the shards are not merged")
+            else:
+                log.info("Marlin execution of "+str(len(rcodes))+" shards done")
+                if mergeShards(shardOutputFiles, args.jobtask) == 0:
+                    log.info("Shards merged")
+            for shardbasefilename in basefilenames:
+                zipLogs(parameters["logpath"], shardbasefilename)
         
     # return to the prvious signal handler
     signal.signal(signal.SIGINT, prevINTHandler)
@@ -103,9 +103,7 @@ std::string CMSPixelClusteringProcessor::_cluster1_2pxHistoName         = "clust
 std::string CMSPixelClusteringProcessor::_clusterMorepxHistoName        = "clustersMorePixel";
 #endif
 
-static const int NOCLUSTER=-1;
-
-CMSPixelClusteringProcessor::CMSPixelClusteringProcessor () : Processor("CMSPixelClusteringProcessor"), _zsDataCollectionName(""), _clusterCollectionName(""), _iRun(0), _iEvt(0), _isFirstEvent(true), _iClusters(0), _iPlaneClusters(),  _initialClusterCollectionSize(0), _minNPixels(0), _minXDistance(0), _minYDistance(0), _minDiagDistance(0), _minCharge(0), _fillHistos(false), hotPixelCollectionVec(), _hitIndexMapVec(), _noOfDetector(0), _isGeometryReady(false), _sensorIDVec(), _siPlanesParameters(), _siPlanesLayerLayout(), _orderedSensorIDVec(), _histoInfoFileName(""), _hotPixelCollectionName(""), _clusterSpectraNVector(), _clusterSpectraNxNVector(), _aidaHistoMap() {
+CMSPixelClusteringProcessor::CMSPixelClusteringProcessor () : Processor("CMSPixelClusteringProcessor"), _zsDataCollectionName(""), _clusterCollectionName(""), _iRun(0), _iEvt(0), _isFirstEvent(true), _iClusters(0), _iPlaneClusters(),  _initialClusterCollectionSize(0), _minNPixels(0), _minXDistance(0), _minYDistance(0), _minDiagDistance(0), _minCharge(0), _fillHistos(false), _hotPixelMap(0), _noOfDetector(0), _isGeometryReady(false), _sensorIDVec(), _siPlanesParameters(), _siPlanesLayerLayout(), _orderedSensorIDVec(), _histoInfoFileName(""), _hotPixelCollectionName(""), _clusterSpectraNVector(), _clusterSpectraNxNVector(), _aidaHistoMap(), _nThreads(1), _threadPool(0), _planeClusterers() {
 	 _description = "CMSPixelClusteringProcessor is searching clusters in zero suppressed data.";
 
 	registerInputCollection (LCIO::TRACKERDATA, "ZSDataCollectionName", "LCIO converted data files", _zsDataCollectionName, string("zsdata_pixel"));
@@ -122,6 +120,9 @@ CMSPixelClusteringProcessor::CMSPixelClusteringProcessor () : Processor("CMSPixe
 	
     registerOptionalParameter("HotPixelCollectionName","This is the name of the hotpixel collection",
                              _hotPixelCollectionName, static_cast< string > ( "hotpixel" ) );
+
+    registerOptionalParameter("NumberOfThreads","Number of threads used to cluster the sensor planes concurrently. 1 means serial processing, 0 one thread per CPU core",
+                             _nThreads, static_cast< int > ( 1 ) );
                              
 	_isFirstEvent = true;
 	
@@ -147,13 +148,19 @@ void CMSPixelClusteringProcessor::init () {
 	_iClusters = 0;
 	_iPlaneClusters.clear();
 	
-    // reset hotpixel map vectors
-    _hitIndexMapVec.clear();
-    
     _isGeometryReady = false;
+
+    delete _threadPool;
+    _threadPool = new EUTelThreadPool( _nThreads < 0 ? 1 : _nThreads );
+    streamlog_out( MESSAGE4 ) << "Clustering planes with " << _threadPool->size() << " thread(s)" << endl;
   
 }
 
+CMSPixelClusteringProcessor::~CMSPixelClusteringProcessor() {
+	delete _threadPool;
+	for ( size_t i = 0; i < _planeClusterers.size(); ++i ) delete _planeClusterers[i];
+}
+
 void CMSPixelClusteringProcessor::processRunHeader (LCRunHeader * rdr) {
 	streamlog_out( MESSAGE4 ) << "Processing Run Header" << endl;
 	auto_ptr<EUTelRunHeaderImpl> runHeader( new EUTelRunHeaderImpl( rdr ) );
@@ -208,63 +215,6 @@ void CMSPixelClusteringProcessor::initializeGeometry( LCEvent * event ) throw (
 }
 
 
-void CMSPixelClusteringProcessor::initializeHotPixelMapVec(  )
-{
-    streamlog_out( MESSAGE5 ) << "CMSPixelClusteringProcessor::initializeHotPixelMapVec, hotPixelCollectionVec size = " << hotPixelCollectionVec->size() << endl;
-    
-    // prepare some decoders
-    CellIDDecoder<TrackerDataImpl> cellDecoder( hotPixelCollectionVec );
-
-    for ( unsigned int iDetector = 0 ; iDetector < hotPixelCollectionVec->size(); iDetector++ )         
-    {
-        if( _hitIndexMapVec.size() < iDetector+1 )            _hitIndexMapVec.resize(iDetector+1);
-
-        TrackerDataImpl * hotData = dynamic_cast< TrackerDataImpl * > ( hotPixelCollectionVec->getElementAt( iDetector ) );
-        unsigned int sensorID            = static_cast< unsigned int > ( cellDecoder( hotData )["sensorID"] );
- 
- 
-        if ( _layerIndexMap.find( sensorID ) == _layerIndexMap.end()   )
-        {
-	  streamlog_out( WARNING5 ) << "sensor " << sensorID << " not found in the present Data, so skip the hotPixel info for this sensor " << endl;
-	  continue;
-        }
-       
-        // prepare the matrix decoder
-        EUTelMatrixDecoder matrixDecoder( _siPlanesLayerLayout , iDetector );
-
-        // now prepare the EUTelescope interface to sparsified data.  
-        auto_ptr<EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel> > sparseData(new EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel>( hotData ));
-
-        streamlog_out ( MESSAGE1 ) << "Processing hotpixel data on detector " << sensorID << " with "
-                                 << sparseData->size() << " pixels " << endl;
-        
-        for ( unsigned int iPixel = 0; iPixel < sparseData->size(); iPixel++ ) 
-        {
-            // loop over all pixels in the sparseData object.      
-            EUTelGenericSparsePixel *sparsePixel =  new EUTelGenericSparsePixel() ;
-
-            sparseData->getSparsePixelAt( iPixel, sparsePixel );
-            int decoded_XY_index = matrixDecoder.getIndexFromXY( sparsePixel->getXCoord(), sparsePixel->getYCoord() ); // unique pixel index !!
-
-            streamlog_out ( DEBUG5 )   << " iPixel " << iPixel << " idet " << iDetector << " decoded_XY_index " << decoded_XY_index << endl;
-            
-            if( _hitIndexMapVec[iDetector].find( decoded_XY_index ) == _hitIndexMapVec[iDetector].end() )
-            {
-                _hitIndexMapVec[iDetector].insert ( make_pair ( decoded_XY_index, EUTELESCOPE::FIRINGPIXEL ) );               
-                streamlog_out ( DEBUG5 ) 
-                    << "adding hot pixel " << " Det." << iDetector << " [" << sparsePixel->getXCoord() << " "<< sparsePixel->getYCoord() << "]" << " status : " << EUTELESCOPE::FIRINGPIXEL << endl;
-              }
-              else
-              {
-                  streamlog_out ( ERROR5 ) << "hot pixel [index " << decoded_XY_index << "] reoccered ?!" << endl;
-              }
-           
-        }
-  }
-    
-}
-
-
 void CMSPixelClusteringProcessor::modifyEvent( LCEvent * /* event */ ){
   return;
 }
@@ -283,17 +233,8 @@ void CMSPixelClusteringProcessor::processEvent (LCEvent * event) {
 	 if ( !_isGeometryReady ) {
 		initializeGeometry( event ) ;
 		
-		hotPixelCollectionVec = 0;
-        try 
-        {
-            hotPixelCollectionVec = static_cast< LCCollectionVec* >  (event->getCollection( _hotPixelCollectionName )) ;
-            initializeHotPixelMapVec();
-            streamlog_out ( MESSAGE5 ) << "hotPixelCollectionName: " << _hotPixelCollectionName.c_str() << " found " << endl;
-        } 
-        catch (lcio::DataNotAvailableException& e ) 
-        {
-            streamlog_out ( MESSAGE5 ) << "No hot pixel DB collection (" << _hotPixelCollectionName << ") found in the event" << endl;
-        }
+		_hotPixelMap = &EUTelHotPixelMap::getInstance( _hotPixelCollectionName );
+		_hotPixelMap->load( event );
 	}
 	
 	
@@ -324,7 +265,12 @@ void CMSPixelClusteringProcessor::processEvent (LCEvent * event) {
 
 	
     // Start the clustering...	
-	Clustering(evt, clusterCollection);
+	try {
+		Clustering(evt, clusterCollection);
+	} catch ( ... ) {
+		if ( ! clusterCollectionExists ) delete clusterCollection;
+		throw;
+	}
 	
 	
 	// If we found some clusters (event not empty), we add the collection
@@ -351,6 +297,137 @@ void CMSPixelClusteringProcessor::processEvent (LCEvent * event) {
 }
 
 
+CMSPixelClusteringProcessor::PlaneClusterer::PlaneClusterer() :
+	_zsData(0),
+	_hotPixels(0),
+	_minXDistance(1),
+	_minYDistance(1),
+	_minDiagDistance(-1),
+	_pixels(),
+	_parent(),
+	_label(),
+	_grid(),
+	_gridInUse(false),
+	_clusterPixels(),
+	_clusterStart() {
+}
+
+void CMSPixelClusteringProcessor::PlaneClusterer::setInput( TrackerDataImpl * zsData, const EUTelHotPixelMap::SensorMap * hotPixels,
+                                                             int minXDistance, int minYDistance, int minDiagDistance ) {
+	_zsData = zsData;
+	_hotPixels = hotPixels;
+	_minXDistance = minXDistance;
+	_minYDistance = minYDistance;
+	_minDiagDistance = minDiagDistance;
+}
+
+int CMSPixelClusteringProcessor::PlaneClusterer::findRoot( int iPixel ) {
+	while ( _parent[iPixel] != iPixel ) {
+		_parent[iPixel] = _parent[ _parent[iPixel] ];
+		iPixel = _parent[iPixel];
+	}
+	return iPixel;
+}
+
+void CMSPixelClusteringProcessor::PlaneClusterer::unite( int aPixel, int bPixel ) {
+	int aRoot = findRoot( aPixel );
+	int bRoot = findRoot( bPixel );
+	if ( aRoot < bRoot ) _parent[bRoot] = aRoot;
+	else if ( bRoot < aRoot ) _parent[aRoot] = bRoot;
+}
+
+void CMSPixelClusteringProcessor::PlaneClusterer::run() {
+
+	// A previous run that did not finish may have left cells filled
+	if ( _gridInUse ) {
+		std::fill( _grid.begin(), _grid.end(), -1 );
+		_gridInUse = false;
+	}
+
+	_pixels.clear();
+	_clusterPixels.clear();
+	_clusterStart.clear();
+
+	// Read the hit pixels of the plane, dropping the hot ones
+	EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel> pixelData( _zsData );
+	_pixels.reserve( pixelData.size() );
+	EUTelGenericSparsePixel pixel;
+	for ( unsigned int iPixel = 0; iPixel < pixelData.size(); iPixel++ ) {
+		pixelData.getSparsePixelAt( iPixel, &pixel );
+		if ( _hotPixels && _hotPixels->isHot( pixel.getXCoord(), pixel.getYCoord() ) ) continue;
+		_pixels.push_back( pixel );
+	}
+
+	const int nPixels = _pixels.size();
+	if ( nPixels == 0 ) return;
+
+	// Bounding box of the hit pixels
+	int xMin = _pixels[0].getXCoord(), xMax = xMin;
+	int yMin = _pixels[0].getYCoord(), yMax = yMin;
+	for ( int i = 1; i < nPixels; ++i ) {
+		xMin = std::min< int >( xMin, _pixels[i].getXCoord() );
+		xMax = std::max< int >( xMax, _pixels[i].getXCoord() );
+		yMin = std::min< int >( yMin, _pixels[i].getYCoord() );
+		yMax = std::max< int >( yMax, _pixels[i].getYCoord() );
+	}
+	const int nX = xMax - xMin + 1;
+	const int nY = yMax - yMin + 1;
+
+	// The grid is only ever grown and all its cells are -1 between two
+	// calls, so that it never has to be cleared completely
+	if ( _grid.size() < static_cast< size_t >( nX ) * nY ) _grid.resize( static_cast< size_t >( nX ) * nY, -1 );
+	_gridInUse = true;
+
+	_parent.resize( nPixels );
+	for ( int i = 0; i < nPixels; ++i ) _parent[i] = i;
+
+	// Fill the grid, pixels read out twice are merged directly
+	for ( int i = 0; i < nPixels; ++i ) {
+		int & cell = _grid[ ( _pixels[i].getXCoord() - xMin ) + ( _pixels[i].getYCoord() - yMin ) * nX ];
+		if ( cell < 0 ) cell = i;
+		else unite( i, cell );
+	}
+
+	// Merge every pixel with its neighbours. Only half of the window is
+	// scanned, the other half is covered when the neighbour is visited.
+	for ( int i = 0; i < nPixels; ++i ) {
+		const int x = _pixels[i].getXCoord() - xMin;
+		const int y = _pixels[i].getYCoord() - yMin;
+		for ( int dy = 0; dy <= _minYDistance && y + dy < nY; ++dy ) {
+			for ( int dx = -_minXDistance; dx <= _minXDistance; ++dx ) {
+				if ( dy == 0 && dx <= 0 ) continue;
+				if ( x + dx < 0 || x + dx >= nX ) continue;
+				// diagonal partners further apart than _minDiagDistance are not neighbours
+				if ( _minDiagDistance != -1 && dx != 0 && dy != 0 && std::max( abs(dx), dy ) > _minDiagDistance ) continue;
+				const int j = _grid[ ( x + dx ) + ( y + dy ) * nX ];
+				if ( j >= 0 ) unite( i, j );
+			}
+		}
+	}
+
+	// Number the clusters in the order of their first pixel and sort the
+	// pixels by cluster, keeping the read out order within a cluster
+	_label.assign( nPixels, -1 );
+	int nClusters = 0;
+	for ( int i = 0; i < nPixels; ++i ) {
+		int root = findRoot( i );
+		if ( _label[root] < 0 ) _label[root] = nClusters++;
+		_label[i] = _label[root];
+	}
+
+	_clusterStart.assign( nClusters + 1, 0 );
+	for ( int i = 0; i < nPixels; ++i ) ++_clusterStart[ _label[i] + 1 ];
+	for ( int c = 0; c < nClusters; ++c ) _clusterStart[c + 1] += _clusterStart[c];
+
+	std::vector< unsigned int > fill( _clusterStart.begin(), _clusterStart.end() - 1 );
+	_clusterPixels.resize( nPixels );
+	for ( int i = 0; i < nPixels; ++i ) _clusterPixels[ fill[ _label[i] ]++ ] = _pixels[i];
+
+	// Leave the grid empty for the next call
+	for ( int i = 0; i < nPixels; ++i ) _grid[ ( _pixels[i].getXCoord() - xMin ) + ( _pixels[i].getYCoord() - yMin ) * nX ] = -1;
+	_gridInUse = false;
+}
+
 void CMSPixelClusteringProcessor::Clustering(LCEvent * evt, LCCollectionVec * clusterCollection) {
 	
 	//Data Input
@@ -360,14 +437,9 @@ void CMSPixelClusteringProcessor::Clustering(LCEvent * evt, LCCollectionVec * cl
 	//Data Output
     CellIDEncoder< TrackerPulseImpl > zsDataEncoder ( "sensorID:5,clusterID:12,xSeed:9,ySeed:10,xCluSize:9,yCluSize:9,type:5", clusterCollection );	
 
-    LCCollectionVec * sparseClusterCollectionVec = NULL;
-    sparseClusterCollectionVec =  new LCCollectionVec(LCIO::TRACKERDATA);
-	  
-    CellIDEncoder<TrackerDataImpl> idClusterEncoder( "sensorID:5,clusterID:12,sparsePixelType:5,type:6", sparseClusterCollectionVec  );
-    
-    
-	
-	// One loop for each sensor plane
+	// Hand every plane with generic sparse pixels to its clusterer
+	std::vector< unsigned int > planeSensorID;
+	std::vector< PlaneClusterer * > planeClusterer;
 	for ( unsigned int i = 0 ; i < zsInputCollectionVec->size(); i++ ) {
 		TrackerDataImpl * zsData = dynamic_cast< TrackerDataImpl * > ( zsInputCollectionVec->getElementAt( i ) );
 		SparsePixelType   type   = static_cast<SparsePixelType> ( static_cast<int> (cellDecoder( zsData )["sparsePixelType"]) );
@@ -375,176 +447,94 @@ void CMSPixelClusteringProcessor::Clustering(LCEvent * evt, LCCollectionVec * cl
 		unsigned int sensorID              = static_cast<unsigned int > ( cellDecoder( zsData )["sensorID"] );
 		streamlog_out ( DEBUG5 ) << "evt " << evt->getEventNumber() << " SensorID " << sensorID << endl;
 
-        // prepare the matrix decoder
-        EUTelMatrixDecoder matrixDecoder( _siPlanesLayerLayout , sensorID );
-		
-		if (type == kEUTelGenericSparsePixel  ) {
-		    auto_ptr<EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel> > pixelData( new EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel>( zsData ));
-			streamlog_out ( DEBUG5 ) << "Processing data on detector " << sensorID << ", " << pixelData->size() << " pixels " << endl;
-
-			// Loop over all pixels in the sparseData object.
-			std::vector<EUTelGenericSparsePixel*> PixelVec;
-			EUTelGenericSparsePixel Pixel;
-
-			 //Push all single Pixels of one plane in the PixelVec
-			for ( unsigned int iPixel = 0; iPixel < pixelData->size(); iPixel++ ) {
-				pixelData->getSparsePixelAt( iPixel, &Pixel);
-
-                // HotPixel treatment: check if we read a hotpixel db:
-				if(_hitIndexMapVec.size() > sensorID) {
-                    // Now remove HotPixels
-                    int index = matrixDecoder.getIndexFromXY( Pixel.getXCoord(), Pixel.getYCoord() );
-                    if( _hitIndexMapVec[sensorID].find( index ) != _hitIndexMapVec[sensorID].end() )
-                    {
-                        streamlog_out ( DEBUG5 ) << "Detector " << sensorID << " Pixel " << Pixel.getXCoord() << " " << Pixel.getYCoord() << " -- HOTPIXEL, skipping... " << endl;
-                        continue;
-                    }
-                }
+		if ( type != kEUTelGenericSparsePixel ) continue;
 
-				PixelVec.push_back(new EUTelGenericSparsePixel(Pixel));
-			}
-			
-			streamlog_out ( DEBUG5 ) << "Hit Pixels: " << PixelVec.size() << endl;
-			
-			/* --- Here the real clustering happens --- */
-			 int nClusters = 0;
-			std::vector<int> clusterNumber;
+		if ( _planeClusterers.size() <= planeClusterer.size() ) _planeClusterers.push_back( new PlaneClusterer );
+		PlaneClusterer * clusterer = _planeClusterers[ planeClusterer.size() ];
 
-			if (!PixelVec.empty()) clusterNumber.assign(PixelVec.size(), NOCLUSTER);
-			
-			
-			streamlog_out( DEBUG5 ) << "Starting with clustering..." << endl;
-			if (PixelVec.size() > 1) {
-				//Now compare all pixel in one plane with each other
-				for ( unsigned int aPixel=0;aPixel < PixelVec.size();++aPixel) {
-					for ( unsigned int bPixel=aPixel+1; bPixel < PixelVec.size(); ++bPixel) {
-						EUTelGenericSparsePixel *aPix = PixelVec.at(aPixel);
-						EUTelGenericSparsePixel *bPix = PixelVec.at(bPixel);
-						int xDist = abs( aPix->getXCoord() - bPix->getXCoord() );
-						int yDist = abs( aPix->getYCoord() - bPix->getYCoord() );
-						
-						if ( ( xDist <= _minXDistance) && (yDist <= _minYDistance)  ) { // This means they are neighbours in x-direction && this means they are neighbours in y-direction
-							bool skipPixel = false;
-							if (_minDiagDistance != -1) {
-								bool areDiagonalPartners =  (xDist != 0 && yDist != 0);  // If true then these pixels are diagonal partners
-								int diagDist = max(xDist,yDist);
-								if (areDiagonalPartners && diagDist > _minDiagDistance) skipPixel = true;
-							}
-						
-							if (skipPixel == false) {
-								
-								if ( (clusterNumber.at(aPixel) == NOCLUSTER) && clusterNumber.at(bPixel) == NOCLUSTER) { // None of these pixels have been assigned to a cluster
-									++nClusters;
-									clusterNumber.at(aPixel) = nClusters;
-									clusterNumber.at(bPixel) = nClusters;
-									streamlog_out ( DEBUG5 ) << "assigning clusternumber: " << nClusters << endl;
-								}else if ( (clusterNumber.at(aPixel) == NOCLUSTER) && clusterNumber.at(bPixel) != NOCLUSTER) { 
-								    // b was assigned already, a not
-									clusterNumber.at(aPixel) = clusterNumber.at(bPixel);
-								}else if ( (clusterNumber.at(aPixel) != NOCLUSTER) && clusterNumber.at(bPixel) == NOCLUSTER) { 
-								    // a was assigned already, b not
-									clusterNumber.at(bPixel) = clusterNumber.at(aPixel);
-								}else { 
-								    // Both pixels have a clusternumber already
-									int min = std::min(clusterNumber.at(aPixel), clusterNumber.at(bPixel));
-									clusterNumber.at(aPixel) = min;
-									clusterNumber.at(bPixel) = min;
-								}
-							} else { // These pixels are not neighboured due to diagonal cut
-								if ( clusterNumber.at(aPixel) == NOCLUSTER ) {
-									++nClusters;
-									clusterNumber.at(aPixel) = nClusters;
-								}
-								if ( clusterNumber.at(bPixel) == NOCLUSTER ) {
-									++nClusters;
-									clusterNumber.at(bPixel) = nClusters;
-								}
-							}
-						} else { // These pixels are not neighboured
-							if ( clusterNumber.at(aPixel) == NOCLUSTER ) {
-								++nClusters;
-								clusterNumber.at(aPixel) = nClusters;
-							}
-							if ( clusterNumber.at(bPixel) == NOCLUSTER ) {
-								++nClusters;
-								clusterNumber.at(bPixel) = nClusters;
-							}
-						}
-					}
-				}
-			} else { 
-			    // You can't use the clustering algorithm with only one pixel
-				if (PixelVec.size() == 1) clusterNumber.at(0) = 1;
-			}
-			
-			// It happens, that nCluster is higher that the real number of clusters, as a clusternumber can be deleted in the else-block, so lets correct it
-			std::set<int> clusterSet;
-			for (unsigned int i=0; i<PixelVec.size();++i) {
-				clusterSet.insert(clusterNumber.at(i));
-				if ( clusterNumber.at(i) == NOCLUSTER) {streamlog_out(MESSAGE1) << "Cluster with ID -1 in " << i << endl;}
+		// HotPixel treatment: check if we read a hotpixel db
+		const EUTelHotPixelMap::SensorMap * hotPixels = _hotPixelMap != 0 ? _hotPixelMap->getSensorMap( sensorID ) : 0;
+
+		clusterer->setInput( zsData, hotPixels, _minXDistance, _minYDistance, _minDiagDistance );
+		planeClusterer.push_back( clusterer );
+		planeSensorID.push_back( sensorID );
+		_threadPool->submit( clusterer );
+	}
+	_threadPool->wait();
+
+	// Only allocated once the planes are done, wait() rethrows the exception of a failed plane
+    LCCollectionVec * sparseClusterCollectionVec = NULL;
+    sparseClusterCollectionVec =  new LCCollectionVec(LCIO::TRACKERDATA);
+	  
+    CellIDEncoder<TrackerDataImpl> idClusterEncoder( "sensorID:5,clusterID:12,sparsePixelType:5,type:6", sparseClusterCollectionVec  );
+
+	/* --- Push back one Collection per Cluster, in plane order --- */
+	for ( size_t iPlane = 0; iPlane < planeClusterer.size(); ++iPlane ) {
+		const PlaneClusterer * clusterer = planeClusterer[iPlane];
+		unsigned int sensorID = planeSensorID[iPlane];
+		const std::vector< EUTelGenericSparsePixel > & pixels = clusterer->getClusterPixels();
+
+		streamlog_out( DEBUG5 ) << "Hit Pixels: " << pixels.size() << endl;
+		if ( clusterer->getNumberOfClusters() != 0 ) streamlog_out( DEBUG5 ) << "Found " << clusterer->getNumberOfClusters() << " clusters in sensor " << sensorID<< endl;
+
+		for ( unsigned int iCluster = 0; iCluster < clusterer->getNumberOfClusters(); ++iCluster ) {
+			unsigned int first = clusterer->getClusterStart( iCluster );
+			unsigned int last  = clusterer->getClusterStart( iCluster + 1 );
+
+			// Apply the size and charge cuts before creating any LCIO object
+			float charge = 0;
+			for ( unsigned int iPixel = first; iPixel < last; ++iPixel ) charge += pixels[iPixel].getSignal();
+
+            streamlog_out( DEBUG5 ) << "size: " << last - first << ">=" << _minNPixels << " && charge: " << charge << ">=" << _minCharge << endl;
+			if ( (last - first < static_cast< unsigned int >(_minNPixels)) || (charge < static_cast< unsigned int >(_minCharge)) ) continue;
+
+			lcio::TrackerDataImpl * clusterFrame = new lcio::TrackerDataImpl();
+			eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelGenericSparsePixel > pixelCluster(clusterFrame);
+			clusterFrame->chargeValues().reserve( 4 * ( last - first ) );
+			for ( unsigned int iPixel = first; iPixel < last; ++iPixel ) {
+				EUTelGenericSparsePixel pixel( pixels[iPixel] );
+				pixelCluster.addSparsePixel( &pixel );
 			}
-			nClusters = clusterSet.size();
-			
-			
-			if (nClusters != 0) streamlog_out( DEBUG5 ) << "Found " << nClusters << " clusters in sensor " << sensorID<< endl;
-			
-			/* --- Finished Clustering --- */
-			
-			/* --- Push back one Collection per Cluster --- */
-			std::set<int>::iterator it;
-			for (it = clusterSet.begin(); it != clusterSet.end(); ++it) {
-				lcio::TrackerPulseImpl * pulseFrame = new lcio::TrackerPulseImpl();
-				lcio::TrackerDataImpl * clusterFrame = new lcio::TrackerDataImpl();
-				eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelGenericSparsePixel > *pixelCluster = new eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelGenericSparsePixel >(clusterFrame);	
-				for (unsigned int i=0;i< PixelVec.size();i++) {
-					if(clusterNumber.at(i)== *it) { 
-					    // Put only these pixels in that ClusterCollection that belong to that cluster
-						pixelCluster->addSparsePixel(PixelVec.at(i));
-						streamlog_out( DEBUG5 ) << "Adding Pixel " << i << " to cluster " << clusterNumber.at(i) << endl;
-					}
-				}
-	            
-	            streamlog_out( DEBUG5 ) << "size: " << pixelCluster->size() << ">=" << _minNPixels << " && charge: " << pixelCluster->getTotalCharge() << ">=" << _minCharge << endl;
-                if ( (pixelCluster->size() >= static_cast< unsigned int >(_minNPixels)) && (pixelCluster->getTotalCharge() >= static_cast< unsigned int >(_minCharge)) ) {
 
-					float x,y;
-					int xsize,ysize;
-					
-                    pulseFrame->setCharge(pixelCluster->getTotalCharge());
-
-					// This is using analogue hit information:
-					pixelCluster->getCenterOfGravity(x,y);
-					pixelCluster->getClusterSize(xsize,ysize);
-					if (x >= 0 && x <= _siPlanesLayerLayout->getSensitiveNpixelX( _layerIndexMap[ sensorID ] ) && 
-					    y >= 0 && y <= _siPlanesLayerLayout->getSensitiveNpixelY( _layerIndexMap[ sensorID ] )) {
-						streamlog_out( DEBUG5 ) << "Clustervars: ROC" << sensorID << " Cl" << *it << " x" << x << " y" << y << " dx" <<xsize << " dy" << ysize << " " << type << endl;
-						_iClusters++;
-						_iPlaneClusters[sensorID]++;
-
-						int clusterID = *it;
-						zsDataEncoder["sensorID"]      = sensorID;
-						zsDataEncoder["clusterID"]     = clusterID;
-						zsDataEncoder["xSeed"]         = static_cast< long >(x);
-						zsDataEncoder["ySeed"]         = static_cast< long >(y);
-						zsDataEncoder["xCluSize"]      = xsize;
-						zsDataEncoder["yCluSize"]      = ysize;
-						zsDataEncoder["type"]          = static_cast<int>(kEUTelSparseClusterImpl);
-						zsDataEncoder.setCellID(pulseFrame);
-						pulseFrame->setTrackerData(clusterFrame);
-						clusterCollection->push_back(pulseFrame);
-						
-						idClusterEncoder["sensorID"] 		= sensorID;
-						idClusterEncoder["clusterID"] 		= clusterID;
-						idClusterEncoder["sparsePixelType"] 	= static_cast<int>(type);
-						idClusterEncoder["type"] 		= static_cast<int>(kEUTelSparseClusterImpl);
-						idClusterEncoder.setCellID(clusterFrame);
-						sparseClusterCollectionVec->push_back(clusterFrame);
-					}
-					else streamlog_out( DEBUG5 ) << "No cluster: ROC" << sensorID << " Cl" << *it << " x" << x << " y" << y << " dx" <<xsize << " dy" << ysize << " " << type << endl;
+			float x,y;
+			int xsize,ysize;
 
-				}
-            }
-		 }
+			// This is using analogue hit information:
+			pixelCluster.getCenterOfGravity(x,y);
+			pixelCluster.getClusterSize(xsize,ysize);
+			int clusterID = iCluster + 1;
+			if (x >= 0 && x <= _siPlanesLayerLayout->getSensitiveNpixelX( _layerIndexMap[ sensorID ] ) && 
+			    y >= 0 && y <= _siPlanesLayerLayout->getSensitiveNpixelY( _layerIndexMap[ sensorID ] )) {
+				streamlog_out( DEBUG5 ) << "Clustervars: ROC" << sensorID << " Cl" << clusterID << " x" << x << " y" << y << " dx" <<xsize << " dy" << ysize << endl;
+				_iClusters++;
+				_iPlaneClusters[sensorID]++;
+
+				lcio::TrackerPulseImpl * pulseFrame = new lcio::TrackerPulseImpl();
+				pulseFrame->setCharge(charge);
+
+				zsDataEncoder["sensorID"]      = sensorID;
+				zsDataEncoder["clusterID"]     = clusterID;
+				zsDataEncoder["xSeed"]         = static_cast< long >(x);
+				zsDataEncoder["ySeed"]         = static_cast< long >(y);
+				zsDataEncoder["xCluSize"]      = xsize;
+				zsDataEncoder["yCluSize"]      = ysize;
+				zsDataEncoder["type"]          = static_cast<int>(kEUTelSparseClusterImpl);
+				zsDataEncoder.setCellID(pulseFrame);
+				pulseFrame->setTrackerData(clusterFrame);
+				clusterCollection->push_back(pulseFrame);
+				
+				idClusterEncoder["sensorID"] 		= sensorID;
+				idClusterEncoder["clusterID"] 		= clusterID;
+				idClusterEncoder["sparsePixelType"] 	= static_cast<int>(kEUTelGenericSparsePixel);
+				idClusterEncoder["type"] 		= static_cast<int>(kEUTelSparseClusterImpl);
+				idClusterEncoder.setCellID(clusterFrame);
+				sparseClusterCollectionVec->push_back(clusterFrame);
+			}
+			else {
+				streamlog_out( DEBUG5 ) << "No cluster: ROC" << sensorID << " Cl" << clusterID << " x" << x << " y" << y << " dx" <<xsize << " dy" << ysize << endl;
+				delete clusterFrame;
+			}
+		}
 	}
     evt->addCollection( sparseClusterCollectionVec, "original_zsdata" );
 }
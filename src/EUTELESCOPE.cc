@@ -18,6 +18,8 @@
 using namespace eutelescope;
 
 const std::string EUTELESCOPE::GEOFILENAME		= "telescope_geometry.root";
+const std::string EUTELESCOPE::GEOSNAPSHOTFILE		= "GeometrySnapshotFile";
+const std::string EUTELESCOPE::MONITORHEAP		= "MonitorHeap";
 const char *   EUTELESCOPE::HEADERVERSION       = "HeaderVersion";
 const char *   EUTELESCOPE::NOOFEVENT           = "NoOfEvent";
 const char *   EUTELESCOPE::DATATYPE            = "DataType";
@@ -30,36 +30,49 @@ EUTelAPIXTbTrackTuple::EUTelAPIXTbTrackTuple()
   _telZsColName(""),
   _dutZsColName(""),
   _path2file(""),
+  _compressionLevel(1),
+  _basketSize(32000),
+  _writeBatchSize(1000),
+  _asyncWrite(true),
   _DUTIDs(std::vector<int>()),
+  _xSensSize(),
+  _ySensSize(),
   _nRun (0),
   _nEvt (0),
   _runNr(0),
   _evtNr(0),
   _isFirstEvent(false),
-  _file(NULL),
-  _eutracks(NULL),
+  _writer(),
+  _eutracks(0),
   _nTrackParams(0),
-  _xPos(NULL),
-  _yPos(NULL),
-  _dxdz(NULL),
-  _dydz(NULL),
-  _trackIden(NULL),
-  _trackNum(NULL),
-  _chi2(NULL),
-  _ndof(NULL),
-  _zstree(NULL),
+  _nTrackParamsCol(0),
+  _trackEvtCol(0),
+  _xPos(0),
+  _yPos(0),
+  _dxdz(0),
+  _dydz(0),
+  _trackIden(0),
+  _trackNum(0),
+  _chi2(0),
+  _ndof(0),
+  _zstree(0),
   _nPixHits(0),
-  p_col(NULL),
-  p_row(NULL),
-  p_tot(NULL),
-  p_iden(NULL),
-  p_lv1(NULL),
-  _euhits(NULL),
+  _nPixHitsCol(0),
+  _zsEvtCol(0),
+  p_col(0),
+  p_row(0),
+  p_tot(0),
+  p_iden(0),
+  p_lv1(0),
+  _euhits(0),
   _nHits(0),
-  _hitXPos(NULL),
-  _hitYPos(NULL),
-  _hitZPos(NULL),
-  _hitSensorId(NULL)
+  _nHitsCol(0),
+  _hitXPos(0),
+  _hitYPos(0),
+  _hitZPos(0),
+  _hitSensorId(0),
+  _versionTree(0),
+  _versionNo(0)
  {
   //processor description
   _description = "Prepare tbtrack style n-tuple with track fit results" ;
@@ -80,6 +93,18 @@ EUTelAPIXTbTrackTuple::EUTelAPIXTbTrackTuple()
   registerProcessorParameter ("DUTIDs", "Int std::vector containing the IDs of the DUTs",
 		  		_DUTIDs, std::vector<int>());
 
+  registerOptionalParameter ("CompressionLevel", "ROOT compression level of the output file",
+			      _compressionLevel, static_cast<int>(1));
+
+  registerOptionalParameter ("BasketSize", "Basket size in bytes of the n-tuple branches",
+			      _basketSize, static_cast<int>(32000));
+
+  registerOptionalParameter ("WriteBatchSize", "Number of events handed over at once to the n-tuple writer",
+			      _writeBatchSize, static_cast<int>(1000));
+
+  registerOptionalParameter ("AsyncWrite", "Compress and write the n-tuple in a background thread",
+			      _asyncWrite, true);
+
 }
 
 
@@ -135,7 +160,7 @@ void EUTelAPIXTbTrackTuple::processEvent( LCEvent * event )
     		return;
 	}
 
-	//Clear all event info containers
+	//Drop what was left of the previous event if it was not filled
 	clear();
 
 	//try to read in hits (e.g. fitted hits in local frame)	
@@ -157,9 +182,16 @@ void EUTelAPIXTbTrackTuple::processEvent( LCEvent * event )
 	}
  
         //fill the trees	
-	_zstree->Fill();
-	_eutracks->Fill();
-	_euhits->Fill();
+	_writer->setInt( _nPixHitsCol, _nPixHits );
+	_writer->setInt( _zsEvtCol, _nEvt );
+	_writer->fill( _zstree );
+
+	_writer->setInt( _nTrackParamsCol, _nTrackParams );
+	_writer->setInt( _trackEvtCol, _nEvt );
+	_writer->fill( _eutracks );
+
+	_writer->setInt( _nHitsCol, _nHits );
+	_writer->fill( _euhits );
 
 	_isFirstEvent = false;
 }
@@ -167,10 +199,10 @@ void EUTelAPIXTbTrackTuple::processEvent( LCEvent * event )
 void EUTelAPIXTbTrackTuple::end()
 {
 	//write version number
-	_versionNo->push_back(1.1);
-	_versionTree->Fill();
+	_writer->pushDouble( _versionNo, 1.1 );
+	_writer->fill( _versionTree );
 	//Maybe some stats output?
-	_file->Write();
+	_writer->close();
 }
 
 //Read in TrackerHit(Impl) to later dump them
@@ -190,14 +222,14 @@ bool EUTelAPIXTbTrackTuple::readHits( std::string hitColName, LCEvent* event )
   	
 	int nHit = hitCollection->getNumberOfElements();
 	_nHits = nHit;
+
+	UTIL::CellIDDecoder<TrackerHitImpl> hitDecoder ( EUTELESCOPE::HITENCODING );
  
   	for(int ihit=0; ihit< nHit ; ihit++)
        	{
     		TrackerHitImpl* meshit = dynamic_cast<TrackerHitImpl*>( hitCollection->getElementAt(ihit) ) ;
     		const double* pos = meshit->getPosition();	
-    		LCObjectVec clusterVec = (meshit->getRawHits());
 
-		UTIL::CellIDDecoder<TrackerHitImpl> hitDecoder ( EUTELESCOPE::HITENCODING );
     		int sensorID = hitDecoder(meshit)["sensorID"];
 
 		//Only dump DUT hits
@@ -211,10 +243,10 @@ bool EUTelAPIXTbTrackTuple::readHits( std::string hitColName, LCEvent* event )
     		double z = pos[2];
 
 	       	//offset by half sensor/sensitive size
-			_hitXPos->push_back(x + _xSensSize.at(sensorID)/2.0);
-    		_hitYPos->push_back(y + _ySensSize.at(sensorID)/2.0);
-    		_hitZPos->push_back(z);
-    		_hitSensorId->push_back(sensorID);
+			_writer->pushDouble(_hitXPos, x + _xSensSize.at(sensorID)/2.0);
+    		_writer->pushDouble(_hitYPos, y + _ySensSize.at(sensorID)/2.0);
+    		_writer->pushDouble(_hitZPos, z);
+    		_writer->pushInt(_hitSensorId, sensorID);
 	}
 
 	return true;
@@ -243,7 +275,7 @@ bool EUTelAPIXTbTrackTuple::readTracks(LCEvent* event)
        	{
 		lcio::Track* fittrack = dynamic_cast<lcio::Track*>( trackCol->getElementAt(itrack) ) ;
 		
-		std::vector<EVENT::TrackerHit*> trackhits = fittrack->getTrackerHits();
+		const std::vector<EVENT::TrackerHit*>& trackhits = fittrack->getTrackerHits();
 		double chi2 = fittrack->getChi2();
 		double ndof = fittrack->getNdf();
 		double dxdz = fittrack->getOmega();
@@ -259,8 +291,7 @@ bool EUTelAPIXTbTrackTuple::readTracks(LCEvent* event)
 			       	continue;
 		       	}
 
-     			UTIL::CellIDDecoder<TrackerHitImpl> hitDecoder ( EUTELESCOPE::HITENCODING );
-      			int sensorID = hitDecoder(fittedHit)["sensorID"];
+      			int sensorID = hitCellDecoder(fittedHit)["sensorID"];
 
 			//Dump the (fitted) hits for the DUTs
 			if( std::find( _DUTIDs.begin(), _DUTIDs.end(), sensorID) == _DUTIDs.end() )
@@ -275,14 +306,14 @@ bool EUTelAPIXTbTrackTuple::readTracks(LCEvent* event)
       			//double z = pos[2]; //not used!
 			
 				//eutrack tree
-      			_xPos->push_back(x);
-      			_yPos->push_back(y);
-      			_dxdz->push_back(dxdz);
-      			_dydz->push_back(dydz);
-      			_trackIden->push_back(sensorID);
-      			_trackNum->push_back(itrack);
-      			_chi2->push_back(chi2);
-      			_ndof->push_back(ndof);
+      			_writer->pushDouble(_xPos, x);
+      			_writer->pushDouble(_yPos, y);
+      			_writer->pushDouble(_dxdz, dxdz);
+      			_writer->pushDouble(_dydz, dydz);
+      			_writer->pushInt(_trackIden, sensorID);
+      			_writer->pushInt(_trackNum, itrack);
+      			_writer->pushDouble(_chi2, chi2);
+      			_writer->pushDouble(_ndof, ndof);
     		}
   	}
 
@@ -321,11 +352,11 @@ bool EUTelAPIXTbTrackTuple::readZsHits( std::string colName, LCEvent* event)
 			{
 				apixData->getSparsePixelAt( iHit, &apixPixel);
 				_nPixHits++;
-				p_iden->push_back( sensorID );
-				p_row->push_back( apixPixel.getYCoord() );
-				p_col->push_back( apixPixel.getXCoord() );
-				p_tot->push_back( static_cast< int >(apixPixel.getSignal()) );
-				p_lv1->push_back( static_cast< int >(apixPixel.getTime()) );
+				_writer->pushInt( p_iden, sensorID );
+				_writer->pushInt( p_row, apixPixel.getYCoord() );
+				_writer->pushInt( p_col, apixPixel.getXCoord() );
+				_writer->pushInt( p_tot, static_cast< int >(apixPixel.getSignal()) );
+				_writer->pushInt( p_lv1, static_cast< int >(apixPixel.getTime()) );
      		}
     	}
 		else
@@ -339,89 +370,53 @@ bool EUTelAPIXTbTrackTuple::readZsHits( std::string colName, LCEvent* event)
 void EUTelAPIXTbTrackTuple::clear()
 {
 	/* Clear zsdata */
-	p_col->clear();
-	p_row->clear();
-	p_tot->clear();
-	p_iden->clear();
-	p_lv1->clear();
+	_writer->discard( _zstree );
 	_nPixHits = 0;
 	/* Clear hittrack */
-	_xPos->clear();
-	_yPos->clear();
-	_dxdz->clear();
-	_dydz->clear();
-	_trackNum->clear();
-	_trackIden->clear();
-	_chi2->clear();
-	_ndof->clear();
+	_writer->discard( _eutracks );
+	_nTrackParams = 0;
 	//Clear hits
-	_hitXPos->clear();
-	_hitYPos->clear();
-	_hitZPos->clear();
-	_hitSensorId->clear();
+	_writer->discard( _euhits );
+	_nHits = 0;
 }
 
 void EUTelAPIXTbTrackTuple::prepareTree()
 {
-	_file = new TFile(_path2file.c_str(),"RECREATE");
-
-	_xPos = new std::vector<double>();	     
-	_yPos = new std::vector<double>();	   
-	_dxdz = new std::vector<double>();	   
-	_dydz = new std::vector<double>();	   
-	_trackIden  = new std::vector<int>();
-	_trackNum = new std::vector<int>();
-	_chi2 = new std::vector<double>();	   
-	_ndof = new std::vector<double>();    
-
-	p_col = new std::vector<int>();
-	p_row = new std::vector<int>();
-	p_tot = new std::vector<int>();
-	p_iden = new std::vector<int>();
-	p_lv1 = new std::vector<int>();
-
-	_hitXPos = new std::vector<double>();
-	_hitYPos = new std::vector<double>();
-	_hitZPos = new std::vector<double>();
-	_hitSensorId  = new std::vector<int>();
-
-	_versionNo = new std::vector<double>();
-	_versionTree = new TTree("version","version");
-	_versionTree->Branch("no", &_versionNo);
-
-	_euhits = new TTree("fitpoints","fitpoints");
-	_euhits->SetAutoSave(1000000000);
-	
-	_euhits->Branch("nHits", &_nHits);
-	_euhits->Branch("xPos", &_hitXPos);
-	_euhits->Branch("yPos", &_hitYPos);
-	_euhits->Branch("zPos", &_hitZPos);
-	_euhits->Branch("sensorId", &_hitSensorId);
-
-	_zstree = new TTree("rawdata", "rawdata");
-	_zstree->SetAutoSave(1000000000);
-	_zstree->Branch("nPixHits", &_nPixHits);
-	_zstree->Branch("euEvt",    &_nEvt);
-	_zstree->Branch("col",      &p_col);
-	_zstree->Branch("row",      &p_row);
-	_zstree->Branch("tot",      &p_tot);
-	_zstree->Branch("lv1",      &p_lv1);
-	_zstree->Branch("iden",     &p_iden);
+	_writer.reset( new EUTelTupleWriter( _path2file, _compressionLevel, _basketSize,
+	                                     static_cast<unsigned int>( std::max( _writeBatchSize, 1 ) ), _asyncWrite ) );
+
+	_versionTree = _writer->addTree("version","version");
+	_versionNo   = _writer->addColumn(_versionTree, "no", EUTelTupleWriter::kDoubleVector);
+
+	_euhits = _writer->addTree("fitpoints","fitpoints");
+	_nHitsCol    = _writer->addColumn(_euhits, "nHits",    EUTelTupleWriter::kInt);
+	_hitXPos     = _writer->addColumn(_euhits, "xPos",     EUTelTupleWriter::kDoubleVector);
+	_hitYPos     = _writer->addColumn(_euhits, "yPos",     EUTelTupleWriter::kDoubleVector);
+	_hitZPos     = _writer->addColumn(_euhits, "zPos",     EUTelTupleWriter::kDoubleVector);
+	_hitSensorId = _writer->addColumn(_euhits, "sensorId", EUTelTupleWriter::kIntVector);
+
+	_zstree = _writer->addTree("rawdata", "rawdata");
+	_nPixHitsCol = _writer->addColumn(_zstree, "nPixHits", EUTelTupleWriter::kInt);
+	_zsEvtCol    = _writer->addColumn(_zstree, "euEvt",    EUTelTupleWriter::kInt);
+	p_col        = _writer->addColumn(_zstree, "col",      EUTelTupleWriter::kIntVector);
+	p_row        = _writer->addColumn(_zstree, "row",      EUTelTupleWriter::kIntVector);
+	p_tot        = _writer->addColumn(_zstree, "tot",      EUTelTupleWriter::kIntVector);
+	p_lv1        = _writer->addColumn(_zstree, "lv1",      EUTelTupleWriter::kIntVector);
+	p_iden       = _writer->addColumn(_zstree, "iden",     EUTelTupleWriter::kIntVector);
 
 	//Tree for storing all track param info
-	_eutracks = new TTree("tracks", "tracks");
-	_eutracks->SetAutoSave(1000000000);
-	_eutracks->Branch("nTrackParams", &_nTrackParams);
-	_eutracks->Branch("euEvt", &_nEvt);
-	_eutracks->Branch("xPos", &_xPos);
-	_eutracks->Branch("yPos", &_yPos);
-	_eutracks->Branch("dxdz", &_dxdz);
-	_eutracks->Branch("dydz", &_dydz);
-	_eutracks->Branch("trackNum", &_trackNum);
-	_eutracks->Branch("iden", &_trackIden);
-	_eutracks->Branch("chi2", &_chi2);
-	_eutracks->Branch("ndof", &_ndof);
-
-	_euhits->AddFriend(_zstree);
-	_euhits->AddFriend(_eutracks);
+	_eutracks = _writer->addTree("tracks", "tracks");
+	_nTrackParamsCol = _writer->addColumn(_eutracks, "nTrackParams", EUTelTupleWriter::kInt);
+	_trackEvtCol     = _writer->addColumn(_eutracks, "euEvt",        EUTelTupleWriter::kInt);
+	_xPos            = _writer->addColumn(_eutracks, "xPos",         EUTelTupleWriter::kDoubleVector);
+	_yPos            = _writer->addColumn(_eutracks, "yPos",         EUTelTupleWriter::kDoubleVector);
+	_dxdz            = _writer->addColumn(_eutracks, "dxdz",         EUTelTupleWriter::kDoubleVector);
+	_dydz            = _writer->addColumn(_eutracks, "dydz",         EUTelTupleWriter::kDoubleVector);
+	_trackNum        = _writer->addColumn(_eutracks, "trackNum",     EUTelTupleWriter::kIntVector);
+	_trackIden       = _writer->addColumn(_eutracks, "iden",         EUTelTupleWriter::kIntVector);
+	_chi2            = _writer->addColumn(_eutracks, "chi2",         EUTelTupleWriter::kDoubleVector);
+	_ndof            = _writer->addColumn(_eutracks, "ndof",         EUTelTupleWriter::kDoubleVector);
+
+	_writer->addFriend(_euhits, _zstree);
+	_writer->addFriend(_euhits, _eutracks);
 }
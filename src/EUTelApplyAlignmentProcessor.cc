@@ -137,6 +137,7 @@ EUTelApplyAlignmentProcessor::EUTelApplyAlignmentProcessor ()
   _iEvt(0),
   _lookUpTable(),
   _fevent(false),
+  _sensorAlignments(),
   _aidaHistoMap(),
   _siPlanesParameters(NULL),
   _siPlanesLayerLayout(NULL),
@@ -1049,7 +1050,6 @@ void EUTelApplyAlignmentProcessor::RevertGear6D( LCEvent *event)
 }
 
 void EUTelApplyAlignmentProcessor::Direct(LCEvent *event) {
-  UTIL::CellIDDecoder<TrackerHitImpl> hitDecoder ( EUTELESCOPE::HITENCODING );
 
   EUTelEventImpl * evt = static_cast<EUTelEventImpl*> (event);
 
@@ -1129,279 +1129,11 @@ void EUTelApplyAlignmentProcessor::Direct(LCEvent *event) {
     streamlog_out ( DEBUG5 ) << "DIRECT:-----:-----: EUTelApplyAlignmentProcessor::Direct. going to proceeed with " <<  _inputCollectionVec->size() << " hits " << endl;
 
 // go-go
-    for (size_t iHit = 0; iHit < _inputCollectionVec->size(); iHit++) {
-
-      streamlog_out ( DEBUG5 ) << "DIRECT:-----:-----: hit " << iHit << " of  " <<  _inputCollectionVec->size() << " hits " << endl;
-
-      TrackerHitImpl* inputHit = dynamic_cast<TrackerHitImpl*>( _inputCollectionVec->getElementAt(iHit) );
-
-      // now we have to understand which layer this hit belongs to.
-      int sensorID = hitDecoder(inputHit)["sensorID"];
-
-      //find proper alignment colleciton:
-            double alpha = 0.;
-            double beta  = 0.;
-            double gamma = 0.;
-            double offsetX = 0.;
-            double offsetY = 0.;
-            double offsetZ = 0.;
- 
-      // now that we know at which sensor the hit belongs to, we can
-      // get the corresponding alignment constants
-      map< int , int >::iterator  positionIter = _lookUpTable[ _alignmentCollectionName ].find( sensorID );
-
-     streamlog_out( DEBUG5 ) << "DIRECT:-----:-----: iHit [" <<  iHit << "] for sensor  "<<  sensorID << endl;
-     if ( positionIter == _lookUpTable[ _alignmentCollectionName ].end() )
-         {
-          streamlog_out( DEBUG5 ) << "DIRECT:-----:-----: wrong sensorID : " <<  sensorID << " ?? " << endl;
-//          continue; //do nothing as if alignment == 0.
-         }
-      else
-         {
-           EUTelAlignmentConstant * alignment = static_cast< EUTelAlignmentConstant * >  ( _alignmentCollectionVec->getElementAt( positionIter->second ) );
-           streamlog_out( DEBUG5 ) << "DIRECT:-----:-----: iHit [" <<  iHit << "] at "<<  positionIter->second << " found at (EUTelAlignmentConstant*) " << alignment ;
-           streamlog_out( DEBUG5 ) << " with alignment collection name : " << _alignmentCollectionName << endl;
-           alpha   = alignment->getAlpha();
-           beta    = alignment->getBeta();
-           gamma   = alignment->getGamma();
-           offsetX = alignment->getXOffset();
-           offsetY = alignment->getYOffset();
-           offsetZ = alignment->getZOffset();
-         }  
-
-
-      // refhit = center-of-the-sensor coordinates:
-      double x_refhit = 0.; 
-      double y_refhit = 0.; 
-      double z_refhit = 0.; 
-      
-      if( !_applyToReferenceHitCollection || _referenceHitVec == 0 )
-      {
-	// todo: is this case (no reference vector) treated correctly?
-        streamlog_out( DEBUG5 ) << "DIRECT:-----:-----: _referenceHitVec is empty" << endl;
-      }
-      else
-      {
-        streamlog_out( DEBUG5 ) << "DIRECT:-----:-----: reference Hit collection name : " << _referenceHitCollectionName << endl;
- 
-       for(size_t ii = 0 ; ii <  static_cast< size_t >(_referenceHitVec->getNumberOfElements()); ii++)
-       {
-        EUTelReferenceHit * refhit = static_cast< EUTelReferenceHit*> ( _referenceHitVec->getElementAt(ii) ) ;
-        if( sensorID != refhit->getSensorID() )
-        {
-//          streamlog_out( DEBUG5 ) << "DIRECT:-----:-----: Looping through a varity of sensor IDs" << endl;
-          continue;
-        }
-        else
-        {
-          streamlog_out( DEBUG5 ) << "DIRECT:-----:-----: Sensor ID and Alignment plane ID match!" << endl;
-          x_refhit =  refhit->getXOffset();
-          y_refhit =  refhit->getYOffset();
-          z_refhit =  refhit->getZOffset();
-
-          // possible source of inconsistency; Apply to reference hit collection flag should be enabled in steering file
-          // otherwise the following three lines (undo alignment shifts) makes no sense !!!
-          x_refhit += offsetX;
-          y_refhit += offsetY;
-          z_refhit += offsetZ;
-
-          break;
-        } 
-           streamlog_out( DEBUG5 ) << "DIRECT:-----:-----: sensorID "<<
-             refhit->getSensorID(   )  << " X: "   <<                
-             refhit->getXOffset(    )  << " Y: "   <<
-             refhit->getYOffset(    )  << " Z: "   <<
-             refhit->getZOffset(    )  << " X_REFHIT: "   <<
-             x_refhit << " Y_REFHIT: "   <<
-             y_refhit << " Z_REFHIT: "   <<
-             z_refhit << "  "   << endl;        
-       }
-      }
-      streamlog_out( DEBUG5 ) << "DIRECT:-----:-----: refhit found for sensorID " << sensorID << endl;
-
-      // copy the input to the output, at least for the common part
-      TrackerHitImpl   * outputHit  = new TrackerHitImpl;
-      outputHit->setType( inputHit->getType() );
-      outputHit->rawHits() = inputHit->getRawHits();
-      outputHit->setCovMatrix( inputHit->getCovMatrix() );
-      outputHit->setCellID0( inputHit->getCellID0() );
-      outputHit->setCellID1( inputHit->getCellID1() );
-      outputHit->setTime( inputHit->getTime() );
-
-      // hit coordinates in the center-of-the sensor frame (axis coincide with the global frame)
-      const double *inputS = static_cast<const double*> ( inputHit->getPosition() ) ;
-
-      double inputPosition[3]      = { inputS[0], inputS[1], inputS[2] };
-      double inputPosition_orig[3] = { inputS[0], inputS[1], inputS[2] };
-
-      // calculate hit position on a sensor relative to its center (assuming that refhit is still without alignment corrections)
-      inputPosition[0] = inputPosition[0] - x_refhit;
-      inputPosition[1] = inputPosition[1] - y_refhit;
-      inputPosition[2] = inputPosition[2] - z_refhit;
-
-      // initial setting of the sensor = center-of-the sensor coordinates in the global frame
-      double   outputPosition[3]  = { 0., 0., 0. };
-      outputPosition[0] = x_refhit;
-      outputPosition[1] = y_refhit;
-      outputPosition[2] = z_refhit;
-/*
-        printf("PRE sensorID: %5d   [%5.2f %5.2f %5.2f]\n",
-                sensorID, x_refhit, y_refhit, z_refhit
-        );
-*/
-
-
-//      if ( positionIter != _lookUpTable[ _alignmentCollectionName ].end() ) {
-
-
-#if ( defined(USE_AIDA) || defined(MARLIN_USE_AIDA) )
-        string tempHistoName;
-//        AIDA::IHistogram3D *histo3D; 
-        if ( _histogramSwitch ) {
-          {
-            stringstream ss;
-            ss  << _hitHistoBeforeAlignName << "_" << sensorID ;
-            tempHistoName = ss.str();
-          }
-          if ( AIDA::IHistogram2D * histo = dynamic_cast<AIDA::IHistogram2D*> ( _aidaHistoMap[ tempHistoName ] )) {
-            histo->fill( inputPosition[0], inputPosition[1] );
-          }
-          else
-            {
-              streamlog_out ( ERROR1 )  << "DIRECT:-----:-----: Not able to retrieve histogram pointer for " << tempHistoName
-                                        << ".\nDisabling histogramming from now on " << endl;
-              _histogramSwitch = false;
-            }
-//          histo3D = dynamic_cast<AIDA::IHistogram3D*> (_aidaHistoMap[ _densityPlotBeforeAlignName ] );
-//          if ( histo3D ) histo3D->fill( inputPosition[0], inputPosition[1], inputPosition[2] );
-//          else {
-//            streamlog_out ( ERROR1 )  << "DIRECT:-----:-----: Not able to retrieve histogram pointer for " << _densityPlotBeforeAlignName
-//                                      << ".\nDisabling histogramming from now on " << endl;
-//            _histogramSwitch = false;
-//          }
-        }
-#endif
-
-        
-        if ( _correctionMethod == 0 ) 
-        {
-
-            // this is the shift only case
-            outputPosition[0] += inputPosition[0] - offsetX;                
-            outputPosition[1] += inputPosition[1] - offsetY; 
-            outputPosition[2] += inputPosition[2] - offsetZ;
-
-        } 
-        else if ( _correctionMethod == 1 ) 
-        {
-            if ( _debugSwitch )
-            {
-                alpha = _alpha;
-                beta  = _beta;
-                gamma = _gamma; 
-                offsetX = 0.;
-                offsetY = 0.;
-                offsetZ = 0.;
-            }
-            else
-            {
-            }
-
-            if( _iEvt < _printEvents )
-            {
-                if ( _debugSwitch ) 
-                {
-                    streamlog_out ( DEBUG5 )  << "DIRECT:-----:-----: Debugmode ON " << endl;                                   
-                }
-                streamlog_out ( DEBUG5 )  << "DIRECT:-----:-----: _correctionMethod == rotation first " << endl;
-                streamlog_out ( DEBUG5 )  << "DIRECT:-----:-----:  alignment->getAlpha() = " << alpha  << endl;
-                streamlog_out ( DEBUG5 )  << "DIRECT:-----:-----:  alignment->getBeta()  = " <<  beta  << endl;
-                streamlog_out ( DEBUG5 )  << "DIRECT:-----:-----:  alignment->getGamma() = " << gamma << endl;
-                streamlog_out ( DEBUG5 )  << "DIRECT:-----:-----:  alignment->getXOffest() = " << offsetX  << endl;
-                streamlog_out ( DEBUG5 )  << "DIRECT:-----:-----:  alignment->getYOffest() = " << offsetY  << endl;
-                streamlog_out ( DEBUG5 )  << "DIRECT:-----:-----:  alignment->getZOffest() = " << offsetZ  << endl;
-            }
-            // this is the rotation first
-            TVector3 iCenterOfSensorFrame(  inputPosition[0],  inputPosition[1],  inputPosition[2] );
-
-            iCenterOfSensorFrame.RotateX( -alpha );
-            iCenterOfSensorFrame.RotateY( -beta  );
-            iCenterOfSensorFrame.RotateZ( -gamma );
-
-            outputPosition[0] += iCenterOfSensorFrame(0);
-            outputPosition[1] += iCenterOfSensorFrame(1);
-            outputPosition[2] += iCenterOfSensorFrame(2);
-
-            // second the shift
-            outputPosition[0] -= offsetX; 
-            outputPosition[1] -= offsetY; 
-            outputPosition[2] -= offsetZ; 
-          
-        }
-        else if ( _correctionMethod == 2 ) 
-        {
-        }
-
-#if ( defined(USE_AIDA) || defined(MARLIN_USE_AIDA) ) 
-        if ( _histogramSwitch ) {
-          {
-            stringstream ss;
-            ss  << _hitHistoAfterAlignName << "_" << sensorID ;
-            tempHistoName = ss.str();
-          }
-          if ( AIDA::IHistogram2D * histo = dynamic_cast<AIDA::IHistogram2D*> ( _aidaHistoMap[ tempHistoName ] )) {
-            histo->fill( outputPosition[0], outputPosition[1] );
-          }
-          else {
-            streamlog_out ( ERROR1 )  << "DIRECT:-----:-----: Not able to retrieve histogram pointer for " << tempHistoName
-                                      << ".\nDisabling histogramming from now on " << endl;
-            _histogramSwitch = false;
-          }
-//          histo3D = dynamic_cast<AIDA::IHistogram3D*> (_aidaHistoMap[ _densityPlotAfterAlignName ] );
-//          if ( histo3D ) histo3D->fill( outputPosition[0], outputPosition[1], outputPosition[2] );
-//          else {
-//            streamlog_out ( ERROR1 )  << "DIRECT:-----:-----: Not able to retrieve histogram pointer for " << _densityPlotAfterAlignName
-//                                      << ".\nDisabling histogramming from now on " << endl;
-//            _histogramSwitch = false;
-//          }
-        }
-#endif
-
-/*
-      } 
-      else 
-      {
-
-        // this hit belongs to a plane whose sensorID is not in the
-        // alignment constants. So the idea is to eventually advice
-        // the users if running in DEBUG and copy the not aligned hit
-        // in the new collection.
-//        streamlog_out ( DEBUG5 ) << "Sensor ID " << sensorID << " not found. Skipping alignment for hit "
-//                                << iHit << endl;
-
-        for ( size_t i = 0; i < 3; ++i )
-        {
-            outputPosition[i] = inputPosition[i];
-        }
-
-      }
-*/
-
-      if ( _iEvt < _printEvents )
-      {
-         streamlog_out ( DEBUG1 ) << "DIRECT:-----:-----:" << _alignmentCollectionName.c_str() << " : ORIGI: Sensor ID " << sensorID << " " << inputPosition_orig[0] << " " << inputPosition_orig[1] << " " << inputPosition_orig[2] <<  endl;   
-         streamlog_out ( DEBUG1 ) << "DIRECT:-----:-----:" << _alignmentCollectionName.c_str() << " : INPUT: Sensor ID " << sensorID << " " << inputPosition[0] << " " << inputPosition[1] << " " << inputPosition[2] <<  endl;   
-         streamlog_out ( DEBUG1 ) << "DIRECT:-----:-----:" << _alignmentCollectionName.c_str() << " : OUTPUT:Sensor ID " << sensorID << " " << outputPosition[0] << " " << outputPosition[1] << " " << outputPosition[2]  << endl;
-      }
-
-      outputHit->setPosition( outputPosition ) ;
-      _outputCollectionVec->push_back( outputHit );
-    }
+    alignHits( false );
 }
 
 void EUTelApplyAlignmentProcessor::Reverse(LCEvent *event) {
 
-    UTIL::CellIDDecoder<TrackerHitImpl> hitDecoder ( EUTELESCOPE::HITENCODING ); 
     
     EUTelEventImpl * evt = static_cast<EUTelEventImpl*> (event);
 
@@ -1477,284 +1209,211 @@ void EUTelApplyAlignmentProcessor::Reverse(LCEvent *event) {
     }
 
 // go-go
-        for (size_t iHit = 0; iHit < _inputCollectionVec->size(); iHit++) 
-        {
-
-	TrackerHitImpl* inputHit  = dynamic_cast<TrackerHitImpl*>( _inputCollectionVec->getElementAt(iHit) );
-
-	// now we have to understand which layer this hit belongs to.
-	int sensorID = hitDecoder(inputHit)["sensorID"];
-
-      //find proper alignment colleciton:
-      double alpha = 0.;
-      double beta  = 0.;
-      double gamma = 0.;
-      double offsetX = 0.;
-      double offsetY = 0.;
-      double offsetZ = 0.;
- 
-      // now that we know at which sensor the hit belongs to, we can
-      // get the corresponding alignment constants
-      map< int , int >::iterator  positionIter = _lookUpTable[ _alignmentCollectionName ].find( sensorID );
-
-      if ( positionIter == _lookUpTable[ _alignmentCollectionName ].end() )
-         {
-           streamlog_out( DEBUG5 ) <<  "REVERSE: wrong sensorId " << sensorID  << endl;
-	   // continue; do nothing as if alignment == 0.
-         }
-      else
-         {
-           streamlog_out( DEBUG5 ) << "REVERSE: FOUND alignment collection "<< _alignmentCollectionName.c_str() <<" record for sensorId " << sensorID  << endl;
-           EUTelAlignmentConstant * alignment = static_cast< EUTelAlignmentConstant * >  ( _alignmentCollectionVec->getElementAt( positionIter->second ) );
-
-           alpha   = alignment->getAlpha();
-           beta    = alignment->getBeta();
-           gamma   = alignment->getGamma();
-           offsetX = alignment->getXOffset();
-           offsetY = alignment->getYOffset();
-           offsetZ = alignment->getZOffset();
-         }  
-
-      // refhit = center-of-the-sensor coordinates:
-      double x_refhit = 0.; 
-      double y_refhit = 0.; 
-      double z_refhit = 0.; 
+    alignHits( true );
+}
 
-      if( !_applyToReferenceHitCollection || _referenceHitVec == 0 )
-      {
-	// todo: is this case (no reference vector) treated correctly?
-        // streamlog_out( MESSAGE5 ) << "_referenceHitVec is empty" << endl;
-      }
-      else
-      {
-        if(_fevent) streamlog_out( MESSAGE5 ) << "REVERSE: reference Hit collection name : " << _referenceHitCollectionName << " at " << _referenceHitVec  << endl;
+namespace {
+  // row-major matrix of TVector3::RotateX/Y/Z( angle ), axis 0, 1 or 2
+  void rotationMatrix( int axis, double angle, double matrix[9] ) {
+    const double c = cos( angle );
+    const double s = sin( angle );
+    const int i = ( axis + 1 ) % 3;
+    const int j = ( axis + 2 ) % 3;
+    for ( int k = 0; k < 9; ++k ) matrix[k] = 0.;
+    matrix[ 4 * axis ] = 1.;
+    matrix[ 3 * i + i ] = c;
+    matrix[ 3 * i + j ] = -s;
+    matrix[ 3 * j + i ] = s;
+    matrix[ 3 * j + j ] = c;
+  }
 
-        for(size_t ii = 0 ; ii <  static_cast< size_t >(_referenceHitVec->getNumberOfElements()); ii++)
-        {
-          EUTelReferenceHit * refhit = static_cast< EUTelReferenceHit*> ( _referenceHitVec->getElementAt(ii) ) ;
-          if( sensorID != refhit->getSensorID() )
-          {
-            // Looping through a varity of sensor IDs
-            continue;
-          }
-          else
-          {
-	    // Sensor ID and Alignment plane ID match!
-            x_refhit =  refhit->getXOffset();
-            y_refhit =  refhit->getYOffset();
-            z_refhit =  refhit->getZOffset();
-
-// do not apply this part: refhits should be just as they where befre the alignment has been applied
-// = it means the anti-apply alignment should have been applied already in the AlignReferenceHit
-//---//
-//          x_refhit -= offsetX;
-//          y_refhit -= offsetY;
-//          z_refhit -= offsetZ;
-//---//
-
-            break;
-          } 
-        }
+  // matrix = rotation * matrix
+  void rotateLeft( const double rotation[9], double matrix[9] ) {
+    double result[9];
+    for ( int i = 0; i < 3; ++i ) {
+      for ( int j = 0; j < 3; ++j ) {
+        result[ 3 * i + j ] = rotation[ 3 * i ] * matrix[ j ] + rotation[ 3 * i + 1 ] * matrix[ 3 + j ] + rotation[ 3 * i + 2 ] * matrix[ 6 + j ];
       }
- 
-      // copy the input to the output, at least for the common part
-      TrackerHitImpl   * outputHit  = new TrackerHitImpl;
-      outputHit->setType( inputHit->getType() );
-      outputHit->rawHits() = inputHit->getRawHits();
-      outputHit->setCellID0( inputHit->getCellID0() );
-      outputHit->setCellID1( inputHit->getCellID1() );
-      outputHit->setTime( inputHit->getTime() );
-
-      // now that we know at which sensor the hit belongs to, we can
-      // get the corresponding alignment constants
-      // map< int , int >::iterator  positionIter = _lookUpTable[ _alignmentCollectionName ].find( sensorID );
+    }
+    for ( int k = 0; k < 9; ++k ) matrix[k] = result[k];
+  }
+}
 
-      // hit coordinates in the center-of-the sensor frame (axis coincide with the global frame)
-      const double *inputS = static_cast<const double*> ( inputHit->getPosition() ) ;
+size_t EUTelApplyAlignmentProcessor::getSensorAlignment(int sensorID, bool reverse, const std::map< int, int >& lookUpTable) {
 
-      double inputPosition[3]      = { inputS[0], inputS[1], inputS[2] };
-      double inputPosition_orig[3] = { inputS[0], inputS[1], inputS[2] };
+  for ( size_t iAlign = 0; iAlign < _sensorAlignments.size(); ++iAlign ) {
+    if ( _sensorAlignments[ iAlign ].sensorID == sensorID ) return iAlign;
+  }
 
-      inputPosition[0] = inputPosition[0] - x_refhit;
-      inputPosition[1] = inputPosition[1] - y_refhit;
-      inputPosition[2] = inputPosition[2] - z_refhit;
+  //find proper alignment colleciton:
+  double alpha = 0.;
+  double beta  = 0.;
+  double gamma = 0.;
+  double offset[3] = { 0., 0., 0. };
+
+  map< int , int >::const_iterator positionIter = lookUpTable.find( sensorID );
+  if ( positionIter == lookUpTable.end() ) {
+    // do nothing as if alignment == 0.
+    streamlog_out( DEBUG5 ) << "No alignment constant in " << _alignmentCollectionName << " for sensorID " << sensorID << endl;
+  } else {
+    EUTelAlignmentConstant * alignment = static_cast< EUTelAlignmentConstant * >  ( _alignmentCollectionVec->getElementAt( positionIter->second ) );
+    alpha     = alignment->getAlpha();
+    beta      = alignment->getBeta();
+    gamma     = alignment->getGamma();
+    offset[0] = alignment->getXOffset();
+    offset[1] = alignment->getYOffset();
+    offset[2] = alignment->getZOffset();
+  }
 
+  SensorAlignment sensorAlignment;
+  sensorAlignment.sensorID = sensorID;
+
+  // refhit = center-of-the-sensor coordinates:
+  double * reference = sensorAlignment.reference;
+  reference[0] = reference[1] = reference[2] = 0.;
+  if ( _applyToReferenceHitCollection && _referenceHitVec != 0 ) {
+    for ( size_t ii = 0 ; ii < static_cast< size_t >(_referenceHitVec->getNumberOfElements()); ii++ ) {
+      EUTelReferenceHit * refhit = static_cast< EUTelReferenceHit*> ( _referenceHitVec->getElementAt(ii) ) ;
+      if ( sensorID != refhit->getSensorID() ) continue;
+
+      reference[0] = refhit->getXOffset();
+      reference[1] = refhit->getYOffset();
+      reference[2] = refhit->getZOffset();
+
+      // the reference hits of the direct alignment are without the
+      // alignment shifts, in reverse they were already reverted in
+      // AlignReferenceHit
+      if ( !reverse ) {
+        for ( int i = 0; i < 3; ++i ) reference[i] += offset[i];
+      }
+      break;
+    }
+  }
 
-//            const double * inputPosition = const_cast< const double * > ( inputHit->getPosition() ) ;
-//            double   outputPosition[3]   = { 0., 0., 0. };
-  
-      // initial setting of the sensor = center-of-the sensor coordinates in the global frame
-      double   outputPosition[3]  = { 0., 0., 0. };
-      outputPosition[0] = x_refhit;
-      outputPosition[1] = y_refhit;
-      outputPosition[2] = z_refhit;
+  if ( _correctionMethod == 1 && _debugSwitch ) {
+    alpha = _alpha;
+    beta  = _beta;
+    gamma = _gamma;
+    offset[0] = offset[1] = offset[2] = 0.;
+  }
 
-//            if ( positionIter != _lookUpTable[ _alignmentCollectionName ].end() ) 
-//            {
+  double * rotation    = sensorAlignment.transform.rotation;
+  double * translation = sensorAlignment.transform.translation;
+  for ( int k = 0; k < 9; ++k ) rotation[k] = ( k % 4 == 0 ) ? 1. : 0.;
+
+  if ( _correctionMethod == 0 ) {
+    // this is the shift only case
+    for ( int i = 0; i < 3; ++i ) translation[i] = reverse ? offset[i] : reference[i] - offset[i];
+  } else if ( _correctionMethod == 1 ) {
+    // this is the rotation first, applied as the TVector3 rotations
+    // X, Y and Z (direct) or Z, Y and X (reverse) would do
+    double step[9];
+    const int    axes[3]   = { reverse ? 2 : 0, 1, reverse ? 0 : 2 };
+    const double angles[3] = { reverse ? gamma : -alpha, reverse ? beta : -beta, reverse ? alpha : -gamma };
+    for ( int iRot = 0; iRot < 3; ++iRot ) {
+      rotationMatrix( axes[iRot], angles[iRot], step );
+      rotateLeft( step, rotation );
+    }
+    // second the shift
+    for ( int i = 0; i < 3; ++i ) translation[i] = reverse ? reference[i] + offset[i] : reference[i] - offset[i];
+
+    if ( _iEvt < _printEvents ) {
+      if ( _debugSwitch ) streamlog_out ( DEBUG1 ) << "Debugmode ON " << endl;
+      streamlog_out ( DEBUG1 ) << "_correctionMethod == rotation first, sensorID " << sensorID << endl;
+      streamlog_out ( DEBUG1 ) << " alignment->getAlpha() = " << alpha  << endl;
+      streamlog_out ( DEBUG1 ) << " alignment->getBeta()  = " << beta  << endl;
+      streamlog_out ( DEBUG1 ) << " alignment->getGamma() = " << gamma << endl;
+      streamlog_out ( DEBUG1 ) << " alignment->getXOffest() = " << offset[0] << endl;
+      streamlog_out ( DEBUG1 ) << " alignment->getYOffest() = " << offset[1] << endl;
+      streamlog_out ( DEBUG1 ) << " alignment->getZOffest() = " << offset[2] << endl;
+    }
+  } else {
+    // no correction implemented: the hit is put on the reference point
+    for ( int k = 0; k < 9; ++k ) rotation[k] = 0.;
+    for ( int i = 0; i < 3; ++i ) translation[i] = reference[i];
+  }
 
 #if ( defined(USE_AIDA) || defined(MARLIN_USE_AIDA) )
-                string tempHistoName;
-//                AIDA::IHistogram3D *histo3D; 
-                if ( _histogramSwitch ) 
-                {
-                    {
-                        stringstream ss;
-                        ss  << _hitHistoBeforeAlignName << "_" << sensorID ;
-                        tempHistoName = ss.str();
-                    }
-                    if ( AIDA::IHistogram2D * histo = dynamic_cast<AIDA::IHistogram2D*> ( _aidaHistoMap[ tempHistoName ] )) 
-                    {
-                        histo->fill( inputPosition[0], inputPosition[1] );
-                    }
-                    else
-                    {
-                        streamlog_out ( ERROR1 )  << "Not able to retrieve histogram pointer for " << tempHistoName
-                                                  << ".\nDisabling histogramming from now on " << endl;
-                        _histogramSwitch = false;
-                    }
-                    
-//                    histo3D = dynamic_cast<AIDA::IHistogram3D*> (_aidaHistoMap[ _densityPlotBeforeAlignName ] );
-//                    if ( histo3D ) 
-//                    {
-//                        histo3D->fill( inputPosition[0], inputPosition[1], inputPosition[2] );
-//                    }
-//                    else 
-//                    {
-//                        streamlog_out ( ERROR1 )  << "Not able to retrieve histogram pointer for " << _densityPlotBeforeAlignName
-//                                                  << ".\nDisabling histogramming from now on " << endl;
-//                       _histogramSwitch = false;
-//                    }
-                }
+  sensorAlignment.histoBeforeAlign = 0;
+  sensorAlignment.histoAfterAlign  = 0;
+  if ( _histogramSwitch ) {
+    stringstream before, after;
+    before << _hitHistoBeforeAlignName << "_" << sensorID;
+    after  << _hitHistoAfterAlignName  << "_" << sensorID;
+    sensorAlignment.histoBeforeAlign = dynamic_cast< AIDA::IHistogram2D* > ( _aidaHistoMap[ before.str() ] );
+    sensorAlignment.histoAfterAlign  = dynamic_cast< AIDA::IHistogram2D* > ( _aidaHistoMap[ after.str() ] );
+    if ( sensorAlignment.histoBeforeAlign == 0 || sensorAlignment.histoAfterAlign == 0 ) {
+      streamlog_out ( ERROR1 ) << "Not able to retrieve histogram pointer for " << ( sensorAlignment.histoBeforeAlign == 0 ? before.str() : after.str() )
+                               << ".\nDisabling histogramming from now on " << endl;
+      _histogramSwitch = false;
+    }
+  }
 #endif
 
-       
-                if ( _correctionMethod == 0 ) 
-                {                   
+  _sensorAlignments.push_back( sensorAlignment );
+  return _sensorAlignments.size() - 1;
+}
 
-                    // this is the shift only case
+void EUTelApplyAlignmentProcessor::alignHits(bool reverse) {
 
-                    outputPosition[0] = inputPosition[0] + offsetX ;
-                    outputPosition[1] = inputPosition[1] + offsetY ;
-                    outputPosition[2] = inputPosition[2] + offsetZ ;
+  UTIL::CellIDDecoder<TrackerHitImpl> hitDecoder ( EUTELESCOPE::HITENCODING );
+  const std::map< int, int >& lookUpTable = _lookUpTable[ _alignmentCollectionName ];
+  const char * direction = reverse ? "REVERSE: " : "DIRECT:-----:-----: ";
 
-                }
-                else
-                    if ( _correctionMethod == 1 ) 
-                    {
-                        // this is the rotation first
-                        if ( _debugSwitch )
-                        {
-                          alpha = _alpha;
-                          beta  = _beta;
-                          gamma = _gamma; 
-                          offsetX = 0.;
-                          offsetY = 0.;
-                          offsetZ = 0.;
-                        }
-                        else
-                        {
-                        }
-
-            if( _iEvt < _printEvents )
-            {
-                if ( _debugSwitch ) 
-                {
-                    streamlog_out ( DEBUG1 )  << "Debugmode ON " << endl;                                   
-                }
-                
-                streamlog_out ( DEBUG1 )  << "_correctionMethod == rotation first " << endl;
-                streamlog_out ( DEBUG1 )  << " alignment->getAlpha() = " << alpha  << endl;
-                streamlog_out ( DEBUG1 )  << " alignment->getBeta()  = " <<  beta  << endl;
-                streamlog_out ( DEBUG1 )  << " alignment->getGamma() = " << gamma << endl;
-                streamlog_out ( DEBUG1 )  << " alignment->getXOffest() = " << offsetX  << endl;
-                streamlog_out ( DEBUG1 )  << " alignment->getYOffest() = " << offsetY  << endl;
-                streamlog_out ( DEBUG1 )  << " alignment->getZOffest() = " << offsetZ  << endl;
-            }
-        
-            // this is the rotation first
-            TVector3 iCenterOfSensorFrame(  inputPosition[0],  inputPosition[1],  inputPosition[2] );
+  // the reference hits are part of the event, the transforms are
+  // compiled again for every event and alignment collection
+  _sensorAlignments.clear();
 
-            iCenterOfSensorFrame.RotateZ( +gamma );
-            iCenterOfSensorFrame.RotateY( +beta  );
-            iCenterOfSensorFrame.RotateX( +alpha );
+  // hits of the same sensor usually come one after the other
+  size_t iAlign   = 0;
+  int lastSensorID = 0;
 
-            outputPosition[0] += iCenterOfSensorFrame(0);
-            outputPosition[1] += iCenterOfSensorFrame(1);
-            outputPosition[2] += iCenterOfSensorFrame(2);
+  for ( size_t iHit = 0; iHit < _inputCollectionVec->size(); iHit++ ) {
 
-            // second the shift
-            outputPosition[0] += offsetX; 
-            outputPosition[1] += offsetY; 
-            outputPosition[2] += offsetZ; 
+    TrackerHitImpl* inputHit = dynamic_cast<TrackerHitImpl*>( _inputCollectionVec->getElementAt(iHit) );
 
-                    }
-                    else
-                        if ( _correctionMethod == 2 ) 
-                        {
-                        }
-
-#if ( defined(USE_AIDA) || defined(MARLIN_USE_AIDA) ) 
+    // now we have to understand which layer this hit belongs to.
+    int sensorID = hitDecoder(inputHit)["sensorID"];
+    if ( iHit == 0 || sensorID != lastSensorID ) {
+      iAlign       = getSensorAlignment( sensorID, reverse, lookUpTable );
+      lastSensorID = sensorID;
+    }
+    const SensorAlignment& sensorAlignment = _sensorAlignments[ iAlign ];
+
+    // copy the input to the output, at least for the common part
+    TrackerHitImpl   * outputHit  = new TrackerHitImpl;
+    outputHit->setType( inputHit->getType() );
+    outputHit->rawHits() = inputHit->getRawHits();
+    if ( !reverse ) outputHit->setCovMatrix( inputHit->getCovMatrix() );
+    outputHit->setCellID0( inputHit->getCellID0() );
+    outputHit->setCellID1( inputHit->getCellID1() );
+    outputHit->setTime( inputHit->getTime() );
+
+    // hit position relative to the sensor reference point
+    const double * inputS = inputHit->getPosition();
+    const double inputPosition[3] = { inputS[0] - sensorAlignment.reference[0],
+                                      inputS[1] - sensorAlignment.reference[1],
+                                      inputS[2] - sensorAlignment.reference[2] };
+
+    double outputPosition[3];
+    sensorAlignment.transform.local2Master( inputPosition, outputPosition );
 
-                if ( _histogramSwitch ) 
-                {
-                    {
-                        stringstream ss;
-                        ss  << _hitHistoAfterAlignName << "_" << sensorID ;
-                        tempHistoName = ss.str();
-                    }
-                    if ( AIDA::IHistogram2D * histo = dynamic_cast<AIDA::IHistogram2D*> ( _aidaHistoMap[ tempHistoName ] )) 
-                    {
-                        histo->fill( outputPosition[0], outputPosition[1] );
-                    }
-                    else 
-                    {
-                        streamlog_out ( ERROR1 )  << "Not able to retrieve histogram pointer for " << tempHistoName
-                                                  << ".\nDisabling histogramming from now on " << endl;
-                        _histogramSwitch = false;
-                    }
-                    
-//                    histo3D = dynamic_cast<AIDA::IHistogram3D*> (_aidaHistoMap[ _densityPlotAfterAlignName ] );
-//                    if ( histo3D )
-//                    {
-//                        histo3D->fill( outputPosition[0], outputPosition[1], outputPosition[2] );
-//                    }
-//                    else 
-//                    {
-//                        streamlog_out ( ERROR1 )  << "Not able to retrieve histogram pointer for " << _densityPlotAfterAlignName
-//                                                  << ".\nDisabling histogramming from now on " << endl;
-//                        _histogramSwitch = false;
-//                    }
-                }
+#if ( defined(USE_AIDA) || defined(MARLIN_USE_AIDA) )
+    if ( _histogramSwitch ) {
+      sensorAlignment.histoBeforeAlign->fill( inputPosition[0], inputPosition[1] );
+      sensorAlignment.histoAfterAlign->fill( outputPosition[0], outputPosition[1] );
+    }
 #endif
-/*
-            }
-            else 
-            {
-
-                // this hit belongs to a plane whose sensorID is not in the
-                // alignment constants. So the idea is to eventually advice
-                // the users if running in DEBUG and copy the not aligned hit
-                // in the new collection.
 
-                streamlog_out ( DEBUG5 ) << "Sensor ID " << sensorID << " not found. Skipping alignment for hit "
-                                          << iHit << endl;
-                
-                for ( size_t i = 0; i < 3; ++i )
-                {
-                    outputPosition[i] = inputPosition[i];
-                }
-            }
-*/
-      if ( _iEvt < _printEvents )
-      {
-         streamlog_out ( DEBUG0 ) <<_alignmentCollectionName.c_str() << " REVERT: ORIGI: Sensor ID " << sensorID << " " << inputPosition_orig[0] << " " << inputPosition_orig[1] << " " << inputPosition_orig[2] <<  endl;   
-         streamlog_out ( DEBUG0 ) <<_alignmentCollectionName.c_str() << " REVERT: INPUT: Sensor ID " << sensorID << " " << inputPosition[0] << " " << inputPosition[1] << " " << inputPosition[2] <<  endl;   
-         streamlog_out ( DEBUG0 ) <<_alignmentCollectionName.c_str() << " REVERT: OUTPUT:Sensor ID " << sensorID << " " << outputPosition[0] << " " << outputPosition[1] << " " << outputPosition[2]  << endl;
-      }
+    if ( _iEvt < _printEvents ) {
+      streamlog_out ( DEBUG1 ) << direction << _alignmentCollectionName << " : ORIGI: Sensor ID " << sensorID << " " << inputS[0] << " " << inputS[1] << " " << inputS[2] <<  endl;
+      streamlog_out ( DEBUG1 ) << direction << _alignmentCollectionName << " : INPUT: Sensor ID " << sensorID << " " << inputPosition[0] << " " << inputPosition[1] << " " << inputPosition[2] <<  endl;
+      streamlog_out ( DEBUG1 ) << direction << _alignmentCollectionName << " : OUTPUT:Sensor ID " << sensorID << " " << outputPosition[0] << " " << outputPosition[1] << " " << outputPosition[2]  << endl;
+    }
 
-            outputHit->setPosition( outputPosition ) ;
-            _outputCollectionVec->push_back( outputHit );
-        }
+    outputHit->setPosition( outputPosition ) ;
+    _outputCollectionVec->push_back( outputHit );
+  }
 }
 
 void EUTelApplyAlignmentProcessor::bookHistos() {
@@ -18,6 +18,7 @@
 #include "EUTelDFFClusterImpl.h"
 #include "EUTelBrickedClusterImpl.h"
 #include "EUTelSparseClusterImpl.h"
+#include "EUTelClusterSummary.h"
 #include "EUTelEtaFunctionImpl.h"
 #include "EUTelPseudo1DHistogram.h"
 #include "EUTelExceptions.h"
@@ -260,9 +261,15 @@ void EUTelCalculateEtaProcessor::processEvent (LCEvent * event) {
     try {
       LCCollectionVec * clusterCollectionVec    = dynamic_cast < LCCollectionVec * > (evt->getCollection(_clusterCollectionName));
       CellIDDecoder<TrackerPulseImpl> cellDecoder(clusterCollectionVec);
+      const EUTelClusterSummary & clusterSummary = EUTelClusterSummary::get( evt, _clusterCollectionName );
 
       for (int iCluster = 0; iCluster < clusterCollectionVec->getNumberOfElements() ; iCluster++) {
 
+        // the quality is already known from the cluster summary, no
+        // need to build the cluster if it is not the one we want
+        const EUTelClusterSummary::Entry & summary = clusterSummary[ iCluster ];
+        if ( summary.valid && summary.quality != _clusterQuality ) continue;
+
         TrackerPulseImpl   * pulse = dynamic_cast<TrackerPulseImpl *>  ( clusterCollectionVec->getElementAt(iCluster) );
         int temp = cellDecoder(pulse)["type"];
         ClusterType type = static_cast<ClusterType>( temp );
@@ -16,6 +16,7 @@
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelEventImpl.h"
 #include "EUTelHistogramManager.h"
+#include "EUTelCalibrationKernel.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -144,6 +145,9 @@ void EUTelCalibrateEventProcessor::processRunHeader (LCRunHeader * rdr) {
   // increment the run counter
   ++_iRun;
 
+  // the conditions may change with the run
+  _sensorCalibrationMap.clear();
+
 }
 
 void EUTelCalibrateEventProcessor::initializeGeometry(LCEvent * event) throw ( marlin::SkipEventException ) {
@@ -437,6 +441,7 @@ void EUTelCalibrateEventProcessor::processEvent (LCEvent * event) {
     }
 
     LCCollectionVec * correctedDataCollection = new LCCollectionVec(LCIO::TRACKERDATA);
+    CellIDEncoder<TrackerDataImpl> idDataEncoder(EUTELESCOPE::MATRIXDEFAULTENCODING, correctedDataCollection);
 
     _minX.clear();
     _maxX.clear();
@@ -444,16 +449,12 @@ void EUTelCalibrateEventProcessor::processEvent (LCEvent * event) {
     _maxY.clear();
 
     for (unsigned int iDetector = 0; iDetector < inputCollectionVec->size(); iDetector++) {
-      vector< float > commonModeCorVec;
-      commonModeCorVec.clear();
 
       // reset quantity for the common mode.
-      double pixelSum      = 0.;
       double commonMode    = 0.;
       int    goodPixel     = 0;
       int    skippedPixel  = 0;
-      int    skippedRow   = 0;
-
+      int    skippedRow    = 0;
 
       TrackerRawDataImpl  * rawData   = dynamic_cast < TrackerRawDataImpl * >(inputCollectionVec->getElementAt(iDetector));
       int sensorID                    = cellDecoder(rawData)["sensorID"];
@@ -464,54 +465,51 @@ void EUTelCalibrateEventProcessor::processEvent (LCEvent * event) {
       TrackerDataImpl     * noise     = dynamic_cast < TrackerDataImpl * >   (noiseCollectionVec->getElementAt( ancillaryPos ));
       TrackerRawDataImpl  * status    = dynamic_cast < TrackerRawDataImpl * >(statusCollectionVec->getElementAt( ancillaryPos ));
 
+      SensorCalibration & calibration = getSensorCalibration( sensorID, noise, status );
+
+      const int xMin = cellDecoder(rawData)["xMin"];
+      const int xMax = cellDecoder(rawData)["xMax"];
+      const int yMin = cellDecoder(rawData)["yMin"];
+      const int yMax = cellDecoder(rawData)["yMax"];
+      _minX.push_back( xMin ) ;
+      _maxX.push_back( xMax ) ;
+      _minY.push_back( yMin ) ;
+      _maxY.push_back( yMax ) ;
+
       TrackerDataImpl     * corrected = new TrackerDataImpl;
-      CellIDEncoder<TrackerDataImpl> idDataEncoder(EUTELESCOPE::MATRIXDEFAULTENCODING, correctedDataCollection);
       idDataEncoder["sensorID"] = sensorID;
-      idDataEncoder["xMin"]     = static_cast<int > (cellDecoder(rawData)["xMin"]);
-      idDataEncoder["xMax"]     = static_cast<int > (cellDecoder(rawData)["xMax"]);
-      idDataEncoder["yMin"]     = static_cast<int > (cellDecoder(rawData)["yMin"]);
-      idDataEncoder["yMax"]     = static_cast<int > (cellDecoder(rawData)["yMax"]);
-      _minX.push_back( cellDecoder( rawData ) ["xMin"] ) ;
-      _maxX.push_back( cellDecoder( rawData ) ["xMax"] ) ;
-      _minY.push_back( cellDecoder( rawData ) ["yMin"] ) ;
-      _maxY.push_back( cellDecoder( rawData ) ["yMax"] ) ;
-
+      idDataEncoder["xMin"]     = xMin;
+      idDataEncoder["xMax"]     = xMax;
+      idDataEncoder["yMin"]     = yMin;
+      idDataEncoder["yMax"]     = yMax;
       idDataEncoder.setCellID(corrected);
 
-      ShortVec::const_iterator rawIter     = rawData->getADCValues().begin();
-      FloatVec::const_iterator pedIter     = pedestal->getChargeValues().begin();
-      FloatVec::const_iterator noiseIter   = noise->getChargeValues().begin();
-      ShortVec::const_iterator statusIter  = status->getADCValues().begin();
+      // the whole frame is pedestal subtracted directly into the
+      // output charge vector, the common mode is then computed on it
+      // and subtracted in place
+      const ShortVec & adcValues = rawData->getADCValues();
+      const size_t     nPixel    = adcValues.size();
+      FloatVec       & data      = corrected->chargeValues();
+      data.resize( nPixel );
 
+      if ( nPixel != 0 ) {
+        CalibrationKernel::subtractPedestal( &adcValues[0], &pedestal->getChargeValues()[0], &data[0], nPixel );
+      }
 
       bool isEventValid = true;
-      if ( _doCommonMode == 1 ) {
+      if ( _doCommonMode == 1 && nPixel != 0 ) {
 
         // FULLFRAME common mode
-        while ( rawIter != rawData->getADCValues().end() ) {
-          bool isHit   = ( ((*rawIter) - (*pedIter)) > _hitRejectionCut * (*noiseIter) );
-          bool isGood  = ( (*statusIter) == EUTELESCOPE::GOODPIXEL );
-
-          if ( !isHit && isGood ) {
-            pixelSum += (*rawIter) - (*pedIter);
-            ++goodPixel;
-          } else if ( isHit ) {
-            ++skippedPixel;
-          }
-          ++rawIter;
-          ++pedIter;
-          ++noiseIter;
-          ++statusIter;
-        }
+        CalibrationKernel::Sum sum = CalibrationKernel::maskedSum( &data[0], &calibration.threshold[0], &calibration.goodMask[0], nPixel );
+        goodPixel    = sum.nGood;
+        skippedPixel = sum.nHit;
 
         if ( ( ( _maxNoOfRejectedPixels == -1 )  ||  ( skippedPixel < _maxNoOfRejectedPixels ) ) &&
              ( goodPixel != 0 ) ) {
 
-          commonMode = pixelSum / goodPixel;
+          commonMode = sum.sum / goodPixel;
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-          string tempHistoName = _commonModeDistHistoName + "_d" + to_string( sensorID );
-          if ( AIDA::IHistogram1D* histo = dynamic_cast<AIDA::IHistogram1D*>(_aidaHistoMap[tempHistoName]) )
-            histo->fill(commonMode);
+          if ( calibration.commonModeDistHisto ) calibration.commonModeDistHisto->fill(commonMode);
 #endif
 
         } else {
@@ -519,60 +517,41 @@ void EUTelCalibrateEventProcessor::processEvent (LCEvent * event) {
         }
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-        string tempHistoName = _skippedPixelDistHistoName + "_d" + to_string( sensorID ) ;
-        if ( AIDA::IHistogram1D* histo = dynamic_cast<AIDA::IHistogram1D*>(_aidaHistoMap[tempHistoName]) )
-          histo->fill( skippedPixel );
+        if ( calibration.skippedPixelDistHisto ) calibration.skippedPixelDistHisto->fill( skippedPixel );
 #endif
 
+      } else if ( _doCommonMode == 1 ) {
+
+        // an empty frame has no good pixel
+        isEventValid = false;
+
       } else if ( _doCommonMode == 2 ) {
 
         // ROWWISE common mode
-        ShortVec adcValues = rawData->getADCValues ();
-        FloatVec _pedestal     = pedestal->getChargeValues();
-        ShortVec _status  = status->getADCValues();
-        FloatVec  _noise   = noise->getChargeValues();
-        int    iPixel       = 0;
-        int    colCounter   = 0;
-        int    rowLength    = _maxX[iDetector] -  _minX[iDetector] + 1;
-
-        for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
-
-          double pixelSum           = 0.;
-          double commonMode         = 0.;
-          int    goodPixel          = 0;
-          int    skippedPixelPerRow = 0;
-
-          for ( int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector]; xPixel++) {
-            bool isHit  = ( ( adcValues[iPixel] - _pedestal[iPixel] ) > _hitRejectionCut * _noise[iPixel] );
-            bool isGood = ( _status[iPixel] == EUTELESCOPE::GOODPIXEL );
-            if ( !isHit && isGood ) {
-              pixelSum += adcValues[iPixel] - _pedestal[iPixel];
-              ++goodPixel;
-            } else if ( isHit ) {
-              ++skippedPixelPerRow;
-              ++skippedPixel;
-            }
-            ++iPixel;
-          }
+        const size_t rowLength = xMax - xMin + 1;
+        const size_t noOfRow   = yMax - yMin + 1;
+        calibration.rowCommonMode.assign( noOfRow, 0.f );
+
+        for ( size_t iRow = 0; iRow < noOfRow && ( iRow + 1 ) * rowLength <= nPixel; ++iRow ) {
+
+          const size_t offset = iRow * rowLength;
+          CalibrationKernel::Sum sum = CalibrationKernel::maskedSum( &data[offset], &calibration.threshold[offset],
+                                                                     &calibration.goodMask[offset], rowLength );
+          skippedPixel += sum.nHit;
 
           // we are now at the end of the row, so let's calculate the
           // common mode
-          if ( ( skippedPixelPerRow < _maxNoOfRejectedPixelPerRow ) &&
-               ( goodPixel != 0 ) ) {
-            commonMode = pixelSum / goodPixel ;
-            commonModeCorVec.insert( commonModeCorVec.begin() + colCounter * rowLength, rowLength, commonMode );
+          if ( ( sum.nHit < _maxNoOfRejectedPixelPerRow ) &&
+               ( sum.nGood != 0 ) ) {
+            commonMode = sum.sum / sum.nGood;
+            calibration.rowCommonMode[ iRow ] = commonMode;
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-            string tempHistoName = _commonModeDistHistoName + "_d" + to_string( sensorID );
-            if ( AIDA::IHistogram1D* histo = dynamic_cast<AIDA::IHistogram1D*>(_aidaHistoMap[tempHistoName]) )
-              histo->fill(commonMode);
+            if ( calibration.commonModeDistHisto ) calibration.commonModeDistHisto->fill( commonMode );
 #endif
           } else {
-            commonModeCorVec.insert( commonModeCorVec.begin() + colCounter * rowLength, rowLength, 0. );
             ++skippedRow;
           }
-
-          ++colCounter;
         }
         if ( skippedRow > _maxNoOfSkippedRow ) {
           isEventValid = false;
@@ -582,82 +561,26 @@ void EUTelCalibrateEventProcessor::processEvent (LCEvent * event) {
 
       if(isEventValid) {
         if(_doCommonMode == 2) {
-          ShortVec adcValues = rawData->getADCValues ();
-          FloatVec _pedestal = pedestal->getChargeValues();
-
-          int iPixel = 0;
-
-          for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
-            for ( int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector]; xPixel++) {
-
-              double correctedValue = adcValues[iPixel] - _pedestal[iPixel] - commonModeCorVec[iPixel];
-              corrected->chargeValues().push_back(correctedValue);
-
-              ++iPixel;
-#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-              if (_fillDebugHisto == 1) {
-                string tempHistoName = _rawDataDistHistoName + "_d" + to_string( sensorID );
-                if ( AIDA::IHistogram1D* histo = dynamic_cast<AIDA::IHistogram1D*>(_aidaHistoMap[tempHistoName]) ) {
-                  histo->fill(adcValues[iPixel]);
-                } else {
-                  streamlog_out ( ERROR1 ) << "Not able to retrieve histogram pointer for " << tempHistoName
-                                           << ".\nDisabling histogramming from now on " << endl;
-                  _fillDebugHisto = 0 ;
-                }
-
-                tempHistoName = _dataDistHistoName + "_d" + to_string( sensorID );
-                if ( AIDA::IHistogram1D * histo = dynamic_cast<AIDA::IHistogram1D*>(_aidaHistoMap[tempHistoName]) ) {
-                  histo->fill(correctedValue);
-                } else {
-                  streamlog_out ( ERROR1 ) << "Not able to retrieve histogram pointer for " << tempHistoName
-                                           << ".\nDisabling histogramming from now on " << endl;
-                  _fillDebugHisto = 0 ;
-                }
-              }
-#endif
-            }
+          const size_t rowLength = xMax - xMin + 1;
+          for ( size_t iRow = 0; iRow < calibration.rowCommonMode.size() && ( iRow + 1 ) * rowLength <= nPixel; ++iRow ) {
+            CalibrationKernel::subtractCommonMode( &data[ iRow * rowLength ], rowLength, calibration.rowCommonMode[ iRow ] );
           }
-        } else {
-
-          // that's the case the user wants to apply the FullFrame
-          // common mode or doesn't want to apply any correction at
-          // all. In this last case the value of the commonMode
-          // variable is taken directly from the initialization ( = 0 ).
-
-          rawIter     = rawData->getADCValues().begin();
-          pedIter     = pedestal->getChargeValues().begin();
-
-          while ( rawIter != rawData->getADCValues().end() )  {
-
-            double correctedValue = (*rawIter) - (*pedIter) - commonMode;
-            corrected->chargeValues().push_back(correctedValue);
+        } else if ( _doCommonMode == 1 ) {
+          CalibrationKernel::subtractCommonMode( &data[0], nPixel, commonMode );
+        }
 
+        // in the case the user doesn't want any common mode
+        // correction, the pedestal subtracted frame is already the
+        // final one.
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-            if (_fillDebugHisto == 1) {
-              string tempHistoName = _rawDataDistHistoName + "_d" + to_string( sensorID );
-              if ( AIDA::IHistogram1D* histo = dynamic_cast<AIDA::IHistogram1D*>(_aidaHistoMap[tempHistoName]) ) {
-                histo->fill(*rawIter);
-              } else {
-                streamlog_out ( ERROR1 ) << "Not able to retrieve histogram pointer for " << tempHistoName
-                                         << ".\nDisabling histogramming from now on " << endl;
-                _fillDebugHisto = 0 ;
-              }
-
-              tempHistoName = _dataDistHistoName + "_d" + to_string( sensorID );
-              if ( AIDA::IHistogram1D * histo = dynamic_cast<AIDA::IHistogram1D*>(_aidaHistoMap[tempHistoName]) ) {
-                histo->fill(correctedValue);
-              } else {
-                streamlog_out ( ERROR1 ) << "Not able to retrieve histogram pointer for " << tempHistoName
-                                         << ".\nDisabling histogramming from now on " << endl;
-                _fillDebugHisto = 0 ;
-              }
-            }
-#endif
-            ++rawIter;
-            ++pedIter;
+        if (_fillDebugHisto == 1) {
+          for ( size_t iPixel = 0; iPixel < nPixel; ++iPixel ) {
+            calibration.rawDataDistHisto->fill( adcValues[iPixel] );
+            calibration.dataDistHisto->fill( data[iPixel] );
           }
         }
+#endif
 
       } else {
         // this is the case the event is not valid because of common
@@ -672,6 +595,8 @@ void EUTelCalibrateEventProcessor::processEvent (LCEvent * event) {
           streamlog_out ( WARNING4 ) << "Skipping event " << evt->getEventNumber() << " for an unknown reason " << endl;
         }
 
+        delete corrected;
+        delete correctedDataCollection;
         throw SkipEventException( this );
 
       }
@@ -698,6 +623,65 @@ void EUTelCalibrateEventProcessor::processEvent (LCEvent * event) {
 
 
 
+EUTelCalibrateEventProcessor::SensorCalibration::SensorCalibration() :
+  threshold(),
+  goodMask(),
+  rowCommonMode()
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+  ,
+  rawDataDistHisto(0),
+  dataDistHisto(0),
+  commonModeDistHisto(0),
+  skippedPixelDistHisto(0)
+#endif
+{
+}
+
+EUTelCalibrateEventProcessor::SensorCalibration & EUTelCalibrateEventProcessor::getSensorCalibration( int sensorID,
+                                                                                                    const TrackerDataImpl * noise,
+                                                                                                    const TrackerRawDataImpl * status ) {
+
+  // the conditions can change at any event without the pointers
+  // changing, so the threshold and the mask are always refilled
+  std::map< int, SensorCalibration >::iterator found = _sensorCalibrationMap.find( sensorID );
+  const bool isNew = ( found == _sensorCalibrationMap.end() );
+  if ( isNew ) {
+    found = _sensorCalibrationMap.insert( std::make_pair( sensorID, SensorCalibration() ) ).first;
+  }
+  SensorCalibration & calibration = found->second;
+
+  const FloatVec & noiseValues  = noise->getChargeValues();
+  const ShortVec & statusValues = status->getADCValues();
+
+  calibration.threshold.resize( noiseValues.size() );
+  for ( size_t iPixel = 0; iPixel < noiseValues.size(); ++iPixel ) {
+    calibration.threshold[ iPixel ] = _hitRejectionCut * noiseValues[ iPixel ];
+  }
+
+  calibration.goodMask.resize( statusValues.size() );
+  for ( size_t iPixel = 0; iPixel < statusValues.size(); ++iPixel ) {
+    calibration.goodMask[ iPixel ] = ( statusValues[ iPixel ] == EUTELESCOPE::GOODPIXEL ) ? 1.f : 0.f;
+  }
+
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+  if ( !isNew ) return calibration;
+
+  calibration.rawDataDistHisto      = dynamic_cast< AIDA::IHistogram1D * > ( _aidaHistoMap[ _rawDataDistHistoName      + "_d" + to_string( sensorID ) ] );
+  calibration.dataDistHisto         = dynamic_cast< AIDA::IHistogram1D * > ( _aidaHistoMap[ _dataDistHistoName         + "_d" + to_string( sensorID ) ] );
+  calibration.commonModeDistHisto   = dynamic_cast< AIDA::IHistogram1D * > ( _aidaHistoMap[ _commonModeDistHistoName   + "_d" + to_string( sensorID ) ] );
+  calibration.skippedPixelDistHisto = dynamic_cast< AIDA::IHistogram1D * > ( _aidaHistoMap[ _skippedPixelDistHistoName + "_d" + to_string( sensorID ) ] );
+
+  if ( _fillDebugHisto == 1 && ( calibration.rawDataDistHisto == 0 || calibration.dataDistHisto == 0 ) ) {
+    streamlog_out ( ERROR1 ) << "Not able to retrieve the debug histogram pointers for detector " << sensorID
+                             << ".\nDisabling histogramming from now on " << endl;
+    _fillDebugHisto = 0 ;
+  }
+#endif
+
+  return calibration;
+}
+
+
 void EUTelCalibrateEventProcessor::check (LCEvent * /* evt */ ) {
   // nothing to check here - could be used to fill check plots in reconstruction processor
 }
@@ -0,0 +1,163 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelCalibrationKernel.h"
+
+// system includes <>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace eutelescope;
+
+void CalibrationKernel::subtractPedestal( const short * raw, const float * pedestal, float * data, size_t n ) {
+
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  for ( ; i + 8 <= n; i += 8 ) {
+    __m128i adc = _mm_loadu_si128( reinterpret_cast< const __m128i * >( raw + i ) );
+    // sign extend the eight shorts to two times four ints
+    __m128i lo  = _mm_srai_epi32( _mm_unpacklo_epi16( adc, adc ), 16 );
+    __m128i hi  = _mm_srai_epi32( _mm_unpackhi_epi16( adc, adc ), 16 );
+    _mm_storeu_ps( data + i,     _mm_sub_ps( _mm_cvtepi32_ps( lo ), _mm_loadu_ps( pedestal + i ) ) );
+    _mm_storeu_ps( data + i + 4, _mm_sub_ps( _mm_cvtepi32_ps( hi ), _mm_loadu_ps( pedestal + i + 4 ) ) );
+  }
+#endif
+
+  for ( ; i < n; ++i ) data[i] = raw[i] - pedestal[i];
+}
+
+CalibrationKernel::Sum CalibrationKernel::maskedSum( const float * data, const float * threshold, const float * goodMask, size_t n ) {
+
+  Sum result;
+  result.sum   = 0.;
+  result.nGood = 0;
+  result.nHit  = 0;
+
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  __m128d sumLo  = _mm_setzero_pd();
+  __m128d sumHi  = _mm_setzero_pd();
+  __m128i nGood  = _mm_setzero_si128();
+  __m128i nHit   = _mm_setzero_si128();
+
+  for ( ; i + 4 <= n; i += 4 ) {
+    __m128 value = _mm_loadu_ps( data + i );
+    __m128 isHit = _mm_cmpgt_ps( value, _mm_loadu_ps( threshold + i ) );
+    // 1.f for the good pixels below threshold, 0.f otherwise
+    __m128 use   = _mm_andnot_ps( isHit, _mm_loadu_ps( goodMask + i ) );
+    __m128 part  = _mm_and_ps( value, _mm_cmpneq_ps( use, _mm_setzero_ps() ) );
+    sumLo = _mm_add_pd( sumLo, _mm_cvtps_pd( part ) );
+    sumHi = _mm_add_pd( sumHi, _mm_cvtps_pd( _mm_movehl_ps( part, part ) ) );
+    nGood = _mm_add_epi32( nGood, _mm_cvttps_epi32( use ) );
+    // the comparison gives -1 in each hit lane
+    nHit  = _mm_sub_epi32( nHit, _mm_castps_si128( isHit ) );
+  }
+
+  double sums[4];
+  _mm_storeu_pd( sums,     sumLo );
+  _mm_storeu_pd( sums + 2, sumHi );
+  result.sum = ( sums[0] + sums[1] ) + ( sums[2] + sums[3] );
+
+  int counts[4];
+  _mm_storeu_si128( reinterpret_cast< __m128i * >( counts ), nGood );
+  result.nGood = counts[0] + counts[1] + counts[2] + counts[3];
+  _mm_storeu_si128( reinterpret_cast< __m128i * >( counts ), nHit );
+  result.nHit  = counts[0] + counts[1] + counts[2] + counts[3];
+#endif
+
+  for ( ; i < n; ++i ) {
+    if ( data[i] > threshold[i] ) {
+      ++result.nHit;
+    } else if ( goodMask[i] != 0.f ) {
+      result.sum += data[i];
+      ++result.nGood;
+    }
+  }
+
+  return result;
+}
+
+void CalibrationKernel::subtractCommonMode( float * data, size_t n, double commonMode ) {
+
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  const __m128d cm = _mm_set1_pd( commonMode );
+  for ( ; i + 4 <= n; i += 4 ) {
+    __m128  value = _mm_loadu_ps( data + i );
+    __m128  lo    = _mm_cvtpd_ps( _mm_sub_pd( _mm_cvtps_pd( value ), cm ) );
+    __m128  hi    = _mm_cvtpd_ps( _mm_sub_pd( _mm_cvtps_pd( _mm_movehl_ps( value, value ) ), cm ) );
+    _mm_storeu_ps( data + i, _mm_movelh_ps( lo, hi ) );
+  }
+#endif
+
+  for ( ; i < n; ++i ) data[i] = static_cast< float >( data[i] - commonMode );
+}
+
+void CalibrationKernel::subtractCommonMode( float * data, size_t n, float commonMode ) {
+
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  const __m128 cm = _mm_set1_ps( commonMode );
+  for ( ; i + 4 <= n; i += 4 ) {
+    _mm_storeu_ps( data + i, _mm_sub_ps( _mm_loadu_ps( data + i ), cm ) );
+  }
+#endif
+
+  for ( ; i < n; ++i ) data[i] -= commonMode;
+}
+
+size_t CalibrationKernel::sparsify( const short * raw, const float * pedestal, const float * threshold, size_t n,
+                                   int * index, float * signal ) {
+
+  size_t nHit = 0;
+  size_t i    = 0;
+
+#if defined(__SSE2__)
+  float data[8];
+  for ( ; i + 8 <= n; i += 8 ) {
+    __m128i adc = _mm_loadu_si128( reinterpret_cast< const __m128i * >( raw + i ) );
+    __m128  lo  = _mm_sub_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( adc, adc ), 16 ) ),
+                              _mm_loadu_ps( pedestal + i ) );
+    __m128  hi  = _mm_sub_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( adc, adc ), 16 ) ),
+                              _mm_loadu_ps( pedestal + i + 4 ) );
+    int mask = _mm_movemask_ps( _mm_cmpgt_ps( lo, _mm_loadu_ps( threshold + i ) ) )
+      | ( _mm_movemask_ps( _mm_cmpgt_ps( hi, _mm_loadu_ps( threshold + i + 4 ) ) ) << 4 );
+
+    // most of the blocks are empty
+    if ( mask == 0 ) continue;
+
+    _mm_storeu_ps( data,     lo );
+    _mm_storeu_ps( data + 4, hi );
+    for ( int bit = 0; mask != 0; ++bit, mask >>= 1 ) {
+      if ( mask & 1 ) {
+        index[ nHit ]  = static_cast< int >( i ) + bit;
+        signal[ nHit ] = data[ bit ];
+        ++nHit;
+      }
+    }
+  }
+#endif
+
+  for ( ; i < n; ++i ) {
+    float data = raw[i] - pedestal[i];
+    if ( data > threshold[i] ) {
+      index[ nHit ]  = static_cast< int >( i );
+      signal[ nHit ] = data;
+      ++nHit;
+    }
+  }
+
+  return nHit;
+}
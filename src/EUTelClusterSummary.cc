@@ -0,0 +1,189 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelClusterSummary.h"
+#include "EUTELESCOPE.h"
+#include "EUTelVirtualCluster.h"
+#include "EUTelFFClusterImpl.h"
+#include "EUTelDFFClusterImpl.h"
+#include "EUTelBrickedClusterImpl.h"
+#include "EUTelSparseClusterImpl.h"
+#include "EUTelGenericSparsePixel.h"
+
+// lcio includes <.h>
+#include <lcio.h>
+#include <Exceptions.h>
+#include <EVENT/LCCollection.h>
+#include <IMPL/LCCollectionVec.h>
+#include <IMPL/TrackerPulseImpl.h>
+#include <IMPL/TrackerDataImpl.h>
+#include <UTIL/CellIDDecoder.h>
+
+// system includes <>
+#include <limits>
+
+using namespace std;
+using namespace lcio;
+using namespace eutelescope;
+
+const std::string EUTelClusterSummary::SUFFIX = "_summary";
+
+namespace {
+
+  // one pass over the pixels of a sparse cluster
+  void summarizeSparse( TrackerDataImpl * data, EUTelClusterSummary::Entry & entry ) {
+
+    EUTelSparseClusterImpl< EUTelGenericSparsePixel > cluster( data );
+    EUTelGenericSparsePixel pixel;
+
+    float maxSignal = -1 * numeric_limits<float>::max();
+    float xPos = 0, yPos = 0, charge = 0;
+    entry.xMin = entry.yMin = numeric_limits<int>::max();
+    entry.xMax = entry.yMax = numeric_limits<int>::min();
+
+    const unsigned int nPixels = cluster.size();
+    for ( unsigned int index = 0; index < nPixels; ++index ) {
+      cluster.getSparsePixelAt( index, &pixel );
+      const float signal = pixel.getSignal();
+      const int x = pixel.getXCoord();
+      const int y = pixel.getYCoord();
+      xPos   += x * signal;
+      yPos   += y * signal;
+      charge += signal;
+      if ( signal > maxSignal ) {
+        maxSignal = signal;
+        entry.xSeed = x;
+        entry.ySeed = y;
+      }
+      if ( x < entry.xMin ) entry.xMin = x;
+      if ( x > entry.xMax ) entry.xMax = x;
+      if ( y < entry.yMin ) entry.yMin = y;
+      if ( y > entry.yMax ) entry.yMax = y;
+    }
+
+    entry.size        = nPixels;
+    entry.quality     = cluster.getClusterQuality();
+    entry.totalCharge = charge;
+    entry.seedCharge  = maxSignal;
+    entry.xCoG        = xPos / charge;
+    entry.yCoG        = yPos / charge;
+  }
+
+  // fixed frame clusters through the virtual interface
+  void summarizeFixedFrame( const EUTelVirtualCluster & cluster, EUTelClusterSummary::Entry & entry ) {
+
+    int xCenter = 0, yCenter = 0, xSize = 0, ySize = 0;
+    cluster.getCenterCoord( xCenter, yCenter );
+    cluster.getClusterSize( xSize, ySize );
+    cluster.getSeedCoord( entry.xSeed, entry.ySeed );
+    cluster.getCenterOfGravity( entry.xCoG, entry.yCoG );
+
+    entry.size        = xSize * ySize;
+    entry.quality     = cluster.getClusterQuality();
+    entry.totalCharge = cluster.getTotalCharge();
+    entry.seedCharge  = cluster.getSeedCharge();
+    entry.xMin        = xCenter - xSize / 2;
+    entry.xMax        = xCenter + xSize / 2;
+    entry.yMin        = yCenter - ySize / 2;
+    entry.yMax        = yCenter + ySize / 2;
+  }
+}
+
+const EUTelClusterSummary & EUTelClusterSummary::get( LCEvent * event, const string & pulseCollectionName ) {
+
+  const string summaryName = pulseCollectionName + SUFFIX;
+
+  LCCollection * pulseCollection = event->getCollection( pulseCollectionName );
+
+  try {
+    LCCollection * summaryCollection = event->getCollection( summaryName );
+    if ( summaryCollection->getNumberOfElements() == 1 ) {
+      EUTelClusterSummary * summary = dynamic_cast< EUTelClusterSummary * > ( summaryCollection->getElementAt( 0 ) );
+      if ( summary != 0 ) {
+        // the clustering processors append to an existing pulse
+        // collection: a summary computed before is too short
+        if ( summary->size() != static_cast< size_t >( pulseCollection->getNumberOfElements() ) ) {
+          summary->summarize( pulseCollection );
+        }
+        return *summary;
+      }
+    }
+  } catch ( lcio::DataNotAvailableException& e ) {
+    // not computed yet in this event
+  }
+
+  EUTelClusterSummary * summary = new EUTelClusterSummary( pulseCollection );
+
+  LCCollectionVec * summaryCollection = new LCCollectionVec( LCIO::LCGENERICOBJECT );
+  summaryCollection->setTransient( true );
+  summaryCollection->push_back( summary );
+  event->addCollection( summaryCollection, summaryName );
+
+  return *summary;
+}
+
+EUTelClusterSummary::EUTelClusterSummary( LCCollection * pulseCollection ) :
+  IMPL::LCGenericObjectImpl(),
+  _entries(),
+  _index() {
+
+  _typeName        = "Cluster summary";
+  _dataDescription = "transient, see EUTelClusterSummary::Entry";
+
+  summarize( pulseCollection );
+}
+
+void EUTelClusterSummary::summarize( LCCollection * pulseCollection ) {
+
+  CellIDDecoder<TrackerPulseImpl> pulseCellDecoder( pulseCollection );
+
+  const int nClusters = pulseCollection->getNumberOfElements();
+  _entries.resize( nClusters );
+  _index.clear();
+
+  for ( int iCluster = 0; iCluster < nClusters; ++iCluster ) {
+
+    TrackerPulseImpl * pulse = static_cast< TrackerPulseImpl * > ( pulseCollection->getElementAt( iCluster ) );
+    TrackerDataImpl  * data  = static_cast< TrackerDataImpl * > ( pulse->getTrackerData() );
+
+    Entry & entry      = _entries[ iCluster ];
+    entry.valid        = true;
+    entry.sensorID     = pulseCellDecoder( pulse )[ "sensorID" ];
+    entry.type         = static_cast< ClusterType > ( static_cast< int > ( pulseCellDecoder( pulse )[ "type" ] ) );
+    entry.size         = 0;
+    entry.quality      = 0;
+    entry.xSeed        = entry.ySeed = 0;
+    entry.xMin         = entry.xMax = entry.yMin = entry.yMax = 0;
+    entry.xCoG         = entry.yCoG = 0;
+    entry.totalCharge  = 0;
+    entry.seedCharge   = 0;
+    entry.data         = data;
+
+    _index[ data ] = iCluster;
+
+    if ( entry.type == kEUTelSparseClusterImpl ) {
+      summarizeSparse( data, entry );
+    } else if ( entry.type == kEUTelDFFClusterImpl ) {
+      summarizeFixedFrame( EUTelDFFClusterImpl( data ), entry );
+    } else if ( entry.type == kEUTelBrickedClusterImpl ) {
+      summarizeFixedFrame( EUTelBrickedClusterImpl( data ), entry );
+    } else if ( entry.type == kEUTelFFClusterImpl ) {
+      summarizeFixedFrame( EUTelFFClusterImpl( data ), entry );
+    } else {
+      entry.valid = false;
+    }
+  }
+}
+
+const EUTelClusterSummary::Entry * EUTelClusterSummary::find( const TrackerData * data ) const {
+  map< const TrackerData *, size_t >::const_iterator iter = _index.find( data );
+  if ( iter == _index.end() ) return 0;
+  return &_entries[ iter->second ];
+}
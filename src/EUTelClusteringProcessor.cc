@@ -21,6 +21,7 @@
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelEventImpl.h"
 #include "EUTelClusteringProcessor.h"
+#include "EUTelProcessorMonitor.h"
 #include "EUTelVirtualCluster.h"
 #include "EUTelFFClusterImpl.h"
 #include "EUTelDFFClusterImpl.h"
@@ -126,7 +127,10 @@ EUTelClusteringProcessor::EUTelClusteringProcessor ()
       hotPixelCollectionVec(NULL),
       hasNZSData(false),
       hasZSData(false),
-      _hitIndexMapVec()
+      _hitIndexMapVec(),
+      _nThreads(1),
+      _threadPool(NULL),
+      _clusterFinders()
 {
 
     // modify processor description
@@ -250,11 +254,20 @@ EUTelClusteringProcessor::EUTelClusteringProcessor ()
 
     registerOptionalParameter("ExcludedPlanes", "The list of sensor ids that have to be excluded from the clustering.",
                               _ExcludedPlanes, std::vector<int> () );
+
+    registerOptionalParameter("NumberOfThreads","Number of threads used by the sparse clustering to cluster the sensors concurrently. 1 means serial processing, 0 one thread per CPU core",
+                              _nThreads, static_cast<int>(1) );
     _isFirstEvent = true;
 }
 
+EUTelClusteringProcessor::~EUTelClusteringProcessor() {
+    delete _threadPool;
+    for ( size_t i = 0; i < _clusterFinders.size(); ++i ) delete _clusterFinders[i];
+}
+
 
 void EUTelClusteringProcessor::init() {
+    EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
     // this method is called only once even when the rewind is active
     // usually a good idea to
 
@@ -303,6 +316,10 @@ void EUTelClusteringProcessor::init() {
     // the geometry is not yet initialized, so set the corresponding
     // switch to false
     _isGeometryReady = false;
+
+    delete _threadPool;
+    _threadPool = new EUTelThreadPool( _nThreads < 0 ? 1 : _nThreads );
+    streamlog_out( MESSAGE4 ) << "Sparse clustering of the sensors with " << _threadPool->size() << " thread(s)" << endl;
 }
 
 
@@ -676,6 +693,7 @@ void EUTelClusteringProcessor::readCollections (LCEvent * event)
 
 void EUTelClusteringProcessor::processEvent (LCEvent * event)
 {
+    EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
     ID = 0;
     ++_iEvt;
 
@@ -2008,7 +2026,10 @@ void EUTelClusteringProcessor::sparseClustering(LCEvent* evt, LCCollectionVec* p
     CellIDEncoder<TrackerPulseImpl> idZSPulseEncoder(EUTELESCOPE::PULSEDEFAULTENCODING, pulseCollection);
 
     // in the zsInputDataCollectionVec we should have one TrackerData for each
-    // detector working in ZS mode. We need to loop over all of them
+    // detector working in ZS mode. The hit pixels of each of them are handed
+    // to a cluster finder, and the finders run concurrently on the thread pool
+    std::vector< unsigned int > finderDetector;
+    std::vector< int > finderSensorID;
     for ( unsigned int idetector = 0 ; idetector < zsInputDataCollectionVec->size(); idetector++ )
     {
         // get the TrackerData and guess which kind of sparsified data it contains.
@@ -2031,163 +2052,123 @@ void EUTelClusteringProcessor::sparseClustering(LCEvent* evt, LCCollectionVec* p
             continue;
         }
 
-        // reset the cluster counter for the clusterID
-        int clusterID = 0;
-
-        if ( type == kEUTelGenericSparsePixel )
+        if ( type != kEUTelGenericSparsePixel )
         {
+            // the finders already submitted must not be running any more
+            _threadPool->wait();
+            throw UnknownDataTypeException("Unknown sparsified pixel");
+        }
 
-            // now prepare the EUTelescope interface to sparsified data.
-            auto_ptr<EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel > > sparseData( new EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel> ( zsData ) );
+        if ( _clusterFinders.size() <= finderSensorID.size() ) _clusterFinders.push_back( new SensorClusterFinder );
+        SensorClusterFinder * finder = _clusterFinders[ finderSensorID.size() ];
+        finder->setCut( EUTelPixelDistanceCut( _sparseMinDistanceSquared ) );
 
-            streamlog_out ( DEBUG2 ) << "Processing sparse data on detector " << sensorID << " with " << sparseData->size() << " pixels " << endl;
+        // now prepare the EUTelescope interface to sparsified data.
+        EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel> sparseData( zsData );
 
-            int hitPixelsInEvent = sparseData->size();
-            std::vector<EUTelGenericSparsePixel> hitPixelVec;
-            EUTelGenericSparsePixel* pixel = new EUTelGenericSparsePixel;
+        streamlog_out ( DEBUG2 ) << "Processing sparse data on detector " << sensorID << " with " << sparseData.size() << " pixels " << endl;
 
-            //This for-loop loads all the hits of the given event and detector plane and stores them
-            for(int i = 0; i < hitPixelsInEvent; ++i )
-            {
-                //Load the information of the hit pixel into genericPixel
-                sparseData->getSparsePixelAt( i, pixel );
-                EUTelGenericSparsePixel hitPixel( *pixel );
+        //This for-loop loads all the hits of the given event and detector plane and stores them
+        std::vector<EUTelGenericSparsePixel> & hitPixelVec = finder->pixels();
+        hitPixelVec.clear();
+        hitPixelVec.reserve( sparseData.size() );
+        EUTelGenericSparsePixel pixel;
+        for( unsigned int i = 0; i < sparseData.size(); ++i )
+        {
+            sparseData.getSparsePixelAt( i, &pixel );
+            hitPixelVec.push_back( pixel );
+        }
 
-                //and push this pixel back
-                hitPixelVec.push_back( hitPixel );
-            }
+        finderDetector.push_back( idetector );
+        finderSensorID.push_back( sensorID );
+        _threadPool->submit( finder );
+    }
+    _threadPool->wait();
 
-            std::vector<EUTelGenericSparsePixel> newlyAdded;
-            //We now cluster those hits together
-            while( !hitPixelVec.empty() )
-            {
-                // prepare a TrackerData to store the cluster candidate
-                auto_ptr< TrackerDataImpl > zsCluster ( new TrackerDataImpl );
-                // prepare a reimplementation of sparsified cluster
-                auto_ptr<EUTelSparseClusterImpl<EUTelGenericSparsePixel > > sparseCluster ( new EUTelSparseClusterImpl<EUTelGenericSparsePixel>( zsCluster.get() ) );
-
-                std::vector<EUTelGenericSparsePixel> cluCandidate;
-
-                //First we need to take any pixel, so let's take the first one
-                //Add it to the cluster as well as the newly added pixels
-                newlyAdded.push_back( hitPixelVec.front() );
-                //sparseCluster->addSparsePixel( &(hitPixelVec.front()) );
-                cluCandidate.push_back( hitPixelVec.front() );
-                //And remove it from the original collection
-                hitPixelVec.erase( hitPixelVec.begin() );
-
-                //Now process all newly added pixels, initially this is the just previously added one
-                //but in the process of neighbour finding we continue to add new pixels
-                while( !newlyAdded.empty() )
-                {
-                    bool newlyDone = true;
-                    int  x1, x2, y1, y2, dX, dY;
+    // Now the cluster candidates are cleaned from the hot pixels and
+    // stored, in the order of the sensors in the input collection
+    for ( size_t iFinder = 0; iFinder < finderSensorID.size(); ++iFinder )
+    {
+        const SensorClusterFinder * finder = _clusterFinders[ iFinder ];
+        const std::vector<EUTelGenericSparsePixel> & clusterPixels = finder->getClusterPixels();
+        unsigned int idetector = finderDetector[ iFinder ];
+        int sensorID = finderSensorID[ iFinder ];
 
-                    //check against all pixels in the hitPixelVec
-                    for( std::vector<EUTelGenericSparsePixel>::iterator hitVec = hitPixelVec.begin(); hitVec != hitPixelVec.end(); ++hitVec )
-                    {
-                        //get the relevant infos from the newly added pixel
-                        x1 = newlyAdded.front().getXCoord();
-                        y1 = newlyAdded.front().getYCoord();
-
-                        //and the pixel we test against
-                        x2 = hitVec->getXCoord();
-                        y2 = hitVec->getYCoord();
-
-                        dX = x1 - x2;
-                        dY = y1 - y2;
-                        int distance = dX*dX+dY*dY;
-                        //if they pass the spatial and temporal cuts, we add them
-                        if( distance <= _sparseMinDistanceSquared )
-                        {
-                            //add them to the cluster as well as to the newly added ones
-                            newlyAdded.push_back( *hitVec );
-                            cluCandidate.push_back( *hitVec );
-                            //	sparseCluster->addSparsePixel( &(*hitVec) );
-                            //and remove it from the original collection
-                            hitPixelVec.erase( hitVec );
-                            //for the pixel we test there might be other neighbours, we still have to check
-                            newlyDone = false;
-                            break;
-                        }
-                    }
+        if ( finder->getNumberOfClusters() == 0 ) continue;
 
-                    //if no neighbours are found, we can delete the pixel from the newly added
-                    //we tested against _ALL_ non cluster pixels, there are no other pixels
-                    //which could be neighbours
-                    if(newlyDone) newlyAdded.erase( newlyAdded.begin() );
-                }
+        // get the noise matrix with the right detectorID
+        TrackerDataImpl* noise  = dynamic_cast<TrackerDataImpl*>   (noiseCollectionVec->getElementAt( _ancillaryIndexMap[ sensorID ] ));
+        // prepare the matrix decoder
+        EUTelMatrixDecoder matrixDecoder( noiseDecoder , noise );
 
-                // get the noise matrix with the right detectorID
-                TrackerDataImpl* noise  = dynamic_cast<TrackerDataImpl*>   (noiseCollectionVec->getElementAt( _ancillaryIndexMap[ sensorID ] ));
-                // prepare the matrix decoder
-                EUTelMatrixDecoder matrixDecoder( noiseDecoder , noise );
-                // prepare a vector to store the noise values
-                vector<float> noiseValueVec;
+        // reset the cluster counter for the clusterID
+        int clusterID = 0;
 
-                //Hot pixel removement:
-                while(!cluCandidate.empty())
-                {
-                    EUTelGenericSparsePixel pixel = cluCandidate.front();
-                    cluCandidate.erase( cluCandidate.begin() );
+        for ( unsigned int iCluster = 0; iCluster < finder->getNumberOfClusters(); ++iCluster )
+        {
+            // prepare a TrackerData to store the cluster candidate
+            auto_ptr< TrackerDataImpl > zsCluster ( new TrackerDataImpl );
+            // prepare a reimplementation of sparsified cluster
+            auto_ptr<EUTelSparseClusterImpl<EUTelGenericSparsePixel > > sparseCluster ( new EUTelSparseClusterImpl<EUTelGenericSparsePixel>( zsCluster.get() ) );
 
-                    int index = matrixDecoder.getIndexFromXY( pixel.getXCoord(), pixel.getYCoord() );
-                    if( _hitIndexMapVec[idetector].find( index ) != _hitIndexMapVec[idetector].end() )
-                    {
-                        // do nothing
-                    }
-                    else
-                    {
-                        sparseCluster->addSparsePixel( &pixel );
-                        noiseValueVec.push_back(noise->getChargeValues()[ index ]);
-                    }
-                }
+            // prepare a vector to store the noise values
+            vector<float> noiseValueVec;
 
-                sparseCluster->setNoiseValues( noiseValueVec );
+            //Hot pixel removement:
+            for ( unsigned int iPixel = finder->getClusterStart( iCluster ); iPixel < finder->getClusterStart( iCluster + 1 ); ++iPixel )
+            {
+                EUTelGenericSparsePixel pixel = clusterPixels[ iPixel ];
 
-                //Now we need to process the found cluster
-                if ( (sparseCluster->size() > 0) && (sparseCluster->getSeedSNR() >= _sparseSeedCut) && (sparseCluster->getClusterSNR() >= _sparseClusterCut) )
+                int index = matrixDecoder.getIndexFromXY( pixel.getXCoord(), pixel.getYCoord() );
+                if( _hitIndexMapVec[idetector].find( index ) != _hitIndexMapVec[idetector].end() )
                 {
-                    // set the ID for this zsCluster
-                    idZSClusterEncoder["sensorID"] = sensorID;
-                    idZSClusterEncoder["sparsePixelType"] = static_cast<int>( type );
-                    idZSClusterEncoder["quality"] = 0;
-                    idZSClusterEncoder.setCellID( zsCluster.get() );
-                    zsCluster->setTime(ID);
-
-                    // add it to the cluster collection
-                    sparseClusterCollectionVec->push_back( zsCluster.get() );
-
-                    // prepare a pulse for this cluster
-                    auto_ptr<TrackerPulseImpl> zsPulse ( new TrackerPulseImpl );
-                    idZSPulseEncoder["sensorID"] = sensorID;
-                    idZSPulseEncoder["type"] = static_cast<int>(kEUTelSparseClusterImpl);
-                    idZSPulseEncoder.setCellID( zsPulse.get() );
-
-                    zsPulse->setTime(ID);
-                    ID++;
-                    //zsPulse->setCharge( sparseCluster->getTotalCharge() );
-                    zsPulse->setTrackerData( zsCluster.release() );
-                    pulseCollection->push_back( zsPulse.release() );
-
-                    // last but not least increment the totClusterMap
-                    ++clusterID;
-                    _totClusterMap[ sensorID ] += 1;
-                } //cluster processing if
-
+                    // do nothing
+                }
                 else
                 {
-                    //in the case the cluster candidate is not passing the threshold ...
-                    //forget about them, the memory should be automatically cleaned by auto_ptr's
+                    sparseCluster->addSparsePixel( &pixel );
+                    noiseValueVec.push_back(noise->getChargeValues()[ index ]);
                 }
-            } //loop over all found clusters
+            }
 
-            delete pixel;
-        }
-        else
-        {
-            throw UnknownDataTypeException("Unknown sparsified pixel");
-        }
+            sparseCluster->setNoiseValues( noiseValueVec );
+
+            //Now we need to process the found cluster
+            if ( (sparseCluster->size() > 0) && (sparseCluster->getSeedSNR() >= _sparseSeedCut) && (sparseCluster->getClusterSNR() >= _sparseClusterCut) )
+            {
+                // set the ID for this zsCluster
+                idZSClusterEncoder["sensorID"] = sensorID;
+                idZSClusterEncoder["sparsePixelType"] = static_cast<int>( kEUTelGenericSparsePixel );
+                idZSClusterEncoder["quality"] = 0;
+                idZSClusterEncoder.setCellID( zsCluster.get() );
+                zsCluster->setTime(ID);
+
+                // add it to the cluster collection
+                sparseClusterCollectionVec->push_back( zsCluster.get() );
+
+                // prepare a pulse for this cluster
+                auto_ptr<TrackerPulseImpl> zsPulse ( new TrackerPulseImpl );
+                idZSPulseEncoder["sensorID"] = sensorID;
+                idZSPulseEncoder["type"] = static_cast<int>(kEUTelSparseClusterImpl);
+                idZSPulseEncoder.setCellID( zsPulse.get() );
+
+                zsPulse->setTime(ID);
+                ID++;
+                //zsPulse->setCharge( sparseCluster->getTotalCharge() );
+                zsPulse->setTrackerData( zsCluster.release() );
+                pulseCollection->push_back( zsPulse.release() );
+
+                // last but not least increment the totClusterMap
+                ++clusterID;
+                _totClusterMap[ sensorID ] += 1;
+            } //cluster processing if
+
+            else
+            {
+                //in the case the cluster candidate is not passing the threshold ...
+                //forget about them, the memory should be automatically cleaned by auto_ptr's
+            }
+        } //loop over all found clusters
     } // this is the end of the loop over all ZS detectors
 
     // if the sparseClusterCollectionVec isn't empty add it to the
@@ -2845,6 +2826,7 @@ void EUTelClusteringProcessor::check (LCEvent * /* evt */) {
 
 
 void EUTelClusteringProcessor::end() {
+    EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
     int max = 0, maxBin = -1;
     for (int iBin=0; iBin<1000; iBin++)
     {
@@ -76,6 +76,8 @@
 #include <vector>
 #include <map>
 #include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
 
 using namespace std;
 using namespace lcio ;
@@ -123,6 +125,8 @@ EUTelDUTHistograms::EUTelDUTHistograms()
   _bgfittedX(),
   _bgfittedY(),
   _DUTalign(),
+  _hitGrid(),
+  _hitMatched(),
 _ClusterSizeHistos(),
 _ShiftHistos(),
 _MeasuredHistos(),
@@ -133,6 +137,14 @@ _EfficiencyHistos(),
 _BgEfficiencyHistos(),
 _NoiseHistos(),
 _BgShiftHistos(),
+_ClusterSizeHistoSet(),
+_ShiftHistoSet(),
+_MeasuredHistoSet(),
+_MatchedHistoSet(),
+_UnMatchedHistoSet(),
+_FittedHistoSet(),
+_EfficiencyHistoSet(),
+_NoiseHistoSet(),
 _ShiftXvsYHisto(),
 _ShiftYvsXHisto(),
 _ShiftXvsXHisto(),
@@ -349,10 +361,9 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
   {
     for( int ifit=0;ifit<static_cast<int>(_fittedX[itrack].size()); ifit++)
     {
-      (dynamic_cast<AIDA::IHistogram1D*> ( _FittedHistos.at(projX)))->fill(_fittedX[itrack][ifit]);
-
-      (dynamic_cast<AIDA::IHistogram1D*> ( _FittedHistos.at(projY)))->fill(_fittedY[itrack][ifit]);
-      (dynamic_cast<AIDA::IHistogram2D*> ( _FittedHistos.at(projXY)))->fill(_fittedX[itrack][ifit],_fittedY[itrack][ifit]);
+      _FittedHistoSet.x->fill(_fittedX[itrack][ifit]);
+      _FittedHistoSet.y->fill(_fittedY[itrack][ifit]);
+      _FittedHistoSet.xy->fill(_fittedX[itrack][ifit],_fittedY[itrack][ifit]);
       if(streamlog_level(DEBUG5)){
 	message<DEBUG5> ( log() << "Fit " << ifit << " [track:"<< itrack << "] "
 			  << "   X = " << _fittedX[itrack][ifit]
@@ -367,9 +378,9 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
   // Histograms of measured positions
   for(int ihit=0;ihit<static_cast<int>(_measuredX.size()); ihit++)
     {
-      (dynamic_cast<AIDA::IHistogram1D*> ( _MeasuredHistos.at(projX)))->fill(_measuredX[ihit]);
-      (dynamic_cast<AIDA::IHistogram1D*> ( _MeasuredHistos.at(projY)))->fill(_measuredY[ihit]);
-      (dynamic_cast<AIDA::IHistogram2D*> ( _MeasuredHistos.at(projXY)))->fill(_measuredX[ihit],_measuredY[ihit]);
+      _MeasuredHistoSet.x->fill(_measuredX[ihit]);
+      _MeasuredHistoSet.y->fill(_measuredY[ihit]);
+      _MeasuredHistoSet.xy->fill(_measuredX[ihit],_measuredY[ihit]);
       if(streamlog_level(DEBUG5)){
 	message<DEBUG5> ( log() << "Hit " << ihit
 			  << "   X = " << _measuredX[ihit]
@@ -380,40 +391,64 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
 
 
   // Match measured and fitted positions
+  // Tracks are taken in turn, each one is matched to the closest
+  // measured hit not taken by a previous track. The candidate hits are
+  // looked up in the grid cells around the fitted position instead of
+  // looping over all of them; ties are resolved as in a full loop over
+  // the fits and then over the hits of the track.
+
+  fillHitGrid();
+  _hitMatched.assign(_measuredX.size(), false);
 
   int nMatch=0;
-  double distmin;
+  int nUnMatched=static_cast<int>(_measuredX.size());
+  const double distMax2 = _distMax*_distMax;
 
   for(int itrack=0; itrack< _maptrackid; itrack++)
   {
     int bestfit=-1;
     int besthit=-1;
 
-    distmin = _distMax*_distMax + 10. ;
+    double distmin = distMax2;
  
     if( static_cast<int>(_fittedX[itrack].size()) < 1 ) continue;
  
     for(int ifit=0;ifit<static_cast<int>(_fittedX[itrack].size()); ifit++)
     {
-      if( _measuredX.empty() ) continue;
+      if( _hitGrid.empty() ) continue;
 
-      for(int ihit=0; ihit< static_cast<int>(_measuredX.size()) ; ihit++)
-        {
+      const double fitX = _fittedX[itrack][ifit];
+      const double fitY = _fittedY[itrack][ifit];
+      const int cellXMin = getGridCell( fitX - std::fabs(_distMax) );
+      const int cellXMax = getGridCell( fitX + std::fabs(_distMax) );
+      const std::pair< int, int > cellYRange( getGridCell( fitY - std::fabs(_distMax) ),
+                                              getGridCell( fitY + std::fabs(_distMax) ) );
 
-          double dist2rd=
-            (_measuredX[ihit]-_fittedX[itrack][ifit])*(_measuredX[ihit]-_fittedX[itrack][ifit])
-            + (_measuredY[ihit]-_fittedY[itrack][ifit])*(_measuredY[ihit]-_fittedY[itrack][ifit]);
+      for(int cellX = cellXMin; cellX <= cellXMax; cellX++)
+        {
+          std::vector< std::pair< std::pair< int, int >, int > >::const_iterator cell =
+            std::lower_bound( _hitGrid.begin(), _hitGrid.end(), std::make_pair( std::make_pair( cellX, cellYRange.first ), -1 ) );
 
-	  if(streamlog_level(DEBUG5)){
-	    message<DEBUG5> ( log() << "Fit ["<< itrack << ":" << _maptrackid <<"], ifit= " << ifit << " ["<< _fittedX[itrack][ifit] << ":" << _fittedY[itrack][ifit] << "]" << endl) ;
-	    message<DEBUG5> ( log() << "rec " << ihit << " ["<< _measuredX[ihit] << ":" << _measuredY[ihit] << "]" << endl) ;
-	    message<DEBUG5> ( log() << "distance : " << TMath::Sqrt( dist2rd )  << endl) ;
-	  }
-          if(dist2rd<distmin)
+          for( ; cell != _hitGrid.end() && cell->first <= std::make_pair( cellX, cellYRange.second ); ++cell)
             {
-              distmin = dist2rd;
-              besthit = ihit;
-              bestfit = ifit;
+              const int ihit = cell->second;
+              if( _hitMatched[ihit] ) continue;
+
+              double dist2rd=
+                (_measuredX[ihit]-fitX)*(_measuredX[ihit]-fitX)
+                + (_measuredY[ihit]-fitY)*(_measuredY[ihit]-fitY);
+
+	      if(streamlog_level(DEBUG5)){
+		message<DEBUG5> ( log() << "Fit ["<< itrack << ":" << _maptrackid <<"], ifit= " << ifit << " ["<< fitX << ":" << fitY << "]" << endl) ;
+		message<DEBUG5> ( log() << "rec " << ihit << " ["<< _measuredX[ihit] << ":" << _measuredY[ihit] << "]" << endl) ;
+		message<DEBUG5> ( log() << "distance : " << TMath::Sqrt( dist2rd )  << endl) ;
+	      }
+              if( dist2rd < distmin || ( dist2rd == distmin && ifit == bestfit && ihit < besthit ) )
+                {
+                  distmin = dist2rd;
+                  besthit = ihit;
+                  bestfit = ifit;
+                }
             }
         }
  
@@ -421,64 +456,64 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
  
     // Match found:
 
-    if( distmin < _distMax*_distMax  )
+    if( besthit >= 0 )
       {
 
         nMatch++;
+        nUnMatched--;
+        _hitMatched[besthit] = true;
 
         // Matched hits positions
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 
+        const detMatrix subMatrix = getHitSubMatrix(besthit);
+
 	// fill once for any matrix ("full detector")
-        (dynamic_cast<AIDA::IHistogram1D*> ( _ClusterSizeHistos.at(projX).at(FullDetector)))->fill(_clusterSizeX[besthit]+0.0);
-        (dynamic_cast<AIDA::IHistogram1D*> ( _ClusterSizeHistos.at(projY).at(FullDetector)))->fill(_clusterSizeY[besthit]+0.0);
-        (dynamic_cast<AIDA::IHistogram2D*> ( _ClusterSizeHistos.at(projXY).at(FullDetector)))->fill(_clusterSizeX[besthit]+0.0,_clusterSizeY[besthit]+0.0);
+        _ClusterSizeHistoSet[FullDetector].x->fill(_clusterSizeX[besthit]+0.0);
+        _ClusterSizeHistoSet[FullDetector].y->fill(_clusterSizeY[besthit]+0.0);
+        _ClusterSizeHistoSet[FullDetector].xy->fill(_clusterSizeX[besthit]+0.0,_clusterSizeY[besthit]+0.0);
 
 	// .. and once for the submatrix (identified by the index)
-        (dynamic_cast<AIDA::IHistogram1D*> ( _ClusterSizeHistos.at(projX).at(static_cast<detMatrix>(_subMatrix[besthit]))))
-	  ->fill(_clusterSizeX[besthit]+0.0);
-        (dynamic_cast<AIDA::IHistogram1D*> ( _ClusterSizeHistos.at(projY).at(static_cast<detMatrix>(_subMatrix[besthit]))))
-	  ->fill(_clusterSizeY[besthit]+0.0);
-        (dynamic_cast<AIDA::IHistogram2D*> ( _ClusterSizeHistos.at(projXY).at(static_cast<detMatrix>(_subMatrix[besthit]))))
-	  ->fill(_clusterSizeX[besthit]+0.0,_clusterSizeY[besthit]+0.0);
+        _ClusterSizeHistoSet[subMatrix].x->fill(_clusterSizeX[besthit]+0.0);
+        _ClusterSizeHistoSet[subMatrix].y->fill(_clusterSizeY[besthit]+0.0);
+        _ClusterSizeHistoSet[subMatrix].xy->fill(_clusterSizeX[besthit]+0.0,_clusterSizeY[besthit]+0.0);
 
 
-        (dynamic_cast<AIDA::IHistogram1D*> ( _MatchedHistos.at(projX)))->fill(_measuredX[besthit]);
-        (dynamic_cast<AIDA::IHistogram1D*> ( _MatchedHistos.at(projY)))->fill(_measuredY[besthit]);
-        (dynamic_cast<AIDA::IHistogram2D*> ( _MatchedHistos.at(projXY)))->fill(_measuredX[besthit],_measuredY[besthit]);
+        _MatchedHistoSet.x->fill(_measuredX[besthit]);
+        _MatchedHistoSet.y->fill(_measuredY[besthit]);
+        _MatchedHistoSet.xy->fill(_measuredX[besthit],_measuredY[besthit]);
 
         // Histograms of measured-fitted shifts
         double shiftX =  _measuredX[besthit]-_fittedX[itrack][bestfit];
         double shiftY =  _measuredY[besthit]-_fittedY[itrack][bestfit];
 
 	// fill global: any matrix, any cluster size (cluster size 0 -> any cluster size)
-	(dynamic_cast<AIDA::IHistogram1D*> (_ShiftHistos.at(projX).at(FullDetector).at(0)))->fill(shiftX);
-	(dynamic_cast<AIDA::IHistogram1D*> (_ShiftHistos.at(projY).at(FullDetector).at(0)))->fill(shiftY);
-	(dynamic_cast<AIDA::IHistogram2D*> (_ShiftHistos.at(projXY).at(FullDetector).at(0)))->fill(shiftX, shiftY);
+	_ShiftHistoSet[FullDetector][0].x->fill(shiftX);
+	_ShiftHistoSet[FullDetector][0].y->fill(shiftY);
+	_ShiftHistoSet[FullDetector][0].xy->fill(shiftX, shiftY);
         
 	// fill for submatrix and any cluster size
-	(dynamic_cast<AIDA::IHistogram1D*> (_ShiftHistos.at(projX).at(static_cast<detMatrix>(_subMatrix[besthit])).at(0)))->fill(shiftX);
-	(dynamic_cast<AIDA::IHistogram1D*> (_ShiftHistos.at(projY).at(static_cast<detMatrix>(_subMatrix[besthit])).at(0)))->fill(shiftY);
-	(dynamic_cast<AIDA::IHistogram2D*> (_ShiftHistos.at(projXY).at(static_cast<detMatrix>(_subMatrix[besthit])).at(0)))->fill(shiftX, shiftY);
+	_ShiftHistoSet[subMatrix][0].x->fill(shiftX);
+	_ShiftHistoSet[subMatrix][0].y->fill(shiftY);
+	_ShiftHistoSet[subMatrix][0].xy->fill(shiftX, shiftY);
 	
 	// check that the cluster size is within the limits of our multi diff. binning
-	if (_clusterSizeX[besthit] <= HistoMaxClusterSize && _clusterSizeY[besthit] <= HistoMaxClusterSize){
+	if (_clusterSizeX[besthit] >= 0 && _clusterSizeY[besthit] >= 0
+	    && _clusterSizeX[besthit] <= HistoMaxClusterSize && _clusterSizeY[besthit] <= HistoMaxClusterSize){
 	  // fill for any matrix
-	  (dynamic_cast<AIDA::IHistogram1D*> (_ShiftHistos.at(projX).at(FullDetector).at(_clusterSizeX[besthit])))->fill(shiftX);
-	  (dynamic_cast<AIDA::IHistogram1D*> (_ShiftHistos.at(projY).at(FullDetector).at(_clusterSizeY[besthit])))->fill(shiftY);
+	  _ShiftHistoSet[FullDetector][_clusterSizeX[besthit]].x->fill(shiftX);
+	  _ShiftHistoSet[FullDetector][_clusterSizeY[besthit]].y->fill(shiftY);
 	  // for XY: only if cluster size identical in both x and y
 	  if (_clusterSizeX[besthit]==_clusterSizeY[besthit]){
-	    (dynamic_cast<AIDA::IHistogram2D*> (_ShiftHistos.at(projXY).at(FullDetector).at(_clusterSizeX[besthit])))->fill(shiftX, shiftY);}
+	    _ShiftHistoSet[FullDetector][_clusterSizeX[besthit]].xy->fill(shiftX, shiftY);}
 
 	  // fill for submatrix
-	  (dynamic_cast<AIDA::IHistogram1D*> (_ShiftHistos.at(projX).at(static_cast<detMatrix>(_subMatrix[besthit])).at(_clusterSizeX[besthit])))
-	    ->fill(shiftX);
-	  (dynamic_cast<AIDA::IHistogram1D*> (_ShiftHistos.at(projY).at(static_cast<detMatrix>(_subMatrix[besthit])).at(_clusterSizeY[besthit])))
-	    ->fill(shiftY);
+	  _ShiftHistoSet[subMatrix][_clusterSizeX[besthit]].x->fill(shiftX);
+	  _ShiftHistoSet[subMatrix][_clusterSizeY[besthit]].y->fill(shiftY);
 	  // for XY: only if cluster size identical in both x and y
 	  if (_clusterSizeX[besthit]==_clusterSizeY[besthit]){
-	    (dynamic_cast<AIDA::IHistogram2D*> (_ShiftHistos.at(projXY).at(static_cast<detMatrix>(_subMatrix[besthit])).at(_clusterSizeX[besthit])))->fill(shiftX, shiftY);}
+	    _ShiftHistoSet[subMatrix][_clusterSizeX[besthit]].xy->fill(shiftX, shiftY);}
 	}
 
 
@@ -535,27 +570,25 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
         _EtaY2DHisto->fill(_localY[itrack][bestfit],_measuredY[besthit]-_fittedY[itrack][bestfit]);
 
         // Efficiency plots
-        (dynamic_cast<AIDA::IProfile1D*> ( _EfficiencyHistos.at(projX)))->fill(_fittedX[itrack][bestfit],1.);
-        (dynamic_cast<AIDA::IProfile1D*> ( _EfficiencyHistos.at(projY)))->fill(_fittedY[itrack][bestfit],1.);
-        (dynamic_cast<AIDA::IProfile2D*> ( _EfficiencyHistos.at(projXY)))->fill(_fittedX[itrack][bestfit],_fittedY[itrack][bestfit],1.);
+        _EfficiencyHistoSet.x->fill(_fittedX[itrack][bestfit],1.);
+        _EfficiencyHistoSet.y->fill(_fittedY[itrack][bestfit],1.);
+        _EfficiencyHistoSet.xy->fill(_fittedX[itrack][bestfit],_fittedY[itrack][bestfit],1.);
 
 
         // Noise plots
-        (dynamic_cast<AIDA::IProfile1D*> ( _NoiseHistos.at(projX)))->fill(_measuredX[besthit],0.);
-        (dynamic_cast<AIDA::IProfile1D*> ( _NoiseHistos.at(projY)))->fill(_measuredY[besthit],0.);
-        (dynamic_cast<AIDA::IProfile2D*> ( _NoiseHistos.at(projXY)))->fill(_measuredX[besthit],_measuredY[besthit],0.);
+        _NoiseHistoSet.x->fill(_measuredX[besthit],0.);
+        _NoiseHistoSet.y->fill(_measuredY[besthit],0.);
+        _NoiseHistoSet.xy->fill(_measuredX[besthit],_measuredY[besthit],0.);
 
 #endif
 
-        // Remove matched entries from the list (so the next matching pair
-        // can be looked for)
+        // Remove the matched fit from the list of the track; the matched
+        // hit is only flagged, so that its index stays valid for the
+        // cluster size and sub matrix vectors
 
         _fittedX[itrack].erase(_fittedX[itrack].begin()+bestfit);
         _fittedY[itrack].erase(_fittedY[itrack].begin()+bestfit);
 
-        _measuredX.erase(_measuredX.begin()+besthit);
-        _measuredY.erase(_measuredY.begin()+besthit);
-
         _localX[itrack].erase(_localX[itrack].begin()+bestfit);
         _localY[itrack].erase(_localY[itrack].begin()+bestfit);
 
@@ -566,7 +599,7 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
 
     if(streamlog_level(DEBUG5)){
       message<DEBUG5> ( log() << nMatch << " DUT hits matched to fitted tracks ");
-      message<DEBUG5> ( log() << _measuredX.size() << " DUT hits not matched to any track ");
+      message<DEBUG5> ( log() << nUnMatched << " DUT hits not matched to any track ");
       message<DEBUG5> ( log() << "track "<<itrack<<" has " << _fittedX[itrack].size() << " _fittedX[itrack].size() not matched to any DUT hit ");
     }
 
@@ -581,9 +614,9 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
 
   for(int ifit=0;ifit<static_cast<int>(_fittedX[itrack].size()); ifit++)
     {
-      (dynamic_cast<AIDA::IProfile1D*> ( _EfficiencyHistos.at(projX)))->fill(_fittedX[itrack][ifit],0.);
-      (dynamic_cast<AIDA::IProfile1D*> ( _EfficiencyHistos.at(projY)))->fill(_fittedY[itrack][ifit],0.);
-      (dynamic_cast<AIDA::IProfile2D*> ( _EfficiencyHistos.at(projXY)))->fill(_fittedX[itrack][ifit],_fittedY[itrack][ifit],0.);
+      _EfficiencyHistoSet.x->fill(_fittedX[itrack][ifit],0.);
+      _EfficiencyHistoSet.y->fill(_fittedY[itrack][ifit],0.);
+      _EfficiencyHistoSet.xy->fill(_fittedX[itrack][ifit],_fittedY[itrack][ifit],0.);
     }
   #endif
 }
@@ -594,14 +627,16 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
   // Noise plots - unmatched hits
 
   for(int ihit=0;ihit<static_cast<int>(_measuredX.size()); ihit++){
-      (dynamic_cast<AIDA::IProfile1D*> ( _NoiseHistos.at(projX)))->fill(_measuredX[ihit],1.);
-      (dynamic_cast<AIDA::IProfile1D*> ( _NoiseHistos.at(projY)))->fill(_measuredY[ihit],1.);
-      (dynamic_cast<AIDA::IProfile2D*> ( _NoiseHistos.at(projXY)))->fill(_measuredX[ihit],_measuredY[ihit],1.);
+      if( _hitMatched[ihit] ) continue;
+
+      _NoiseHistoSet.x->fill(_measuredX[ihit],1.);
+      _NoiseHistoSet.y->fill(_measuredY[ihit],1.);
+      _NoiseHistoSet.xy->fill(_measuredX[ihit],_measuredY[ihit],1.);
 
       // Unmatched hit positions
-      (dynamic_cast<AIDA::IHistogram1D*> ( _UnMatchedHistos.at(projX)))->fill(_measuredX[ihit]);
-      (dynamic_cast<AIDA::IHistogram1D*> ( _UnMatchedHistos.at(projY)))->fill(_measuredY[ihit]);
-      (dynamic_cast<AIDA::IHistogram2D*> ( _UnMatchedHistos.at(projXY)))->fill(_measuredX[ihit],_measuredY[ihit]);
+      _UnMatchedHistoSet.x->fill(_measuredX[ihit]);
+      _UnMatchedHistoSet.y->fill(_measuredY[ihit]);
+      _UnMatchedHistoSet.xy->fill(_measuredX[ihit],_measuredY[ihit]);
 
     }
 
@@ -1712,6 +1747,8 @@ void EUTelDUTHistograms::bookHistos()
   _PixelChargeSharingHisto->setTitle( pixTitle.c_str());
 
 
+  setHistoSets();
+
   message<DEBUG5> ( log() << "Histogram booking completed \n\n");
 #else
   message<MESSAGE5> ( log() << "No histogram produced because Marlin doesn't use AIDA" );
@@ -1800,6 +1837,74 @@ int EUTelDUTHistograms::getSubMatrix(int detectorID, float xlocal)
    return subquarter;       
 }  
 
+void EUTelDUTHistograms::fillHitGrid()
+{
+  _hitGrid.clear();
+
+  // no hit can be closer than a zero distance
+  if( _distMax == 0. ) return;
+
+  for(int ihit=0; ihit<static_cast<int>(_measuredX.size()); ihit++)
+    {
+      _hitGrid.push_back( std::make_pair( std::make_pair( getGridCell(_measuredX[ihit]), getGridCell(_measuredY[ihit]) ), ihit ) );
+    }
+
+  std::sort( _hitGrid.begin(), _hitGrid.end() );
+}
+
+int EUTelDUTHistograms::getGridCell( double position ) const
+{
+  const double cell = std::floor( position / std::fabs(_distMax) );
+
+  // far away and not finite positions are kept in the int range, the
+  // distance to them decides that they do not match
+  if( !( cell > -1.e9 ) ) return -1000000000;
+  if( cell > 1.e9 ) return 1000000000;
+  return static_cast<int>( cell );
+}
+
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+void EUTelDUTHistograms::setHistoSets()
+{
+  for(int thisMatrix = 0; thisMatrix <= FullDetector; thisMatrix++)
+    {
+      std::map< projAxis, AIDA::IBaseHistogram* > histos;
+
+      for(int thisProjection = projX; thisProjection <= projXY; thisProjection++)
+        {
+          histos[static_cast<projAxis>(thisProjection)] = _ClusterSizeHistos.at(static_cast<projAxis>(thisProjection)).at(static_cast<detMatrix>(thisMatrix));
+        }
+      _ClusterSizeHistoSet[thisMatrix].set( histos );
+
+      for(int thisClusterSize = 0; thisClusterSize <= HistoMaxClusterSize; thisClusterSize++)
+        {
+          for(int thisProjection = projX; thisProjection <= projXY; thisProjection++)
+            {
+              histos[static_cast<projAxis>(thisProjection)] = _ShiftHistos.at(static_cast<projAxis>(thisProjection)).at(static_cast<detMatrix>(thisMatrix)).at(thisClusterSize);
+            }
+          _ShiftHistoSet[thisMatrix][thisClusterSize].set( histos );
+        }
+    }
+
+  _MeasuredHistoSet.set( _MeasuredHistos );
+  _MatchedHistoSet.set( _MatchedHistos );
+  _UnMatchedHistoSet.set( _UnMatchedHistos );
+  _FittedHistoSet.set( _FittedHistos );
+  _EfficiencyHistoSet.set( _EfficiencyHistos );
+  _NoiseHistoSet.set( _NoiseHistos );
+}
+
+EUTelDUTHistograms::detMatrix EUTelDUTHistograms::getHitSubMatrix( int ihit ) const
+{
+  const int subMatrix = _subMatrix.at(ihit);
+  if( subMatrix < 0 || subMatrix > FullDetector )
+    {
+      throw std::out_of_range( "EUTelDUTHistograms: sub matrix index out of range" );
+    }
+  return static_cast<detMatrix>( subMatrix );
+}
+#endif
+
 // -------------------------------------------------------------------------------------------
 int EUTelDUTHistograms::read_track_from_collections(LCEvent *event)
 {
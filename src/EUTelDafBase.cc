@@ -38,6 +38,7 @@
 #if defined(USE_GEAR)
 // eutelescope includes ".h"
 #include "EUTelDafBase.h"
+#include "EUTelProcessorMonitor.h"
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelEventImpl.h"
 #include "EUTELESCOPE.h"
@@ -314,6 +315,7 @@ void EUTelDafBase::getPlaneNorm(daffitter::FitPlane& pl){
 }
 
 void EUTelDafBase::init() {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
   trackstream.open(_asciiName.c_str());
   
   printParameters ();
@@ -544,6 +546,7 @@ int EUTelDafBase::checkInTime(){
 }
 
 void EUTelDafBase::processEvent(LCEvent * event){
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
   try{
     _clusterVec = dynamic_cast < LCCollectionVec * > (event->getCollection( _clusterCollectionName));
   } catch(...){
@@ -863,6 +866,7 @@ double GetAverageResolution(std::vector< double > averageresidual){
 }
 
 void EUTelDafBase::end() {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
 
   for(std::map< int, std::vector < double > >::iterator it = _xPositionForClustering.begin(); it != _xPositionForClustering.end(); ++it){
     double newx = minx + binsizex*it->first;
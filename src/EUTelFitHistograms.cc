@@ -17,6 +17,7 @@
 
 // eutelescope includes
 #include "EUTelFitHistograms.h"
+#include "EUTelProcessorMonitor.h"
 #include "EUTelVirtualCluster.h"
 #include "EUTelFFClusterImpl.h"
 #include "EUTELESCOPE.h"
@@ -164,6 +165,7 @@ EUTelFitHistograms::EUTelFitHistograms() : Processor("EUTelFitHistograms") {
 
 
 void EUTelFitHistograms::init() {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
 
   // usually a good idea to
   printParameters() ;
@@ -358,6 +360,7 @@ void EUTelFitHistograms::processRunHeader( LCRunHeader* runHeader) {
 }
 
 void EUTelFitHistograms::processEvent( LCEvent * event ) {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 
   EUTelEventImpl * euEvent = static_cast<EUTelEventImpl*> ( event );
   if ( euEvent->getEventType() == kEORE ) {
@@ -825,6 +828,7 @@ void EUTelFitHistograms::check( LCEvent * /* evt  */ ) {
 
 
 void EUTelFitHistograms::end(){
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
 
   //   std::cout << "EUTelFitHistograms::end()  " << name()
   //        << " processed " << _nEvt << " events in " << _nRun << " runs "
@@ -24,6 +24,7 @@
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelHistogramManager.h"
 #include "EUTelExceptions.h"
+#include "EUTelTupleWriter.h"
 
 // aida includes <.h>
 #include <marlin/AIDAProcessor.h>
@@ -47,6 +48,7 @@
 #include <IMPL/LCFlagImpl.h>
 #include <Exceptions.h>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <cmath>
@@ -66,7 +68,15 @@ using namespace eutelescope;
 std::string EUTelFitTuple::_FitTupleName  = "EUFit";
 
 
-EUTelFitTuple::EUTelFitTuple() : Processor("EUTelFitTuple") {
+EUTelFitTuple::EUTelFitTuple() : Processor("EUTelFitTuple"),
+  _outputPath(""),
+  _compressionLevel(1),
+  _basketSize(32000),
+  _writeBatchSize(1000),
+  _asyncWrite(true),
+  _writer(),
+  _fitTree(0),
+  _fitColumns() {
 
   // modify processor description
   _description = "Prepare n-tuple with track fit results" ;
@@ -118,6 +128,26 @@ EUTelFitTuple::EUTelFitTuple() : Processor("EUTelFitTuple") {
                               "Alignment corrections for DUT: shift in X, Y and rotation around Z",
                               _DUTalign, initAlign);
 
+  registerOptionalParameter ("OutputPath",
+                             "ROOT file to write the n-tuple to as a TTree, the AIDA tuple is used if empty",
+                             _outputPath, std::string(""));
+
+  registerOptionalParameter ("CompressionLevel",
+                             "ROOT compression level of the output file",
+                             _compressionLevel, static_cast < int > (1));
+
+  registerOptionalParameter ("BasketSize",
+                             "Basket size in bytes of the n-tuple branches",
+                             _basketSize, static_cast < int > (32000));
+
+  registerOptionalParameter ("WriteBatchSize",
+                             "Number of events handed over at once to the n-tuple writer",
+                             _writeBatchSize, static_cast < int > (1000));
+
+  registerOptionalParameter ("AsyncWrite",
+                             "Compress and write the ROOT n-tuple in a background thread",
+                             _asyncWrite, static_cast < bool > (true));
+
 }
 
 
@@ -468,8 +498,8 @@ void EUTelFitTuple::processEvent( LCEvent * event ) {
 
               if(rawdata.size()>0 && rawdata.at(0)!=NULL )
                 {
-                  EUTelVirtualCluster * cluster = new EUTelFFClusterImpl ( static_cast<TrackerDataImpl*> (rawdata.at(0))) ;
-                  _measuredQ[hitPlane]=cluster->getTotalCharge();
+                  EUTelFFClusterImpl cluster( static_cast<TrackerDataImpl*> (rawdata.at(0)) ) ;
+                  _measuredQ[hitPlane]=cluster.getTotalCharge();
                 }
 
               message<DEBUG5> ( log() << "Measured hit in plane " << hitPlane << " at  X = "
@@ -495,22 +525,22 @@ void EUTelFitTuple::processEvent( LCEvent * event ) {
       // Fill n-tuple
 
       int icol=0;
-      _FitTuple->fill(icol++,_nEvt);
-      _FitTuple->fill(icol++,_runNr);
-      _FitTuple->fill(icol++,_evtNr);
-      _FitTuple->fill(icol++,_tluTimeStamp); // new! TLU timestamp
-      _FitTuple->fill(icol++,nTrack); // new! TLU timestamp
-      _FitTuple->fill(icol++,fittrack->getNdf());
-      _FitTuple->fill(icol++,fittrack->getChi2());
+      fillColumn(icol++,_nEvt);
+      fillColumn(icol++,_runNr);
+      fillColumn(icol++,_evtNr);
+      fillColumn(icol++,_tluTimeStamp); // new! TLU timestamp
+      fillColumn(icol++,nTrack); // new! TLU timestamp
+      fillColumn(icol++,fittrack->getNdf());
+      fillColumn(icol++,fittrack->getChi2());
 
       for(int ipl=0; ipl<_nTelPlanes;ipl++)
         {
-          _FitTuple->fill(icol++,_measuredX[ipl]);
-          _FitTuple->fill(icol++,_measuredY[ipl]);
-          _FitTuple->fill(icol++,_measuredZ[ipl]);
-          _FitTuple->fill(icol++,_measuredQ[ipl]);
-          _FitTuple->fill(icol++,_fittedX[ipl]);
-          _FitTuple->fill(icol++,_fittedY[ipl]);
+          fillColumn(icol++,_measuredX[ipl]);
+          fillColumn(icol++,_measuredY[ipl]);
+          fillColumn(icol++,_measuredZ[ipl]);
+          fillColumn(icol++,_measuredQ[ipl]);
+          fillColumn(icol++,_fittedX[ipl]);
+          fillColumn(icol++,_fittedY[ipl]);
         }
 
       //  Look for closest DUT hit
@@ -574,8 +604,8 @@ void EUTelFitTuple::processEvent( LCEvent * event ) {
 
               if(rawdata.size()>0 && rawdata.at(0)!=NULL )
                 {
-                  EUTelVirtualCluster * cluster = new EUTelFFClusterImpl ( static_cast<TrackerDataImpl*> (rawdata.at(0))) ;
-                  dutQ=cluster->getTotalCharge();
+                  EUTelFFClusterImpl cluster( static_cast<TrackerDataImpl*> (rawdata.at(0)) ) ;
+                  dutQ=cluster.getTotalCharge();
                 }
 
               dutR=sqrt(distmin);
@@ -591,12 +621,15 @@ void EUTelFitTuple::processEvent( LCEvent * event ) {
         }
 
 
-      _FitTuple->fill(icol++,dutX);
-      _FitTuple->fill(icol++,dutY);
-      _FitTuple->fill(icol++,dutR);
-      _FitTuple->fill(icol++,dutQ);
+      fillColumn(icol++,dutX);
+      fillColumn(icol++,dutY);
+      fillColumn(icol++,dutR);
+      fillColumn(icol++,dutQ);
 
-      _FitTuple->addRow();
+      if( _writer.get() != 0 )
+        _writer->fill(_fitTree);
+      else
+        _FitTuple->addRow();
 
       // End of loop over tracks
     }
@@ -619,8 +652,15 @@ void EUTelFitTuple::end(){
   //        << std::endl ;
 
 
-  message<MESSAGE5> ( log() << "N-tuple with "
-                     << _FitTuple->rows() << " rows created" );
+  if( _writer.get() != 0 )
+    {
+      message<MESSAGE5> ( log() << "N-tuple with "
+                         << _writer->getEntries(_fitTree) << " rows written to " << _outputPath );
+      _writer->close();
+    }
+  else
+    message<MESSAGE5> ( log() << "N-tuple with "
+                       << _FitTuple->rows() << " rows created" );
 
 
   // Clean memory
@@ -700,7 +740,22 @@ void EUTelFitTuple::bookHistos()
   _columnType.push_back("double");
 
 
-  _FitTuple=AIDAProcessor::tupleFactory(this)->create(_FitTupleName, _FitTupleName, _columnNames, _columnType, "");
+  if( !_outputPath.empty() )
+    {
+      // same columns, written as a TTree by the tuple writer
+      _writer.reset( new EUTelTupleWriter( _outputPath, _compressionLevel, _basketSize,
+                                           static_cast<unsigned int>( std::max( _writeBatchSize, 1 ) ), _asyncWrite ) );
+      _fitTree = _writer->addTree(_FitTupleName, _FitTupleName);
+      for(size_t i=0; i<_columnNames.size(); i++)
+        {
+          EUTelTupleWriter::ColumnType type = EUTelTupleWriter::kDouble;
+          if( _columnType[i] == "int" ) type = EUTelTupleWriter::kInt;
+          else if( _columnType[i] == "long int" ) type = EUTelTupleWriter::kLong;
+          _fitColumns.push_back( _writer->addColumn(_fitTree, _columnNames[i], type) );
+        }
+    }
+  else
+    _FitTuple=AIDAProcessor::tupleFactory(this)->create(_FitTupleName, _FitTupleName, _columnNames, _columnType, "");
 
 
   message<DEBUG5> ( log() << "Booking completed \n\n");
@@ -708,4 +763,28 @@ void EUTelFitTuple::bookHistos()
   return;
 }
 
+void EUTelFitTuple::fillColumn( int icol, int value )
+{
+  if( _writer.get() != 0 ) _writer->setInt(_fitColumns[icol], value);
+  else _FitTuple->fill(icol, value);
+}
+
+void EUTelFitTuple::fillColumn( int icol, long int value )
+{
+  if( _writer.get() != 0 ) _writer->setLong(_fitColumns[icol], value);
+  else _FitTuple->fill(icol, value);
+}
+
+void EUTelFitTuple::fillColumn( int icol, float value )
+{
+  if( _writer.get() != 0 ) _writer->setDouble(_fitColumns[icol], value);
+  else _FitTuple->fill(icol, value);
+}
+
+void EUTelFitTuple::fillColumn( int icol, double value )
+{
+  if( _writer.get() != 0 ) _writer->setDouble(_fitColumns[icol], value);
+  else _FitTuple->fill(icol, value);
+}
+
 #endif // GEAR && AIDA
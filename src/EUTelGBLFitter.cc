@@ -57,7 +57,8 @@ namespace eutelescope {
 	_parameterIdYRotationsMap(),
 	_parameterIdZRotationsMap(),
 	_counter_num_pointer(1),
-	_kinkAngleEstimation(false) //This used to determine if the correction matrix from the GBL fit is 5 or 7 elements long. 
+	_kinkAngleEstimation(false), //This used to determine if the correction matrix from the GBL fit is 5 or 7 elements long. 
+	_workspace()
 	{}
 
 	EUTelGBLFitter::~EUTelGBLFitter() {
@@ -84,16 +85,19 @@ namespace eutelescope {
 	//Note that we take the planes themselfs at scatters and also add scatterers to simulate the medium inbetween. 
 	void EUTelGBLFitter::setScattererGBL(gbl::GblPoint& point, EUTelState & state ) {
 		streamlog_out(DEBUG1) << " setScattererGBL ------------- BEGIN --------------  " << std::endl;
-		TMatrixDSym precisionMatrix =  state.getScatteringVarianceInLocalFrame();
+		TMatrixDSym precisionMatrix(2);
+		state.getScatteringVarianceInLocalFrame(precisionMatrix);
 		streamlog_out(MESSAGE1) << "The precision matrix being used for the sensor  "<<state.getLocation()<<":" << std::endl;
 		streamlog_message( DEBUG0, precisionMatrix.Print();, std::endl; );
-		point.addScatterer(state.getKinks(), precisionMatrix);
+		const TVectorD kinks(2, state.getKinks());
+		point.addScatterer(kinks, precisionMatrix);
 		streamlog_out(DEBUG1) << "  setScattererGBL  ------------- END ----------------- " << std::endl;
 	}
 		//This is used when the we know the radiation length already
-		void EUTelGBLFitter::setScattererGBL(gbl::GblPoint& point,EUTelState & state, float variance,TVectorD scat ) {
+		void EUTelGBLFitter::setScattererGBL(gbl::GblPoint& point,EUTelState & state, float variance,const TVectorD& scat ) {
 		streamlog_out(MESSAGE1) << " setScattererGBL ------------- BEGIN --------------  " << std::endl;
-		TMatrixDSym precisionMatrix =  state.getScatteringVarianceInLocalFrame(variance);
+		TMatrixDSym precisionMatrix(2);
+		state.getScatteringVarianceInLocalFrame(variance, precisionMatrix);
 		streamlog_out(MESSAGE1) << "The precision matrix being used for the scatter:  " << std::endl;
 		streamlog_message( DEBUG0, precisionMatrix.Print();, std::endl; );
 		point.addScatterer(scat, precisionMatrix);
@@ -109,7 +113,7 @@ namespace eutelescope {
 	}
 	//This will add measurement information to the GBL point
 	//Note that if we have a strip sensor then y will be ignored using projection matrix.
-	void EUTelGBLFitter::setMeasurementGBL(gbl::GblPoint& point, const double *hitPos,  double statePos[3], double combinedCov[4], TMatrixD projection){
+	void EUTelGBLFitter::setMeasurementGBL(gbl::GblPoint& point, const double *hitPos,  double statePos[3], double combinedCov[4], const TMatrixD& projection){
 		streamlog_out(DEBUG1) << " setMeasurementGBL ------------- BEGIN --------------- " << std::endl;
 		TVectorD meas(2);//Remember we need to pass the same 5 since gbl expects this due to jacobian
 		meas.Zero();
@@ -175,38 +179,38 @@ namespace eutelescope {
 		}
 	}
 	//This creates the scatters point to simulate the passage through air. 
-	void EUTelGBLFitter::setPointListWithNewScatterers(std::vector< gbl::GblPoint >& pointList,EUTelState & state, std::vector<float>  variance){
+	void EUTelGBLFitter::setPointListWithNewScatterers(std::vector< gbl::GblPoint >& pointList,EUTelState & state, const float (&variance)[2]){
 		if(_scattererJacobians.size() != _scattererPositions.size()){
 			throw(lcio::Exception("The size of the scattering positions and jacobians is different.")); 	
 		}
-        TVectorD kinksMedium[2] = {state.getKinksMedium1(),state.getKinksMedium2()};
+        const TVectorD kinksMedium[2] = {TVectorD(2, state.getKinksMedium1()),TVectorD(2, state.getKinksMedium2())};
 		for(size_t i = 0 ;i < _scattererJacobians.size()-1;++i){//The last jacobain is used to get to the plane! So only loop over to (_scatterJacobians-1)
 			gbl::GblPoint point(_scattererJacobians[i]);
 			point.setLabel(_counter_num_pointer);
 			_counter_num_pointer++;
-			if(variance.at(i) == 0){
-				throw(lcio::Exception("Variance is 0 for the scattering plane."));
-			}
 			if(i > 1){
 				throw(lcio::Exception("Trying to add more than 2 scattering planes "));
 			}
+			if(variance[i] == 0){
+				throw(lcio::Exception("Variance is 0 for the scattering plane."));
+			}
 
-			setScattererGBL(point,state, variance.at(i),kinksMedium[i]);//TO DO:This will only work for homogeneous distributions.
+			setScattererGBL(point,state, variance[i],kinksMedium[i]);//TO DO:This will only work for homogeneous distributions.
 			pointList.push_back(point);
 		}
 	}
-	std::vector<float> EUTelGBLFitter::computeVarianceForEachScatterer(EUTelState & state){
+	//The variance of the air comes from the scattering table of the pattern recognition, through the state. Here it is only shared between the two scatterers.
+	void EUTelGBLFitter::computeVarianceForEachScatterer(const EUTelState & state, float (&variance)[2]){
 		const double scatteringVariance  = state.getRadFracAir();//What we get out is the RMS and need the variance.
 		streamlog_out(DEBUG0) << "Variance (AIR Total):  " << std::scientific << scatteringVariance  << "  Plane: " << state.getLocation() << std::endl;
 		if(scatteringVariance == 0){
 			throw(std::string("scatteringVariance for air is zero. Something is wrong with radiation length calculation."));
 		}
-		std::vector<float> variance;
-		float powMeanStart=pow((_normalMean - _start),2);
-		float denominator=_normalVariance + powMeanStart;
-		variance.push_back(scatteringVariance*(_normalVariance/denominator));
-		variance.push_back(scatteringVariance*(powMeanStart/denominator));
-		return variance;
+		const float meanStart = _normalMean - _start;
+		const float powMeanStart = meanStart*meanStart;
+		const float denominator=_normalVariance + powMeanStart;
+		variance[0] = scatteringVariance*(_normalVariance/denominator);
+		variance[1] = scatteringVariance*(powMeanStart/denominator);
 	}
 	//This set the estimate resolution for each plane in the X direction.
 	void EUTelGBLFitter::setParamterIdXResolutionVec( const std::vector<float>& vector)
@@ -351,7 +355,8 @@ namespace eutelescope {
 				setMomentsAndStartEndScattering(state);
 				findScattersZPositionBetweenTwoStates();//We use the exact arc length between the two states to place the scatterers. 
 				jacPointToPoint=findScattersJacobians(state,nextState);
-				std::vector<float> variance =  computeVarianceForEachScatterer(state);
+				float variance[2];
+				computeVarianceForEachScatterer(state, variance);
 				setPointListWithNewScatterers(pointList,state, variance);//We assume that on all scattering planes the incidence angle is the same as on the last measurement state. Not a terrible approximation and will be corrected by GBL anyway.
 			}else{
 				streamlog_out(DEBUG3)<<"We have reached the last plane"<<std::endl;
@@ -362,7 +367,7 @@ namespace eutelescope {
 	}
 
 	//THIS IS THE GETTERS
-	gbl::GblPoint EUTelGBLFitter::getLabelToPoint(std::vector<gbl::GblPoint> & pointList, unsigned int label)
+	const gbl::GblPoint& EUTelGBLFitter::getLabelToPoint(const std::vector<gbl::GblPoint> & pointList, unsigned int label)
 	{
 		for(size_t i = 0; i< pointList.size();++i)
 		{
@@ -376,7 +381,7 @@ namespace eutelescope {
 		throw(lcio::Exception("There is no point with this label"));
 	}
 	//This used after trackfit will fill a map between (sensor ID and residualx/y). 
-  void EUTelGBLFitter::getResidualOfTrackandHits(gbl::GblTrajectory* traj, std::vector< gbl::GblPoint > pointList,EUTelTrack& track, std::map< int, std::map< float, float > > &  SensorResidual, std::map< int, std::map< float, float > >& sensorResidualError, std::map<int, int> & planes){
+  void EUTelGBLFitter::getResidualOfTrackandHits(gbl::GblTrajectory* traj, const std::vector< gbl::GblPoint >& pointList,EUTelTrack& track, std::map< int, std::map< float, float > > &  SensorResidual, std::map< int, std::map< float, float > >& sensorResidualError, std::map<int, int> & planes){
     planes = geo::gGeometry().sensorZOrdertoIDs(); 
 	  
 	       for(size_t j=0 ; j< _vectorOfPairsMeasurementStatesAndLabels.size();j++){
@@ -469,7 +474,7 @@ namespace eutelescope {
      * \return Jacobain 5x5  from scatter->plane 
      */
 
-	TMatrixD EUTelGBLFitter::findScattersJacobians(EUTelState state, EUTelState nextState){
+	TMatrixD EUTelGBLFitter::findScattersJacobians(const EUTelState& state, const EUTelState& nextState){
 		streamlog_out(DEBUG1) << "CREATE JACOBIAN LINKS: Plane->scatter->scatter->plane  " << std::endl;
 
         double min = 1e-4;
@@ -511,11 +516,11 @@ namespace eutelescope {
             streamlog_out(DEBUG1) <<"Distance between states "<<distance << std::endl;
             streamlog_out(DEBUG1) <<"Minimum value of jacobian accepted "<<min << std::endl;
 
-        TMatrixD simpleJacobian = EUTelNav::getPropagationJacobianGlobalToGlobal(distance, momStart.Unit());
+        TMatrixD simpleJacobian = EUTelNav::getPropagationJacobianGlobalToGlobal(distance, momStart.Unit(), _workspace.getMagneticField());
         TVector3 momStartLocal = transVecGlobalToLocal(momStart, locationStart);
-        TMatrixD localToGlobalJacobianStart =  EUTelNav::getMeasToGlobal(momStartLocal, locationStart);
+        TMatrixD localToGlobalJacobianStart =  EUTelNav::getMeasToGlobal(momStartLocal, _workspace.getRotMatrix(locationStart));
         TVector3 momEndLocal = transVecGlobalToLocal(momEnd, locationEnd);
-        TMatrixD localToGlobalJacobianEnd =  EUTelNav::getMeasToGlobal(momEndLocal,locationEnd );
+        TMatrixD localToGlobalJacobianEnd =  EUTelNav::getMeasToGlobal(momEndLocal, _workspace.getRotMatrix(locationEnd));
         streamlog_out( DEBUG0 ) << "Invert local matrix... " << std::endl;
         TMatrixD globalToLocalJacobianEnd = localToGlobalJacobianEnd.Invert();
         streamlog_out( DEBUG0 ) << "Global to local: " << std::endl;
@@ -529,12 +534,8 @@ namespace eutelescope {
         return localToNextLocalJacobian;
     }
     TVector3 EUTelGBLFitter::transVecGlobalToLocal(TVector3 input, int location){
-        double globalVec[] = { input[0],input[1],input[2] };
-        double localVec[3];
-        geo::gGeometry().master2LocalVec( location ,globalVec, localVec );
-        TVector3 pVecUnitLocal;
-        pVecUnitLocal[0] = localVec[0]; 	pVecUnitLocal[1] = localVec[1]; 	pVecUnitLocal[2] = localVec[2]; 
-        return pVecUnitLocal;
+        //The transformation of each plane is cached by the workspace
+        return _workspace.transVecGlobalToLocal(input, location);
     }
 
 
@@ -0,0 +1,103 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifdef USE_GBL
+
+// its own header
+#include "EUTelGBLWorkspace.h"
+
+// eutelescope includes ".h"
+#include "EUTelGeometryTelescopeGeoDescription.h"
+
+namespace eutelescope {
+
+	EUTelGBLWorkspace::EUTelGBLWorkspace() :
+	_pointList(),
+	_trajectory(),
+	_rotMatrix(),
+	_master2LocalVec(),
+	_magneticField(),
+	_hasMagneticField(false),
+	_geoVersion(geo::gGeometry().getGeoVersion())
+	{}
+
+	EUTelGBLWorkspace::~EUTelGBLWorkspace() {
+	}
+
+	std::vector< gbl::GblPoint >& EUTelGBLWorkspace::newPointList() {
+		//The capacity is kept, the points of the previous track are destroyed
+		_pointList.clear();
+		return _pointList;
+	}
+
+	gbl::GblTrajectory* EUTelGBLWorkspace::newTrajectory(bool curved) {
+		//Delete the trajectory of the previous track before building the next one
+		_trajectory.reset();
+		_trajectory.reset( new gbl::GblTrajectory( _pointList, curved ) );
+		return _trajectory.get();
+	}
+
+	const TMatrixD& EUTelGBLWorkspace::getRotMatrix(int location) {
+		checkGeometry();
+		std::map< int, TMatrixD >::iterator rotation = _rotMatrix.find( location );
+		if( rotation == _rotMatrix.end() ) {
+			//Each call to the geometry navigates TGeo, so do it once per plane
+			rotation = _rotMatrix.insert( std::make_pair( location, geo::gGeometry().getRotMatrix( location ) ) ).first;
+		}
+		return rotation->second;
+	}
+
+	TVector3 EUTelGBLWorkspace::transVecGlobalToLocal(const TVector3& input, int location) {
+		checkGeometry();
+		std::map< int, TMatrixD >::iterator transformation = _master2LocalVec.find( location );
+		if( transformation == _master2LocalVec.end() ) {
+			//The transformation is linear, its columns are the images of the unit vectors
+			TMatrixD matrix(3,3);
+			for( int column = 0; column < 3; ++column ) {
+				double globalVec[] = { 0., 0., 0. };
+				double localVec[3];
+				globalVec[column] = 1.;
+				geo::gGeometry().master2LocalVec( location, globalVec, localVec );
+				for( int row = 0; row < 3; ++row ) matrix[row][column] = localVec[row];
+			}
+			transformation = _master2LocalVec.insert( std::make_pair( location, matrix ) ).first;
+		}
+		const TMatrixD& matrix = transformation->second;
+		TVector3 pVecUnitLocal;
+		for( int row = 0; row < 3; ++row ) {
+			pVecUnitLocal[row] = matrix[row][0]*input[0] + matrix[row][1]*input[1] + matrix[row][2]*input[2];
+		}
+		return pVecUnitLocal;
+	}
+
+	const TVector3& EUTelGBLWorkspace::getMagneticField() {
+		checkGeometry();
+		if( !_hasMagneticField ) {
+			const gear::BField& field = geo::gGeometry().getMagneticField();
+			gear::Vector3D vectorGlobal(0.1,0.1,0.1);
+			_magneticField.SetXYZ( field.at( vectorGlobal ).x(), field.at( vectorGlobal ).y(), field.at( vectorGlobal ).z() );
+			_hasMagneticField = true;
+		}
+		return _magneticField;
+	}
+
+	void EUTelGBLWorkspace::clearGeometry() {
+		_rotMatrix.clear();
+		_master2LocalVec.clear();
+		_hasMagneticField = false;
+		_geoVersion = geo::gGeometry().getGeoVersion();
+	}
+
+	void EUTelGBLWorkspace::checkGeometry() {
+		if( _geoVersion != geo::gGeometry().getGeoVersion() ) clearGeometry();
+	}
+
+} // namespace eutelescope
+
+#endif
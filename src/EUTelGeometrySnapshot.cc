@@ -0,0 +1,371 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelGeometrySnapshot.h"
+#include "EUTelExceptions.h"
+
+// system includes <>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace eutelescope;
+using namespace geo;
+
+namespace {
+
+	const char SNAPSHOTMAGIC[8] = { 'E', 'U', 'T', 'G', 'E', 'O', 'S', 'N' };
+	const uint32_t SNAPSHOTVERSION = 1;
+
+	const uint64_t FNVOFFSET = 14695981039346656037UL;
+	const uint64_t FNVPRIME  = 1099511628211UL;
+
+	void hashBytes( uint64_t& hash, const void* data, size_t size )
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>( data );
+		for( size_t i = 0; i < size; ++i )
+		{
+			hash ^= bytes[i];
+			hash *= FNVPRIME;
+		}
+	}
+
+	template<typename T> void writeValue( std::ostream& os, const T& value )
+	{
+		os.write( reinterpret_cast<const char*>( &value ), sizeof(T) );
+	}
+
+	template<typename T> void readValue( std::istream& is, T& value )
+	{
+		is.read( reinterpret_cast<char*>( &value ), sizeof(T) );
+	}
+
+	void writeIntMap( std::ostream& os, const std::map<int,int>& map )
+	{
+		writeValue( os, static_cast<uint32_t>( map.size() ) );
+		for( std::map<int,int>::const_iterator it = map.begin(); it != map.end(); ++it )
+		{
+			writeValue( os, it->first );
+			writeValue( os, it->second );
+		}
+	}
+
+	void readIntMap( std::istream& is, std::map<int,int>& map )
+	{
+		uint32_t size = 0;
+		readValue( is, size );
+		for( uint32_t i = 0; i < size && is; ++i )
+		{
+			int key = 0, value = 0;
+			readValue( is, key );
+			readValue( is, value );
+			map[key] = value;
+		}
+	}
+
+	void writePlane( std::ostream& os, const EUTelPlane& plane )
+	{
+		const double values[19] = { plane.xPos, plane.yPos, plane.zPos, plane.alpha, plane.beta, plane.gamma,
+					    plane.r1, plane.r2, plane.r3, plane.r4, plane.xSize, plane.ySize, plane.zSize,
+					    plane.xPitch, plane.yPitch, plane.radLength, plane.xRes, plane.yRes, 0. };
+		os.write( reinterpret_cast<const char*>( values ), sizeof(values) );
+		writeValue( os, plane.xPixelNo );
+		writeValue( os, plane.yPixelNo );
+		writeValue( os, static_cast<uint32_t>( plane.pixGeoName.size() ) );
+		os.write( plane.pixGeoName.data(), plane.pixGeoName.size() );
+	}
+
+	void readPlane( std::istream& is, EUTelPlane& plane )
+	{
+		double values[19];
+		is.read( reinterpret_cast<char*>( values ), sizeof(values) );
+		plane.xPos = values[0];   plane.yPos = values[1];   plane.zPos = values[2];
+		plane.alpha = values[3];  plane.beta = values[4];   plane.gamma = values[5];
+		plane.r1 = values[6];     plane.r2 = values[7];     plane.r3 = values[8];     plane.r4 = values[9];
+		plane.xSize = values[10]; plane.ySize = values[11]; plane.zSize = values[12];
+		plane.xPitch = values[13]; plane.yPitch = values[14];
+		plane.radLength = values[15];
+		plane.xRes = values[16];  plane.yRes = values[17];
+		readValue( is, plane.xPixelNo );
+		readValue( is, plane.yPixelNo );
+		uint32_t nameLength = 0;
+		readValue( is, nameLength );
+		if( !is || nameLength > 4096 )
+		{
+			is.setstate( std::ios::failbit );
+			return;
+		}
+		std::vector<char> name( nameLength + 1, '\0' );
+		is.read( &name[0], nameLength );
+		plane.pixGeoName.assign( &name[0], nameLength );
+	}
+
+	// left multiplication of a row-major 3x3 matrix, as TGeoRotation::RotateX/Y/Z does
+	void rotateLeft( const double rot[9], double matrix[9] )
+	{
+		double result[9];
+		for( int i = 0; i < 3; ++i )
+		{
+			for( int j = 0; j < 3; ++j )
+			{
+				result[3*i+j] = rot[3*i]*matrix[j] + rot[3*i+1]*matrix[3+j] + rot[3*i+2]*matrix[6+j];
+			}
+		}
+		std::memcpy( matrix, result, sizeof(result) );
+	}
+}
+
+void EUTelPlaneTransform::local2Master( const double local[], double master[] ) const
+{
+	local2MasterVec( local, master );
+	master[0] += translation[0];
+	master[1] += translation[1];
+	master[2] += translation[2];
+}
+
+void EUTelPlaneTransform::master2Local( const double master[], double local[] ) const
+{
+	const double shifted[3] = { master[0]-translation[0], master[1]-translation[1], master[2]-translation[2] };
+	master2LocalVec( shifted, local );
+}
+
+void EUTelPlaneTransform::local2MasterVec( const double local[], double master[] ) const
+{
+	for( int i = 0; i < 3; ++i )
+	{
+		master[i] = rotation[3*i]*local[0] + rotation[3*i+1]*local[1] + rotation[3*i+2]*local[2];
+	}
+}
+
+void EUTelPlaneTransform::master2LocalVec( const double master[], double local[] ) const
+{
+	for( int i = 0; i < 3; ++i )
+	{
+		local[i] = rotation[i]*master[0] + rotation[3+i]*master[1] + rotation[6+i]*master[2];
+	}
+}
+
+EUTelGeometrySnapshot::EUTelGeometrySnapshot() :
+	_valid(false),
+	_gearHash(0),
+	_alignmentHash(0),
+	_layoutID(0),
+	_nPlanes(0),
+	_sensorIDs(),
+	_sensorIDVecMap(),
+	_zOrderToID(),
+	_planes(),
+	_transforms()
+{
+}
+
+void EUTelGeometrySnapshot::clear()
+{
+	_valid = false;
+	_gearHash = 0;
+	_alignmentHash = 0;
+	_layoutID = 0;
+	_nPlanes = 0;
+	_sensorIDs.clear();
+	_sensorIDVecMap.clear();
+	_zOrderToID.clear();
+	_planes.clear();
+	_transforms.clear();
+}
+
+void EUTelGeometrySnapshot::set( uint64_t gearHash, int layoutID, size_t nPlanes,
+				 const std::vector<int>& sensorIDs,
+				 const std::map<int,int>& sensorIDVecMap,
+				 const std::map<int,int>& zOrderToID,
+				 const std::map<int,EUTelPlane>& planes )
+{
+	_gearHash = gearHash;
+	_layoutID = layoutID;
+	_nPlanes = nPlanes;
+	_sensorIDs = sensorIDs;
+	_sensorIDVecMap = sensorIDVecMap;
+	_zOrderToID = zOrderToID;
+	_planes = planes;
+	_alignmentHash = hashAlignment( _planes );
+
+	_transforms.clear();
+	for( std::map<int,EUTelPlane>::const_iterator it = _planes.begin(); it != _planes.end(); ++it )
+	{
+		computeTransform( it->second, _transforms[it->first] );
+	}
+	_valid = true;
+}
+
+bool EUTelGeometrySnapshot::write( const std::string& filename ) const
+{
+	if( !_valid ) return false;
+
+	std::ofstream os( filename.c_str(), std::ios::binary );
+	if( !os ) return false;
+
+	os.write( SNAPSHOTMAGIC, sizeof(SNAPSHOTMAGIC) );
+	writeValue( os, SNAPSHOTVERSION );
+	writeValue( os, _gearHash );
+	writeValue( os, _alignmentHash );
+	writeValue( os, _layoutID );
+	writeValue( os, static_cast<uint32_t>( _nPlanes ) );
+
+	writeValue( os, static_cast<uint32_t>( _sensorIDs.size() ) );
+	for( size_t i = 0; i < _sensorIDs.size(); ++i ) writeValue( os, _sensorIDs[i] );
+	writeIntMap( os, _sensorIDVecMap );
+	writeIntMap( os, _zOrderToID );
+
+	writeValue( os, static_cast<uint32_t>( _planes.size() ) );
+	for( std::map<int,EUTelPlane>::const_iterator it = _planes.begin(); it != _planes.end(); ++it )
+	{
+		writeValue( os, it->first );
+		writePlane( os, it->second );
+	}
+
+	return os.good();
+}
+
+bool EUTelGeometrySnapshot::read( const std::string& filename )
+{
+	clear();
+
+	std::ifstream is( filename.c_str(), std::ios::binary );
+	if( !is ) return false;
+
+	char magic[8];
+	uint32_t version = 0;
+	is.read( magic, sizeof(magic) );
+	readValue( is, version );
+	if( !is || std::memcmp( magic, SNAPSHOTMAGIC, sizeof(magic) ) != 0 || version != SNAPSHOTVERSION ) return false;
+
+	uint64_t gearHash = 0, alignmentHash = 0;
+	int layoutID = 0;
+	uint32_t nPlanes = 0, nSensors = 0;
+	readValue( is, gearHash );
+	readValue( is, alignmentHash );
+	readValue( is, layoutID );
+	readValue( is, nPlanes );
+	readValue( is, nSensors );
+
+	std::vector<int> sensorIDs;
+	for( uint32_t i = 0; i < nSensors && is; ++i )
+	{
+		int sensorID = 0;
+		readValue( is, sensorID );
+		sensorIDs.push_back( sensorID );
+	}
+
+	std::map<int,int> sensorIDVecMap, zOrderToID;
+	readIntMap( is, sensorIDVecMap );
+	readIntMap( is, zOrderToID );
+
+	uint32_t nPlaneEntries = 0;
+	readValue( is, nPlaneEntries );
+	std::map<int,EUTelPlane> planes;
+	for( uint32_t i = 0; i < nPlaneEntries && is; ++i )
+	{
+		int sensorID = 0;
+		readValue( is, sensorID );
+		readPlane( is, planes[sensorID] );
+	}
+
+	if( !is ) return false;
+
+	set( gearHash, layoutID, nPlanes, sensorIDs, sensorIDVecMap, zOrderToID, planes );
+
+	// protect against a snapshot whose planes were modified by hand
+	if( _alignmentHash != alignmentHash )
+	{
+		clear();
+		return false;
+	}
+	return true;
+}
+
+const EUTelPlaneTransform& EUTelGeometrySnapshot::transform( int sensorID ) const
+{
+	std::map<int,EUTelPlaneTransform>::const_iterator it = _transforms.find( sensorID );
+	if( it == _transforms.end() )
+	{
+		std::stringstream ss;
+		ss << "EUTelGeometrySnapshot::transform: Could not find planeID: " << sensorID;
+		throw InvalidGeometryException( ss.str() );
+	}
+	return it->second;
+}
+
+double EUTelGeometrySnapshot::materialBudget( int sensorID ) const
+{
+	std::map<int,EUTelPlane>::const_iterator it = _planes.find( sensorID );
+	if( it == _planes.end() )
+	{
+		std::stringstream ss;
+		ss << "EUTelGeometrySnapshot::materialBudget: Could not find planeID: " << sensorID;
+		throw InvalidGeometryException( ss.str() );
+	}
+	return it->second.radLength > 0. ? it->second.zSize / it->second.radLength : 0.;
+}
+
+uint64_t EUTelGeometrySnapshot::hashFile( const std::string& filename )
+{
+	std::ifstream is( filename.c_str(), std::ios::binary );
+	if( !is ) return 0;
+
+	uint64_t hash = FNVOFFSET;
+	char buffer[8192];
+	while( is )
+	{
+		is.read( buffer, sizeof(buffer) );
+		hashBytes( hash, buffer, static_cast<size_t>( is.gcount() ) );
+	}
+	return hash;
+}
+
+uint64_t EUTelGeometrySnapshot::hashAlignment( const std::map<int,EUTelPlane>& planes )
+{
+	uint64_t hash = FNVOFFSET;
+	for( std::map<int,EUTelPlane>::const_iterator it = planes.begin(); it != planes.end(); ++it )
+	{
+		const EUTelPlane& plane = it->second;
+		const double values[10] = { plane.xPos, plane.yPos, plane.zPos, plane.alpha, plane.beta, plane.gamma,
+					    plane.r1, plane.r2, plane.r3, plane.r4 };
+		hashBytes( hash, &it->first, sizeof(it->first) );
+		hashBytes( hash, values, sizeof(values) );
+	}
+	return hash;
+}
+
+void EUTelGeometrySnapshot::computeTransform( const EUTelPlane& plane, EUTelPlaneTransform& transform )
+{
+	// same sequence as in translateSiPlane2TGeo: integer rotations and
+	// reflections, then Z, X and Y rotations (degrees) about the master axes
+	double* matrix = transform.rotation;
+	const double flip[9] = { plane.r1, plane.r2, 0., plane.r3, plane.r4, 0., 0., 0., 1. };
+	std::memcpy( matrix, flip, sizeof(flip) );
+
+	const double degToRad = 3.141592653589793/180.;
+
+	double c = std::cos( plane.gamma*degToRad ), s = std::sin( plane.gamma*degToRad );
+	const double rotZ[9] = { c, -s, 0., s, c, 0., 0., 0., 1. };
+	rotateLeft( rotZ, matrix );
+
+	c = std::cos( plane.alpha*degToRad ); s = std::sin( plane.alpha*degToRad );
+	const double rotX[9] = { 1., 0., 0., 0., c, -s, 0., s, c };
+	rotateLeft( rotX, matrix );
+
+	c = std::cos( plane.beta*degToRad ); s = std::sin( plane.beta*degToRad );
+	const double rotY[9] = { c, 0., s, 0., 1., 0., -s, 0., c };
+	rotateLeft( rotY, matrix );
+
+	transform.translation[0] = plane.xPos;
+	transform.translation[1] = plane.yPos;
+	transform.translation[2] = plane.zPos;
+}
@@ -19,6 +19,7 @@
 #include "gearxml/GearXML.h"
 
 // EUTELESCOPE
+#include "EUTELESCOPE.h"
 #include "EUTelExceptions.h"
 #include "EUTelGenericPixGeoMgr.h"
 #include "EUTelNav.h"
@@ -383,6 +384,9 @@ _sensorZOrderToIDMap(),
 _sensorIDtoZOrderMap(),
 _nPlanes(0),
 _isGeoInitialized(false),
+_snapshot(),
+_snapshotOutdated(true),
+_geoVersion(0),
 _geoManager(nullptr)
 {
 	//Set ROOTs verbosity to only display error messages or higher (so info will not be streamed to stderr)
@@ -421,19 +425,100 @@ void EUTelGeometryTelescopeGeoDescription::readGear()
 		streamlog_out(WARNING)   << "gear::TrackerPlanes NOT found "  << std::endl;
     }
 
+    if( !_siPlanesDefined && !_telPlanesDefined )
+	{
+		streamlog_out(ERROR5) << "Your GEAR file neither contains SiPlanes nor TrackerPlanes and thus is not valid" << std::endl;
+		throw eutelescope::InvalidGeometryException("GEAR file invalid, does not contain SiPlanes nor TrackerPlanes");
+	}
+
+	// a snapshot of the plane layout can be used instead of reading it from GEAR
+	std::string snapshotFileName, gearFileName;
+	if( marlin::Global::parameters != nullptr &&
+	    marlin::Global::parameters->isParameterSet( EUTELESCOPE::GEOSNAPSHOTFILE ) &&
+	    marlin::Global::parameters->isParameterSet( "GearXMLFile" ) )
+	{
+		snapshotFileName = marlin::Global::parameters->getStringVal( EUTELESCOPE::GEOSNAPSHOTFILE );
+		gearFileName = marlin::Global::parameters->getStringVal( "GearXMLFile" );
+	}
+
+	if( !snapshotFileName.empty() && readSnapshot( snapshotFileName, gearFileName ) )
+	{
+		streamlog_out(MESSAGE4) << "Plane layout taken from geometry snapshot " << snapshotFileName << std::endl;
+		return;
+	}
+
     if( _siPlanesDefined )
 	{
 		readSiPlanesLayout();
     }
-    else if( _telPlanesDefined )
+    else
 	{
 		readTrackerPlanesLayout();
     }
-	else
+
+	if( !snapshotFileName.empty() )
 	{
-		streamlog_out(ERROR5) << "Your GEAR file neither contains SiPlanes nor TrackerPlanes and thus is not valid" << std::endl;
-		throw eutelescope::InvalidGeometryException("GEAR file invalid, does not contain SiPlanes nor TrackerPlanes");
+		if( writeSnapshot( snapshotFileName, gearFileName ) )
+		{
+			streamlog_out(MESSAGE4) << "Geometry snapshot written to " << snapshotFileName << std::endl;
+		}
+		else
+		{
+			streamlog_out(WARNING) << "Could not write geometry snapshot " << snapshotFileName << std::endl;
+		}
+	}
+}
+
+const EUTelGeometrySnapshot& EUTelGeometryTelescopeGeoDescription::getSnapshot()
+{
+	if( _snapshotOutdated )
+	{
+		_snapshot.set( _snapshot.gearHash(), static_cast<int>(_siPlanesLayoutID), _nPlanes, _sensorIDVec, _sensorIDVecMap, _sensorZOrderToIDMap, _planeSetup );
+		_snapshotOutdated = false;
+	}
+	return _snapshot;
+}
+
+bool EUTelGeometryTelescopeGeoDescription::writeSnapshot( const std::string& snapshotFileName, const std::string& gearFileName )
+{
+	uint64_t gearHash = EUTelGeometrySnapshot::hashFile( gearFileName );
+	if( gearHash == 0 )
+	{
+		streamlog_out(WARNING) << "Cannot read GEAR file " << gearFileName << " to identify the geometry snapshot" << std::endl;
+		return false;
+	}
+
+	_snapshot.set( gearHash, static_cast<int>(_siPlanesLayoutID), _nPlanes, _sensorIDVec, _sensorIDVecMap, _sensorZOrderToIDMap, _planeSetup );
+	_snapshotOutdated = false;
+	return _snapshot.write( snapshotFileName );
+}
+
+bool EUTelGeometryTelescopeGeoDescription::readSnapshot( const std::string& snapshotFileName, const std::string& gearFileName )
+{
+	EUTelGeometrySnapshot snapshot;
+	if( !snapshot.read( snapshotFileName ) ) return false;
+
+	if( snapshot.gearHash() != EUTelGeometrySnapshot::hashFile( gearFileName ) )
+	{
+		streamlog_out(MESSAGE4) << "Geometry snapshot " << snapshotFileName << " was made from a different GEAR file, not used" << std::endl;
+		return false;
+	}
+
+	setSiPlanesLayoutID( snapshot.layoutID() );
+	_nPlanes = snapshot.nPlanes();
+	_sensorIDVec = snapshot.sensorIDs();
+	_sensorIDVecMap = snapshot.sensorIDVecMap();
+	_sensorZOrderToIDMap = snapshot.zOrderToID();
+	_sensorIDtoZOrderMap.clear();
+	for( std::map<int,int>::const_iterator it = _sensorZOrderToIDMap.begin(); it != _sensorZOrderToIDMap.end(); ++it )
+	{
+		_sensorIDtoZOrderMap.insert( std::make_pair( it->second, it->first ) );
 	}
+	_planeSetup = snapshot.planes();
+
+	_snapshot = snapshot;
+	_snapshotOutdated = false;
+	return true;
 }
 
 EUTelGeometryTelescopeGeoDescription::~EUTelGeometryTelescopeGeoDescription()
@@ -454,6 +539,8 @@ void EUTelGeometryTelescopeGeoDescription::initializeTGeoDescription( std::strin
     }
 
     _geoManager->CloseGeometry();
+    _isGeoInitialized = true;
+    ++_geoVersion;
 }
 
 /**
@@ -664,6 +751,7 @@ void EUTelGeometryTelescopeGeoDescription::initializeTGeoDescription( std::strin
 
     _geoManager->CloseGeometry();
     _isGeoInitialized = true;
+    ++_geoVersion;
     // Dump ROOT TGeo object into file
     if ( dumpRoot ) _geoManager->Export( geomName.c_str() );
     return;
@@ -779,6 +867,11 @@ int EUTelGeometryTelescopeGeoDescription::getSensorIDFromManager()  {
  * @param globalPos (x,y,z) in global coordinate system
  */
 void EUTelGeometryTelescopeGeoDescription::local2Master( int sensorID, const double localPos[], double globalPos[] ) {
+    // without TGeo geometry the transformation of the plane layout is used
+    if( !_isGeoInitialized ) {
+        getSnapshot().transform( sensorID ).local2Master( localPos, globalPos );
+        return;
+    }
     _geoManager->cd( _planePath[sensorID].c_str() );
     _geoManager->GetCurrentNode()->LocalToMaster( localPos, globalPos );
 }
@@ -792,6 +885,11 @@ void EUTelGeometryTelescopeGeoDescription::local2Master( int sensorID, const dou
  * @param localPos (x,y,z) in local coordinate system
  */
 void EUTelGeometryTelescopeGeoDescription::master2Local(int sensorID, const double globalPos[], double localPos[] ) {
+    // without TGeo geometry the transformation of the plane layout is used
+    if( !_isGeoInitialized ) {
+        getSnapshot().transform( sensorID ).master2Local( globalPos, localPos );
+        return;
+    }
     _geoManager->cd( _planePath[sensorID].c_str() );
     _geoManager->GetCurrentNode()->MasterToLocal( globalPos, localPos );
 }
@@ -804,6 +902,11 @@ void EUTelGeometryTelescopeGeoDescription::master2Local(int sensorID, const doub
  * @param localVec (x,y,z) in local coordinate system
  */
 void EUTelGeometryTelescopeGeoDescription::local2MasterVec( int sensorID, const double localVec[], double globalVec[] ) {
+    // without TGeo geometry the transformation of the plane layout is used
+    if( !_isGeoInitialized ) {
+        getSnapshot().transform( sensorID ).local2MasterVec( localVec, globalVec );
+        return;
+    }
     _geoManager->cd( _planePath[sensorID].c_str() );
     _geoManager->GetCurrentNode()->LocalToMasterVect( localVec, globalVec );
 }
@@ -818,6 +921,11 @@ void EUTelGeometryTelescopeGeoDescription::local2MasterVec( int sensorID, const
  */
 void EUTelGeometryTelescopeGeoDescription::master2LocalVec( int sensorID, const double globalVec[], double localVec[] ) {
     
+    // without TGeo geometry the transformation of the plane layout is used
+    if( !_isGeoInitialized ) {
+        getSnapshot().transform( sensorID ).master2LocalVec( globalVec, localVec );
+        return;
+    }
     _geoManager->cd( _planePath[sensorID].c_str() );
     _geoManager->GetCurrentNode()->MasterToLocalVect( globalVec, localVec );
 
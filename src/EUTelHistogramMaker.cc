@@ -23,6 +23,7 @@
 #include "EUTelHistogramManager.h"
 #include "EUTelMatrixDecoder.h"
 #include "EUTelHistogramMaker.h"
+#include "EUTelProcessorMonitor.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -119,6 +120,7 @@ EUTelHistogramMaker::EUTelHistogramMaker () : Processor("EUTelHistogramMaker") {
 
 
 void EUTelHistogramMaker::init () {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
   // this method is called only once even when the rewind is active
   // usually a good idea to
   printParameters ();
@@ -190,6 +192,7 @@ void EUTelHistogramMaker::initializeGeometry( LCEvent * event ) {
 
 
 void EUTelHistogramMaker::processEvent (LCEvent * evt) {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 
@@ -533,6 +536,7 @@ void EUTelHistogramMaker::check (LCEvent * /*  evt */) {
 
 
 void EUTelHistogramMaker::end() {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
 
   streamlog_out ( MESSAGE4 ) << "Processor finished successfully." << endl;
 
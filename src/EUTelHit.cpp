@@ -29,16 +29,19 @@ void EUTelHit::setID(int id){
     _id = id;
 }
 
-std::vector<double> EUTelHit::getLCIOOutput(){
+std::vector<double> EUTelHit::getLCIOOutput() const {
     std::vector<double> output;
+    getLCIOOutput(output);
+    return output;
+}
+void EUTelHit::getLCIOOutput(std::vector<double>& output) const {
+    output.clear();
     output.push_back(getID());
     output.push_back(getPosition()[0]);
     output.push_back(getPosition()[1]);
     output.push_back(getPosition()[2]);
-
-    return output;
 }
-void EUTelHit::setTrackFromLCIOVec(std::vector<double> input){
+void EUTelHit::setTrackFromLCIOVec(const std::vector<double>& input){
     setID(input.at(0));
     const double pos[3] = {input.at(1),input.at(2),input.at(3)};
     setPosition(pos);
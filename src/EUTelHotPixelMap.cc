@@ -0,0 +1,192 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelHotPixelMap.h"
+#include "EUTELESCOPE.h"
+#include "EUTelExceptions.h"
+#include "EUTelSparseClusterImpl.h"
+#include "EUTelGenericSparsePixel.h"
+
+// marlin includes ".h"
+#include "streamlog/streamlog.h"
+
+// lcio includes <.h>
+#include <lcio.h>
+#include <Exceptions.h>
+#include <EVENT/LCCollection.h>
+#include <UTIL/CellIDDecoder.h>
+
+// system includes <>
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+using namespace lcio;
+using namespace eutelescope;
+
+EUTelHotPixelMap::SensorMap::SensorMap() :
+  _xMin(0),
+  _yMin(0),
+  _width(0),
+  _height(0),
+  _nHot(0),
+  _bits() {
+}
+
+void EUTelHotPixelMap::SensorMap::fill( const vector< pair< int, int > > & pixels ) {
+
+  _bits.clear();
+  _nHot = 0;
+  _width = _height = 0;
+  if ( pixels.empty() ) return;
+
+  int xMax = numeric_limits<int>::min(), yMax = numeric_limits<int>::min();
+  _xMin = _yMin = numeric_limits<int>::max();
+  for ( size_t i = 0; i < pixels.size(); ++i ) {
+    _xMin = min( _xMin, pixels[i].first  );
+    _yMin = min( _yMin, pixels[i].second );
+    xMax  = max( xMax,  pixels[i].first  );
+    yMax  = max( yMax,  pixels[i].second );
+  }
+
+  _width  = xMax - _xMin + 1;
+  _height = yMax - _yMin + 1;
+  _bits.assign( static_cast< size_t >( _width ) * _height, false );
+
+  for ( size_t i = 0; i < pixels.size(); ++i ) {
+    vector< bool >::reference bit = _bits[ static_cast< size_t >( pixels[i].second - _yMin ) * _width + ( pixels[i].first - _xMin ) ];
+    if ( !bit ) {
+      bit = true;
+      ++_nHot;
+    }
+  }
+}
+
+EUTelHotPixelMap & EUTelHotPixelMap::getInstance( const string & collectionName ) {
+
+  // one map per collection, living until the end of the job
+  static map< string, EUTelHotPixelMap * > instances;
+
+  map< string, EUTelHotPixelMap * >::iterator iter = instances.find( collectionName );
+  if ( iter == instances.end() ) {
+    iter = instances.insert( make_pair( collectionName, new EUTelHotPixelMap( collectionName ) ) ).first;
+  }
+  return *( iter->second );
+}
+
+EUTelHotPixelMap::EUTelHotPixelMap( const string & collectionName ) :
+  _collectionName( collectionName ),
+  _isLoaded( false ),
+  _nHot( 0 ),
+  _sensorMaps() {
+}
+
+bool EUTelHotPixelMap::load( LCEvent * event ) {
+
+  if ( _isLoaded ) return true;
+  if ( _collectionName.empty() ) return false;
+
+  LCCollection * hotPixelCollection = 0;
+  try {
+    hotPixelCollection = event->getCollection( _collectionName );
+  } catch ( lcio::DataNotAvailableException& e ) {
+    streamlog_out ( WARNING5 ) << "Hot pixel collection " << _collectionName << " not found" << endl;
+    return false;
+  }
+
+  CellIDDecoder<TrackerDataImpl> cellDecoder( hotPixelCollection );
+
+  // first collect the pixels of each sensor, a sensor can appear in
+  // more than one element of the collection
+  map< int, vector< pair< int, int > > > pixelsBySensor;
+  EUTelGenericSparsePixel pixel;
+
+  for ( int i = 0; i < hotPixelCollection->getNumberOfElements(); ++i ) {
+
+    TrackerDataImpl * hotData = dynamic_cast< TrackerDataImpl * > ( hotPixelCollection->getElementAt( i ) );
+    if ( hotData == 0 ) continue;
+
+    SparsePixelType type = static_cast< SparsePixelType >( static_cast< int >( cellDecoder( hotData )["sparsePixelType"] ) );
+    int sensorID         = static_cast< int >( cellDecoder( hotData )["sensorID"] );
+
+    if ( type != kEUTelGenericSparsePixel ) {
+      streamlog_out ( WARNING5 ) << "Hot pixel collection " << _collectionName << ": unsupported pixel type "
+                                 << type << " on sensor " << sensorID << ", skipped" << endl;
+      continue;
+    }
+    if ( sensorID < 0 ) continue;
+
+    EUTelSparseClusterImpl< EUTelGenericSparsePixel > hotPixels( hotData );
+    vector< pair< int, int > > & pixels = pixelsBySensor[ sensorID ];
+    pixels.reserve( pixels.size() + hotPixels.size() );
+    for ( unsigned int iPixel = 0; iPixel < hotPixels.size(); ++iPixel ) {
+      hotPixels.getSparsePixelAt( iPixel, &pixel );
+      pixels.push_back( make_pair( static_cast< int >( pixel.getXCoord() ), static_cast< int >( pixel.getYCoord() ) ) );
+    }
+  }
+
+  // then build the bitmaps
+  _sensorMaps.clear();
+  _nHot = 0;
+  if ( !pixelsBySensor.empty() ) _sensorMaps.resize( pixelsBySensor.rbegin()->first + 1 );
+
+  for ( map< int, vector< pair< int, int > > >::iterator iter = pixelsBySensor.begin(); iter != pixelsBySensor.end(); ++iter ) {
+    _sensorMaps[ iter->first ].fill( iter->second );
+    _nHot += _sensorMaps[ iter->first ].size();
+    streamlog_out ( DEBUG5 ) << "Sensor " << iter->first << ": " << _sensorMaps[ iter->first ].size() << " hot pixels" << endl;
+  }
+
+  streamlog_out ( MESSAGE4 ) << "Hot pixel collection " << _collectionName << " loaded: " << _nHot
+                             << " hot pixels on " << pixelsBySensor.size() << " sensors" << endl;
+
+  _isLoaded = true;
+  return true;
+}
+
+const EUTelHotPixelMap::SensorMap * EUTelHotPixelMap::getSensorMap( int sensorID ) const {
+  if ( sensorID < 0 || static_cast< size_t >( sensorID ) >= _sensorMaps.size() ) return 0;
+  const SensorMap & sensorMap = _sensorMaps[ sensorID ];
+  return sensorMap.size() == 0 ? 0 : &sensorMap;
+}
+
+bool EUTelHotPixelMap::isHot( int sensorID, int x, int y ) const {
+  const SensorMap * sensorMap = getSensorMap( sensorID );
+  return sensorMap != 0 && sensorMap->isHot( x, y );
+}
+
+bool EUTelHotPixelMap::containsHot( int sensorID, TrackerDataImpl * sparseData ) const {
+
+  const SensorMap * sensorMap = getSensorMap( sensorID );
+  if ( sensorMap == 0 ) return false;
+
+  EUTelSparseClusterImpl< EUTelGenericSparsePixel > cluster( sparseData );
+  EUTelGenericSparsePixel pixel;
+  for ( unsigned int iPixel = 0; iPixel < cluster.size(); ++iPixel ) {
+    cluster.getSparsePixelAt( iPixel, &pixel );
+    if ( sensorMap->isHot( pixel.getXCoord(), pixel.getYCoord() ) ) return true;
+  }
+  return false;
+}
+
+bool EUTelHotPixelMap::containsHot( const TrackerHitImpl * hit ) const {
+
+  if ( _nHot == 0 || hit->getType() != kEUTelSparseClusterImpl ) return false;
+
+  const LCObjectVec & clusterVector = hit->getRawHits();
+  if ( clusterVector.empty() ) return false;
+
+  TrackerDataImpl * clusterFrame = dynamic_cast< TrackerDataImpl * > ( clusterVector[0] );
+  if ( clusterFrame == 0 ) {
+    throw UnknownDataTypeException( "Invalid hit found in method EUTelHotPixelMap::containsHot()" );
+  }
+
+  CellIDDecoder<TrackerDataImpl> cellDecoder( EUTELESCOPE::ZSCLUSTERDEFAULTENCODING );
+  return containsHot( static_cast< int >( cellDecoder( clusterFrame )["sensorID"] ), clusterFrame );
+}
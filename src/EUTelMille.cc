@@ -14,6 +14,7 @@
 
 // eutelescope includes ".h"
 #include "EUTelMille.h"
+#include "EUTelProcessorMonitor.h"
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelEventImpl.h"
 #include "EUTELESCOPE.h"
@@ -121,7 +122,7 @@ std::string EUTelMille::_residualZvsYLocalname      = "ResidualZvsY";
 
 
 
-EUTelMille::EUTelMille () : Processor("EUTelMille") {
+EUTelMille::EUTelMille () : Processor("EUTelMille"), _hotPixelMap(0) {
 
   //some default values
   FloatVec MinimalResidualsX;
@@ -222,6 +223,8 @@ EUTelMille::EUTelMille () : Processor("EUTelMille") {
 
   registerOptionalParameter("BinaryFilename","Name of the Millepede binary file.",_binaryFilename, string ("mille.bin"));
 
+  registerOptionalParameter("BinaryManifest","Text file listing the Millepede binary files written by other jobs, one per line. They are read by pede after BinaryFilename, in the order of the list.",_binaryManifest, string (""));
+
   registerOptionalParameter("TelescopeResolution","(default) Resolution of the telescope for Millepede (sigma_x=sigma_y) used only if plane dependent resolution is set inconsistently.",_telescopeResolution, static_cast <float> (3.0));
 
   registerOptionalParameter("OnlySingleHitEvents","Use only events with one hit in every plane.",_onlySingleHitEvents, static_cast <bool> (false));
@@ -323,6 +326,7 @@ EUTelMille::EUTelMille () : Processor("EUTelMille") {
 }
 
 void EUTelMille::init() {
+    EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
 
     // Getting access to geometry description
     std::string name("test.root");
@@ -582,6 +586,10 @@ void EUTelMille::init() {
         }
     }
 
+  _trackFinder.setAllowedMissingHits( _allowedMissingHits );
+  _trackFinder.setMaxTrackCandidates( _maxTrackCandidates );
+  _trackFinder.setResidualCuts( _residualsXMin, _residualsXMax, _residualsYMin, _residualsYMax );
+
   streamlog_out ( MESSAGE4 ) << "end of initialisation" << endl;
 }
 
@@ -608,163 +616,6 @@ void EUTelMille::processRunHeader (LCRunHeader * rdr) {
 
 
 
-void EUTelMille::findtracks2(
-                            int missinghits,
-                            std::vector<IntVec > &indexarray,
-                            IntVec vec,
-                            std::vector<std::vector<EUTelMille::HitsInPlane> > &_allHitsArray,
-                            unsigned int i,
-                            int y
-                            )
-{
- if(y==-1) missinghits++;
- streamlog_out(DEBUG9) << "Missing hits:" << missinghits << std::endl;
-
- if( missinghits > getAllowedMissingHits() ) 
- {
-   // recursive chain is dropped here;
-   streamlog_out(DEBUG9) << "indexarray size:" << indexarray.size() << std::endl;
-   return;
- }
-
- if(i>0)
- { 
-    vec.push_back(y); // recall hit id from the plane (i-1)
- }
-
-
- if( (_allHitsArray[i].size() == 0) && (i <_allHitsArray.size()-1) )
- {
-    findtracks2(missinghits,indexarray,vec, _allHitsArray, i+1, -1 ); 
- } 
-
- for(size_t j =0; j < _allHitsArray[i].size(); j++)
-    {
-      int ihit = static_cast< int >(j);
-      streamlog_out(DEBUG5) << "ihit:" << ihit << std::endl;
-
-      //if we are not in the last plane, call this method again
-      if(i < _allHitsArray.size()-1)
-        {
-          vec.push_back( ihit); //index of the cluster in the last plane
-         
-          //track candidate requirements
-          bool taketrack = true;
-          const int e = vec.size()-2;
-          if(e >= 0)
-            {
-              double residualX  = -999999.;
-              double residualY  = -999999.;
-              double residualZ  = -999999.;
-
-              // ACTIVE
-              // stop on the last non-zero hit
-
-              // now loop through all hits on a track candidate "vec"
-              // start at the end, stop on the first non-zero hit
-              for(int ivec=e; ivec>=e; --ivec)                  //     <-> OFF
-              {
-                if(vec[ivec]>=0) // non zero hit has id vec[ivec]>=0 {otherwise -1}
-                {
-                  double x = _allHitsArray[ivec][vec[ivec]].measuredX;
-                  double y = _allHitsArray[ivec][vec[ivec]].measuredY;
-                  double z = _allHitsArray[ivec][vec[ivec]].measuredZ;
-                  residualX  = abs(x - _allHitsArray[e+1][vec[e+1]].measuredX);
-                  residualY  = abs(y - _allHitsArray[e+1][vec[e+1]].measuredY);
-                  residualZ  = abs(z - _allHitsArray[e+1][vec[e+1]].measuredZ);
-		  streamlog_out(DEBUG9) << "residuals:" << std::endl;
-		  streamlog_out(DEBUG9) << residualX << std::endl;
-		  streamlog_out(DEBUG9) << residualY << std::endl;
-		  streamlog_out(DEBUG9) << residualZ << std::endl;
-
-                  break; 
-                }   
-              }
-           
-             if ( 
-                   residualX < _residualsXMin[e] || residualX > _residualsXMax[e] ||
-                   residualY < _residualsYMin[e] || residualY > _residualsYMax[e] 
-                 )
-                 taketrack = false;
-
-              if( taketrack == false )
-              {
-                taketrack = true; 
-                ihit=-1;
-              } 
-            }
-          vec.pop_back(); 
-
-          if(taketrack)
-          { 
-              findtracks2(missinghits, indexarray, vec, _allHitsArray, i+1, ihit );
-          }
-        }
-      else
-        {
-          //we are in the last plane
-          vec.push_back( ihit ); //index of the cluster in the last plane
-
-          //track candidate requirements
-          bool taketrack = true;
-          const int e = vec.size()-2;
-          if(e >= 0)
-            {
-              double residualX  = -999999.;
-              double residualY  = -999999.;
-              //double residualZ  = -999999.;
-
-              // now loop through all hits on a track candidate "vec"
-              // start at the end, stop on the first non-zero hit
-              for(int ivec=e; ivec>=e; --ivec)                        //   <-> OFF
-              {
-                if(vec[ivec]>=0) // non zero hit has id vec[ivec]>=0 {otherwise -1}
-                {
-                  double x = _allHitsArray[ivec][vec[ivec]].measuredX;
-                  double y = _allHitsArray[ivec][vec[ivec]].measuredY;
-                  //double z = _allHitsArray[ivec][vec[ivec]].measuredZ;
-                  residualX  = abs(x - _allHitsArray[e+1][vec[e+1]].measuredX);
-                  residualY  = abs(y - _allHitsArray[e+1][vec[e+1]].measuredY);
-                  //residualZ  = abs(z - _allHitsArray[e+1][vec[e+1]].measuredZ);
-                  break; 
-                }   
-              }
-           
-              if ( 
-                   residualX < _residualsXMin[e] || residualX > _residualsXMax[e] ||
-                   residualY < _residualsYMin[e] || residualY > _residualsYMax[e] 
-                 )
-                 taketrack = false;
- 
-              if( taketrack == false )
-              {
-                taketrack = true; 
-                ihit=-1;
-              } 
-            }
-
-          if(static_cast< int >(indexarray.size()) >= _maxTrackCandidates)
-            taketrack = false;
- 
-          if(taketrack)
-            {
-               indexarray.push_back(vec);
-	       streamlog_out(DEBUG9) << "indexarray size at last plane:" << indexarray.size() << std::endl;
-            }
-          vec.pop_back(); //last element must be removed because the
-                          //vector is still used -> we are in a last plane hit loop!
-
-        }
-    }
-
-  if( (_allHitsArray[i].size() == 0) && (i >= _allHitsArray.size()-1) )
-  {
-               indexarray.push_back(vec);
-  } 
-}
-
-
-
 void EUTelMille::findtracks(
                             std::vector<IntVec > &indexarray,
                             IntVec vec,
@@ -1001,55 +852,8 @@ double residYFit[], double angleFit[2]) {
 
 void  EUTelMille::FillHotPixelMap(LCEvent *event)
 {
-    LCCollectionVec *hotPixelCollectionVec = 0;
-    try 
-    {
-      hotPixelCollectionVec = static_cast< LCCollectionVec* > ( event->getCollection( _hotPixelCollectionName  ) );
-    }
-    catch (...)
-    {
-      if (!_hotPixelCollectionName.empty())
-	streamlog_out ( WARNING ) << "_hotPixelCollectionName " << _hotPixelCollectionName.c_str() << " not found" << endl; 
-      return;
-    }
-
-        CellIDDecoder<TrackerDataImpl> cellDecoder( hotPixelCollectionVec );
-	
-        for(int i=0; i<  hotPixelCollectionVec->getNumberOfElements(); i++)
-        {
-           TrackerDataImpl* hotPixelData = dynamic_cast< TrackerDataImpl *> ( hotPixelCollectionVec->getElementAt( i ) );
-	   SparsePixelType  type         = static_cast<SparsePixelType> (static_cast<int> (cellDecoder( hotPixelData )["sparsePixelType"]));
-
-	   int sensorID              = static_cast<int > ( cellDecoder( hotPixelData )["sensorID"] );
-
-           if( type  ==  kEUTelGenericSparsePixel )
-           {  
-              auto_ptr<EUTelSparseClusterImpl< EUTelGenericSparsePixel > > m26Data( new EUTelSparseClusterImpl< EUTelGenericSparsePixel >   ( hotPixelData ) );
-
-              std::vector<EUTelGenericSparsePixel*> m26PixelVec;
-	      EUTelGenericSparsePixel m26Pixel;
-  	      //Push all single Pixels of one plane in the m26PixelVec
-
-             for ( unsigned int iPixel = 0; iPixel < m26Data->size(); iPixel++ ) 
-             {
-              IntVec m26ColVec();
-              m26Data->getSparsePixelAt( iPixel, &m26Pixel);
-              streamlog_out ( DEBUG3 ) << iPixel << " of " << m26Data->size() << " HotPixelInfo:  " << m26Pixel.getXCoord() << " " << m26Pixel.getYCoord() << " " << m26Pixel.getSignal() << endl;
-              try
-              {
-                 char ix[100];
-                 sprintf(ix, "%d,%d,%d", sensorID, m26Pixel.getXCoord(), m26Pixel.getYCoord() ); 
-                 _hotPixelMap[ix] = true;             
-              }
-              catch(...)
-              {
-                 std::cout << "can not add pixel " << std::endl;
-                 std::cout << sensorID << " " << m26Pixel.getXCoord() << " " << m26Pixel.getYCoord() << " " << std::endl;   
-              }
-             }
-           }
-       }
-
+  _hotPixelMap = &EUTelHotPixelMap::getInstance( _hotPixelCollectionName );
+  _hotPixelMap->load( event );
 }
 
 void  EUTelMille::findMatchedHits(int& _ntrack, Track* TrackHere) {
@@ -1134,6 +938,7 @@ void  EUTelMille::findMatchedHits(int& _ntrack, Track* TrackHere) {
 }
 
 void EUTelMille::processEvent (LCEvent * event) {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 
   if ( isFirstEvent() )
   {
@@ -1288,7 +1093,7 @@ void EUTelMille::processEvent (LCEvent * event) {
     std::vector<IntVec > indexarray;
 
     streamlog_out( DEBUG5 ) << "Event #" << _iEvt << std::endl;
-    findtracks2(0, indexarray, IntVec(), _allHitsArray, 0, 0);
+    _trackFinder.findTracks(indexarray, _allHitsArray);
     for(size_t i = 0; i < indexarray.size(); i++)
       {
         for(size_t j = 0; j <  _nPlanes; j++)
@@ -2409,63 +2214,20 @@ TVector3 EUTelMille::Line2Plane(int iplane, const TVector3& lpoint, const TVecto
       
 bool EUTelMille::hitContainsHotPixels( TrackerHitImpl   * hit) 
 {
+  if ( _hotPixelMap == 0 ) return 0;
+
   try
     {
-      try{
-	LCObjectVec clusterVector = hit->getRawHits();
-
-	if ( hit->getType() == kEUTelSparseClusterImpl ) 
-	  {
-      
-	    TrackerDataImpl * clusterFrame = dynamic_cast<TrackerDataImpl*> ( clusterVector[0] );
-	    if (clusterFrame == 0){
-	      // found invalid result from cast
-	      throw UnknownDataTypeException("Invalid hit found in method hitContainsHotPixels()");
-	    }
-		
-	    eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelGenericSparsePixel > *cluster = new eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelGenericSparsePixel >(clusterFrame);
-	    int sensorID = cluster->getDetectorID();
- 
-	    for ( unsigned int iPixel = 0; iPixel < cluster->size(); iPixel++ ) 
-              {
-                EUTelGenericSparsePixel m26Pixel;
-                cluster->getSparsePixelAt( iPixel, &m26Pixel);
-                int pixelX, pixelY;
-                pixelX = m26Pixel.getXCoord();
-                pixelY = m26Pixel.getYCoord();
-
-		{                       
-		    char ix[100];
-		    sprintf(ix, "%d,%d,%d", sensorID, pixelX, pixelY ); 
-		    std::map<std::string, bool >::const_iterator z = _hotPixelMap.find(ix);
-		    if(z!=_hotPixelMap.end() && _hotPixelMap[ix] == true  )
-		      { 
-			streamlog_out(DEBUG3) << "Skipping hit as it was found in the hot pixel map." << endl;
-			return true; // if TRUE  this hit will be skipped
-		      }
-		} 
-	      }
-
-	  } else if ( hit->getType() == kEUTelBrickedClusterImpl ) {
-
-	  // fixed cluster implementation. Remember it
-	  //  can come from
-	  //  both RAW and ZS data
-                   
-	} else if ( hit->getType() == kEUTelDFFClusterImpl ) {
-              
-	  // fixed cluster implementation. Remember it can come from
-	  // both RAW and ZS data
-	} else if ( hit->getType() == kEUTelFFClusterImpl ) {
-              
-	  // fixed cluster implementation. Remember it can come from
-	  // both RAW and ZS data
-	} 
-      }
-      catch(lcio::Exception e){
-	// catch specific exceptions
-          streamlog_out ( ERROR5 ) << "Exception occured in hitContainsHotPixels(): " << e.what() << endl;
-      }
+      if ( _hotPixelMap->containsHot( hit ) )
+        {
+          streamlog_out(DEBUG3) << "Skipping hit as it was found in the hot pixel map." << endl;
+          return true; // if TRUE  this hit will be skipped
+        }
+    }
+  catch(lcio::Exception& e)
+    {
+      // catch specific exceptions
+      streamlog_out ( ERROR5 ) << "Exception occured in hitContainsHotPixels(): " << e.what() << endl;
     }
   catch(...)
     { 
@@ -2480,6 +2242,7 @@ bool EUTelMille::hitContainsHotPixels( TrackerHitImpl   * hit)
 
 
 void EUTelMille::end() {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
 
   delete [] _telescopeResolY;
   delete [] _telescopeResolX;
@@ -2589,6 +2352,13 @@ void EUTelMille::end() {
 
       steerFile << "Cfiles" << endl;
       steerFile << _binaryFilename << endl;
+      if ( !_binaryManifest.empty() ) {
+        // the binaries written by the other jobs, in a fixed order
+        vector< string > shards = Utility::readMilleManifest( _binaryManifest );
+        for ( size_t iShard = 0; iShard < shards.size(); ++iShard ) {
+          steerFile << shards[ iShard ] << endl;
+        }
+      }
       steerFile << endl;
 
       steerFile << "Parameter" << endl;
@@ -0,0 +1,199 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelMilleTrackFinder.h"
+
+// marlin includes ".h"
+#include "streamlog/streamlog.h"
+
+// system includes <>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+using namespace eutelescope;
+
+EUTelMilleTrackFinder::EUTelMilleTrackFinder() :
+  _allowedMissingHits(0),
+  _maxTrackCandidates(2000),
+  _residualsXMin(),
+  _residualsXMax(),
+  _residualsYMin(),
+  _residualsYMax()
+{}
+
+void EUTelMilleTrackFinder::setResidualCuts( const std::vector< float > & xMin, const std::vector< float > & xMax,
+                                             const std::vector< float > & yMin, const std::vector< float > & yMax ) {
+  _residualsXMin = xMin;
+  _residualsXMax = xMax;
+  _residualsYMin = yMin;
+  _residualsYMax = yMax;
+}
+
+void EUTelMilleTrackFinder::findTracks( std::vector< std::vector< int > > & indexArray,
+                                        const std::vector< std::vector< HitsInPlane > > & allHitsArray ) const {
+  if ( allHitsArray.empty() ) return;
+  findtracks2( 0, indexArray, std::vector< int >(), allHitsArray, 0, 0 );
+}
+
+void EUTelMilleTrackFinder::findtracks2(
+                            int missinghits,
+                            std::vector< std::vector< int > > &indexarray,
+                            std::vector< int > vec,
+                            const std::vector< std::vector< HitsInPlane > > &_allHitsArray,
+                            unsigned int i,
+                            int y
+                            ) const
+{
+ if(y==-1) missinghits++;
+ streamlog_out(DEBUG9) << "Missing hits:" << missinghits << std::endl;
+
+ if( missinghits > _allowedMissingHits ) 
+ {
+   // recursive chain is dropped here;
+   streamlog_out(DEBUG9) << "indexarray size:" << indexarray.size() << std::endl;
+   return;
+ }
+
+ if(i>0)
+ { 
+    vec.push_back(y); // recall hit id from the plane (i-1)
+ }
+
+
+ if( (_allHitsArray[i].size() == 0) && (i <_allHitsArray.size()-1) )
+ {
+    findtracks2(missinghits,indexarray,vec, _allHitsArray, i+1, -1 ); 
+ } 
+
+ for(size_t j =0; j < _allHitsArray[i].size(); j++)
+    {
+      int ihit = static_cast< int >(j);
+      streamlog_out(DEBUG5) << "ihit:" << ihit << std::endl;
+
+      //if we are not in the last plane, call this method again
+      if(i < _allHitsArray.size()-1)
+        {
+          vec.push_back( ihit); //index of the cluster in the last plane
+         
+          //track candidate requirements
+          bool taketrack = true;
+          const int e = vec.size()-2;
+          if(e >= 0)
+            {
+              double residualX  = -999999.;
+              double residualY  = -999999.;
+              double residualZ  = -999999.;
+
+              // ACTIVE
+              // stop on the last non-zero hit
+
+              // now loop through all hits on a track candidate "vec"
+              // start at the end, stop on the first non-zero hit
+              for(int ivec=e; ivec>=e; --ivec)                  //     <-> OFF
+              {
+                if(vec[ivec]>=0) // non zero hit has id vec[ivec]>=0 {otherwise -1}
+                {
+                  double x = _allHitsArray[ivec][vec[ivec]].measuredX;
+                  double y = _allHitsArray[ivec][vec[ivec]].measuredY;
+                  double z = _allHitsArray[ivec][vec[ivec]].measuredZ;
+                  residualX  = abs(x - _allHitsArray[e+1][vec[e+1]].measuredX);
+                  residualY  = abs(y - _allHitsArray[e+1][vec[e+1]].measuredY);
+                  residualZ  = abs(z - _allHitsArray[e+1][vec[e+1]].measuredZ);
+		  streamlog_out(DEBUG9) << "residuals:" << std::endl;
+		  streamlog_out(DEBUG9) << residualX << std::endl;
+		  streamlog_out(DEBUG9) << residualY << std::endl;
+		  streamlog_out(DEBUG9) << residualZ << std::endl;
+
+                  break; 
+                }   
+              }
+           
+             if ( 
+                   residualX < _residualsXMin[e] || residualX > _residualsXMax[e] ||
+                   residualY < _residualsYMin[e] || residualY > _residualsYMax[e] 
+                 )
+                 taketrack = false;
+
+              if( taketrack == false )
+              {
+                taketrack = true; 
+                ihit=-1;
+              } 
+            }
+          vec.pop_back(); 
+
+          if(taketrack)
+          { 
+              findtracks2(missinghits, indexarray, vec, _allHitsArray, i+1, ihit );
+          }
+        }
+      else
+        {
+          //we are in the last plane
+          vec.push_back( ihit ); //index of the cluster in the last plane
+
+          //track candidate requirements
+          bool taketrack = true;
+          const int e = vec.size()-2;
+          if(e >= 0)
+            {
+              double residualX  = -999999.;
+              double residualY  = -999999.;
+              //double residualZ  = -999999.;
+
+              // now loop through all hits on a track candidate "vec"
+              // start at the end, stop on the first non-zero hit
+              for(int ivec=e; ivec>=e; --ivec)                        //   <-> OFF
+              {
+                if(vec[ivec]>=0) // non zero hit has id vec[ivec]>=0 {otherwise -1}
+                {
+                  double x = _allHitsArray[ivec][vec[ivec]].measuredX;
+                  double y = _allHitsArray[ivec][vec[ivec]].measuredY;
+                  //double z = _allHitsArray[ivec][vec[ivec]].measuredZ;
+                  residualX  = abs(x - _allHitsArray[e+1][vec[e+1]].measuredX);
+                  residualY  = abs(y - _allHitsArray[e+1][vec[e+1]].measuredY);
+                  //residualZ  = abs(z - _allHitsArray[e+1][vec[e+1]].measuredZ);
+                  break; 
+                }   
+              }
+           
+              if ( 
+                   residualX < _residualsXMin[e] || residualX > _residualsXMax[e] ||
+                   residualY < _residualsYMin[e] || residualY > _residualsYMax[e] 
+                 )
+                 taketrack = false;
+ 
+              if( taketrack == false )
+              {
+                taketrack = true; 
+                ihit=-1;
+              } 
+            }
+
+          if(static_cast< int >(indexarray.size()) >= _maxTrackCandidates)
+            taketrack = false;
+ 
+          if(taketrack)
+            {
+               indexarray.push_back(vec);
+	       streamlog_out(DEBUG9) << "indexarray size at last plane:" << indexarray.size() << std::endl;
+            }
+          vec.pop_back(); //last element must be removed because the
+                          //vector is still used -> we are in a last plane hit loop!
+
+        }
+    }
+
+  if( (_allHitsArray[i].size() == 0) && (i >= _allHitsArray.size()-1) )
+  {
+               indexarray.push_back(vec);
+  } 
+}
@@ -15,13 +15,16 @@ _jacobian(2,6),
 _globalLabels(6),
 _milleSteeringFilename("steer.txt"),
 _milleSteerNameOldFormat("steer-iteration-0.txt"),
-_iteration(1)
+_iteration(1),
+_milleBinaryFilename("mille.bin"),
+_milleBinaryInputFiles()
 {
 	FillMilleParametersLabels();
-	CreateBinary();
 }
 
-EUTelMillepede::~EUTelMillepede(){}
+EUTelMillepede::~EUTelMillepede(){
+	closeBinary();
+}
 
 //Note here we label sensors and every alignment degree of freedom uniquely. Note that even if the sensor is to remain fixed. The fixing is done latter.
 void EUTelMillepede::FillMilleParametersLabels() {
@@ -109,9 +112,16 @@ void EUTelMillepede::writeMilleSteeringFile(lcio::StringVec pedeSteerAddCmds){
 	if (!steerFile.is_open()) {
 		throw(lcio::Exception("Could not open steering file.")); 	
 	}
-	streamlog_out(DEBUG0) << "Millepede binary:" << _milleBinaryFilename << std::endl;
 	steerFile << "Cfiles" << std::endl;
-	steerFile << _milleBinaryFilename << std::endl;
+	if(_milleBinaryInputFiles.empty()){
+		streamlog_out(DEBUG0) << "Millepede binary:" << _milleBinaryFilename << std::endl;
+		steerFile << _milleBinaryFilename << std::endl;
+	}
+	//pede reads the binaries one after the other, the order is fixed by the list so the result does not depend on which job finished first.
+	for(size_t i = 0; i < _milleBinaryInputFiles.size(); ++i){
+		streamlog_out(DEBUG0) << "Millepede binary:" << _milleBinaryInputFiles.at(i) << std::endl;
+		steerFile << _milleBinaryInputFiles.at(i) << std::endl;
+	}
 	steerFile << std::endl;
 	steerFile << "Parameter" << std::endl;
 	//TO DO: There should be a test that all planes that are used have a state associated with them and that state has a hit
@@ -370,8 +380,8 @@ void EUTelMillepede::CreateBinary(){
 
         const unsigned int reserveSize = 0;//This is the number of elements the vector will have as start for alignment parameters and derivatives.
 				//Can still push more onto the vector.
-				std::string string = "millepede.bin"; //TO DO:need to fix this. Not reading it correctly
-        _milleGBL = new gbl::MilleBinary(string, reserveSize);
+        closeBinary();
+        _milleGBL = new gbl::MilleBinary(_milleBinaryFilename, reserveSize);
 
         if (_milleGBL == NULL) {
             streamlog_out(ERROR) << "Can't allocate an instance of mMilleBinary. Stopping ..." << std::endl;
@@ -379,6 +389,12 @@ void EUTelMillepede::CreateBinary(){
         }
 }
 
+void EUTelMillepede::closeBinary(){
+	//The destructor of MilleBinary closes the file
+	delete _milleGBL;
+	_milleGBL = NULL;
+}
+
 void EUTelMillepede::testUserInput(){
 	bool fixedGood=true;
 	if(_fixedAlignmentXShfitPlaneIds.size()== 0){
@@ -58,7 +58,8 @@ _knownHitPos(0),
 _nDutHits(0),
 _nDutHitsCreated(0),
 _maxExpectedCreatedHitPerDUTHit(10),
-_numberOfCreatedHitPerDUTHit()
+_numberOfCreatedHitPerDUTHit(),
+_matcher()
 {
     // modify processor description
     _description =  "EUTelMissingCoordinateEstimator As the name suggest this processor is finds the position of the missing coordinate on your How it works is simple, it gets the hits from specified two finds the closest hit pairs, make a straight line out of it and the estimated position in one axis on your sensor you want. No promises that this will work with tilted sensors and/or with magnetic field. One needs to used this with merged hits and after pre-alignment";
@@ -117,6 +118,9 @@ void EUTelMissingCoordinateEstimator::init() {
     }
     
     
+    _matcher.setKnownCoordinate(_knownHitPos);
+    _matcher.setMaxResidual(_maxResidual);
+    
     // set counters to zero
     _nDutHits = 0;
     _nDutHitsCreated = 0;
@@ -199,6 +203,7 @@ void EUTelMissingCoordinateEstimator::processEvent (LCEvent * event) {
     vector<int> referencePlaneHits1;
     vector<int> referencePlaneHits2;
     vector<int> dutPlaneHits;
+    _matcher.clear();
 
     // Here identify which hits come from reference planes or DUT
     for ( int iInputHits = 0; iInputHits < inputHitCollection->getNumberOfElements(); iInputHits++ )
@@ -214,6 +219,7 @@ void EUTelMissingCoordinateEstimator::processEvent (LCEvent * event) {
         for (unsigned int i=0; i<_dutPlanes.size(); i++) {
             if (sensorID == _dutPlanes[i]) {
                 dutPlaneHits.push_back(iInputHits);
+                _matcher.addHit(sensorID, inputHit->getPosition());
                 isDUTHit = true;
                 _nDutHits++;
             }
@@ -241,6 +247,10 @@ void EUTelMissingCoordinateEstimator::processEvent (LCEvent * event) {
 		countCreatedDutHits.push_back(0);
 	}
  
+    // only the DUT hits close to the line through the reference hits in the known coordinate are tested
+    _matcher.prepare();
+    vector<unsigned int> matchedDutHits;
+
     // loop over first reference plane hits
     for (unsigned int iHitRefPlane1=0; iHitRefPlane1<referencePlaneHits1.size(); iHitRefPlane1++) {
         TrackerHitImpl * refHit1 = dynamic_cast<TrackerHitImpl*> ( inputHitCollection->getElementAt( referencePlaneHits1[iHitRefPlane1] ) );
@@ -251,8 +261,12 @@ void EUTelMissingCoordinateEstimator::processEvent (LCEvent * event) {
             TrackerHitImpl * refHit2 = dynamic_cast<TrackerHitImpl*> ( inputHitCollection->getElementAt( referencePlaneHits2[iHitRefPlane2] ) );
             const double* refHit2Pos = refHit2->getPosition();
             
-            // loop over second dut plane hits
-            for (unsigned int iDutHit=0; iDutHit<dutPlaneHits.size(); iDutHit++) {
+            // the DUT hits whose residual in the known coordinate is below MaxResidual, in the order of the input collection
+            _matcher.findMatches(refHit1Pos, refHit2Pos, matchedDutHits);
+
+            // loop over the correlated dut plane hits
+            for (unsigned int iMatch=0; iMatch<matchedDutHits.size(); iMatch++) {
+                unsigned int iDutHit = matchedDutHits[iMatch];
                 TrackerHitImpl * dutHit = dynamic_cast<TrackerHitImpl*> ( inputHitCollection->getElementAt( dutPlaneHits[iDutHit] ) );
                 const double* dutHitPos = dutHit->getPosition();
                 double newDutHitPos[3];
@@ -261,36 +275,30 @@ void EUTelMissingCoordinateEstimator::processEvent (LCEvent * event) {
                 // t = (z-z1)/(z2-z1)
                 double t = ( dutHitPos[2] - refHit1Pos[2] ) / ( refHit2Pos[2] - refHit1Pos[2] );
                 
-                // find the known coordinate value correcponds to that z on the line
-                double knownHitPosOnLine = refHit1Pos[_knownHitPos] + (refHit2Pos[_knownHitPos] - refHit1Pos[_knownHitPos]) * t;
+                // first copy old DUT hit position to the new one
+                newDutHitPos[0] = dutHitPos[0];
+                newDutHitPos[1] = dutHitPos[1];
+                newDutHitPos[2] = dutHitPos[2];
+                
+                // then replace the unknown one with the estimated one
+                double estimatedHitPos = refHit1Pos[_missingHitPos] + (refHit2Pos[_missingHitPos] - refHit1Pos[_missingHitPos]) * t;
                 
-                // if knownHitPosOnLine is close to the knownHitPos
-                if ( fabs( knownHitPosOnLine - dutHitPos[_knownHitPos] ) < _maxResidual) {
-                    // first copy old DUT hit position to the new one
-                    newDutHitPos[0] = dutHitPos[0];
-                    newDutHitPos[1] = dutHitPos[1];
-                    newDutHitPos[2] = dutHitPos[2];
-                    
-                    // then replace the unknown one with the estimated one
-                    double estimatedHitPos = refHit1Pos[_missingHitPos] + (refHit2Pos[_missingHitPos] - refHit1Pos[_missingHitPos]) * t;
-                    
-                    newDutHitPos[_missingHitPos] = estimatedHitPos;
-                    
-                    // now store new hit position in the TrackerHit, copy and store in the collection
-                    
-                    TrackerHitImpl * newHit = cloneHit(dutHit);
-			const double* hitpos = newDutHitPos;
-                    newHit->setPosition( &hitpos[0] );
-                    outputHitCollection->push_back(newHit);
-
-                    // count new created hits
-                    _nDutHitsCreated++;
-
-		    // increase the created DUT hits
-		    countCreatedDutHits[iDutHit] ++;
-                }
+                newDutHitPos[_missingHitPos] = estimatedHitPos;
+                
+                // now store new hit position in the TrackerHit, copy and store in the collection
+                
+                TrackerHitImpl * newHit = cloneHit(dutHit);
+		const double* hitpos = newDutHitPos;
+                newHit->setPosition( &hitpos[0] );
+                outputHitCollection->push_back(newHit);
+
+                // count new created hits
+                _nDutHitsCreated++;
+
+		// increase the created DUT hits
+		countCreatedDutHits[iDutHit] ++;
                 
-            } // end of loop over first dut plane hits
+            } // end of loop over correlated dut plane hits
             
             
         } // end of loop over second reference plane hits
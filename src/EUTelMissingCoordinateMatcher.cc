@@ -0,0 +1,141 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelMissingCoordinateMatcher.h"
+
+// system includes <>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace eutelescope;
+
+namespace {
+
+  typedef std::pair< double, unsigned int > KnownEntry;
+
+  bool knownLess( const KnownEntry & a, double b ) { return a.first < b; }
+
+  bool isFinite( double value ) { return std::fabs( value ) <= DBL_MAX; }
+
+}
+
+EUTelMissingCoordinateMatcher::EUTelMissingCoordinateMatcher() :
+  _positions(),
+  _sensorIDs(),
+  _planes(),
+  _nPlanes(0),
+  _knownHitPos(1),
+  _maxResidual(0.),
+  _sortedSearchMinHits(kDefaultSortedSearchMinHits),
+  _sorted(false)
+{}
+
+void EUTelMissingCoordinateMatcher::clear() {
+  _positions.clear();
+  _sensorIDs.clear();
+  for ( size_t iPlane = 0; iPlane < _nPlanes; ++iPlane ) _planes[ iPlane ].known.clear();
+  _nPlanes = 0;
+  _sorted = false;
+}
+
+void EUTelMissingCoordinateMatcher::addHit( int sensorID, const double * position ) {
+  _positions.insert( _positions.end(), position, position + 3 );
+  _sensorIDs.push_back( sensorID );
+}
+
+void EUTelMissingCoordinateMatcher::prepare() {
+
+  _sorted = _sensorIDs.size() >= _sortedSearchMinHits;
+  if ( !_sorted ) return;
+
+  for ( size_t index = 0; index < _sensorIDs.size(); ++index ) {
+    const double * position = &_positions[ 3 * index ];
+    const int sensorID = _sensorIDs[ index ];
+
+    size_t iPlane = 0;
+    while ( iPlane < _nPlanes && _planes[ iPlane ].sensorID != sensorID ) ++iPlane;
+    if ( iPlane == _nPlanes ) {
+      if ( _nPlanes == _planes.size() ) _planes.push_back( Plane() );
+      Plane & plane = _planes[ _nPlanes++ ];
+      plane.sensorID = sensorID;
+      plane.zMin     = position[2];
+      plane.zMax     = position[2];
+    }
+
+    Plane & plane = _planes[ iPlane ];
+    plane.zMin = std::min( plane.zMin, position[2] );
+    plane.zMax = std::max( plane.zMax, position[2] );
+    plane.known.push_back( std::make_pair( position[ _knownHitPos ], static_cast< unsigned int >( index ) ) );
+  }
+
+  for ( size_t iPlane = 0; iPlane < _nPlanes; ++iPlane ) {
+    std::sort( _planes[ iPlane ].known.begin(), _planes[ iPlane ].known.end() );
+  }
+}
+
+void EUTelMissingCoordinateMatcher::findMatches( const double * refHit1Pos, const double * refHit2Pos,
+                                                 std::vector< unsigned int > & matches ) const {
+
+  matches.clear();
+
+  // with few hits the plain loop is faster, and already in input order
+  if ( !_sorted ) {
+    for ( size_t index = 0; index < _sensorIDs.size(); ++index ) {
+      const double * dutHitPos = &_positions[ 3 * index ];
+      double t = ( dutHitPos[2] - refHit1Pos[2] ) / ( refHit2Pos[2] - refHit1Pos[2] );
+      double knownHitPosOnLine = refHit1Pos[ _knownHitPos ] + ( refHit2Pos[ _knownHitPos ] - refHit1Pos[ _knownHitPos ] ) * t;
+      if ( std::fabs( knownHitPosOnLine - dutHitPos[ _knownHitPos ] ) < _maxResidual ) {
+        matches.push_back( static_cast< unsigned int >( index ) );
+      }
+    }
+    return;
+  }
+
+  const double knownSlope = refHit2Pos[ _knownHitPos ] - refHit1Pos[ _knownHitPos ];
+  const double dz         = refHit2Pos[2] - refHit1Pos[2];
+
+  for ( size_t iPlane = 0; iPlane < _nPlanes; ++iPlane ) {
+
+    const Plane & plane = _planes[ iPlane ];
+
+    // the line is linear in z, so over the z range of the sensor it
+    // lies between its values at the two ends of the range
+    const double tMin    = ( plane.zMin - refHit1Pos[2] ) / dz;
+    const double tMax    = ( plane.zMax - refHit1Pos[2] ) / dz;
+    const double atZMin  = refHit1Pos[ _knownHitPos ] + knownSlope * tMin;
+    const double atZMax  = refHit1Pos[ _knownHitPos ] + knownSlope * tMax;
+
+    std::vector< KnownEntry >::const_iterator first = plane.known.begin();
+    std::vector< KnownEntry >::const_iterator last  = plane.known.end();
+
+    if ( isFinite( atZMin ) && isFinite( atZMax ) ) {
+      // widened by far more than the rounding of the per hit computation
+      const double margin = _maxResidual
+        + 1e-9 * ( 1. + std::fabs( refHit1Pos[ _knownHitPos ] ) + std::fabs( knownSlope ) * std::max( std::fabs( tMin ), std::fabs( tMax ) ) );
+      first = std::lower_bound( plane.known.begin(), plane.known.end(), std::min( atZMin, atZMax ) - margin, knownLess );
+      last  = std::lower_bound( first, plane.known.end(), std::max( atZMin, atZMax ) + margin, knownLess );
+    }
+    // otherwise the reference hits are at the same z and every hit is
+    // left to the exact test below
+
+    for ( ; first != last; ++first ) {
+      const double * dutHitPos = &_positions[ 3 * first->second ];
+      double t = ( dutHitPos[2] - refHit1Pos[2] ) / ( refHit2Pos[2] - refHit1Pos[2] );
+      double knownHitPosOnLine = refHit1Pos[ _knownHitPos ] + ( refHit2Pos[ _knownHitPos ] - refHit1Pos[ _knownHitPos ] ) * t;
+      if ( std::fabs( knownHitPosOnLine - dutHitPos[ _knownHitPos ] ) < _maxResidual ) {
+        matches.push_back( first->second );
+      }
+    }
+  }
+
+  // same order as a loop over all the DUT hits
+  std::sort( matches.begin(), matches.end() );
+}
@@ -220,6 +220,11 @@ TMatrixD EUTelNav::getLocalToCurvilinearTransformMatrix(TVector3 globalMomentum,
 TMatrixD EUTelNav::getMeasToGlobal(TVector3 t1w, int  planeID)
 {
 //	std::cout<<"Plane ID " << planeID <<std::endl;
+	return getMeasToGlobal(t1w, geo::gGeometry().getRotMatrix( planeID ));
+}
+///Same as above with the rotation matrix of the plane already known, as cached by the GBL workspace.
+TMatrixD EUTelNav::getMeasToGlobal(TVector3 t1w, const TMatrixD& TRotMatrix)
+{
 	TMatrixD transM2l(5,5);
 	transM2l.UnitMatrix();
 	std::vector<double> slope;
@@ -230,8 +235,6 @@ TMatrixD EUTelNav::getMeasToGlobal(TVector3 t1w, int  planeID)
 	TMatrixD xyDir(2, 3);
 	xyDir[0][0] = 1; xyDir[0][1]=0.0; xyDir[0][2]=-slope.at(0);  
 	xyDir[1][0] = 0; xyDir[1][1]=1.0; xyDir[1][2]=-slope.at(1);  
-	TMatrixD TRotMatrix(3,3);
-	TRotMatrix	=  geo::gGeometry().getRotMatrix( planeID );
 	TVector3 normalVec;
 	normalVec[0] = TRotMatrix[0][2];	normalVec[1] = TRotMatrix[1][2];	normalVec[2] = TRotMatrix[2][2];
 	double cosInc = direction*normalVec;
@@ -274,6 +277,14 @@ TMatrixD EUTelNav::getMeasToGlobal(TVector3 t1w, int  planeID)
  */
 
 TMatrixD EUTelNav::getPropagationJacobianGlobalToGlobal(float ds, TVector3 t1w)
+{
+	const gear::BField& Bfield = geo::gGeometry().getMagneticField();
+	gear::Vector3D vectorGlobal(0.1,0.1,0.1);
+	TVector3 b(Bfield.at( vectorGlobal ).x(), Bfield.at( vectorGlobal ).y(), Bfield.at( vectorGlobal ).z());
+	return getPropagationJacobianGlobalToGlobal(ds, t1w, b);
+}
+///Same as above with the magnetic field already known, as cached by the GBL workspace.
+TMatrixD EUTelNav::getPropagationJacobianGlobalToGlobal(float ds, TVector3 t1w, const TVector3& b)
 {
 	t1w.Unit();
 	std::vector<double> slope;
@@ -283,15 +294,7 @@ TMatrixD EUTelNav::getPropagationJacobianGlobalToGlobal(float ds, TVector3 t1w)
 	direction[0] = (slope.at(0)/norm); direction[1] =(slope.at(1)/norm);	direction[2] = (1.0/norm);
 //	std::cout <<"DIRECTION: "<< direction[0] <<"   " << direction[1]<< "  "<< direction[2] <<std::endl;
 	double sinLambda = direction[2]; 
-	const gear::BField& Bfield = geo::gGeometry().getMagneticField();
-	gear::Vector3D vectorGlobal(0.1,0.1,0.1);
-
-
-	const double Bx = (Bfield.at( vectorGlobal ).x());  
-	const double By = (Bfield.at( vectorGlobal ).y());
-	const double Bz = (Bfield.at( vectorGlobal ).z());
 
-	TVector3 b(Bx, By, Bz);
 	TVector3 BxT = b.Cross(direction);
 //	std::cout << "BxT" << BxT[0] << "  ,  " <<  BxT[1] <<"   ,  " <<BxT[2] << std::endl;
 	TMatrixD xyDir(2, 3);
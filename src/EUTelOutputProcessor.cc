@@ -19,6 +19,7 @@
 #include "marlin/LCIOOutputProcessor.h"
 
 // lcio includes <.h>
+#include <lcio.h>
 #include <UTIL/LCTOOLS.h>
 #include <UTIL/LCTime.h>
 
@@ -30,7 +31,10 @@ using namespace marlin;
 using namespace eutelescope;
 
  
-EUTelOutputProcessor::EUTelOutputProcessor() : LCIOOutputProcessor("EUTelOutputProcessor")  {
+EUTelOutputProcessor::EUTelOutputProcessor() : LCIOOutputProcessor("EUTelOutputProcessor"),
+  _eventType(kUNKNOWN),
+  _skipIntermediateEORESwitch(true),
+  _compressionLevel(-1) {
     
   _description = "Writes the current event to the specified LCIO outputfile."
     " Eventually it adds a EORE at the of the file if it was missing"
@@ -82,6 +86,10 @@ EUTelOutputProcessor::EUTelOutputProcessor() : LCIOOutputProcessor("EUTelOutputP
 			     "Set it to true to remove intermediate EORE in merged runs",
 			     _skipIntermediateEORESwitch, static_cast< bool > ( true ) );
 
+  registerOptionalParameter("LCIOCompressionLevel",
+			    "zlib compression level of the output file (0 = none, 1 = fastest, 9 = smallest), LCIO default if negative",
+			    _compressionLevel, static_cast< int > ( -1 ) );
+
 
 }
 
@@ -91,6 +99,20 @@ void EUTelOutputProcessor::init() {
   // LCIOOutputProcessor
   LCIOOutputProcessor::init();
 
+  if ( _compressionLevel < 0 ) return;
+
+  // the compression level is only used when the file is opened, so the
+  // writer of the base class is reopened with it. Nothing has been
+  // written yet: the file created by the base class can be replaced.
+  _lcWrt->close();
+  _lcWrt->setCompressionLevel( _compressionLevel );
+  if ( _lcioWriteMode == "WRITE_APPEND" ) {
+    _lcWrt->open( _lcioOutputFile, lcio::LCIO::WRITE_APPEND );
+  } else {
+    _lcWrt->open( _lcioOutputFile, lcio::LCIO::WRITE_NEW );
+  }
+
+  message<MESSAGE5> ( log() << "Writing " << _lcioOutputFile << " with compression level " << _compressionLevel );
 }
 
 
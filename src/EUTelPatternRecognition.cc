@@ -17,7 +17,8 @@ _numberOfTracksAfterPruneCut(0),
 _allowedMissingHits(0),
 _AllowedSharedHitsOnTrackCandidate(0),
 _beamE(-1.),
-_beamQ(-1.)
+_beamQ(-1.),
+_scatteringTableFailed(false)
 {}
 EUTelPatternRecognition::~EUTelPatternRecognition()  
 {}
@@ -47,27 +48,59 @@ std::vector<EUTelTrack>& EUTelPatternRecognition::getTracks()
 //	}
 //}
 
+//The material is taken along a straight line parallel to the z axis through the centre of the first plane, not along the first seed, so that the table does not depend on the order of the hits.
+//The slope of each track is accounted for by the table itself. 
+bool EUTelPatternRecognition::buildScatteringTable(double momentum)
+{
+	const std::map<int, int>& zOrderToID = geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes();
+	const int firstPlaneID = zOrderToID.at(0);
+	const int lastPlaneID = zOrderToID.at(zOrderToID.size()-1);
+	//Must make sure we add all silicon.
+	const double start[] = {geo::gGeometry().siPlaneXPosition(firstPlaneID), geo::gGeometry().siPlaneYPosition(firstPlaneID), geo::gGeometry().siPlaneZPosition(firstPlaneID)-0.025};
+	const double end[]   = {start[0], start[1], geo::gGeometry().siPlaneZPosition(lastPlaneID)+0.025};
+	std::map<const int,double>  mapSensor;
+	std::map<const int ,double>  mapAir;
+	const double rad = geo::gGeometry().calculateTotalRadiationLengthAndWeights(start, end, mapSensor, mapAir);
+	if(rad == 0 ){ //If the estimated radiation length is 0 then we do not use the tracks.
+		streamlog_out(WARNING5) << "No material found along the z axis through the centre of plane " << firstPlaneID << ", the material is found along each seed instead" << std::endl;
+		return false;
+	}
+	_scatteringTable.build(momentum, mapSensor, mapAir, rad);
+	return true;
+}
+
 //This is the work horse of the class. Using seeds it propagates the track forward using equations of motion. This can be with or without magnetic field.
 void EUTelPatternRecognition::propagateForwardFromSeedState(EUTelState& stateInput, EUTelTrack& track)
 {
     streamlog_out ( DEBUG1 ) << "Initial Seed: "<< std::endl;
     stateInput.print();
 
+	//The material along the telescope is the same for all the tracks: it is found once, along a fixed reference line, and the scattering of each track comes from the table.
+	//If that line misses a plane (e.g. an offset DUT) this is remembered, and the material is found along each seed as it used to be.
+	const double momentum = stateInput.getMomLocal().Mag();
+	if(!_scatteringTableFailed && !_scatteringTable.isBuiltFor(momentum)){
+		_scatteringTableFailed = !buildScatteringTable(momentum);
+	}
 	std::map<const int,double>  mapSensor;
 	std::map<const int ,double>  mapAir;
-	double rad =	stateInput.computeRadLengthsToEnd(mapSensor, mapAir);
-	EUTelState state = stateInput;
-	
-	if(rad == 0 ){ //If the estimated radiation length is 0 then we do not use the track.
-		return;
+	double rad = 0;
+	if(_scatteringTableFailed){
+		rad = stateInput.computeRadLengthsToEnd(mapSensor, mapAir);
+		if(rad == 0 ){ //If the estimated radiation length is 0 then we do not use the track.
+			return;
+		}
 	}
+	EUTelState state = stateInput;
+	//The planes along the beam, looked up once per track
+	const std::map<int, int>& zOrderToID = geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes();
+
 	//Here we loop through all the planes not excluded. We begin at the seed which might not be the first. Then we stop before the last plane, since we do not want to propagate anymore
 	bool firstLoop =true;//This is needed so we get the arclength to the next state on the first. Completing the state and adding.
     bool calcDirection =true;// This is used to have an estimate of the direction of the particle using the first two hits associated together. 
     EUTelState newState; //Must exist after exiting loop. 
-	for(size_t i = geo::gGeometry().sensorIDToZOrderWithoutExcludedPlanes().at(state.getLocation()); i < (geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes().size()); ++i){
+	for(size_t i = geo::gGeometry().sensorIDToZOrderWithoutExcludedPlanes().at(state.getLocation()); i < (zOrderToID.size()); ++i){
         //Loop one more than the last plane to add the last plane on the next loop then end 
-        if(i == geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes().size()-1){
+        if(i == zOrderToID.size()-1){
             //Do not add arclength to the last plane 
             track.setState(newState); 
             newState.clear();
@@ -82,7 +115,7 @@ void EUTelPatternRecognition::propagateForwardFromSeedState(EUTelState& stateInp
 		TVector3 momentumAtIntersection;
 		float arcLength;
 		int newSensorID = 0;
-		bool foundNextIntersection = state.findIntersectionWithCertainID(	geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes().at(i+1), 
+		bool foundNextIntersection = state.findIntersectionWithCertainID(	zOrderToID.at(i+1), 
 											globalIntersection, momentumAtIntersection, arcLength, newSensorID);
 
 		if(!foundNextIntersection)
@@ -91,16 +124,16 @@ void EUTelPatternRecognition::propagateForwardFromSeedState(EUTelState& stateInp
 						<<  globalIntersection[0] << ", " <<globalIntersection[1] << ", " << globalIntersection[2] << std::endl
 						<< "Momentum on next plane: " 
 						<<  momentumAtIntersection[0] << ", " << momentumAtIntersection[1] << ", " << momentumAtIntersection[2] << std::endl
-						<< "From ID: " << geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes().at(i) << " to " 
-						<<  geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes().at(i+1) << std::endl
+						<< "From ID: " << zOrderToID.at(i) << " to " 
+						<<  zOrderToID.at(i+1) << std::endl
 						<< "This is for event number: " << getEventNumber() << std::endl;
 			//So if there is no intersection look on the next plane.
 			//Important since two planes could be at the same z position
 			continue;
 		}
 
-		streamlog_out(DEBUG5) 	<< "INTERSECTION FOUND! From ID: " << geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes().at(i)
-					<< " to " << geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes().at(i+1) << std::endl
+		streamlog_out(DEBUG5) 	<< "INTERSECTION FOUND! From ID: " << zOrderToID.at(i)
+					<< " to " << zOrderToID.at(i+1) << std::endl
 					<< "Intersection point on infinite plane: " 
 					<<  globalIntersection[0] << ", " << globalIntersection[1] << ", " << globalIntersection[2] << std::endl
 					<< "Momentum on next plane: " 
@@ -129,7 +162,7 @@ void EUTelPatternRecognition::propagateForwardFromSeedState(EUTelState& stateInp
 		newState.setLocalMomentumGlobalMomentum(momentumAtIntersection);
         state = newState;//Set state here ready to propagate. It does not need hit information to do this.
 
-		if(_mapHitsVecPerPlane[geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes().at(i+1)].empty()){
+		if(_mapHitsVecPerPlane[zOrderToID.at(i+1)].empty()){
 			streamlog_out(DEBUG5) << "There are no hits on the plane with this state. Add state to track as it is and move on." << std::endl;
 //			track.setState(newState); 
 //			state = newState;
@@ -188,21 +221,40 @@ void EUTelPatternRecognition::propagateForwardFromSeedState(EUTelState& stateInp
 	}
 	//NOW WE ASSOCIATE THE STATES TO A SCATTERING LENGTH.
 
-	setRadLengths(track, mapSensor, mapAir, rad);
+	if(_scatteringTableFailed){
+		setRadLengths(track, mapSensor, mapAir, rad);
+	}else{
+		setRadLengths(track);
+	}
     streamlog_out ( DEBUG1 ) << "ADD SCATTERING TO TRACKS: "<< std::endl;
     track.print();
 
 }
 //setRadLengths: This will determine the variance fraction each scatterer will get. Note this comes in two parts. The first is the plane and the next scattering from the air.    
-void EUTelPatternRecognition::setRadLengths(EUTelTrack & track,	std::map<const int,double>  mapSensor, std::map<const int ,double>  mapAir, double rad ){
+//The variances are looked up in the scattering table, at the incidence of the seed.
+void EUTelPatternRecognition::setRadLengths(EUTelTrack & track){
 	//THE FINAL WEIGHT WE HAVE WILL BE A FRACTION PERCENTAGE OF THE TOTAL RADIATION LENGTH
+	std::vector<EUTelState>& states = track.getStates();
+	const EUTelState& seed = states.at(0);
+	const int bin = _scatteringTable.getSlopeBin(seed.getMomLocalX()/seed.getMomLocalZ(), seed.getMomLocalY()/seed.getMomLocalZ());
+	for(size_t i =0; i < states.size();++i){ //LOOP over all track again.
+		const int plane = _scatteringTable.getPlaneIndex(states[i].getLocation());
+		const double sensorVariance = plane < 0 ? 0. : _scatteringTable.getSensorVariance(bin, plane);
+		const double airVariance = plane < 0 ? 0. : _scatteringTable.getAirVariance(bin, plane);
+		streamlog_out(DEBUG0)<< std::scientific << " Values placed in variance using Highland formula corrected. (SENSOR) : " << sensorVariance << "  (AIR)  " << airVariance <<std::endl;
+		states[i].setRadFrac(sensorVariance, airVariance);//We input the fraction percentage.
+	}
+	//NOW DETERMINE THE VARIANCE DUE TO THE RADIATION LENGTH. THIS IN THE END WILL BE DIVIDED AMOUNG THE SCATTERERS.
+	track.setTotalVariance(_scatteringTable.getTotalVariance(bin));
+}
+//The same, with the material found along the seed of this track, at its own incidence.
+void EUTelPatternRecognition::setRadLengths(EUTelTrack & track,	std::map<const int,double>& mapSensor, std::map<const int ,double>& mapAir, double rad ){
 	std::vector<EUTelState>& states = track.getStates();
 	const double var  = pow( Utility::getThetaRMSHighland(states.at(0).getMomLocal().Mag(), rad) , 2);
-	for(size_t i =0; i < track.getStates().size();++i){ //LOOP over all track again.
+	for(size_t i =0; i < states.size();++i){
 		streamlog_out(DEBUG0)<< std::scientific << " Values placed in variance using Highland formula corrected. (SENSOR) : " << (mapSensor[states.at(i).getLocation()]/rad)*var << "  (AIR)  " << (mapAir[states.at(i).getLocation()]/rad)*var <<std::endl;
-		states.at(i).setRadFrac((mapSensor[states.at(i).getLocation()]/rad)*var,(mapAir[states.at(i).getLocation()]/rad)*var);//We input the fraction percentage.
+		states.at(i).setRadFrac((mapSensor[states.at(i).getLocation()]/rad)*var,(mapAir[states.at(i).getLocation()]/rad)*var);
 	}
-	//NOW DETERMINE THE VARIANCE DUE TO THE RADIATION LENGTH. THIS IN THE END WILL BE DIVIDED AMOUNG THE SCATTERERS.
 	track.setTotalVariance(var);
 }
 
@@ -269,11 +321,11 @@ void EUTelPatternRecognition::findTrackCandidatesWithSameHitsAndRemove(){
 	streamlog_out(MESSAGE1) << "EUTelPatternRecognition::findTrackCandidatesWithSameHitsAndRemove----BEGIN" << std::endl;
 	for(size_t i =0; i < _tracksAfterEnoughHitsCut.size();++i){//LOOP through all tracks 
 		streamlog_out(DEBUG1) <<  "Loop at track number: " <<  i <<". Must loop over " << _tracksAfterEnoughHitsCut.size()<<" tracks in total."   << std::endl;
-		std::vector<EUTelState> iStates = _tracksAfterEnoughHitsCut.at(i).getStates();
+		const std::vector<EUTelState>& iStates = _tracksAfterEnoughHitsCut.at(i).getStates();
 		//Now loop through all tracks one ahead of the original track itTrk. This is done since we want to compare all the track to each other to if they have similar hits     
 		for(size_t j =i+1; j < _tracksAfterEnoughHitsCut.size();++j){ //LOOP over all track again.
 			int hitscount=0;
-			std::vector<EUTelState> jStates = _tracksAfterEnoughHitsCut[j].getStates();
+			const std::vector<EUTelState>& jStates = _tracksAfterEnoughHitsCut[j].getStates();
 			for(size_t k=0;k<iStates.size();k++)
 			{
 					EUTelHit ihit;
@@ -350,6 +402,12 @@ void EUTelPatternRecognition::testUserInput() {
 	}else{
 		streamlog_out(DEBUG0) << "The number of planes to make seeds from is good " +  to_string(_createSeedsFromPlanes.size()) << std::endl;
 	}
+	if(_seedSlopeWindow.size() != 0){
+		if(_seedSlopeWindow.size() != 2 or _seedSlopeWindow[0] <= 0 or _seedSlopeWindow[1] <= 0){
+			throw(lcio::Exception( "The seed slope window must be empty or two positive numbers: dx/dz and dy/dz"));
+		}
+		streamlog_out(DEBUG0) << "The seeds are paired within the slopes " << _seedSlopeWindow[0] << ", " << _seedSlopeWindow[1] << std::endl;
+	}
 	testPlaneDimensions();
 }	
 
@@ -364,6 +422,14 @@ void EUTelPatternRecognition::testUserInput() {
 void EUTelPatternRecognition::initialiseSeeds()
 {
 	_mapSensorIDToSeedStatesVec.clear();
+	//The global positions are for this event only. Keep the memory of the vectors.
+	for(std::map<int, std::vector<double> >::iterator it = _mapGlobalHitPositionsPerPlane.begin(); it != _mapGlobalHitPositionsPerPlane.end(); ++it){
+		it->second.clear();
+	}
+	const bool pairSeeds = !_seedSlopeWindow.empty();
+	int nSeedsNotPaired = 0;
+	//The momentum on the first plane is the same for all the seeds. Paired seeds only change its direction.
+	const TVector3 momentum = computeInitialMomentumGlobal(); 
 	for( size_t iplane = 0; iplane < _createSeedsFromPlanes.size(); iplane++) 
 	{
 		streamlog_out(DEBUG1) << "We are using plane: " <<  _createSeedsFromPlanes[iplane] << " to create seeds" << std::endl;
@@ -386,11 +452,18 @@ void EUTelPatternRecognition::initialiseSeeds()
 			}
 			state.setLocation(_createSeedsFromPlanes[iplane]);  
 			state.setPositionLocal(posLocal);  		
-			TVector3 momentum = computeInitialMomentumGlobal(); 
 			state.setLocalMomentumGlobalMomentum(momentum); 
 			state.setHit(*itHit);
-			_totalNumberOfHits++;//This is used for test of the processor later.   
 			state.setDimensionSize(_planeDimensions[state.getLocation()]);
+			if(pairSeeds){//Only the seeds which can come from the beam are propagated.
+				double posGlobal[3];
+				geo::gGeometry().local2Master(state.getLocation(), temp, posGlobal);
+				if(!pairSeed(state, posGlobal, momentum)){
+					nSeedsNotPaired++;
+					continue;
+				}
+			}
+			_totalNumberOfHits++;//This is used for test of the processor later.   
 			stateVec.push_back(state);
 
 		}
@@ -400,6 +473,70 @@ void EUTelPatternRecognition::initialiseSeeds()
         }
 		_mapSensorIDToSeedStatesVec[_createSeedsFromPlanes[iplane]] = stateVec; 
 	}
+	streamlog_out(DEBUG1) << "Seeds without a pair in the slope window: " << nSeedsNotPaired << std::endl;
+}
+//pairSeed: A seed is only worth propagating if a hit on one of the next planes forms a pair with it, with slopes within the window around the beam direction.
+//The next pixel planes are searched up to the number of missing hits allowed on a track. The first plane with a hit in the window is used and the hit closest to the beam direction gives the direction of the seed.
+//Strip planes do not measure both slopes and are not used. A seed on a strip plane, or with no pixel plane after it, is kept with the beam direction.
+bool EUTelPatternRecognition::pairSeed(EUTelState& seed, const double seedPosGlobal[], const TVector3& momentum){
+	if(_planeDimensions[seed.getLocation()] != 2){
+		return true;
+	}
+	const std::map<int, int>& zOrderToID = geo::gGeometry().sensorZOrderToIDWithoutExcludedPlanes();
+	const double beamSlopeX = momentum[0]/momentum[2];
+	const double beamSlopeY = momentum[1]/momentum[2];
+	bool searched = false;
+	int planesLeft = _allowedMissingHits + 1;
+	for(size_t i = geo::gGeometry().sensorIDToZOrderWithoutExcludedPlanes().at(seed.getLocation()) + 1; i < zOrderToID.size() and planesLeft > 0; ++i){
+		const int sensorID = zOrderToID.at(i);
+		if(_planeDimensions[sensorID] != 2){
+			continue;
+		}
+		searched = true;
+		--planesLeft;//Only the pixel planes searched count against the missing hits allowed
+		//The hits of a plane are moved to the global frame once per event.
+		const EVENT::TrackerHitVec& hits = _mapHitsVecPerPlane[sensorID];
+		std::vector<double>& positions = _mapGlobalHitPositionsPerPlane[sensorID];
+		if(positions.size() != 3*hits.size()){
+			positions.resize(3*hits.size());
+			for(size_t j = 0; j < hits.size(); ++j){
+				geo::gGeometry().local2Master(sensorID, hits[j]->getPosition(), &positions[3*j]);
+			}
+		}
+		int best = -1;
+		double bestDistance = 0.;
+		for(size_t j = 0; j < hits.size(); ++j){
+			const double dz = positions[3*j+2] - seedPosGlobal[2];
+			if(dz == 0){//Planes at the same z give no slope
+				continue;
+			}
+			const double dSlopeX = ((positions[3*j] - seedPosGlobal[0])/dz - beamSlopeX)/_seedSlopeWindow[0];
+			const double dSlopeY = ((positions[3*j+1] - seedPosGlobal[1])/dz - beamSlopeY)/_seedSlopeWindow[1];
+			if(fabs(dSlopeX) > 1. or fabs(dSlopeY) > 1.){
+				continue;
+			}
+			const double distance = dSlopeX*dSlopeX + dSlopeY*dSlopeY;
+			if(best < 0 or distance < bestDistance){
+				best = static_cast<int>(j);
+				bestDistance = distance;
+			}
+		}
+		if(best >= 0){
+			const double* pos = &positions[3*best];
+			TVector3 direction(pos[0] - seedPosGlobal[0], pos[1] - seedPosGlobal[1], pos[2] - seedPosGlobal[2]);
+			seed.setLocalMomentumGlobalMomentum(momentum.Mag()*direction.Unit());
+			streamlog_out(DEBUG1) << "Seed paired with hit " << hits[best]->id() << " on plane " << sensorID << std::endl;
+			return true;
+		}
+	}
+	return !searched;
+}
+int EUTelPatternRecognition::getNumberOfSeeds() const {
+	int nSeeds = 0;
+	for(std::map<int, std::vector<EUTelState> >::const_iterator it = _mapSensorIDToSeedStatesVec.begin(); it != _mapSensorIDToSeedStatesVec.end(); ++it){
+		nSeeds += it->second.size();
+	}
+	return nSeeds;
 }
 TVector3 EUTelPatternRecognition::computeInitialMomentumGlobal(){
 	//We assume that the arc length is the displacement in the z direction. The assumption should be a valid one in most cases
@@ -417,7 +554,7 @@ void EUTelPatternRecognition::testInitialSeeds(){
 //		throw(lcio::Exception("The size of intial state seeds planes and the number to use at the start are different")); 	
 //	}
 	for(size_t i = 0 ; i < _mapSensorIDToSeedStatesVec.size(); ++i){
-		std::vector<EUTelState> StatesVec =  _mapSensorIDToSeedStatesVec[_createSeedsFromPlanes[i]]; 	
+		const std::vector<EUTelState>& StatesVec =  _mapSensorIDToSeedStatesVec[_createSeedsFromPlanes[i]]; 	
 		for(size_t j = 0 ; j < StatesVec.size() ; ++j){
 			if(!StatesVec[j].getStateHasHit()){
 				throw(lcio::Exception("The hit is not on first state. All seeds must have hits.")); 	
@@ -430,16 +567,15 @@ void EUTelPatternRecognition::findTrackCandidates() {
 	streamlog_out(MESSAGE1) << "EUTelPatternRecognition::findTrackCandidates()" << std::endl;
 	clearTrackAndTrackStates(); //Clear all past track information
 	for(size_t i = 0 ; i < _mapSensorIDToSeedStatesVec.size(); ++i){
-		std::vector<EUTelState> statesVec =  _mapSensorIDToSeedStatesVec[_createSeedsFromPlanes[i]]; 	
+		std::vector<EUTelState>& statesVec =  _mapSensorIDToSeedStatesVec[_createSeedsFromPlanes[i]]; 	
 		if(statesVec.size() == 0){
 			streamlog_out(MESSAGE5) << "The size of state Vector seeds is zero. try next seed plane"<<std::endl; 
 			continue;
 		}
 		for(size_t j = 0 ; j < statesVec.size() ; ++j){
-			EUTelTrack track;
-			propagateForwardFromSeedState(statesVec[j], track);
-//			streamlog_out ( DEBUG1 ) << "Before adding track to vector "<< std::endl;
-			_tracks.push_back(track);//Here we create a long list of possible tracks
+			//Here we create a long list of possible tracks. The track is filled in place.
+			_tracks.push_back(EUTelTrack());
+			propagateForwardFromSeedState(statesVec[j], _tracks.back());
 //			streamlog_out ( DEBUG1 ) << "After adding track to vector "<< std::endl;
 
 
@@ -508,7 +644,7 @@ void EUTelPatternRecognition::setHitsVecPerPlane()
 
 std::vector<EUTelTrack> EUTelPatternRecognition::getSeedTracks(){
     std::vector<EUTelTrack> seededTracks;
-    std::vector<EUTelTrack> tracksOriginal = _finalTracks; //Must make copy here so we do not change _finalTracks
+    const std::vector<EUTelTrack>& tracksOriginal = _finalTracks; //seedTrackOuterHits works on a copy, so we do not change _finalTracks
     for(size_t i=0 ; i <tracksOriginal.size(); i++ ){
 //        streamlog_out(DEBUG1) <<"Track before seed running:  "  <<std::endl;
 //        tracksOriginal.at(i).print();
@@ -520,7 +656,8 @@ std::vector<EUTelTrack> EUTelPatternRecognition::getSeedTracks(){
             _finalTracks.at(i).print();
             streamlog_out(DEBUG1) <<"Track after seed:  "  <<std::endl;
             trackOut.print();
-            seededTracks.push_back(trackOut);
+            seededTracks.push_back(EUTelTrack());
+            seededTracks.back().swap(trackOut);
         }
 
     }
@@ -535,8 +672,8 @@ bool EUTelPatternRecognition::seedTrackOuterHits(EUTelTrack track,EUTelTrack & t
       }
     }
 
-    EUTelState firstState = track.getStates().at(0);
-    EUTelState lastState = track.getStates().at(lastStateWithHit);
+    const EUTelState& firstState = track.getStates().at(0);
+    const EUTelState& lastState = track.getStates().at(lastStateWithHit);
 
     TVector3 momGlobal = getGlobalMomBetweenStates(firstState, lastState);
     for(size_t i=0 ; i < track.getStates().size() ; i++){
@@ -553,10 +690,10 @@ bool EUTelPatternRecognition::seedTrackOuterHits(EUTelTrack track,EUTelTrack & t
         }
         track.getStates().at(i+1).setPositionGlobal(intersectionPoint);
     }
-    trackOut = EUTelTrack(track);
+    trackOut.swap(track);
 
 }
-TVector3 EUTelPatternRecognition::getGlobalMomBetweenStates(EUTelState firstState, EUTelState lastState){
+TVector3 EUTelPatternRecognition::getGlobalMomBetweenStates(const EUTelState& firstState, const EUTelState& lastState){
     const double * firstPos = firstState.getHit().getPosition();
     double firstPosGlobal[3];
 	geo::gGeometry().local2Master(firstState.getLocation() ,firstPos,firstPosGlobal);
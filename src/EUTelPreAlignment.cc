@@ -49,6 +49,7 @@
 #include <algorithm>
 #include <memory>
 #include <cstdio>
+#include <fstream>
 
 using namespace std;
 using namespace lcio;
@@ -56,7 +57,7 @@ using namespace marlin;
 using namespace eutelescope;
 using namespace gear;
 
-EUTelPreAlign::EUTelPreAlign(): Processor("EUTelPreAlign")
+EUTelPreAlign::EUTelPreAlign(): Processor("EUTelPreAlign"), _hotPixelMap(0)
 {
   _description = "Apply alignment constants to hit collection";
 
@@ -93,6 +94,10 @@ EUTelPreAlign::EUTelPreAlign(): Processor("EUTelPreAlign")
 
   registerOptionalParameter("ExcludedPlanesYCoord", "The list of sensor IDs for which the Y coordinate  shall be excluded.", _ExcludedPlanesYCoord, std::vector<int>() );
 
+  registerOptionalParameter("HistogramShardFile", "If set, the correlation histograms of this job are written to this file, to be merged with the ones of the other event shards of the run (optional).", _histogramShardFile, std::string("") );
+
+  registerOptionalParameter("MergeHistogramShardFiles", "Histogram files written by other event shards (HistogramShardFile) to be added before computing the offsets (optional).", _mergeHistogramShardFiles, std::vector<std::string>() );
+
 }
 
 
@@ -127,6 +132,7 @@ void EUTelPreAlign::init () {
       _fixedZ = _siPlanesLayerLayout->getSensitivePositionZ(iPlane); 
     } else {
       //Get 
+      _preAlignerIndex[ _siPlanesLayerLayout->getID(iPlane) ] = _preAligners.size();
       _preAligners.push_back( PreAligner( _siPlanesLayerLayout->getSensitivePitchX(iPlane) /10.,
 					  _siPlanesLayerLayout->getSensitivePitchY(iPlane) /10.,
 					  _siPlanesLayerLayout->getSensitivePositionZ(iPlane),
@@ -167,6 +173,28 @@ void EUTelPreAlign::init () {
       _sensorIDinZordered.insert( make_pair( _sensorIDtoZOrderMap[ sensorID ], sensorID ) );
     }
 
+  // the residual windows are given in z order, look them up once
+  // for every PreAligner
+  _windowXMin.assign( _preAligners.size(), -numeric_limits<double>::max() );
+  _windowXMax.assign( _preAligners.size(),  numeric_limits<double>::max() );
+  _windowYMin.assign( _preAligners.size(), -numeric_limits<double>::max() );
+  _windowYMax.assign( _preAligners.size(),  numeric_limits<double>::max() );
+  for( size_t ii = 0; ii < _preAligners.size(); ii++ )
+    {
+      size_t idZ = _sensorIDtoZOrderMap[ _preAligners[ii].getIden() ];
+      if( idZ < _residualsXMin.size() ) _windowXMin[ii] = _residualsXMin[idZ];
+      if( idZ < _residualsXMax.size() ) _windowXMax[ii] = _residualsXMax[idZ];
+      if( idZ < _residualsYMin.size() ) _windowYMin[ii] = _residualsYMin[idZ];
+      if( idZ < _residualsYMax.size() ) _windowYMax[ii] = _residualsYMax[idZ];
+      if( idZ >= _residualsXMin.size() || idZ >= _residualsXMax.size() || idZ >= _residualsYMin.size() || idZ >= _residualsYMax.size() )
+	{
+	  streamlog_out ( WARNING5 ) << "No residual window given for sensor " << _preAligners[ii].getIden() << " (position " << idZ
+				     << " along z), its correlations are not cut" << endl;
+	}
+    }
+  _bucketX.assign( _preAligners.size(), std::vector<double>() );
+  _bucketY.assign( _preAligners.size(), std::vector<double>() );
+
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
   string tempHistoName = "";
   string basePath; 
@@ -207,56 +235,8 @@ void  EUTelPreAlign::FillHotPixelMap(LCEvent *event)
 
   if( _hotPixelCollectionName.empty()) return;
 
-  LCCollectionVec *hotPixelCollectionVec = 0;
-  try 
-    {
-      hotPixelCollectionVec = static_cast< LCCollectionVec* > ( event->getCollection( _hotPixelCollectionName  ) );
-      streamlog_out ( DEBUG5 ) << "Hotpixel database " << _hotPixelCollectionName.c_str() << " found" << endl; 
-    }
-  catch (...)
-    {
-      streamlog_out ( WARNING5 ) << "Hotpixel database " << _hotPixelCollectionName.c_str() << " not found" << endl; 
-      return;
-    }
-
-  CellIDDecoder<TrackerDataImpl> cellDecoder( hotPixelCollectionVec );
-	
-  for(int i=0; i<  hotPixelCollectionVec->getNumberOfElements(); i++)
-    {
-      TrackerDataImpl* hotPixelData = dynamic_cast< TrackerDataImpl *> ( hotPixelCollectionVec->getElementAt( i ) );
-      SparsePixelType  type         = static_cast<SparsePixelType> (static_cast<int> (cellDecoder( hotPixelData )["sparsePixelType"]));
-
-      int sensorID              = static_cast<int > ( cellDecoder( hotPixelData )["sensorID"] );
-
-      if( type  ==  kEUTelGenericSparsePixel )
-	{  
-	  auto_ptr<EUTelSparseClusterImpl< EUTelGenericSparsePixel > > m26Data( new EUTelSparseClusterImpl< EUTelGenericSparsePixel >   ( hotPixelData ) );
-
-	  std::vector<EUTelGenericSparsePixel*> m26PixelVec;
-	  EUTelGenericSparsePixel m26Pixel;
-	  //Push all single Pixels of one plane in the m26PixelVec
-
-	  for(  unsigned int iPixel = 0; iPixel < m26Data->size(); iPixel++ ) 
-	    {
-              std::vector<int> m26ColVec();
-              m26Data->getSparsePixelAt( iPixel, &m26Pixel);
-
-              try
-		{
-		  _hotPixelMap[sensorID].push_back(std::make_pair(m26Pixel.getXCoord(), m26Pixel.getYCoord()));
-		}
-              catch(...)
-		{
-		  streamlog_out ( ERROR5 ) << " cannot add pixel to hotpixel map! SensorID: "  << sensorID << ", X:" << m26Pixel.getXCoord() << ", Y:" << m26Pixel.getYCoord() << endl; 
-		  abort();
-		}
-	    }
-	}          
-      else
-	{
-	  _UsefullHotPixelCollectionFound = 0;
-	}  	
-    }
+  _hotPixelMap = &EUTelHotPixelMap::getInstance( _hotPixelCollectionName );
+  _hotPixelMap->load( event );
 }
 
 void EUTelPreAlign::processEvent(LCEvent* event)
@@ -282,78 +262,84 @@ void EUTelPreAlign::processEvent(LCEvent* event)
 				LCCollectionVec * inputCollectionVec = dynamic_cast < LCCollectionVec * > (evt->getCollection(_inputHitCollectionName));
 				UTIL::CellIDDecoder<TrackerHitImpl> hitDecoder ( EUTELESCOPE::HITENCODING );
 
-				std::vector<float> residX;
-				std::vector<float> residY;
-				std::vector<PreAligner*> prealign;
-
-				//Loop over hits in fixed plane:
-				for( size_t ref = 0; ref < inputCollectionVec->size(); ref++ )
+				// Bucket the hits by sensor once for the whole event, the
+				// hot pixel check and the sensor lookup are done only once
+				// per hit and not for every reference hit
+				_refX.clear();
+				_refY.clear();
+				for( size_t ii = 0; ii < _bucketX.size(); ii++ )
 				{
+						_bucketX[ii].clear();
+						_bucketY[ii].clear();
+				}
 
-						TrackerHitImpl* refHit = dynamic_cast<TrackerHitImpl*>( inputCollectionVec->getElementAt(ref) );
-						const double* refPos = refHit->getPosition();
-
-						int sensorID = hitDecoder(refHit)["sensorID"];
+				for( size_t iHit = 0; iHit < inputCollectionVec->size(); iHit++ )
+				{
+						TrackerHitImpl* hit = dynamic_cast<TrackerHitImpl*>( inputCollectionVec->getElementAt(iHit) );
+						const double * pos = hit->getPosition();
+						int iHitID = hitDecoder(hit)["sensorID"]; 
 
-						// identify fixed plane
-						if( sensorID != _fixedID ) continue;
+						if( iHitID == _fixedID )
+						{
+								_refX.push_back( pos[0] );
+								_refY.push_back( pos[1] );
+								continue;
+						}
 
-						residX.clear();
-						residY.clear();
-						prealign.clear();
+						//Hits with a hot pixel are ignored
+						if( hitContainsHotPixels(hit) ) continue;
 
-						for( size_t iHit = 0; iHit < inputCollectionVec->size(); iHit++)
+						std::map< int, size_t >::const_iterator iter = _preAlignerIndex.find( iHitID );
+						if( iter == _preAlignerIndex.end() )
 						{
+								streamlog_out ( ERROR5 ) << "Mismatched hit at " << pos[2] << endl;
+								continue;
+						}
+						_bucketX[ iter->second ].push_back( pos[0] );
+						_bucketY[ iter->second ].push_back( pos[1] );
+				}
 
-								TrackerHitImpl* hit = dynamic_cast<TrackerHitImpl*>( inputCollectionVec->getElementAt(iHit) );
-								//Hits with a hot pixel are ignored
-								if( hitContainsHotPixels(hit) ) continue;
+				//Loop over hits in fixed plane:
+				for( size_t ref = 0; ref < _refX.size(); ref++ )
+				{
+						const double refX = _refX[ref];
+						const double refY = _refY[ref];
 
-								const double * pos = hit->getPosition();
-								int iHitID = hitDecoder(hit)["sensorID"]; 
+						_residX.clear();
+						_residY.clear();
+						_residPreAligner.clear();
 
-								if( iHitID == _fixedID ) continue;
-								bool gotIt(false);
+						for( size_t ii = 0; ii < _bucketX.size(); ii++ )
+						{
+								const std::vector<double> & bucketX = _bucketX[ii];
+								const std::vector<double> & bucketY = _bucketY[ii];
+								const double xMin = _windowXMin[ii], xMax = _windowXMax[ii];
+								const double yMin = _windowYMin[ii], yMax = _windowYMax[ii];
 
-								for(size_t ii = 0; ii < _preAligners.size(); ii++)
+								for( size_t iHit = 0; iHit < bucketX.size(); iHit++ )
 								{
-
-										PreAligner& pa = _preAligners.at(ii);
-
-										if( pa.getIden() != iHitID  ) { continue; }
-
-										gotIt = true;
-
-										double correlationX =  refPos[0] - pos[0] ;
-										double correlationY =  refPos[1] - pos[1] ;
-
-										int idZ = _sensorIDtoZOrderMap[ iHitID ];
-
-										if( 
-														(_residualsXMin[idZ] < correlationX ) && ( correlationX < _residualsXMax[idZ]) &&
-														(_residualsYMin[idZ] < correlationY ) && ( correlationY < _residualsYMax[idZ]) 
-										  ) {
-												residX.push_back( correlationX );
-												residY.push_back( correlationY );
-												prealign.push_back(&pa);
+										double correlationX =  refX - bucketX[iHit] ;
+										double correlationY =  refY - bucketY[iHit] ;
+
+										if( ( xMin < correlationX ) && ( correlationX < xMax ) &&
+										    ( yMin < correlationY ) && ( correlationY < yMax ) ) {
+												_residX.push_back( correlationX );
+												_residY.push_back( correlationY );
+												_residPreAligner.push_back( ii );
 										}
-										break;
-								}
-								if( not gotIt ) 
-								{
-										streamlog_out ( ERROR5 ) << "Mismatched hit at " << pos[2] << endl;
 								}
 						}
 
-						if( prealign.size() > static_cast< unsigned int >(_minNumberOfCorrelatedHits) && residX.size() == residY.size() ) {
-								for( unsigned int ii = 0 ;ii < prealign.size(); ii++ ) {
+						if( _residPreAligner.size() > static_cast< unsigned int >(_minNumberOfCorrelatedHits) ) {
+								for( unsigned int ii = 0 ;ii < _residPreAligner.size(); ii++ ) {
 
-										prealign[ii]->addPoint( residX[ii], residY[ii] );
+										PreAligner & pa = _preAligners[ _residPreAligner[ii] ];
+										pa.addPoint( _residX[ii], _residY[ii] );
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 										if( _fillHistos ) {
-												( dynamic_cast<AIDA::IHistogram1D*> (_hitXCorr[ prealign[ii]->getIden() ] ) )->fill( residX[ii] );
-												( dynamic_cast<AIDA::IHistogram1D*> (_hitYCorr[ prealign[ii]->getIden() ] ) )->fill( residY[ii] );
+												( dynamic_cast<AIDA::IHistogram1D*> (_hitXCorr[ pa.getIden() ] ) )->fill( _residX[ii] );
+												( dynamic_cast<AIDA::IHistogram1D*> (_hitYCorr[ pa.getIden() ] ) )->fill( _residY[ii] );
 										}
 #endif
 								}
@@ -373,42 +359,13 @@ bool EUTelPreAlign::hitContainsHotPixels( TrackerHitImpl   * hit)
 {
 
   // if no hot pixel map was loaded, just return here
-  if( _hotPixelMap.size() == 0) return 0;
+  if( _hotPixelMap == 0 || _hotPixelMap->empty() ) return 0;
 
   try
     {
-      LCObjectVec clusterVector = hit->getRawHits();
-
       if ( hit->getType() == kEUTelSparseClusterImpl ) 
 	{
-	  TrackerDataImpl * clusterFrame = static_cast<TrackerDataImpl*> ( clusterVector[0] );
-	  eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelGenericSparsePixel > *cluster = new eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelGenericSparsePixel >(clusterFrame);
-
-	  int sensorID = cluster->getDetectorID();
-
-	  for ( unsigned int iPixel = 0; iPixel < cluster->size(); iPixel++ ) 
-	    {
-	      EUTelGenericSparsePixel m26Pixel;
-	      cluster->getSparsePixelAt( iPixel, &m26Pixel);
-	      {
-		try{
-		  if( std::find(_hotPixelMap.at(sensorID).begin(), 
-				_hotPixelMap.at(sensorID).end(),
-				std::make_pair(m26Pixel.getXCoord(),m26Pixel.getYCoord()))
-		      != _hotPixelMap.at(sensorID).end()){ 
-		    delete cluster;                        			  
-		    return true; // if TRUE  this hit will be skipped
-		  }
-		}
-		catch(const std::out_of_range& oor){
-		  streamlog_out(DEBUG0) << " Could not find hot pixel map for sensor ID " 
-					<< sensorID << ": " << oor.what() << endl;
-		}
-	      }
-	    }
-
-	  delete cluster;
-	  return 0;
+	  return _hotPixelMap->containsHot( hit ); // if TRUE  this hit will be skipped
 	} 
       else if ( hit->getType() == kEUTelBrickedClusterImpl ) 
 	{
@@ -455,8 +412,51 @@ bool EUTelPreAlign::hitContainsHotPixels( TrackerHitImpl   * hit)
   return 0;
 }
       
+void EUTelPreAlign::mergeHistogramShards()
+{
+		if( !_histogramShardFile.empty() )
+		{
+				std::ofstream shardFile( _histogramShardFile.c_str() );
+				for( size_t ii = 0; ii < _preAligners.size(); ii++ ) _preAligners[ii].write( shardFile );
+				if( !shardFile ) {
+						streamlog_out ( ERROR5 ) << "Could not write the prealignment histograms to " << _histogramShardFile << endl;
+				} else {
+						streamlog_out ( MESSAGE5 ) << "Prealignment histograms written to " << _histogramShardFile << endl;
+				}
+		}
+
+		for( size_t iFile = 0; iFile < _mergeHistogramShardFiles.size(); iFile++ )
+		{
+				const std::string & fileName = _mergeHistogramShardFiles[iFile];
+				std::ifstream shardFile( fileName.c_str() );
+				if( !shardFile ) {
+						streamlog_out ( ERROR5 ) << "Could not open prealignment histogram file " << fileName << endl;
+						continue;
+				}
+
+				size_t nMerged = 0;
+				for( size_t ii = 0; ii < _preAligners.size(); ii++ )
+				{
+						// a scratch copy keeps the pitches, and thus the binning
+						PreAligner shard( _preAligners[ii] );
+						if( !shard.read( shardFile ) || !_preAligners[ii].merge( shard ) )
+						{
+								streamlog_out ( ERROR5 ) << "Prealignment histogram file " << fileName
+										<< " does not match the geometry, only " << nMerged << " sensors merged" << endl;
+								break;
+						}
+						++nMerged;
+				}
+				if( nMerged == _preAligners.size() ) {
+						streamlog_out ( MESSAGE5 ) << "Prealignment histograms of " << fileName << " merged" << endl;
+				}
+		}
+}
+
 void EUTelPreAlign::end()
 {
+		mergeHistogramShards();
+
 		LCCollectionVec * constantsCollection = new LCCollectionVec( LCIO::LCGENERICOBJECT );
 
 		for(size_t ii=0; ii<_sensorIDVec.size(); ii++)
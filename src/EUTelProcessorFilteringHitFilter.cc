@@ -48,7 +48,8 @@ EUTelProcessorFilteringHitFilter::EUTelProcessorFilteringHitFilter( ) :
  Processor( "EUTelProcessorFilteringHitFilter" ),
  _hitInputCollectionName( "HitCollection" ),
  _nProcessedRuns( 0 ),
- _nProcessedEvents( 0 ) {
+ _nProcessedEvents( 0 ),
+ _hotPixelMap( 0 ) {
 
     // Processor description
     _description = "EUTelProcessorFilteringHitFilter selects hits that fulfill all specified requirements from input collection.";
@@ -97,7 +98,8 @@ void EUTelProcessorFilteringHitFilter::processEvent( LCEvent * event ) {
 
      if ( isFirstEvent() )
     {
-      _hotPixelMap = Utility::FillHotPixelMap(event, _hotpixelCollectionName );
+      _hotPixelMap = &EUTelHotPixelMap::getInstance( _hotpixelCollectionName );
+      _hotPixelMap->load( event );
     }
 
 //cout << " processEvent continue: " << endl;
@@ -138,7 +140,7 @@ void EUTelProcessorFilteringHitFilter::processEvent( LCEvent * event ) {
           {
             TrackerHitImpl * hit = static_cast<TrackerHitImpl*> ( hitInputCollection->getElementAt(iHit) );
              
-            if( Utility::HitContainsHotPixels(  hit,  _hotPixelMap )  ) 
+            if( _hotPixelMap != 0 && _hotPixelMap->containsHot( hit ) ) 
             {
               streamlog_out ( MESSAGE5 ) << "Hit " << iHit << " contains hot pixels; skip this one. " << std::endl;
               continue;
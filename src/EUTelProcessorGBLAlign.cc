@@ -1,5 +1,6 @@
 
 #include "EUTelProcessorGBLAlign.h"
+#include "EUTelProcessorMonitor.h"
 
 using namespace eutelescope;
 
@@ -15,6 +16,9 @@ _alignmentMode(7),
 _beamQ(-1),
 _eBeam(4),
 _createBinary(true),
+_runPede(true),
+_milleBinaryManifest(""),
+_milleBinaryInputFiles(),
 _mEstimatorType()
 {
   // TrackerHit input collection
@@ -42,6 +46,12 @@ _mEstimatorType()
 
   registerOptionalParameter("CreateBinary", "Should we create a binary file for millepede containing the data that millepede needs  ", _createBinary, bool(true));
 
+  registerOptionalParameter("RunPede", "Run pede at the end of the job. Switch off to only write the binary, e.g. one shard of a dataset processed by several jobs", _runPede, bool(true));
+
+  registerOptionalParameter("MilleBinaryManifest", "Text file listing Millepede binaries written by other jobs, one per line. pede reads them after the binary of this job, in the order of the list", _milleBinaryManifest, std::string(""));
+
+  registerOptionalParameter("MilleBinaryInputFiles", "Millepede binaries written by other jobs, read by pede after those of the manifest", _milleBinaryInputFiles, StringVec());
+
   registerOptionalParameter("xResolutionPlane", "x resolution of planes given in Planes", _SteeringxResolutions, FloatVec());
   registerOptionalParameter("yResolutionPlane", "y resolution of planes given in Planes", _SteeringyResolutions, FloatVec());
 
@@ -79,6 +89,7 @@ _mEstimatorType()
 }
 
 void EUTelProcessorGBLAlign::init() {
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
 	try{
 		streamlog_out(DEBUG2) << "EUTelProcessorGBLAlign::init( )---------------------------------------------BEGIN" << std::endl;
 		_nProcessedRuns = 0;
@@ -98,6 +109,22 @@ void EUTelProcessorGBLAlign::init() {
 		_Mille->setYRotationsFixed(_fixedAlignmentYRotationPlaneIds);
 		_Mille->setZRotationsFixed(_fixedAlignmentZRotationPlaneIds);
 		_Mille->setBinaryFileName(_milleBinaryFilename);//The binary file holds for each state: Hold all the information needed for Millepede to work 
+		//Each job writes its own binary. pede can then read all of them, so the track collection can be split over several jobs.
+		std::vector<std::string> binaries;
+		if(_createBinary){
+			_Mille->CreateBinary();
+			binaries.push_back(_milleBinaryFilename);
+		}
+		if(!_milleBinaryManifest.empty()){
+			std::vector<std::string> shards = Utility::readMilleManifest(_milleBinaryManifest);
+			binaries.insert(binaries.end(), shards.begin(), shards.end());
+		}
+		binaries.insert(binaries.end(), _milleBinaryInputFiles.begin(), _milleBinaryInputFiles.end());
+		//Without a new binary and nothing else given, pede runs on an existing MilleBinaryFilename, as it always did.
+		if(!_createBinary && binaries.empty()){
+			binaries.push_back(_milleBinaryFilename);
+		}
+		_Mille->setBinaryInputFiles(binaries);
 		_Mille->setResultsFileName(_milleResultFileName);
 		_Mille->testUserInput();
 		_Mille->printFixedPlanes();
@@ -154,6 +181,7 @@ void EUTelProcessorGBLAlign::processRunHeader(LCRunHeader * run) {
 }
 
 void EUTelProcessorGBLAlign::processEvent(LCEvent * evt){
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 	try{
 		if(_createBinary){
 			EUTelEventImpl * event = static_cast<EUTelEventImpl*> (evt); ///We change the class so we can use EUTelescope functions
@@ -169,22 +197,17 @@ void EUTelProcessorGBLAlign::processEvent(LCEvent * evt){
             for (size_t iTrack = 0; iTrack < tracks.size(); ++iTrack) {
                 _totalTrackCount++;
                 _trackFitter->resetPerTrack(); //Here we reset the label that connects state to GBL point to 1 again. Also we set the list of states->labels to 0
-                EUTelTrack track = tracks.at(iTrack);
+                EUTelTrack& track = tracks.at(iTrack);
     //			float chi = track.getChi2();
 //				float ndf = static_cast<float>(track.getNdf());
-                std::vector< gbl::GblPoint > pointList;//This is the GBL points. These contain the state information, scattering and alignment jacobian. All the information that the mille binary will get.
+                std::vector< gbl::GblPoint >& pointList = _trackFitter->getWorkspace().newPointList();//This is the GBL points. These contain the state information, scattering and alignment jacobian. All the information that the mille binary will get.
                 _trackFitter->setInformationForGBLPointList(track, pointList);//We create all the GBL points with scatterer inbetween both planes. This is identical to creating GBL tracks
                 _trackFitter->setPairMeasurementStateAndPointLabelVec(pointList);
                 _trackFitter->setAlignmentToMeasurementJacobian(pointList); //This is place in GBLFitter since millepede has no idea about states and points. Only GBLFitter know about that
                 const gear::BField& B = geo::gGeometry().getMagneticField();
                 const double Bmag = B.at( TVector3(0.,0.,0.) ).r2();
-                gbl::GblTrajectory* traj = 0;
 //					printPointsInformation(pointList);
-                if ( Bmag < 1.E-6 ) {
-                    traj = new gbl::GblTrajectory( pointList, false ); //Must make sure this is not a memory leak
-                } else {
-                    traj = new gbl::GblTrajectory( pointList, true );
-                }
+                gbl::GblTrajectory* traj = _trackFitter->getWorkspace().newTrajectory( Bmag >= 1.E-6 ); //Owned by the workspace, deleted with the next track
                 double chi2, loss;
                 int ndf2;
                 traj->fit(chi2, ndf2, loss, _mEstimatorType );
@@ -218,7 +241,8 @@ void EUTelProcessorGBLAlign::processEvent(LCEvent * evt){
 }
 
 void EUTelProcessorGBLAlign::end(){
-	_Mille->_milleGBL->~MilleBinary();
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
+	_Mille->closeBinary();
 //	double size =	printSize("millepede.bin");
 //	std::cout<<"Binary after track addition " << size << " This is the size per track: " << size/_totalTrackCount << std::endl;
 
@@ -226,6 +250,10 @@ void EUTelProcessorGBLAlign::end(){
 	if(_totalTrackCount<1000){
 		streamlog_out(WARNING5)<<"You are trying to align with fewer than 1000 tracks. This could be too small a number." <<std::endl;
 	}
+	if(!_runPede){
+		streamlog_out (MESSAGE9) <<"Millepede binary "<< _milleBinaryFilename <<" written. pede is not run by this job."<< std::endl;
+		return;
+	}
 	//TO DO: We automatically create the millepede output file in the directory of execution. We should be able to move these to another folder to stop the clutter in this directory.
 	//The millepede class contains all the functions related to manipulation of steering files, results files from millepede and the scripts related to editing these file.
 	//It also controls the running of millepede. 
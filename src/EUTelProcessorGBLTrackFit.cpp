@@ -2,6 +2,7 @@
 //contact alexander.morton975@gmail.com
 #ifdef USE_GBL   
 #include "EUTelProcessorGBLTrackFit.h"
+#include "EUTelProcessorMonitor.h"
 using namespace eutelescope;
 //TO DO:
 //This way of making histograms makes no sense to me. We should have a class that when called will book any histograms in xml file automatically. So you dont have to book in every processor. It should also return a vector of names to access these histograms. I began this but have not finished. Therefore the silly way of doing the residuals
@@ -76,6 +77,7 @@ _mEstimatorType() //This is used by the GBL software for outliers down weighting
 }
 
 void EUTelProcessorGBLTrackFit::init() {
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
 	try{
 		streamlog_out(DEBUG2) << "EUTelProcessorGBLTrackFit::init( )---------------------------------------------BEGIN" << std::endl;
 		streamlog_out(DEBUG2) << "Beam charge= " << _beamQ <<" Beam energy= " << _eBeam << std::endl;
@@ -135,6 +137,7 @@ void EUTelProcessorGBLTrackFit::processRunHeader(LCRunHeader * run) {
 }
 
 void EUTelProcessorGBLTrackFit::processEvent(LCEvent* evt){
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 	try{
 		streamlog_out(DEBUG5) << "Start of event " << _nProcessedEvents << std::endl;
 
@@ -150,24 +153,20 @@ void EUTelProcessorGBLTrackFit::processEvent(LCEvent* evt){
         std::vector<EUTelTrack> tracks = reader.getTracks(evt, _trackCandidatesInputCollectionName );
 		std::vector<EUTelTrack> allTracksForThisEvent;//GBL will analysis the track one at a time. However we want to save to lcio per event.
 		for (size_t iTrack = 0; iTrack < tracks.size(); iTrack++) {
-			EUTelTrack track = tracks.at(iTrack); 
+			EUTelTrack& track = tracks.at(iTrack); 
             streamlog_out(DEBUG1)<<"Found "<<tracks.size()<<" tracks for event " << evt->getEventNumber() << "  This is track:  " << iTrack <<std::endl;
             track.print();
 			streamlog_out(DEBUG1) << "//////////////////////////////////// " << std::endl;
 			_trackFitter->resetPerTrack(); //Here we reset the label that connects state to GBL point to 1 again. Also we set the list of states->labels to 0
 			_trackFitter->testTrack(track);//Check the track has states and hits  
-			std::vector< gbl::GblPoint > pointList;
+			std::vector< gbl::GblPoint >& pointList = _trackFitter->getWorkspace().newPointList();//Reused from the previous track, so that the points do not have to be reallocated.
 			_trackFitter->setInformationForGBLPointList(track, pointList);//Here we describe the whole setup. Geometry, scattering, data...
 			const gear::BField& B = geo::gGeometry().getMagneticField();//We need this to determine if we should fit a curve or a straight line.
 			const double Bmag = B.at( TVector3(0.,0.,0.) ).r2();
 			_trackFitter->setPairMeasurementStateAndPointLabelVec(pointList);//This will create a link between the states that have a hit associated with them and the GBL label that is associated with the state.
-			gbl::GblTrajectory* traj = 0;
 			//Here we create the trajectory from the points created by setInformationForGBLPointList. This will take the points and propagation jacobian and split this into smaller matrices to describe the problem in terms of offsets. Here is the difference between GBL and other fitting algorithms.  
-			if ( Bmag < 1.E-6 ) {
-				traj = new gbl::GblTrajectory( pointList, false ); 
-			}else {
-				traj = new gbl::GblTrajectory( pointList, true );
-			}
+			//The workspace owns the trajectory and deletes it when the next track is fitted.
+			gbl::GblTrajectory* traj = _trackFitter->getWorkspace().newTrajectory( Bmag >= 1.E-6 );
 			_trackFitter->setPairAnyStateAndPointLabelVec(traj);//This will create a link between any state and it's GBL point label. 
 			double  chi2=0; 
 			int ndf=0;
@@ -199,7 +198,9 @@ void EUTelProcessorGBLTrackFit::processEvent(LCEvent* evt){
 				static_cast < AIDA::IHistogram1D* > ( _aidaHistoMap1D[ _histName::_fitsuccessHistName ] ) -> fill(0.0);
 				continue;//We continue so we don't add an empty track
 			}	
-			allTracksForThisEvent.push_back(track);
+			//The fitted track is handed over, its states are not copied
+			allTracksForThisEvent.push_back(EUTelTrack());
+			allTracksForThisEvent.back().swap(track);
 			}//END OF LOOP FOR ALL TRACKS IN AN EVENT
 			outputLCIO(evt, allTracksForThisEvent); 
 			allTracksForThisEvent.clear();//We clear this so we don't add the same track twice
@@ -313,6 +314,7 @@ void EUTelProcessorGBLTrackFit::plotResidual(std::map< int, std::map<float, floa
 
 
 void EUTelProcessorGBLTrackFit::end() {
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
 	float total = 0;
 	double sizeFittedTracks = _chi2NdfVec.size();
 	for(size_t i=0; i<_chi2NdfVec.size(); ++i)
@@ -12,6 +12,7 @@
 
 //eutelescope includes
 #include "EUTelProcessorGeometricClustering.h"
+#include "EUTelProcessorMonitor.h"
 
 #include "EUTELESCOPE.h"
 #include "EUTelExceptions.h"
@@ -85,7 +86,10 @@ EUTelProcessorGeometricClustering::EUTelProcessorGeometricClustering():
   _isGeometryReady(false),
   _sensorIDVec(),
   _zsInputDataCollectionVec(NULL),
-  _pulseCollectionVec(NULL)
+  _pulseCollectionVec(NULL),
+  _nThreads(1),
+  _threadPool(NULL),
+  _clusterFinders()
  {
   
   // modify processor description
@@ -111,10 +115,14 @@ EUTelProcessorGeometricClustering::EUTelProcessorGeometricClustering():
   registerOptionalParameter("ExcludedPlanes", "The list of sensor ids that have to be excluded from the clustering.",
                              _ExcludedPlanes, std::vector<int> () );
 
+  registerOptionalParameter("NumberOfThreads","Number of threads used to cluster the sensors concurrently. 1 means serial processing, 0 one thread per CPU core",
+                             _nThreads, static_cast<int>(1) );
+
   		_isFirstEvent = true;
 }
 
 void EUTelProcessorGeometricClustering::init() {
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
 	//this method is called only once even when the rewind is active, it is usually a good idea to
 	printParameters ();
 
@@ -128,6 +136,15 @@ void EUTelProcessorGeometricClustering::init() {
 
 	//the geometry is not yet initialized, so set the corresponding switch to false
 	_isGeometryReady = false;
+
+	delete _threadPool;
+	_threadPool = new EUTelThreadPool( _nThreads < 0 ? 1 : _nThreads );
+	streamlog_out( MESSAGE4 ) << "Clustering sensors with " << _threadPool->size() << " thread(s)" << std::endl;
+}
+
+EUTelProcessorGeometricClustering::~EUTelProcessorGeometricClustering() {
+	delete _threadPool;
+	for ( size_t i = 0; i < _clusterFinders.size(); ++i ) delete _clusterFinders[i];
 }
 
 void EUTelProcessorGeometricClustering::processRunHeader (LCRunHeader * rdr) {
@@ -201,6 +218,7 @@ void EUTelProcessorGeometricClustering::readCollections(LCEvent* event)
 
 void EUTelProcessorGeometricClustering::processEvent (LCEvent * event) 
 {
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 	//increment event counter
 	++_iEvt;
 
@@ -295,7 +313,10 @@ void EUTelProcessorGeometricClustering::geometricClustering(LCEvent * evt, LCCol
 	CellIDEncoder<TrackerPulseImpl> idZSPulseEncoder(EUTELESCOPE::PULSEDEFAULTENCODING, pulseCollection);
 
 	// in the _zsInputDataCollectionVec we should have one TrackerData for each 
-	// detector working in ZS mode. We need to loop over all of them
+	// detector working in ZS mode. The hit pixels of each of them are placed
+	// with the geometry, which is not thread safe, and then handed to a cluster
+	// finder. The finders run concurrently on the thread pool.
+	std::vector< int > finderSensorID;
 	for ( unsigned int idetector = 0 ; idetector < _zsInputDataCollectionVec->size(); idetector++ ) 
 	{
 		// get the TrackerData and guess which kind of sparsified data it contains.
@@ -333,10 +354,15 @@ void EUTelProcessorGeometricClustering::geometricClustering(LCEvent * evt, LCCol
 			// now prepare the EUTelescope interface to sparsified data.
 			std::auto_ptr<EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel > > sparseData( new EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel> ( zsData ) );
 
+			if ( _clusterFinders.size() <= finderSensorID.size() ) _clusterFinders.push_back( new SensorClusterFinder );
+			SensorClusterFinder * finder = _clusterFinders[ finderSensorID.size() ];
+			finder->setCut( EUTelGeometricPixelCut( _cutT ) );
+
 			streamlog_out ( DEBUG2 ) << "Processing sparse data on detector " << sensorID << " with " << sparseData->size() << " pixels " << std::endl;
 
 			int hitPixelsInEvent = sparseData->size();
-			std::vector<EUTelGeometricPixel> hitPixelVec;
+			std::vector<EUTelGeometricPixel> & hitPixelVec = finder->pixels();
+			hitPixelVec.clear();
 			EUTelGenericSparsePixel* genericPixel = new EUTelGenericSparsePixel;
 
 			//This for-loop loads all the hits of the given event and detector plane and stores them as GeometricPixels
@@ -391,118 +417,61 @@ void EUTelProcessorGeometricClustering::geometricClustering(LCEvent * evt, LCCol
 				hitPixelVec.push_back( hitPixel );
 			}		
 
-			std::vector<EUTelGeometricPixel> newlyAdded;
-			//We now cluster those hits together
-			while( !hitPixelVec.empty() )
-			{
-				// prepare a TrackerData to store the cluster candidate
-				std::auto_ptr< TrackerDataImpl > zsCluster ( new TrackerDataImpl );
-				// prepare a reimplementation of sparsified cluster
-				std::auto_ptr<EUTelGenericSparseClusterImpl<EUTelGeometricPixel > > sparseCluster ( new EUTelGenericSparseClusterImpl<EUTelGeometricPixel >( zsCluster.get() ) );
-
-				//First we need to take any pixel, so let's take the first one
-				//Add it to the cluster as well as the newly added pixels
-				newlyAdded.push_back( hitPixelVec.front() );
-				sparseCluster->addSparsePixel( &hitPixelVec.front() );
-				//And remove it from the original collection
-				hitPixelVec.erase( hitPixelVec.begin() );
-		
-				//Now process all newly added pixels, initially this is the just previously added one
-				//but in the process of neighbour finding we continue to add new pixels
-				while( !newlyAdded.empty() )
-				{
-					bool newlyDone = true;
-					float x1, x2, y1, y2, dX, dY, cx1, cy1, cx2, cy2, cutX, cutY, t1 , t2, dT;
-
-					//check against all pixels in the hitPixelVec
-					for( std::vector<EUTelGeometricPixel>::iterator hitVec = hitPixelVec.begin(); hitVec != hitPixelVec.end(); ++hitVec )
-					{
-						//get the relevant infos from the newly added pixel
-						x1 = newlyAdded.front().getPosX();
-						y1 = newlyAdded.front().getPosY();
-						t1 =  newlyAdded.front().getTime();
-						cx1 = newlyAdded.front().getBoundaryX();
-						cy1 = newlyAdded.front().getBoundaryY();
-
-						//and the pixel we test against
-						x2 = hitVec->getPosX();
-						y2 = hitVec->getPosY();
-						t2 = hitVec->getTime();
-						cx2 = hitVec->getBoundaryX();
-						cy2 = hitVec->getBoundaryY();
-
-						dX = x1 - x2;
-						dY = y1 - y2;
-						dT = t1 - t2;
-						cutX = (cx1+cx2)*1.01; //this additional 1% is accounting for precision
-						cutY = (cy1+cy2)*1.01; //uncertainty with the geo framework
-
-						//if they pass the spatial and temporal cuts, we add them	
-						if(	(dX*dX <= cutX*cutX) && (dY*dY <= cutY*cutY) && (dT*dT <= _cutT*_cutT) )
-						{
-							//add them to the cluster as well as to the newly added ones
-							newlyAdded.push_back( *hitVec );
-							sparseCluster->addSparsePixel( &(*hitVec) );
-							//and remove it from the original collection
-							hitPixelVec.erase( hitVec );
-							//for the pixel we test there might be other neighbours, we still have to check
-							newlyDone = false;
-							break;
-						}
-					}
-				
-					//if no neighbours are found, we can delete the pixel from the newly added
-					//we tested against _ALL_ non cluster pixels, there are no other pixels
-					//which could be neighbours
-					if(newlyDone) newlyAdded.erase( newlyAdded.begin() );
-				}	
-
-				//Now we need to process the found cluster
-				if ( sparseCluster->size() > 0 ) 
-				{
-					// set the ID for this zsCluster
-					idZSClusterEncoder["sensorID"]  = sensorID;
-					idZSClusterEncoder["sparsePixelType"] = static_cast<int>( kEUTelGeometricPixel );
-					idZSClusterEncoder["quality"] = 0;
-					idZSClusterEncoder.setCellID( zsCluster.get() );
+			delete genericPixel;
+
+			finderSensorID.push_back( sensorID );
+			_threadPool->submit( finder );
+    		}	 
+		else 
+		{
+			// the finders already submitted must not be running any more
+			_threadPool->wait();
+    			throw UnknownDataTypeException("Unknown sparsified pixel");
+    		}
+	}
+	_threadPool->wait();
 
-					// add it to the cluster collection
-					sparseClusterCollectionVec->push_back( zsCluster.get() );
+	//Now we store the found clusters, in the order of the sensors in the input collection
+	for ( size_t iFinder = 0; iFinder < finderSensorID.size(); ++iFinder )
+	{
+		const SensorClusterFinder * finder = _clusterFinders[ iFinder ];
+		const std::vector<EUTelGeometricPixel> & clusterPixels = finder->getClusterPixels();
+		int sensorID = finderSensorID[ iFinder ];
 
-					//int xSeed, ySeed, xSize, ySize;
-					//sparseCluster->getClusterInfo(xSeed, ySeed, xSize, ySize);
+		for ( unsigned int iCluster = 0; iCluster < finder->getNumberOfClusters(); ++iCluster )
+		{
+			// prepare a TrackerData to store the cluster
+			std::auto_ptr< TrackerDataImpl > zsCluster ( new TrackerDataImpl );
+			// prepare a reimplementation of sparsified cluster
+			EUTelGenericSparseClusterImpl<EUTelGeometricPixel > sparseCluster( zsCluster.get() );
+			for ( unsigned int iPixel = finder->getClusterStart( iCluster ); iPixel < finder->getClusterStart( iCluster + 1 ); ++iPixel )
+			{
+				EUTelGeometricPixel pixel( clusterPixels[ iPixel ] );
+				sparseCluster.addSparsePixel( &pixel );
+			}
 
-					// prepare a pulse for this cluster
-					std::auto_ptr<TrackerPulseImpl> zsPulse ( new TrackerPulseImpl );
-					idZSPulseEncoder["sensorID"]  = sensorID;
-					//idZSPulseEncoder["xSeed"]     = xSeed;
-					//idZSPulseEncoder["ySeed"]     = ySeed;
-					idZSPulseEncoder["type"]      = static_cast<int>(kEUTelGenericSparseClusterImpl);
-					idZSPulseEncoder.setCellID( zsPulse.get() );
+			// set the ID for this zsCluster
+			idZSClusterEncoder["sensorID"]  = sensorID;
+			idZSClusterEncoder["sparsePixelType"] = static_cast<int>( kEUTelGeometricPixel );
+			idZSClusterEncoder["quality"] = 0;
+			idZSClusterEncoder.setCellID( zsCluster.get() );
 
-					zsPulse->setCharge( sparseCluster->getTotalCharge() );
-					//zsPulse->setQuality( static_cast<int > (sparseCluster->getClusterQuality()) );
-					zsPulse->setTrackerData( zsCluster.release() );
-					pulseCollection->push_back( zsPulse.release() );
+			// add it to the cluster collection
+			sparseClusterCollectionVec->push_back( zsCluster.get() );
 
-					// last but not least increment the totClusterMap
-					_totClusterMap[ sensorID ] += 1;
+			// prepare a pulse for this cluster
+			std::auto_ptr<TrackerPulseImpl> zsPulse ( new TrackerPulseImpl );
+			idZSPulseEncoder["sensorID"]  = sensorID;
+			idZSPulseEncoder["type"]      = static_cast<int>(kEUTelGenericSparseClusterImpl);
+			idZSPulseEncoder.setCellID( zsPulse.get() );
 
-				} //cluster processing if
+			zsPulse->setCharge( sparseCluster.getTotalCharge() );
+			zsPulse->setTrackerData( zsCluster.release() );
+			pulseCollection->push_back( zsPulse.release() );
 
-				else 
-				{
-					//in the case the cluster candidate is not passing the threshold ...
-					//forget about them, the memory should be automatically cleaned by std::auto_ptr's
-				}
-			} //loop over all found clusters
-			
-			delete genericPixel;
-    		}	 
-		else 
-		{
-    			throw UnknownDataTypeException("Unknown sparsified pixel");
-    		}
+			// last but not least increment the totClusterMap
+			_totClusterMap[ sensorID ] += 1;
+		} //loop over all found clusters
 	} // this is the end of the loop over all ZS detectors
 
 	// if the sparseClusterCollectionVec isn't empty add it to the
@@ -525,6 +494,7 @@ void EUTelProcessorGeometricClustering::check (LCEvent * /* evt */) {
 }
 
 void EUTelProcessorGeometricClustering::end() {
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
 	
 	streamlog_out ( MESSAGE4 ) <<  "Successfully finished" << std::endl;
   
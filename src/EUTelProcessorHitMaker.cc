@@ -15,6 +15,7 @@
 #include "EUTelGeometryTelescopeGeoDescription.h"
 
 #include "EUTelProcessorHitMaker.h"
+#include "EUTelProcessorMonitor.h"
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelEventImpl.h"
 #include "EUTELESCOPE.h"
@@ -26,6 +27,7 @@
 #include "EUTelDFFClusterImpl.h"
 #include "EUTelBrickedClusterImpl.h"
 #include "EUTelSparseClusterImpl.h"
+#include "EUTelClusterSummary.h"
 
 #include "EUTelExceptions.h"
 #include "EUTelAlignmentConstant.h"
@@ -87,7 +89,11 @@ _conversionIdMap(),
 _alreadyBookedSensorID(),
 _aidaHistoMap(),
 _histogramSwitch(true),
-_orderedSensorIDVec()
+_orderedSensorIDVec(),
+_nThreads(1),
+_threadPool(NULL),
+_centreFinders(),
+_clusterCentres()
 {
   // modify processor description
   _description =  "EUTelProcessorHitMaker is responsible to translate cluster centers from the local frame of reference \nto the external frame of reference using the GEAR geometry description";
@@ -101,11 +107,80 @@ _orderedSensorIDVec()
   registerOptionalParameter("ReferenceCollection","This is the name of the reference hit collection initialized in this processor. This collection provides the reference vector to correctly determine a plane corresponding to a global hit coordiante.", _referenceHitCollectionName, static_cast<string>("referenceHit") );
  
   registerOptionalParameter("ReferenceHitFile","This is the file where the reference hit collection is stored", _referenceHitLCIOFile, std::string("reference.slcio") );
+
+  registerOptionalParameter("NumberOfThreads","Number of threads used to compute the cluster centres of the sensors concurrently. 1 means serial processing, 0 one thread per CPU core", _nThreads, static_cast<int>(1) );
+}
+
+EUTelProcessorHitMaker::~EUTelProcessorHitMaker()
+{
+  delete _threadPool;
+  for ( size_t i = 0; i < _centreFinders.size(); ++i ) delete _centreFinders[i];
+}
+
+
+EUTelProcessorHitMaker::SensorCentreFinder::SensorCentreFinder() :
+  EUTelThreadPool::Task(),
+  _clusters(NULL),
+  _clusterIndices()
+{
 }
 
+void EUTelProcessorHitMaker::SensorCentreFinder::run()
+{
+  for ( size_t i = 0; i < _clusterIndices.size(); ++i )
+  {
+    ClusterCentre & centre = (*_clusters)[ _clusterIndices[i] ];
+
+    if( centre.clusterType == kEUTelGenericSparseClusterImpl )
+    {
+      float xPos = 0;
+      float yPos = 0;
+
+      if( centre.pixelType == kEUTelGenericSparsePixel )
+      {
+        EUTelGenericSparseClusterImpl<EUTelGenericSparsePixel> cluster( centre.trackerData );
+        cluster.getCenterOfGravity(xPos, yPos);
+
+        //For non geometric clusters, getCenterOfGravity will return it in pixel indices space, i.e.
+        //we still have to transform into mm via the dimensions
+        xPos = (xPos + 0.5) * centre.xPitch - centre.xSize/2.;
+        yPos = (yPos + 0.5) * centre.yPitch - centre.ySize/2.;
+      }
+      else
+      {
+        EUTelGeometricClusterImpl cluster( centre.trackerData );
+        cluster.getGeometricCenterOfGravity(xPos, yPos);
+      }
+
+      centre.telPos[0] = xPos;
+      centre.telPos[1] = yPos;
+      centre.telPos[2] = 0;
+    }
+    else
+    {
+      // the position is given by the charge centre of gravity, in
+      // pixel number
+      if( !centre.hasCoG )
+      {
+        EUTelSparseClusterImpl<EUTelGenericSparsePixel> cluster( centre.trackerData );
+        cluster.getCenterOfGravity(centre.xCoG, centre.yCoG);
+      }
+      double xDet = (centre.xCoG + 0.5) * centre.xPitch;
+      double yDet = (centre.yCoG + 0.5) * centre.yPitch; 
+
+      //We have calculated the cluster hit position in terms of distance along the X and Y axis.
+      //However we still fo not have the sensor centre as the origin of the coordinate system.
+      //To do this we need to deduct xSize/2 and ySize/2 for the respective cluster X/Y position 
+      centre.telPos[0] = xDet - centre.xSize/2. ;
+      centre.telPos[1] = yDet - centre.ySize/2. ; 
+      centre.telPos[2] = 0.;
+    }
+  }
+}
 
 void EUTelProcessorHitMaker::init()
 {
+		EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
 		printParameters ();
 
 		// set to zero the run and event counters
@@ -119,6 +194,10 @@ void EUTelProcessorHitMaker::init()
 
 		_histogramSwitch = true;
 
+		delete _threadPool;
+		_threadPool = new EUTelThreadPool( _nThreads < 0 ? 1 : _nThreads );
+		streamlog_out( MESSAGE4 ) << "Computing cluster centres with " << _threadPool->size() << " thread(s)" << endl;
+
 		//only for global coord we need a refhit collection
 		if(!_wantLocalCoordinates)
 		{
@@ -231,6 +310,7 @@ void EUTelProcessorHitMaker::processRunHeader (LCRunHeader * rdr) {
 
 
 void EUTelProcessorHitMaker::processEvent (LCEvent * event) {
+    EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 
     ++_iEvt;
 
@@ -275,19 +355,30 @@ void EUTelProcessorHitMaker::processEvent (LCEvent * event) {
     CellIDDecoder<TrackerDataImpl> cellDecoder(EUTELESCOPE::ZSDATADEFAULTENCODING);
 
     int oldDetectorID = -100;
+    const EUTelClusterSummary * clusterSummary = 0;
 
     double xSize = 0., ySize = 0.;
     double resolutionX = 0., resolutionY = 0.;
     double xPitch = 0., yPitch = 0.;
 
+	// The clusters are decoded and the geometry of their sensor is looked
+	// up first. The cluster centres are then computed by one finder per
+	// sensor, concurrently, and the hits are made at the end in the order
+	// of the input clusters.
+	_clusterCentres.resize( pulseCollection->getNumberOfElements() );
+	std::map< int, size_t > finderIndex;
+	size_t nFinders = 0;
+
 	for( int iCluster = 0; iCluster < pulseCollection->getNumberOfElements(); iCluster++ ) 
 	{
-			TrackerPulseImpl* pulse = dynamic_cast<TrackerPulseImpl*>(pulseCollection->getElementAt(iCluster));
-			TrackerDataImpl* trackerData  = dynamic_cast<TrackerDataImpl*>( pulse->getTrackerData());
+			ClusterCentre & centre = _clusterCentres[ iCluster ];
+			centre.pulse = dynamic_cast<TrackerPulseImpl*>(pulseCollection->getElementAt(iCluster));
+			centre.trackerData = dynamic_cast<TrackerDataImpl*>( centre.pulse->getTrackerData());
 
-			int sensorID = clusterCellDecoder(pulse)["sensorID"];
-			ClusterType clusterType = static_cast<ClusterType>( static_cast<int>(clusterCellDecoder(pulse)["type"]) );
-			SparsePixelType pixelType = static_cast<SparsePixelType>( static_cast<int>(cellDecoder(trackerData)["sparsePixelType"]) );
+			int sensorID = clusterCellDecoder(centre.pulse)["sensorID"];
+			centre.sensorID = sensorID;
+			centre.clusterType = static_cast<ClusterType>( static_cast<int>(clusterCellDecoder(centre.pulse)["type"]) );
+			centre.pixelType = static_cast<SparsePixelType>( static_cast<int>(cellDecoder(centre.trackerData)["sparsePixelType"]) );
 
 			// there could be several clusters belonging to the same
 			// detector. So update the geometry information only if this new
@@ -315,115 +406,70 @@ void EUTelProcessorHitMaker::processEvent (LCEvent * event) {
 
 			}
 
+			centre.xSize       = xSize;
+			centre.ySize       = ySize;
+			centre.xPitch      = xPitch;
+			centre.yPitch      = yPitch;
+			centre.resolutionX = resolutionX;
+			centre.resolutionY = resolutionY;
+			centre.hasCoG      = false;
 
-			// LOCAL coordinate system !!!!!!
-			double telPos[3];
-			
-			if(clusterType == kEUTelGenericSparseClusterImpl)
+			if( centre.clusterType == kEUTelGenericSparseClusterImpl )
 			{
-				float xPos = 0;
-				float yPos = 0;
-
 				//in the case of genericSparseCluster we need to know the underlying pixel type
-				if(pixelType == kEUTelGenericSparsePixel)
-				{
-					EUTelGenericSparseClusterImpl<EUTelGenericSparsePixel> cluster (trackerData);
-					cluster.getCenterOfGravity(xPos, yPos);
-
-					//For non geometric clusters, getCenterOfGravity will return it in pixel indices space, i.e.
-					//we still have to transform into mm via the dimensions
-					xPos = (xPos + 0.5) * xPitch - xSize/2.;
-					yPos = (yPos + 0.5) * yPitch - ySize/2.;
-		
-				}
-
-				else if(pixelType == kEUTelGeometricPixel)
-				{
-					
-					EUTelGeometricClusterImpl cluster(trackerData);
-					cluster.getGeometricCenterOfGravity(xPos, yPos);
-				}
-
-				else
+				if( centre.pixelType != kEUTelGenericSparsePixel && centre.pixelType != kEUTelGeometricPixel )
 				{
 					//ERROR
-					streamlog_out( ERROR4 ) << "We do not support pixel type: " << pixelType << " for kEUTelGenericSparseClusterImpl" << std::endl;
+					streamlog_out( ERROR4 ) << "We do not support pixel type: " << centre.pixelType << " for kEUTelGenericSparseClusterImpl" << std::endl;
 					throw UnknownDataTypeException("Pixel type not supported for kEUTelGenericSparseClusterImpl");
 				}
-
-				telPos[0] = xPos;
-				telPos[1] = yPos;
-				telPos[2] = 0;
 			}
-
-			else
+			else if( centre.clusterType == kEUTelSparseClusterImpl )
 			{
-					EUTelSparseClusterImpl<EUTelGenericSparsePixel>* cluster = new EUTelSparseClusterImpl<EUTelGenericSparsePixel>(trackerData);
-
-					// get the position of the seed pixel. This is in pixel number.
-					int xCluSeed = 0;
-					int yCluSeed = 0;
-					cluster->getSeedCoord(xCluSeed, yCluSeed);
-
-					// with the charge center of gravity calculation, we get a shift
-					// from the seed pixel center due to the charge distribution. Those
-					// two numbers are the correction values in the case the Eta
-					// correction is not applied.
-
-					//!HACK TAKI:
-					//! In case of a bricked cluster, we have to make sure to get the normal CoG first.
-					//! The one without the global seed coordinate correction (caused by pixel rows being skewed).
-					//! That one has to be eta-corrected and the global coordinate correction has to be applied on top of that!
-					//! So prepare a brickedCluster pointer now:
-
-					EUTelBrickedClusterImpl* p_tmpBrickedCluster = NULL;
-					if ( clusterType == kEUTelBrickedClusterImpl )
-					{
-							p_tmpBrickedCluster = dynamic_cast< EUTelBrickedClusterImpl* >(cluster);
-							if (p_tmpBrickedCluster == NULL)
-							{
-									streamlog_out ( ERROR4 ) << " .COULD NOT CREATE EUTelBrickedClusterImpl* !!!" << endl;
-									throw UnknownDataTypeException("COULD NOT CREATE EUTelBrickedClusterImpl* !!!");
-							}
-					}
-
-					float xShift = 0.;
-					float yShift = 0.;
+					// Sparse clusters read the centre of gravity from the per
+					// event cluster summary, shared with the other processors.
+					if( clusterSummary == 0 ) clusterSummary = &EUTelClusterSummary::get( event, _pulseCollectionName );
+					const EUTelClusterSummary::Entry & summary = (*clusterSummary)[ iCluster ];
+					centre.xCoG   = summary.xCoG;
+					centre.yCoG   = summary.yCoG;
+					centre.hasCoG = true;
+			}
+			else if ( centre.clusterType == kEUTelBrickedClusterImpl )
+			{
+					streamlog_out ( ERROR4 ) << " .COULD NOT CREATE EUTelBrickedClusterImpl* !!!" << endl;
+					throw UnknownDataTypeException("COULD NOT CREATE EUTelBrickedClusterImpl* !!!");
+			}
 
-					cluster->getCenterOfGravityShift( xShift, yShift );
+			std::map< int, size_t >::iterator finder = finderIndex.find( sensorID );
+			if ( finder == finderIndex.end() )
+			{
+					if ( _centreFinders.size() <= nFinders ) _centreFinders.push_back( new SensorCentreFinder );
+					_centreFinders[ nFinders ]->setClusters( &_clusterCentres );
+					_centreFinders[ nFinders ]->clusterIndices().clear();
+					finder = finderIndex.insert( std::make_pair( sensorID, nFinders++ ) ).first;
+			}
+			_centreFinders[ finder->second ]->clusterIndices().push_back( iCluster );
+	}
 
-					double xCorrection = static_cast<double> (xShift) ;
-					double yCorrection = static_cast<double> (yShift) ;
+	for ( size_t iFinder = 0; iFinder < nFinders; ++iFinder ) _threadPool->submit( _centreFinders[ iFinder ] );
+	_threadPool->wait();
 
-					// rescale the pixel number in millimeter
-					double xDet = ( static_cast<double> (xCluSeed) + xCorrection + 0.5 ) * xPitch ;
-					double yDet = ( static_cast<double> (yCluSeed) + yCorrection + 0.5 ) * yPitch ;
+	for( int iCluster = 0; iCluster < pulseCollection->getNumberOfElements(); iCluster++ ) 
+	{
+			const ClusterCentre & centre = _clusterCentres[ iCluster ];
+			int sensorID = centre.sensorID;
 
-					// check the hack from Havard:
-					float xCoG(0.0f), yCoG(0.0f);
-					cluster->getCenterOfGravity(xCoG, yCoG);
-					xDet = (xCoG + 0.5) * xPitch;
-					yDet = (yCoG + 0.5) * yPitch; 
+			// LOCAL coordinate system !!!!!!
+			double telPos[3] = { centre.telPos[0], centre.telPos[1], centre.telPos[2] };
 
+			if( centre.clusterType != kEUTelGenericSparseClusterImpl )
+			{
 					streamlog_out(DEBUG1) << "cluster[" << setw(4) << iCluster << "] on sensor[" << setw(3) << sensorID 
-							<< "] at [" << setw(8) << setprecision(3) << xCoG << ":" << setw(8) << setprecision(3) << yCoG << "]"
-							<< " ->  [" << setw(8) << setprecision(3) << xDet << ":" << setw(8) << setprecision(3) << yDet << "]"
+							<< "] at [" << setw(8) << setprecision(3) << centre.xCoG << ":" << setw(8) << setprecision(3) << centre.yCoG << "]"
+							<< " ->  [" << setw(8) << setprecision(3) << (centre.xCoG + 0.5) * centre.xPitch << ":" << setw(8) << setprecision(3) << (centre.yCoG + 0.5) * centre.yPitch << "]"
 							<< endl;
-
-					//We have calculated the cluster hit position in terms of distance along the X and Y axis.
-					//However we still fo not have the sensor centre as the origin of the coordinate system.
-					//To do this we need to deduct xSize/2 and ySize/2 for the respective cluster X/Y position 
-
-
-					telPos[0] = xDet - xSize/2. ;
-					telPos[1] = yDet - ySize/2. ; 
-					telPos[2] =   0.;
-
-					delete cluster;
-					cluster = nullptr;
 			}
 
-
 			//We now plot the the hits in the EUTelescope local frame. This frame has the coordinate centre at the sensor centre.
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 			string tempHistoName;
@@ -478,17 +524,17 @@ void EUTelProcessorHitMaker::processEvent (LCEvent * event) {
 
 			hit->setPosition( &telPos[0] );
 			float cov[TRKHITNCOVMATRIX] = {0.,0.,0.,0.,0.,0.};
-			double resx = resolutionX;
-			double resy = resolutionY;
+			double resx = centre.resolutionX;
+			double resy = centre.resolutionY;
 			cov[0] = resx * resx; // cov(x,x)
 			cov[2] = resy * resy; // cov(y,y)
 			hit->setCovMatrix( cov );
-			hit->setType( clusterType  );
-            hit->setTime( pulse->getTime() );
+			hit->setType( centre.clusterType  );
+            hit->setTime( centre.pulse->getTime() );
 
 			// prepare a LCObjectVec to store the current cluster
 			LCObjectVec clusterVec;
-			clusterVec.push_back( trackerData );
+			clusterVec.push_back( centre.trackerData );
 
 			// add the clusterVec to the hit
 			hit->rawHits() = clusterVec;
@@ -521,6 +567,7 @@ void EUTelProcessorHitMaker::processEvent (LCEvent * event) {
 
 void EUTelProcessorHitMaker::end() 
 {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
   streamlog_out ( MESSAGE4 )  << "Successfully finished" << endl;
 }
 
@@ -0,0 +1,180 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelProcessorMonitor.h"
+#include "EUTelCDashMeasurement.h"
+
+// marlin includes ".h"
+#include "marlin/Global.h"
+#include "marlin/VerbosityLevels.h"
+
+// other includes
+#include "streamlog/streamlog.h"
+
+// system includes <>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/time.h>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace std;
+using namespace eutelescope;
+
+EUTelProcessorMonitor::Scope::Scope( const marlin::Processor * processor, Phase phase ) :
+  _processor( processor ),
+  _phase( phase ),
+  _wall( 0. ),
+  _cpu( 0. ),
+  _heap( 0 ) {
+
+  if ( EUTelProcessorMonitor::instance().getHeapMonitoring() ) _heap = heapInUse();
+  _cpu  = cpuTime();
+  _wall = wallTime();
+}
+
+EUTelProcessorMonitor::Scope::~Scope() {
+  const double wall = wallTime() - _wall;
+  const double cpu  = cpuTime() - _cpu;
+  EUTelProcessorMonitor & monitor = EUTelProcessorMonitor::instance();
+  const long heap = monitor.getHeapMonitoring() ? heapInUse() - _heap : 0;
+  monitor.record( _processor, _phase, wall, cpu, heap );
+}
+
+EUTelProcessorMonitor & EUTelProcessorMonitor::instance() {
+  static EUTelProcessorMonitor monitor;
+  return monitor;
+}
+
+EUTelProcessorMonitor::EUTelProcessorMonitor() :
+  _entries(),
+  _index(),
+  _nEnded( 0 ),
+  _heap( false ) {
+
+  if ( marlin::Global::parameters != 0 &&
+       marlin::Global::parameters->isParameterSet( EUTELESCOPE::MONITORHEAP ) ) {
+    const string heap = marlin::Global::parameters->getStringVal( EUTELESCOPE::MONITORHEAP );
+    _heap = ( heap == "true" || heap == "True" || heap == "1" );
+  }
+}
+
+double EUTelProcessorMonitor::wallTime() {
+  timeval tv;
+  gettimeofday( &tv, 0 );
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+double EUTelProcessorMonitor::cpuTime() {
+  rusage usage;
+  getrusage( RUSAGE_SELF, &usage );
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 1e-6 * ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec );
+}
+
+long EUTelProcessorMonitor::heapInUse() {
+#if defined(__GLIBC__) && ( __GLIBC__ > 2 || ( __GLIBC__ == 2 && __GLIBC_MINOR__ >= 33 ) )
+  struct mallinfo2 info = mallinfo2();
+  return static_cast< long >( info.uordblks + info.hblkhd );
+#elif defined(__GLIBC__)
+  struct mallinfo info = mallinfo();
+  return static_cast< long >( static_cast< unsigned int >( info.uordblks ) ) +
+    static_cast< long >( static_cast< unsigned int >( info.hblkhd ) );
+#else
+  return 0;
+#endif
+}
+
+void EUTelProcessorMonitor::record( const marlin::Processor * processor, Phase phase, double wall, double cpu, long heap ) {
+
+  map< const marlin::Processor *, size_t >::const_iterator it = _index.find( processor );
+  size_t iEntry;
+  if ( it == _index.end() ) {
+    Entry entry;
+    entry.processor = processor;
+    for ( int iPhase = 0; iPhase < kNPhases; ++iPhase ) {
+      Counters & counters = entry.phases[ iPhase ];
+      counters.calls = 0;
+      counters.wall  = 0.;
+      counters.cpu   = 0.;
+      counters.heap  = 0.;
+    }
+    iEntry = _entries.size();
+    _entries.push_back( entry );
+    _index[ processor ] = iEntry;
+  } else {
+    iEntry = it->second;
+  }
+
+  Counters & counters = _entries[ iEntry ].phases[ phase ];
+  ++counters.calls;
+  counters.wall += wall;
+  counters.cpu  += cpu;
+  counters.heap += heap;
+
+  // the summary comes once all the processors are done
+  if ( phase == kEnd && ++_nEnded == _entries.size() ) report();
+}
+
+void EUTelProcessorMonitor::report() const {
+
+  stringstream header;
+  header << setw( 36 ) << left << "Processor" << right
+         << setw( 10 ) << "Events"
+         << setw( 12 ) << "Wall [s]"
+         << setw( 12 ) << "CPU [s]"
+         << setw( 14 ) << "Wall [ms/ev]"
+         << setw( 14 ) << "CPU [ms/ev]"
+         << setw( 12 ) << "Events/s"
+         << setw( 10 ) << "Init [s]"
+         << setw( 10 ) << "End [s]";
+  if ( _heap ) header << setw( 14 ) << "Heap [kB/ev]";
+  streamlog_out ( MESSAGE5 ) << "Processor timing summary" << endl << header.str() << endl;
+
+  double totalWall = 0., totalCpu = 0.;
+  for ( size_t iEntry = 0; iEntry < _entries.size(); ++iEntry ) {
+
+    const string & name = _entries[ iEntry ].processor->name();
+    const Counters & init   = _entries[ iEntry ].phases[ kInit ];
+    const Counters & events = _entries[ iEntry ].phases[ kProcessEvent ];
+    const Counters & end    = _entries[ iEntry ].phases[ kEnd ];
+    const double nEvents    = events.calls > 0 ? events.calls : 1.;
+
+    stringstream line;
+    line << setw( 36 ) << left << name << right << fixed
+         << setw( 10 ) << events.calls
+         << setw( 12 ) << setprecision( 3 ) << events.wall
+         << setw( 12 ) << setprecision( 3 ) << events.cpu
+         << setw( 14 ) << setprecision( 4 ) << 1e3 * events.wall / nEvents
+         << setw( 14 ) << setprecision( 4 ) << 1e3 * events.cpu / nEvents
+         << setw( 12 ) << setprecision( 1 ) << ( events.wall > 0. ? events.calls / events.wall : 0. )
+         << setw( 10 ) << setprecision( 3 ) << init.wall
+         << setw( 10 ) << setprecision( 3 ) << end.wall;
+    if ( _heap ) line << setw( 14 ) << setprecision( 2 ) << events.heap / 1024. / nEvents;
+    streamlog_out ( MESSAGE5 ) << line.str() << endl;
+
+    totalWall += init.wall + events.wall + end.wall;
+    totalCpu  += init.cpu + events.cpu + end.cpu;
+
+    // monitor the processors in CDash when running tests
+    cout << CDashMeasurement( name + "_events", static_cast< int >( events.calls ) );
+    cout << CDashMeasurement( name + "_wall_ms_per_event", 1e3 * events.wall / nEvents );
+    cout << CDashMeasurement( name + "_cpu_ms_per_event", 1e3 * events.cpu / nEvents );
+    cout << CDashMeasurement( name + "_end_wall_s", end.wall );
+    if ( _heap ) cout << CDashMeasurement( name + "_heap_kB_per_event", events.heap / 1024. / nEvents );
+  }
+
+  streamlog_out ( MESSAGE5 ) << "Total time in the monitored processors: wall " << totalWall << " s, CPU " << totalCpu << " s" << endl;
+  cout << CDashMeasurement( "monitored_wall_s", totalWall );
+  cout << CDashMeasurement( "monitored_cpu_s", totalCpu );
+}
@@ -1,4 +1,5 @@
 #include "EUTelProcessorPatternRecognition.h"
+#include "EUTelProcessorMonitor.h"
 /**  EUTelProcessorPatternRecognition
  * 
  *  If compiled with MARLIN_USE_AIDA 
@@ -35,7 +36,8 @@ _AllowedSharedHitsOnTrackCandidate(0),
 _nProcessedRuns(0),
 _nProcessedEvents(0),
 _eBeam(-1.),
-_qBeam(-1.)
+_qBeam(-1.),
+_seedSlopeWindow()
 {
 	//The standard description that comes with every processor 
 	_description = "EUTelProcessorPatternRecognition preforms track pattern recognition.";
@@ -74,6 +76,9 @@ _qBeam(-1.)
 	//This is the planes at which we will begin to look for tracks from. We start from this plane and move forward looking to see if hits can be added to the possible track. 
 	registerOptionalParameter("PlanesToCreateSeedsFrom", "This is the planes you want to create seeds from", _createSeedsFromPlanes,IntVec());
 
+	//With many hits per plane most seeds do not come from a track. A seed is only propagated if a hit on one of the next planes makes a pair with it whose slopes are within this window around the beam. The pair also gives the initial direction of the seed.
+	registerOptionalParameter("SeedSlopeWindow", "Maximal difference between the slopes (dx/dz dy/dz) of a pair of seed hits and the beam. Empty to use every hit as a seed", _seedSlopeWindow, FloatVec());
+
 	//This is planes that we should not look for hits or create a state. Effectively this removes this plane from the analysis. However scattering due the material is still taken into account
 	registerOptionalParameter("ExcludePlanes", "This is the planes that will not be included in analysis", _excludePlanes ,IntVec());
 
@@ -86,6 +91,7 @@ _qBeam(-1.)
 }
 //This is the inital function that Marlin will run only once when we run jobsub
 void EUTelProcessorPatternRecognition::init(){
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
 
 	try{
 		_nProcessedRuns = 0;
@@ -109,6 +115,7 @@ void EUTelProcessorPatternRecognition::init(){
 		_trackFitter->setAllowedSharedHitsOnTrackCandidate(_AllowedSharedHitsOnTrackCandidate);
 		_trackFitter->setWindowSize(_residualsRMax);//This is the max distance between hit and predicted track position on plane that we will accept.
 		_trackFitter->setPlanesToCreateSeedsFrom(_createSeedsFromPlanes);
+		_trackFitter->setSeedSlopeWindow(_seedSlopeWindow);
 		_trackFitter->setBeamMomentum(_eBeam);
 		_trackFitter->setBeamCharge(_qBeam);
 		_trackFitter->setPlaneDimensionsVec(_planeDimension);//This is to set if each plane is a strip/pixel sensor. 
@@ -156,6 +163,7 @@ void EUTelProcessorPatternRecognition::processRunHeader(LCRunHeader* run) {
 
 void EUTelProcessorPatternRecognition::processEvent(LCEvent* evt)
 {
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 	UTIL::CellIDDecoder<TrackerHitImpl> hitDecoder ( EUTELESCOPE::HITENCODING );
 
 	try{
@@ -289,6 +297,7 @@ void EUTelProcessorPatternRecognition::check(LCEvent * /*evt*/) {
 }
 
 void EUTelProcessorPatternRecognition::end() {
+    EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
     streamlog_out(MESSAGE9) <<"The average number of tracks per event: " << static_cast<float>(_trackFitter->getNumberOfTracksAfterPruneCut())/static_cast<float>(_nProcessedEvents) <<std::endl; 
     delete _trackFitter;
     streamlog_out(MESSAGE9) << "EUTelProcessorPatternRecognition::end()  " << name()
@@ -12,6 +12,7 @@
 
 //eutelescope includes
 #include "EUTelProcessorSparseClustering.h"
+#include "EUTelProcessorMonitor.h"
 
 #include "EUTELESCOPE.h"
 #include "EUTelExceptions.h"
@@ -85,7 +86,10 @@ EUTelProcessorSparseClustering::EUTelProcessorSparseClustering():
   _sensorIDVec(),
   _zsInputDataCollectionVec(NULL),
   _pulseCollectionVec(NULL),
-  _sparseMinDistanceSquared(2)
+  _sparseMinDistanceSquared(2),
+  _nThreads(1),
+  _threadPool(NULL),
+  _clusterFinders()
  {
   
   // modify processor description
@@ -113,12 +117,16 @@ EUTelProcessorSparseClustering::EUTelProcessorSparseClustering():
 
   registerProcessorParameter("SparseMinDistanceSquared","Minimum distance squared between sparsified pixel ( touching == 2) ",
                              _sparseMinDistanceSquared, static_cast<int>(2) );
+
+  registerOptionalParameter("NumberOfThreads","Number of threads used to cluster the sensors concurrently. 1 means serial processing, 0 one thread per CPU core",
+                             _nThreads, static_cast<int>(1) );
   
 
   		_isFirstEvent = true;
 }
 
 void EUTelProcessorSparseClustering::init() {
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
 	//this method is called only once even when the rewind is active, it is usually a good idea to
 	printParameters ();
 
@@ -132,6 +140,15 @@ void EUTelProcessorSparseClustering::init() {
 
 	//the geometry is not yet initialized, so set the corresponding switch to false
 	_isGeometryReady = false;
+
+	delete _threadPool;
+	_threadPool = new EUTelThreadPool( _nThreads < 0 ? 1 : _nThreads );
+	streamlog_out( MESSAGE4 ) << "Clustering sensors with " << _threadPool->size() << " thread(s)" << std::endl;
+}
+
+EUTelProcessorSparseClustering::~EUTelProcessorSparseClustering() {
+	delete _threadPool;
+	for ( size_t i = 0; i < _clusterFinders.size(); ++i ) delete _clusterFinders[i];
 }
 
 void EUTelProcessorSparseClustering::processRunHeader (LCRunHeader * rdr) {
@@ -205,6 +222,7 @@ void EUTelProcessorSparseClustering::readCollections(LCEvent* event)
 
 void EUTelProcessorSparseClustering::processEvent (LCEvent * event) 
 {
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 	//increment event counter
 	++_iEvt;
 
@@ -301,7 +319,9 @@ void EUTelProcessorSparseClustering::sparseClustering(LCEvent* evt, LCCollection
 	CellIDEncoder<TrackerPulseImpl> idZSPulseEncoder(EUTELESCOPE::PULSEDEFAULTENCODING, pulseCollection);
 
 	// in the zsInputDataCollectionVec we should have one TrackerData for each
-	// detector working in ZS mode. We need to loop over all of them
+	// detector working in ZS mode. The hit pixels of each of them are handed
+	// to a cluster finder, and the finders run concurrently on the thread pool
+	std::vector< int > finderSensorID;
 	for ( unsigned int idetector = 0 ; idetector < _zsInputDataCollectionVec->size(); idetector++ )
 	{
 		// get the TrackerData and guess which kind of sparsified data it contains.
@@ -324,124 +344,77 @@ void EUTelProcessorSparseClustering::sparseClustering(LCEvent* evt, LCCollection
 			continue;
 		}
 
+		if ( type != kEUTelGenericSparsePixel )
+		{
+			// the finders already submitted must not be running any more
+			_threadPool->wait();
+			throw UnknownDataTypeException("Unknown sparsified pixel");
+		}
 
-		if ( type == kEUTelGenericSparsePixel )
+		if ( _clusterFinders.size() <= finderSensorID.size() ) _clusterFinders.push_back( new SensorClusterFinder );
+		SensorClusterFinder * finder = _clusterFinders[ finderSensorID.size() ];
+		finder->setCut( EUTelPixelDistanceCut( _sparseMinDistanceSquared ) );
+
+		// now prepare the EUTelescope interface to sparsified data.
+		EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel> sparseData( zsData );
+
+		//This for-loop loads all the hits of the given event and detector plane and stores them
+		std::vector<EUTelGenericSparsePixel> & hitPixelVec = finder->pixels();
+		hitPixelVec.clear();
+		hitPixelVec.reserve( sparseData.size() );
+		EUTelGenericSparsePixel pixel;
+		for( unsigned int i = 0; i < sparseData.size(); ++i )
 		{
+			sparseData.getSparsePixelAt( i, &pixel );
+			hitPixelVec.push_back( pixel );
+		}
 
-			// now prepare the EUTelescope interface to sparsified data.
-			std::auto_ptr<EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel > > sparseData( new EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel> ( zsData ) );
+		finderSensorID.push_back( sensorID );
+		_threadPool->submit( finder );
+	}
+	_threadPool->wait();
 
-			int hitPixelsInEvent = sparseData->size();
-			std::vector<EUTelGenericSparsePixel> hitPixelVec;
-			EUTelGenericSparsePixel* pixel = new EUTelGenericSparsePixel;
+	//Now we store the found clusters, in the order of the sensors in the input collection
+	for ( size_t iFinder = 0; iFinder < finderSensorID.size(); ++iFinder )
+	{
+		const SensorClusterFinder * finder = _clusterFinders[ iFinder ];
+		const std::vector<EUTelGenericSparsePixel> & clusterPixels = finder->getClusterPixels();
+		int sensorID = finderSensorID[ iFinder ];
 
-			//This for-loop loads all the hits of the given event and detector plane and stores them
-			for(int i = 0; i < hitPixelsInEvent; ++i )
+		for ( unsigned int iCluster = 0; iCluster < finder->getNumberOfClusters(); ++iCluster )
+		{
+			// prepare a TrackerData to store the cluster
+			std::auto_ptr< TrackerDataImpl > zsCluster ( new TrackerDataImpl );
+			// prepare a reimplementation of sparsified cluster
+			EUTelSparseClusterImpl<EUTelGenericSparsePixel> sparseCluster( zsCluster.get() );
+			for ( unsigned int iPixel = finder->getClusterStart( iCluster ); iPixel < finder->getClusterStart( iCluster + 1 ); ++iPixel )
 			{
-				//Load the information of the hit pixel into genericPixel
-				sparseData->getSparsePixelAt( i, pixel );
-				EUTelGenericSparsePixel hitPixel( *pixel );
+				EUTelGenericSparsePixel pixel( clusterPixels[ iPixel ] );
+				sparseCluster.addSparsePixel( &pixel );
+			}
 
-				//and push this pixel back
-				hitPixelVec.push_back( hitPixel );
-			}	
+			// set the ID for this zsCluster
+			idZSClusterEncoder["sensorID"] = sensorID;
+			idZSClusterEncoder["sparsePixelType"] = static_cast<int>( kEUTelGenericSparsePixel );
+			idZSClusterEncoder["quality"] = 0;
+			idZSClusterEncoder.setCellID( zsCluster.get() );
 
-			std::vector<EUTelGenericSparsePixel> newlyAdded;
-			//We now cluster those hits together
-			while( !hitPixelVec.empty() )
-			{
-                           	// prepare a TrackerData to store the cluster candidate
-				std::auto_ptr< TrackerDataImpl > zsCluster ( new TrackerDataImpl );
-				// prepare a reimplementation of sparsified cluster
-				std::auto_ptr<EUTelSparseClusterImpl<EUTelGenericSparsePixel > > sparseCluster ( new EUTelSparseClusterImpl<EUTelGenericSparsePixel>( zsCluster.get() ) );
-
-				//First we need to take any pixel, so let's take the first one
-				//Add it to the cluster as well as the newly added pixels
-				newlyAdded.push_back( hitPixelVec.front() );
-				sparseCluster->addSparsePixel( &(hitPixelVec.front()) );
-				//And remove it from the original collection
-				hitPixelVec.erase( hitPixelVec.begin() );
-
-				//Now process all newly added pixels, initially this is the just previously added one
-				//but in the process of neighbour finding we continue to add new pixels
-				while( !newlyAdded.empty() )
-				{
-					bool newlyDone = true;
-					int  x1, x2, y1, y2, dX, dY;
-
-					//check against all pixels in the hitPixelVec
-					for( std::vector<EUTelGenericSparsePixel>::iterator hitVec = hitPixelVec.begin(); hitVec != hitPixelVec.end(); ++hitVec )
-					{
-						//get the relevant infos from the newly added pixel
-						x1 = newlyAdded.front().getXCoord();
-						y1 = newlyAdded.front().getYCoord();
-
-						//and the pixel we test against
-						x2 = hitVec->getXCoord();
-						y2 = hitVec->getYCoord();
-
-						dX = x1 - x2;
-						dY = y1 - y2;
-						int distance = dX*dX+dY*dY;
-						//if they pass the spatial and temporal cuts, we add them
-						if( distance <= _sparseMinDistanceSquared )
-						{
-							//add them to the cluster as well as to the newly added ones
-							newlyAdded.push_back( *hitVec );
-							sparseCluster->addSparsePixel( &(*hitVec) );
-							//and remove it from the original collection
-							hitPixelVec.erase( hitVec );
-							//for the pixel we test there might be other neighbours, we still have to check
-							newlyDone = false;
-							break;
-						}
-					}
-
-					//if no neighbours are found, we can delete the pixel from the newly added
-					//we tested against _ALL_ non cluster pixels, there are no other pixels
-					//which could be neighbours
-					if(newlyDone) newlyAdded.erase( newlyAdded.begin() );
-				}
-				
-				//Now we need to process the found cluster
-				if (  sparseCluster->size() > 0 )
-				{
-					// set the ID for this zsCluster
-					idZSClusterEncoder["sensorID"] = sensorID;
-					idZSClusterEncoder["sparsePixelType"] = static_cast<int>( type );
-					idZSClusterEncoder["quality"] = 0;
-					idZSClusterEncoder.setCellID( zsCluster.get() );
-
-					// add it to the cluster collection
-					sparseClusterCollectionVec->push_back( zsCluster.get() );
-
-					// prepare a pulse for this cluster
-					std::auto_ptr<TrackerPulseImpl> zsPulse ( new TrackerPulseImpl );
-					idZSPulseEncoder["sensorID"] = sensorID;
-					idZSPulseEncoder["type"] = static_cast<int>(kEUTelSparseClusterImpl);
-					idZSPulseEncoder.setCellID( zsPulse.get() );
-
-					//zsPulse->setCharge( sparseCluster->getTotalCharge() );
-					zsPulse->setTrackerData( zsCluster.release() );
-					pulseCollection->push_back( zsPulse.release() );
-
-					// last but not least increment the totClusterMap
-					_totClusterMap[ sensorID ] += 1;
-				} //cluster processing if
-
-				else
-				{
-					//in the case the cluster candidate is not passing the threshold ...
-					//forget about them, the memory should be automatically cleaned by std::auto_ptr's
-				}
-			} //loop over all found clusters
-
-			delete pixel;
-		}
-		else
-		{
-		     throw UnknownDataTypeException("Unknown sparsified pixel");
-		}
+			// add it to the cluster collection
+			sparseClusterCollectionVec->push_back( zsCluster.get() );
+
+			// prepare a pulse for this cluster
+			std::auto_ptr<TrackerPulseImpl> zsPulse ( new TrackerPulseImpl );
+			idZSPulseEncoder["sensorID"] = sensorID;
+			idZSPulseEncoder["type"] = static_cast<int>(kEUTelSparseClusterImpl);
+			idZSPulseEncoder.setCellID( zsPulse.get() );
+
+			//zsPulse->setCharge( sparseCluster->getTotalCharge() );
+			zsPulse->setTrackerData( zsCluster.release() );
+			pulseCollection->push_back( zsPulse.release() );
+
+			// last but not least increment the totClusterMap
+			_totClusterMap[ sensorID ] += 1;
+		} //loop over all found clusters
 	} // this is the end of the loop over all ZS detectors
 
 	// if the sparseClusterCollectionVec isn't empty add it to the
@@ -466,6 +439,7 @@ void EUTelProcessorSparseClustering::check (LCEvent * /* evt */) {
 }
 
 void EUTelProcessorSparseClustering::end() {
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
 	
 	streamlog_out ( MESSAGE4 ) <<  "Successfully finished" << std::endl;
   
@@ -5,6 +5,7 @@
  * 3) Now pass the track from this processor to EUTelTrackAnalysis via a function as shown in processEvent below.
  * 4)You now have the trackand histogram. Do the analysis and output to that histogram or anyone oyu want.   */
 #include "EUTelProcessorTrackAnalysis.h"
+#include "EUTelProcessorMonitor.h"
 
 using namespace eutelescope;
 
@@ -21,6 +22,7 @@ Processor("EUTelProcessorTrackAnalysis"){
 
 
 void EUTelProcessorTrackAnalysis::init(){
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
 	try{
 		initialiseResidualVsPositionHistograms();
 		//Some initialised in the constructor in part 2.
@@ -40,6 +42,7 @@ void EUTelProcessorTrackAnalysis::init(){
 }
 
 void EUTelProcessorTrackAnalysis::processEvent(LCEvent * evt){
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 	try{
 		EUTelEventImpl * event = static_cast<EUTelEventImpl*> (evt); ///We change the class so we can use EUTelescope functions
 
@@ -53,7 +56,7 @@ void EUTelProcessorTrackAnalysis::processEvent(LCEvent * evt){
         EUTelReaderGenericLCIO reader = EUTelReaderGenericLCIO();
         std::vector<EUTelTrack> tracks = reader.getTracks(evt, _trackInputCollectionName);
         for (size_t iTrack = 0; iTrack < tracks.size(); ++iTrack){
-            EUTelTrack track = tracks.at(iTrack); 
+            const EUTelTrack& track = tracks.at(iTrack); 
             _analysis->plotResidualVsPosition(track);	
             _analysis->plotIncidenceAngles(track);
             if(track.getChi2()/track.getNdf() < 5.0){
@@ -73,7 +76,9 @@ void EUTelProcessorTrackAnalysis::processEvent(LCEvent * evt){
 	
 }
 
-void EUTelProcessorTrackAnalysis::end(){}
+void EUTelProcessorTrackAnalysis::end(){
+	EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
+}
 
 void	EUTelProcessorTrackAnalysis::initialiseResidualVsPositionHistograms(){
 	int NBinX;
@@ -19,6 +19,7 @@
 #include "EUTelRawDataSparsifier.h"
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelEventImpl.h"
+#include "EUTelCalibrationKernel.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -34,13 +35,28 @@
 // system includes <>
 #include <vector>
 #include <memory>
+#include <limits>
 
 using namespace std;
 using namespace lcio;
 using namespace marlin;
 using namespace eutelescope;
 
-EUTelRawDataSparsifier::EUTelRawDataSparsifier () :Processor("EUTelRawDataSparsifier") {
+EUTelRawDataSparsifier::EUTelRawDataSparsifier () :
+  Processor("EUTelRawDataSparsifier"),
+  _rawDataCollectionName(),
+  _pedestalCollectionName(),
+  _noiseCollectionName(),
+  _statusCollectionName(),
+  _sparsifiedDataCollectionName(),
+  _pixelType(0),
+  _sigmaCutVec(),
+  _iRun(0),
+  _iEvt(0),
+  _noOfDetector(0),
+  _thresholdVec(),
+  _hitIndex(),
+  _hitSignal() {
 
   // modify processor description
   _description =
@@ -99,6 +115,9 @@ void EUTelRawDataSparsifier::processRunHeader (LCRunHeader * rdr) {
   // increment the run counter
   ++_iRun;
 
+  // the conditions may change with the run
+  _thresholdVec.clear();
+
 }
 
 
@@ -129,8 +148,8 @@ void EUTelRawDataSparsifier::processEvent (LCEvent * event) {
 
       // let's check if the number of sigma cut components is the same of
       // the detector number.
+      _noOfDetector = inputCollectionVec->getNumberOfElements();
       if ( (inputCollectionVec->getNumberOfElements() != pedestalCollectionVec->getNumberOfElements()) ) {
-        _noOfDetector = inputCollectionVec->getNumberOfElements();
 
         stringstream ss;
         ss << "Input data and pedestal are incompatible" << endl
@@ -191,41 +210,46 @@ void EUTelRawDataSparsifier::processEvent (LCEvent * event) {
 
       EUTelMatrixDecoder matrixDecoder(cellDecoder, rawData);
 
-      ShortVec::const_iterator rawIter     = rawData->getADCValues().begin();
-      FloatVec::const_iterator pedIter     = pedestal->getChargeValues().begin();
-      FloatVec::const_iterator noiseIter   = noise->getChargeValues().begin();
-      ShortVec::const_iterator statusIter  = status->getADCValues().begin();
-      int iPixel = 0;
+      if ( _pixelType == kEUTelGenericSparsePixel ) {
 
-      // there was a bug here in a previous version because we were
-      // looking for
-      //
-      // float sigmaCut = _sigmaCutVec[sensorID];
-      //
-      // instead of
-      float sigmaCut = _sigmaCutVec[ iDetector ];
+        const ShortVec & adcValues = rawData->getADCValues();
+        const FloatVec & pedValues = pedestal->getChargeValues();
+        const std::vector< float > & threshold = getThreshold( iDetector, noise, status );
+        size_t nPixel = adcValues.size();
 
-      if ( _pixelType == kEUTelGenericSparsePixel ) {
+        if ( pedValues.size() != nPixel || threshold.size() != nPixel ) {
+          stringstream ss;
+          ss << "Input data and condition data are incompatible" << endl
+             << "Detector " << iDetector << " has " << nPixel << " pixels in the input data " << endl
+             << "while " << pedValues.size() << " in the pedestal and " << threshold.size() << " in the noise" << endl;
+          throw IncompatibleDataSetException(ss.str());
+        }
+
+        if ( _hitIndex.size() < nPixel ) {
+          _hitIndex.resize( nPixel );
+          _hitSignal.resize( nPixel );
+        }
+
+        size_t nHit = 0;
+        if ( nPixel != 0 ) {
+          nHit = CalibrationKernel::sparsify( &adcValues[0], &pedValues[0], &threshold[0], nPixel,
+                                              &_hitIndex[0], &_hitSignal[0] );
+        }
 
-        EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel>  sparseData( sparsified ) ;
-        while ( rawIter != rawData->getADCValues().end() ) {
-          if (  (*statusIter) == EUTELESCOPE::GOODPIXEL ) {
-            float data      = (*rawIter) - (*pedIter);
-            float threshold = sigmaCut * (*noiseIter);
-            if ( data > threshold  ) {
-              auto_ptr<EUTelGenericSparsePixel> sparsePixel( new EUTelGenericSparsePixel );
-              sparsePixel->setXCoord( matrixDecoder.getXFromIndex(iPixel) );
-              sparsePixel->setYCoord( matrixDecoder.getYFromIndex(iPixel) );
-              sparsePixel->setSignal( static_cast<short> ( data ) );
-              streamlog_out ( DEBUG0 ) << (*sparsePixel.get()) << endl;
-              sparseData.addSparsePixel( sparsePixel.get() );
-            }
-          }
-          ++rawIter;
-          ++pedIter;
-          ++noiseIter;
-          ++statusIter;
-          ++iPixel;
+        // the pixels are written straight in the charge vector, with
+        // the same layout EUTelTrackerDataInterfacerImpl uses for the
+        // EUTelGenericSparsePixel: x, y, signal and time.
+        const size_t nElement = 4;
+        FloatVec & chargeValues = sparsified->chargeValues();
+        chargeValues.resize( nHit * nElement );
+        for ( size_t iHit = 0; iHit < nHit; ++iHit ) {
+          float * pixel = &chargeValues[ iHit * nElement ];
+          pixel[0] = static_cast<float> ( matrixDecoder.getXFromIndex( _hitIndex[iHit] ) );
+          pixel[1] = static_cast<float> ( matrixDecoder.getYFromIndex( _hitIndex[iHit] ) );
+          pixel[2] = static_cast<float> ( static_cast<short> ( _hitSignal[iHit] ) );
+          pixel[3] = 0.;
+          streamlog_out ( DEBUG0 ) << EUTelGenericSparsePixel( static_cast<short> ( pixel[0] ), static_cast<short> ( pixel[1] ),
+                                                               pixel[2], 0 ) << endl;
         }
 
       } else if ( _pixelType == kUnknownPixelType ) {
@@ -245,6 +269,42 @@ void EUTelRawDataSparsifier::processEvent (LCEvent * event) {
 
 
 
+const std::vector< float > & EUTelRawDataSparsifier::getThreshold( size_t iDetector, const TrackerDataImpl * noise,
+                                                                    const TrackerRawDataImpl * status ) {
+
+  if ( _thresholdVec.size() <= iDetector ) _thresholdVec.resize( iDetector + 1 );
+
+  std::vector< float > & threshold = _thresholdVec[ iDetector ];
+
+  const FloatVec & noiseValues  = noise->getChargeValues();
+  const ShortVec & statusValues = status->getADCValues();
+  if ( noiseValues.size() != statusValues.size() ) {
+    stringstream ss;
+    ss << "Noise and status are incompatible" << endl
+       << "Detector " << iDetector << " has " << noiseValues.size() << " pixels in the noise " << endl
+       << "while " << statusValues.size() << " in the status " << endl;
+    throw IncompatibleDataSetException(ss.str());
+  }
+
+  // there was a bug here in a previous version because we were
+  // looking for
+  //
+  // float sigmaCut = _sigmaCutVec[sensorID];
+  //
+  // instead of
+  float sigmaCut = _sigmaCutVec[ iDetector ];
+  threshold.resize( noiseValues.size() );
+  for ( size_t iPixel = 0; iPixel < noiseValues.size(); ++iPixel ) {
+    if ( statusValues[ iPixel ] == EUTELESCOPE::GOODPIXEL ) {
+      threshold[ iPixel ] = sigmaCut * noiseValues[ iPixel ];
+    } else {
+      threshold[ iPixel ] = numeric_limits< float >::infinity();
+    }
+  }
+
+  return threshold;
+}
+
 void EUTelRawDataSparsifier::check (LCEvent * /* evt */ ) {
   // nothing to check here - could be used to fill check plots in reconstruction processor
 }
@@ -3,7 +3,7 @@ using namespace eutelescope;
 
 EUTelReaderGenericLCIO::EUTelReaderGenericLCIO(){
 } 
-void EUTelReaderGenericLCIO::getColVec(std::vector<EUTelTrack> tracks,LCEvent* evt ,std::string colName ){
+void EUTelReaderGenericLCIO::getColVec(const std::vector<EUTelTrack>& tracks,LCEvent* evt ,std::string colName ){
     streamlog_out(DEBUG1)<<"CREATE GENERIC CONTAINER..." <<std::endl;
 
     LCCollectionVec* colTrackVec = new LCCollectionVec(LCIO::LCGENERICOBJECT);
@@ -11,34 +11,38 @@ void EUTelReaderGenericLCIO::getColVec(std::vector<EUTelTrack> tracks,LCEvent* e
     LCCollectionVec* colHitVec = new LCCollectionVec(LCIO::LCGENERICOBJECT);
     LCCollectionVec* relTrackStateVec = new LCCollectionVec(LCIO::LCRELATION);
     LCCollectionVec* relStateHitVec = new LCCollectionVec(LCIO::LCRELATION);
-
+    //One buffer for all the LCIO representations of the event
+    std::vector<double> output;
 
     for(size_t i=0 ; i < tracks.size(); i++){
         IMPL::LCGenericObjectImpl* conTrack = new  IMPL::LCGenericObjectImpl();  
         //Save everything as double and down cast later.
-        for(size_t j=0; j < tracks.at(i).getLCIOOutput().size(); j++){
-            streamlog_out(DEBUG1)<<"Fill number: " << j << " Value " << tracks.at(i).getLCIOOutput().at(j) <<std::endl;
-            conTrack->setDoubleVal (j, tracks.at(i).getLCIOOutput().at(j));
+        tracks.at(i).getLCIOOutput(output);
+        for(size_t j=0; j < output.size(); j++){
+            streamlog_out(DEBUG1)<<"Fill number: " << j << " Value " << output.at(j) <<std::endl;
+            conTrack->setDoubleVal (j, output.at(j));
         }
         streamlog_out(DEBUG1)<<"Fill all track information...        Double number: "<< conTrack->getNDouble()  <<std::endl;
         colTrackVec->push_back(static_cast<EVENT::LCGenericObject*>(conTrack));
         streamlog_out(DEBUG1)<<"Tracks filled" <<std::endl;
-        std::vector<EUTelState> states = tracks.at(i).getStates();
+        const std::vector<EUTelState>& states = tracks.at(i).getStates();
         for(size_t j=0 ; j < states.size(); j++){
             streamlog_out(DEBUG1)<<"Fill all state information " << " state location " << states.at(j).getLocation() <<std::endl;
             IMPL::LCGenericObjectImpl* conState = new  IMPL::LCGenericObjectImpl();  
             streamlog_out(DEBUG1)<<"Empty state container created" <<std::endl;
-            for(size_t k=0 ; k < states.at(j).getLCIOOutput().size(); k++){
-                streamlog_out(DEBUG1)<<"Fill number: " << k << " Value " << tracks.at(i).getStates().at(j).getLCIOOutput().at(k) <<std::endl;
-                conState->setDoubleVal (k,states.at(j).getLCIOOutput().at(k));
+            states.at(j).getLCIOOutput(output);
+            for(size_t k=0 ; k < output.size(); k++){
+                streamlog_out(DEBUG1)<<"Fill number: " << k << " Value " << output.at(k) <<std::endl;
+                conState->setDoubleVal (k,output.at(k));
             }
             IMPL::LCRelationImpl *relTrackState = new IMPL::LCRelationImpl(conTrack,conState); 
             colStateVec->push_back(static_cast<EVENT::LCGenericObject*>(conState));
             relTrackStateVec->push_back(static_cast<EVENT::LCRelation*>(relTrackState));
             if(states.at(j).getStateHasHit()){
                 IMPL::LCGenericObjectImpl* conHit = new  IMPL::LCGenericObjectImpl();  
-                for(size_t k=0 ; k < states.at(j).getHit().getLCIOOutput().size(); k++){
-                    conHit->setDoubleVal (k, states.at(j).getHit().getLCIOOutput().at(k));
+                states.at(j).getHit().getLCIOOutput(output);
+                for(size_t k=0 ; k < output.size(); k++){
+                    conHit->setDoubleVal (k, output.at(k));
                 }
                 IMPL::LCRelationImpl *relStateHit = new IMPL::LCRelationImpl(conState,conHit); 
                 colHitVec->push_back(static_cast<EVENT::LCGenericObject*>(conHit));
@@ -66,6 +70,10 @@ std::vector<EUTelTrack> EUTelReaderGenericLCIO::getTracks( LCEvent* evt, std::st
     streamlog_out(DEBUG1)<<"Open!" <<std::endl;
 
     std::vector<int> trackIDVec;
+    //Buffers for the LCIO representations, reused for all the objects
+    std::vector<double> trackInput;
+    std::vector<double> stateInput;
+    std::vector<double> hitInput;
     //Loop a link between tracks->states. //Remember multiple tracks for each collection 
     for (int iCol = 0; iCol < relTrackStates->getNumberOfElements(); iCol++) {//Loop through each track->state link
         EVENT::LCRelation* relTrackState = static_cast<EVENT::LCRelation*>(relTrackStates->getElementAt(iCol));
@@ -74,11 +82,13 @@ std::vector<EUTelTrack> EUTelReaderGenericLCIO::getTracks( LCEvent* evt, std::st
         if(std::find(trackIDVec.begin(), trackIDVec.end(), trackID) == trackIDVec.end()){//This is a list of tracks already created
             //If track is new enter here.
             trackIDVec.push_back(trackID);
-            std::vector<double> trackInput;
+            trackInput.clear();
             for(int i =0 ; i < track->getNDouble(); i++){
                 trackInput.push_back(track->getDoubleVal(i)); 
             }
-            EUTelTrack track;
+            //The track is filled in place in the output vector
+            tracks.push_back(EUTelTrack());
+            EUTelTrack& track = tracks.back();
             track.setTrackFromLCIOVec(trackInput);
             for (int jCol = 0; jCol < relTrackStates->getNumberOfElements(); jCol++) {//Loop through track->state look for state linked to that track
                 EVENT::LCRelation* relTrackState = static_cast<EVENT::LCRelation*>(relTrackStates->getElementAt(jCol));
@@ -86,7 +96,7 @@ std::vector<EUTelTrack> EUTelReaderGenericLCIO::getTracks( LCEvent* evt, std::st
                 EVENT::LCGenericObject* trackCheck  =  static_cast<EVENT::LCGenericObject*>(relTrackState->getFrom());
                 if(trackCheck->id() == trackID){//If this is true then the state must be part of this track.
                     int stateID = state->id();
-                    std::vector<double> stateInput;
+                    stateInput.clear();
                     for(int i =0 ; i < state->getNDouble(); i++){
                         stateInput.push_back(state->getDoubleVal(i)); 
                     }
@@ -98,7 +108,7 @@ std::vector<EUTelTrack> EUTelReaderGenericLCIO::getTracks( LCEvent* evt, std::st
                         EVENT::LCGenericObject* hit  =  static_cast<EVENT::LCGenericObject*>(relStateHit->getTo());
                         if(stateCheck->id() == stateID){//If this is true then you have the correct hit.
                             streamlog_out(DEBUG1)<<"Found correct ID. Add hit now..." <<std::endl;
-                            std::vector<double> hitInput;
+                            hitInput.clear();
                             for(int i =0 ; i < hit->getNDouble(); i++){
                                 hitInput.push_back(hit->getDoubleVal(i)); 
                             }
@@ -112,7 +122,6 @@ std::vector<EUTelTrack> EUTelReaderGenericLCIO::getTracks( LCEvent* evt, std::st
                     track.setState(state);
                 }
             }
-            tracks.push_back(track);
         }
     }
     streamlog_out(DEBUG1)<<"Return "<< tracks.size() <<" tracks" <<std::endl;
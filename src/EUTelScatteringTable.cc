@@ -0,0 +1,97 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelScatteringTable.h"
+#include "EUTelUtility.h"
+
+// marlin includes ".h"
+#include "streamlog/streamlog.h"
+
+// system includes <>
+#include <cmath>
+
+using namespace std;
+using namespace eutelescope;
+
+EUTelScatteringTable::EUTelScatteringTable( double maxSlope, int nSlopeBins ) :
+  _maxSlope( maxSlope ),
+  _nSlopeBins( nSlopeBins > 0 ? nSlopeBins : 1 ),
+  _momentum( 0. ),
+  _nPlanes( 0 ),
+  _planeIndex(),
+  _totalVariance(),
+  _sensorVariance(),
+  _airVariance()
+{}
+
+void EUTelScatteringTable::build( double momentum, const std::map< const int, double > & mapSensor,
+                                  const std::map< const int, double > & mapAir, double rad ) {
+
+  clear();
+  if ( rad <= 0. || momentum <= 0. ) return;
+
+  // the planes in the order of mapSensor, the air comes with the plane behind it
+  for ( map< const int, double >::const_iterator it = mapSensor.begin(); it != mapSensor.end(); ++it ) {
+    _planeIndex[ it->first ] = _nPlanes++;
+  }
+
+  _momentum = momentum;
+  _totalVariance.resize( _nSlopeBins );
+  _sensorVariance.resize( _nSlopeBins * _nPlanes, 0. );
+  _airVariance.resize( _nSlopeBins * _nPlanes, 0. );
+
+  const double binWidth = _maxSlope / _nSlopeBins;
+  for ( int iBin = 0; iBin < _nSlopeBins; ++iBin ) {
+
+    // the whole path is longer by the same factor for all the planes,
+    // so that only the total variance changes with the incidence
+    const double slope = ( iBin + 0.5 ) * binWidth;
+    const double theta = Utility::getThetaRMSHighland( momentum, rad * sqrt( 1. + slope * slope ) );
+    const double variance = theta * theta;
+    _totalVariance[ iBin ] = variance;
+
+    for ( map< const int, double >::const_iterator it = mapSensor.begin(); it != mapSensor.end(); ++it ) {
+      const int plane = _planeIndex[ it->first ];
+      _sensorVariance[ iBin * _nPlanes + plane ] = ( it->second / rad ) * variance;
+      map< const int, double >::const_iterator air = mapAir.find( it->first );
+      if ( air != mapAir.end() ) _airVariance[ iBin * _nPlanes + plane ] = ( air->second / rad ) * variance;
+    }
+  }
+
+  streamlog_out( DEBUG5 ) << "Scattering table for p = " << momentum << " GeV, X/X0 = " << rad << ": "
+                          << _nPlanes << " planes, " << _nSlopeBins << " slope bins up to " << _maxSlope
+                          << ", variance at normal incidence " << _totalVariance[0] << endl;
+}
+
+void EUTelScatteringTable::clear() {
+  _momentum = 0.;
+  _nPlanes = 0;
+  _planeIndex.clear();
+  _totalVariance.clear();
+  _sensorVariance.clear();
+  _airVariance.clear();
+}
+
+bool EUTelScatteringTable::isBuiltFor( double momentum ) const {
+  return isBuilt() && fabs( momentum - _momentum ) <= 1e-6 * _momentum;
+}
+
+int EUTelScatteringTable::getSlopeBin( double slopeX, double slopeY ) const {
+  const double slope = sqrt( slopeX * slopeX + slopeY * slopeY );
+  // also catches a NaN slope
+  if ( !( slope < _maxSlope ) ) return _nSlopeBins - 1;
+  const int bin = static_cast< int >( slope / _maxSlope * _nSlopeBins );
+  return bin < _nSlopeBins ? bin : _nSlopeBins - 1;
+}
+
+int EUTelScatteringTable::getPlaneIndex( int sensorID ) const {
+  map< int, int >::const_iterator it = _planeIndex.find( sensorID );
+  return it != _planeIndex.end() ? it->second : -1;
+}
@@ -4,13 +4,10 @@
 using namespace eutelescope;
 EUTelState::EUTelState()
 {
-     _kinks.ResizeTo(2);
     _kinks[0]=0;
     _kinks[1]=0;
-    _kinksMedium1.ResizeTo(2);
     _kinksMedium1[0]=0;
     _kinksMedium1[1]=0;
-    _kinksMedium2.ResizeTo(2);
     _kinksMedium2[0]=0;
     _kinksMedium2[1]=0;
 
@@ -19,12 +16,12 @@ EUTelState::EUTelState()
 } 
 
 EUTelState::EUTelState(EUTelState *state){
-     _kinks.ResizeTo(2);
-     _kinks = state->getKinks();
-    _kinksMedium1.ResizeTo(2);
-    _kinksMedium1 = state->getKinksMedium1();
-    _kinksMedium2.ResizeTo(2);
-    _kinksMedium2 = state->getKinksMedium2();
+    _kinks[0] = state->getKinks()[0];
+    _kinks[1] = state->getKinks()[1];
+    _kinksMedium1[0] = state->getKinksMedium1()[0];
+    _kinksMedium1[1] = state->getKinksMedium1()[1];
+    _kinksMedium2[0] = state->getKinksMedium2()[0];
+    _kinksMedium2[1] = state->getKinksMedium2()[1];
     _stateHasHit = false;
 	setDimensionSize(state->getDimensionSize());
     setArcLengthToNextState(state->getArcLengthToNextState());
@@ -48,7 +45,7 @@ double EUTelState::getRadFracSensor() const {
     return _radFracSensor;
 }
 
-EUTelHit EUTelState::getHit(){
+const EUTelHit& EUTelState::getHit() const {
 	return _hit;
 }
 int EUTelState::getDimensionSize() const {
@@ -68,7 +65,7 @@ TVector3 EUTelState::getPositionGlobal() const {
 	TVector3 posGlobalVec(posGlobal[0],posGlobal[1],posGlobal[2]);
 	return posGlobalVec;
 }
-TVectorD EUTelState::getStateVec(){ 
+TVectorD EUTelState::getStateVec() const { 
 	streamlog_out( DEBUG1 ) << "EUTelState::getTrackStateVec()------------------------BEGIN" << std::endl;
 	TVectorD stateVec(5);
 	stateVec[0] = -1.0/getMomLocal().Mag();
@@ -84,52 +81,44 @@ TVectorD EUTelState::getStateVec(){
 	streamlog_out( DEBUG1 ) << "EUTelState::getTrackStateVec()------------------------END" << std::endl;
  	return stateVec;
 }
-TMatrixDSym EUTelState::getScatteringVarianceInLocalFrame(){
+void EUTelState::getScatteringVarianceInLocalFrame(TMatrixDSym& precisionMatrix) const {
 	streamlog_out( DEBUG1 ) << "EUTelState::getScatteringVarianceInLocalFrame(Sensor)----------------------------BEGIN" << std::endl;
 	streamlog_out(DEBUG1) << "Variance (Sensor):  " << std::scientific << getRadFracSensor() << "  Plane: " << getLocation()  << std::endl;
 	if(getRadFracSensor() == 0){
 		throw(std::string("Radiation of sensor is zero. Something is wrong with radiation length calculation."));
 	}
-	float scatPrecision = 1.0/getRadFracSensor();
-	//We need the track direction in the direction of x/y in the local frame. 
-	//This will be the same as unitMomentum in the x/y direction
-	TVector3 unitMomentumLocalFrame =	getMomLocal().Unit();
-	//c1 and c2 come from Claus's paper GBL
-	float c1 = 	unitMomentumLocalFrame[0]; float c2 =	unitMomentumLocalFrame[1];
-	streamlog_out( DEBUG1 ) << "The component in the x/y direction: "<< c1 <<"  "<<c2 << std::endl;
-	TMatrixDSym precisionMatrix(2);
-	float factor = scatPrecision/pow((1-pow(c1,2)-pow(c2,2)),2);
-	streamlog_out( DEBUG1 ) << "The factor: "<< factor << std::endl;
-	precisionMatrix[0][0]=factor*(1-pow(c2,2));
-  precisionMatrix[1][0]=factor*c1*c2;				precisionMatrix[1][1]=factor*(1-pow(c1,2));
+	fillScatteringPrecision(1.0/getRadFracSensor(), precisionMatrix);
 	streamlog_out( DEBUG1 ) << "EUTelState::getScatteringVarianceInLocalFrame(Sensor)----------------------------END" << std::endl;
-	return precisionMatrix;
 }
-TMatrixDSym EUTelState::getScatteringVarianceInLocalFrame(float  variance){
+void EUTelState::getScatteringVarianceInLocalFrame(float  variance, TMatrixDSym& precisionMatrix) const {
 	streamlog_out( DEBUG1 ) << "EUTelState::getScatteringVarianceInLocalFrame(Scatter)----------------------------BEGIN" << std::endl;
 	streamlog_out(DEBUG5)<<"Variance (AIR Fraction): " <<std::scientific  <<  variance <<std::endl; 
-	float scatPrecision = 1.0 /variance;
+	fillScatteringPrecision(1.0/variance, precisionMatrix);
+	streamlog_out( DEBUG1 ) << "EUTelState::getScatteringVarianceInLocalFrame(Scatter)----------------------------END" << std::endl;
+}
+void EUTelState::fillScatteringPrecision(float scatPrecision, TMatrixDSym& precisionMatrix) const {
 	//We need the track direction in the direction of x/y in the local frame. 
 	//This will be the same as unitMomentum in the x/y direction
 	TVector3 unitMomentumLocalFrame =	getMomLocal().Unit();
 	//c1 and c2 come from Claus's paper GBL
-	float c1 = 	unitMomentumLocalFrame[0]; float c2 = 	unitMomentumLocalFrame[1];
+	float c1 = 	unitMomentumLocalFrame[0]; float c2 =	unitMomentumLocalFrame[1];
 	streamlog_out( DEBUG1 ) << "The component in the x/y direction: "<< c1 <<"  "<<c2 << std::endl;
-	TMatrixDSym precisionMatrix(2);
+	//A 2x2 matrix lives in the ROOT matrix itself, no allocation
+	if(precisionMatrix.GetNrows() != 2){
+		precisionMatrix.ResizeTo(2,2);
+	}
+	precisionMatrix.Zero();
 	float factor = scatPrecision/pow((1-pow(c1,2)-pow(c2,2)),2);
 	streamlog_out( DEBUG1 ) << "The factor: "<< factor << std::endl;
 	precisionMatrix[0][0]=factor*(1-pow(c2,2));
   precisionMatrix[1][0]=factor*c1*c2;				precisionMatrix[1][1]=factor*(1-pow(c1,2));
-	streamlog_out( DEBUG1 ) << "EUTelState::getScatteringVarianceInLocalFrame(Scatter)----------------------------END" << std::endl;
-
-	return precisionMatrix;
 }
-TMatrixDSym EUTelState::getStateCov() const {
+const TMatrixDSym& EUTelState::getStateCov() const {
 
 //	streamlog_out( DEBUG1 ) << "EUTelState::getTrackStateCov()----------------------------BEGIN" << std::endl;
-	TMatrixDSym C(5);   
+	//The covariance is not filled yet: the same zero matrix for all the states
+	static const TMatrixDSym C(5);   
 //	const EVENT::FloatVec& trkCov = getCovMatrix();        
-	C.Zero();
             
 //	C[0][0] = trkCov[0]; 
 //	C[1][0] = trkCov[1];  C[1][1] = trkCov[2]; 
@@ -155,31 +144,28 @@ void EUTelState::getCombinedHitAndStateCovMatrixInLocalFrame( double (&cov)[4] )
 	cov[2] = _covCombinedMatrix[2];
 	cov[3] = _covCombinedMatrix[3];
 }
-TMatrixD EUTelState::getProjectionMatrix() const {
-	TMatrixD projection(5,5);
-	projection.Zero();
-	TMatrixD proM2l(2, 2);
-	proM2l.UnitMatrix();
-	projection.SetSub(3, 3, proM2l);
+//The measurements are the local x and y: the same unit matrix for all the states
+const TMatrixD& EUTelState::getProjectionMatrix() const {
+	static const TMatrixD proM2l(TMatrixD::kUnit, TMatrixD(2, 2));
 	return proM2l;
 }
-TVector3 EUTelState::getMomLocal(){
+TVector3 EUTelState::getMomLocal() const {
 	TVector3 pVecUnitLocal;
 	pVecUnitLocal[0] = getMomLocalX(); 	pVecUnitLocal[1] = getMomLocalY(); 	pVecUnitLocal[2] = getMomLocalZ(); 
 	return pVecUnitLocal;
 }
-TVectorD EUTelState::getKinks() const {
-	return _kinks;
+const double* EUTelState::getKinks() const {
+	return &_kinks[0];
 }
-TVectorD EUTelState::getKinksMedium1() const {
-	return _kinksMedium1;
+const double* EUTelState::getKinksMedium1() const {
+	return &_kinksMedium1[0];
 }
-TVectorD EUTelState::getKinksMedium2() const {
-	return _kinksMedium2;
+const double* EUTelState::getKinksMedium2() const {
+	return &_kinksMedium2[0];
 }
 
 //setters
-void EUTelState::setHit(EUTelHit hit){
+void EUTelState::setHit(const EUTelHit& hit){
     _stateHasHit=true;
     _hit = hit;
 }
@@ -211,14 +197,17 @@ void EUTelState::setMomLocalZ(float momZ){
 }
 //This variable is the RESIDUAL (Measurements - Prediction) of the kink angle. 
 //Our measurement is assumed 0 in all cases.
-void EUTelState::setKinks(TVectorD kinks){
-    _kinks = kinks;
+void EUTelState::setKinks(const TVectorD& kinks){
+    _kinks[0] = kinks[0];
+    _kinks[1] = kinks[1];
 }
-void EUTelState::setKinksMedium1(TVectorD kinks){
-    _kinksMedium1 = kinks;
+void EUTelState::setKinksMedium1(const TVectorD& kinks){
+    _kinksMedium1[0] = kinks[0];
+    _kinksMedium1[1] = kinks[1];
 }
-void EUTelState::setKinksMedium2(TVectorD kinks){
-    _kinksMedium2 = kinks;
+void EUTelState::setKinksMedium2(const TVectorD& kinks){
+    _kinksMedium2[0] = kinks[0];
+    _kinksMedium2[1] = kinks[1];
 }
 
 void EUTelState::setPositionGlobal(float positionGlobal[]){
@@ -232,7 +221,7 @@ void EUTelState::setPositionGlobal(float positionGlobal[]){
 
 
 }
-void EUTelState::setLocalMomentumGlobalMomentum(TVector3 momentumIn){
+void EUTelState::setLocalMomentumGlobalMomentum(const TVector3& momentumIn){
 	//Now calculate the momentum in LOCAL coordinates.
 	const double momentum[]	= {momentumIn[0], momentumIn[1],momentumIn[2]};//Need this since geometry works with const doubles not floats 
 	double localMomentum [3];
@@ -251,7 +240,7 @@ void EUTelState::setCombinedHitAndStateCovMatrixInLocalFrame(double cov[4]){
 	_covCombinedMatrix[3] = cov[3];
 }
 
-void EUTelState::setStateUsingCorrection(TVectorD corrections){
+void EUTelState::setStateUsingCorrection(const TVectorD& corrections){
 	double referencePoint[] = { getPosition()[0]+corrections[3],getPosition()[1]+corrections[4],0};
 	setPositionLocal(referencePoint);
     float charge = -1.0;
@@ -362,7 +351,7 @@ float EUTelState::computeRadLengthsToEnd( std::map<const int,double> & mapSensor
 
 
 //print
-void EUTelState::print(){
+void EUTelState::print() const {
 	streamlog_out(DEBUG1)<< std::scientific << "STATE VECTOR:" << std::endl;
 	streamlog_out(DEBUG1)<< std::scientific <<"State memory location "<< this << " The location  " <<getLocation() <<" Distance to next state: " <<getArcLengthToNextState() <<std::endl;
 	streamlog_out(DEBUG1)<< std::scientific <<"(Radiation fraction of full system)*(track Variance)    Plane: "<< getRadFracSensor() <<" Air:  " <<getRadFracAir() <<std::endl;
@@ -400,18 +389,18 @@ void EUTelState::clear(){
 }
 
 //Overload operators.
-bool EUTelState::operator<(const EUTelState compareState ) const {
+bool EUTelState::operator<(const EUTelState& compareState ) const {
 	return getPosition()[2]<compareState.getPosition()[2];
 }
 
-bool EUTelState::operator==(const EUTelState compareState ) const {
+bool EUTelState::operator==(const EUTelState& compareState ) const {
 	if(getLocation() == compareState.getLocation() and 	getPosition()[0] == compareState.getPosition()[0] and	getPosition()[1] == compareState.getPosition()[1] and 	getPosition()[2] == compareState.getPosition()[2]){
 		return true;
 	}else{
 		return false;
 	}
 }
-bool EUTelState::operator!=(const EUTelState compareState ) const {
+bool EUTelState::operator!=(const EUTelState& compareState ) const {
 	if(getLocation() == compareState.getLocation() and 	getPosition()[0] == compareState.getPosition()[0] and	getPosition()[1] == compareState.getPosition()[1] and 	getPosition()[2] == compareState.getPosition()[2]){
 		return false;
 	}else{
@@ -420,8 +409,13 @@ bool EUTelState::operator!=(const EUTelState compareState ) const {
 }
 
 
-std::vector<double> EUTelState::getLCIOOutput(){
+std::vector<double> EUTelState::getLCIOOutput() const {
     std::vector<double> output;
+    getLCIOOutput(output);
+    return output;
+}
+void EUTelState::getLCIOOutput(std::vector<double>& output) const {
+    output.clear();
     output.push_back(getDimensionSize());
     output.push_back(getLocation());
     output.push_back(_momLocalX);
@@ -445,11 +439,8 @@ std::vector<double> EUTelState::getLCIOOutput(){
     output.push_back(getKinksMedium1()[1]);
     output.push_back(getKinksMedium2()[0]);
     output.push_back(getKinksMedium2()[1]);
-
-    return output;
-
 }
-void EUTelState::setTrackFromLCIOVec(std::vector<double> input){
+void EUTelState::setTrackFromLCIOVec(const std::vector<double>& input){
     setDimensionSize(input.at(0));
     setLocation(input.at(1));
     setMomLocalX(input.at(2));
@@ -458,18 +449,12 @@ void EUTelState::setTrackFromLCIOVec(std::vector<double> input){
     setArcLengthToNextState(input.at(5)); 
     double pos[3] = {input.at(6),input.at(7),input.at(8)};
     setPositionLocal(pos);
-    TVectorD kinks(2);
-    kinks[0] = input.at(10);
-    kinks[1] = input.at(11);
-    setKinks(kinks);
+    _kinks[0] = input.at(10);
+    _kinks[1] = input.at(11);
     setRadFrac(input.at(13), input.at(12));
-    TVectorD kinksMedium1(2);
-    kinksMedium1[0] = input.at(14);
-    kinksMedium1[1] = input.at(15);
-    setKinksMedium1(kinksMedium1);
-    TVectorD kinksMedium2(2);
-    kinksMedium2[0] = input.at(16);
-    kinksMedium2[1] = input.at(17);
-    setKinksMedium2(kinksMedium2);
+    _kinksMedium1[0] = input.at(14);
+    _kinksMedium1[1] = input.at(15);
+    _kinksMedium2[0] = input.at(16);
+    _kinksMedium2[1] = input.at(17);
 
 }
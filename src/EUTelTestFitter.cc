@@ -13,12 +13,14 @@
 
 // eutelescope includes
 #include "EUTelTestFitter.h"
+#include "EUTelProcessorMonitor.h"
 #include "EUTELESCOPE.h"
 #include "EUTelEventImpl.h"
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelHistogramManager.h"
 #include "EUTelExceptions.h"
 #include "EUTelReferenceHit.h"
+#include "EUTelTestFitterKernel.h"
 
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
@@ -417,6 +419,7 @@ EUTelTestFitter::EUTelTestFitter()
 
 
 void EUTelTestFitter::init() {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kInit );
 
   // usually a good idea to
   printParameters() ;
@@ -876,6 +879,7 @@ void EUTelTestFitter::processRunHeader( LCRunHeader* runHeader) {
 }
 
 void EUTelTestFitter::processEvent( LCEvent * event ) {
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kProcessEvent );
 
   _nEvt ++ ;
 
@@ -2078,6 +2082,7 @@ void EUTelTestFitter::check( LCEvent * /* evt */  ) {
 
 
 void EUTelTestFitter::end(){
+  EUTelProcessorMonitor::Scope processorMonitor( this, EUTelProcessorMonitor::kEnd );
 
   if(streamlog_level(DEBUG5))
   {
@@ -2526,93 +2531,8 @@ double EUTelTestFitter::NominalFit()
 
 int EUTelTestFitter::DoAnalFit(double * pos, double *err, double slope)
 {
-  for(int ipl=0; ipl<_nTelPlanes;ipl++)
-    {
-      if(_isActive[ipl] && err[ipl]>0)
-        err[ipl]=1./err[ipl]/err[ipl] ;
-      else
-        err[ipl] = 0. ;
-
-      pos[ipl]*=err[ipl];
-    }
-
-  // To take into account beam tilt
-
-  if(_useBeamConstraint && slope!=0.)
-    {
-      pos[0] -= slope*_planeDist[0]*_planeScat[0];
-      pos[1] += slope*_planeDist[0]*_planeScat[0];
-    }
-
-
-  for(int ipl=0; ipl<_nTelPlanes;ipl++)
-  {
-    for(int jpl=0; jpl<_nTelPlanes;jpl++)
-      {
-        int imx=ipl+jpl*_nTelPlanes;
-
-      
-        _fitArray[imx] = 0.;
-
-        if(jpl==ipl-2)
-          _fitArray[imx] += _planeDist[ipl-2]*_planeDist[ipl-1]*_planeScat[ipl-1] ;
-
-        if(jpl==ipl+2)
-          _fitArray[imx] += _planeDist[ipl]*_planeDist[ipl+1]*_planeScat[ipl+1] ;
-
-        if(jpl==ipl-1)
-          {
-            if(ipl>0 &&  ipl < _nTelPlanes-1)
-              _fitArray[imx] -= _planeDist[ipl-1]*(_planeDist[ipl]+_planeDist[ipl-1])*_planeScat[ipl] ;
-            if(ipl>1)
-              _fitArray[imx] -= _planeDist[ipl-1]*(_planeDist[ipl-1]+_planeDist[ipl-2])*_planeScat[ipl-1] ;
-          }
-
-        if(jpl==ipl+1)
-          {
-            if(ipl>0 && ipl < _nTelPlanes-1)
-              _fitArray[imx] -= _planeDist[ipl]*(_planeDist[ipl]+_planeDist[ipl-1])*_planeScat[ipl] ;
-            if(ipl < _nTelPlanes-2)
-              _fitArray[imx] -= _planeDist[ipl]*(_planeDist[ipl+1]+_planeDist[ipl])*_planeScat[ipl+1] ;
-          }
-
-        if(jpl==ipl)
-          {
-            _fitArray[imx] += err[ipl] ;
-
-            if(ipl>0 && ipl<_nTelPlanes-1)
-              _fitArray[imx] += _planeScat[ipl]*(_planeDist[ipl]+_planeDist[ipl-1])*(_planeDist[ipl]+_planeDist[ipl-1]) ;
-
-            if(ipl > 1 )
-              _fitArray[imx] += _planeScat[ipl-1]*_planeDist[ipl-1]*_planeDist[ipl-1] ;
-
-            if(ipl < _nTelPlanes-2)
-              _fitArray[imx] += _planeScat[ipl+1]*_planeDist[ipl]*_planeDist[ipl] ;
-          }
-
-        // For beam constraint
-
-        if(ipl==jpl && ipl<2 && _useBeamConstraint)
-          _fitArray[imx] += _planeScat[0]*_planeDist[0]*_planeDist[0] ;
-
-        if(ipl+jpl==1 && _useBeamConstraint)
-          _fitArray[imx] -= _planeScat[0]*_planeDist[0]*_planeDist[0] ;        
-      }
-  }
-
-  int status=GaussjSolve(_fitArray,pos,_nTelPlanes) ;
-
-  if(status)
-    {
-      cerr << "Singular matrix in track fitting algorithm ! " << endl;
-      for(int ipl=0;ipl<_nTelPlanes;ipl++)
-        err[ipl]=0. ;
-    }
-  else
-    for(int ipl=0;ipl<_nTelPlanes;ipl++)
-      err[ipl]=sqrt(_fitArray[ipl+ipl*_nTelPlanes]);
-
-  return status ;
+  return TestFitterKernel::analyticFit( _nTelPlanes, _isActive, _planeDist, _planeScat, _useBeamConstraint,
+                                        _fitArray, pos, err, slope );
 }
 
 
@@ -2680,104 +2600,7 @@ double EUTelTestFitter::GetFitChi2()
 
 int EUTelTestFitter::GaussjSolve(double *alfa,double *beta,int n)
 {
-  int *ipiv;
-  int *indxr;
-  int *indxc;
-  int i,j,k;
-  int irow=0;
-  int icol=0;
-  double abs,big,help,pivinv;
-
-  ipiv = new int[n];
-  indxr = new int[n];
-  indxc = new int[n];
-
-  for(i=0;i<n;i++)ipiv[i]=0;
-
-  for(i=0;i<n;i++)
-    {
-      big=0.;
-      for(j=0;j<n;j++)
-        {
-          if(ipiv[j]==1)continue;
-          for(k=0;k<n;k++)
-            {
-              if(ipiv[k]!=0)continue;
-              abs=fabs(alfa[n*j+k]);
-              if(abs>big)
-                {
-                  big=abs;
-                  irow=j;
-                  icol=k;
-                }
-            }
-        }
-      ipiv[icol]++;
-
-      if(ipiv[icol]>1){
-	// first clean up then bail out
-	delete[] ipiv;
-	delete[] indxr;
-	delete[] indxc;
-        return 1;
-      }
-
-      if(irow!=icol)
-        {
-          help=beta[irow];
-          beta[irow]=beta[icol];
-          beta[icol]=help;
-          for(j=0;j<n;j++)
-            {
-              help=alfa[n*irow+j];
-              alfa[n*irow+j]=alfa[n*icol+j];
-              alfa[n*icol+j]=help;
-            }
-        }
-      indxr[i]=irow;
-      indxc[i]=icol;
-
-      if(alfa[n*icol+icol]==0.){
-	// first clean up then bail out
-	delete[] ipiv;
-	delete[] indxr;
-	delete[] indxc;
-        return 1;}
-
-      help=alfa[n*icol+icol];
-      pivinv=1./help;
-      alfa[n*icol+icol]=1.;
-      for(j=0;j<n;j++) alfa[n*icol+j]*=pivinv;
-
-      beta[icol]*=pivinv;
-
-      for(j=0;j<n;j++)
-        {
-          if(j==icol)continue;
-          help=alfa[n*j+icol];
-          alfa[n*j+icol]=0.;
-          for(k=0;k<n;k++)
-            alfa[n*j+k]-=alfa[n*icol+k]*help;
-          beta[j]-=beta[icol]*help;
-        }
-    }
-
-  for(i=n-1;i>=0;i--)
-    {
-      if(indxr[i]==indxc[i])continue;
-      for(j=0;j<n;j++)
-        {
-          help=alfa[n*j+indxr[i]];
-          alfa[n*j+indxr[i]]=alfa[n*j+indxc[i]];
-          alfa[n*j+indxc[i]]=help;
-        }
-    }
-
-  delete [] ipiv;
-  delete [] indxr;
-  delete [] indxc;
-
-  return 0;
+  return TestFitterKernel::gaussjSolve( alfa, beta, n );
 }
 
 void EUTelTestFitter::getFastTrackImpactPoint(double & x, double & y, double & z, Track * /* tr */, LCEvent * /* ev */) {
@@ -0,0 +1,212 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelTestFitterKernel.h"
+
+// system includes <>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+using namespace eutelescope;
+
+int TestFitterKernel::analyticFit( int nPlanes, const bool * isActive, const double * planeDist, const double * planeScat,
+                                   bool useBeamConstraint, double * fitArray, double * pos, double * err, double slope )
+{
+  for(int ipl=0; ipl<nPlanes;ipl++)
+    {
+      if(isActive[ipl] && err[ipl]>0)
+        err[ipl]=1./err[ipl]/err[ipl] ;
+      else
+        err[ipl] = 0. ;
+
+      pos[ipl]*=err[ipl];
+    }
+
+  // To take into account beam tilt
+
+  if(useBeamConstraint && slope!=0.)
+    {
+      pos[0] -= slope*planeDist[0]*planeScat[0];
+      pos[1] += slope*planeDist[0]*planeScat[0];
+    }
+
+
+  for(int ipl=0; ipl<nPlanes;ipl++)
+  {
+    for(int jpl=0; jpl<nPlanes;jpl++)
+      {
+        int imx=ipl+jpl*nPlanes;
+
+      
+        fitArray[imx] = 0.;
+
+        if(jpl==ipl-2)
+          fitArray[imx] += planeDist[ipl-2]*planeDist[ipl-1]*planeScat[ipl-1] ;
+
+        if(jpl==ipl+2)
+          fitArray[imx] += planeDist[ipl]*planeDist[ipl+1]*planeScat[ipl+1] ;
+
+        if(jpl==ipl-1)
+          {
+            if(ipl>0 &&  ipl < nPlanes-1)
+              fitArray[imx] -= planeDist[ipl-1]*(planeDist[ipl]+planeDist[ipl-1])*planeScat[ipl] ;
+            if(ipl>1)
+              fitArray[imx] -= planeDist[ipl-1]*(planeDist[ipl-1]+planeDist[ipl-2])*planeScat[ipl-1] ;
+          }
+
+        if(jpl==ipl+1)
+          {
+            if(ipl>0 && ipl < nPlanes-1)
+              fitArray[imx] -= planeDist[ipl]*(planeDist[ipl]+planeDist[ipl-1])*planeScat[ipl] ;
+            if(ipl < nPlanes-2)
+              fitArray[imx] -= planeDist[ipl]*(planeDist[ipl+1]+planeDist[ipl])*planeScat[ipl+1] ;
+          }
+
+        if(jpl==ipl)
+          {
+            fitArray[imx] += err[ipl] ;
+
+            if(ipl>0 && ipl<nPlanes-1)
+              fitArray[imx] += planeScat[ipl]*(planeDist[ipl]+planeDist[ipl-1])*(planeDist[ipl]+planeDist[ipl-1]) ;
+
+            if(ipl > 1 )
+              fitArray[imx] += planeScat[ipl-1]*planeDist[ipl-1]*planeDist[ipl-1] ;
+
+            if(ipl < nPlanes-2)
+              fitArray[imx] += planeScat[ipl+1]*planeDist[ipl]*planeDist[ipl] ;
+          }
+
+        // For beam constraint
+
+        if(ipl==jpl && ipl<2 && useBeamConstraint)
+          fitArray[imx] += planeScat[0]*planeDist[0]*planeDist[0] ;
+
+        if(ipl+jpl==1 && useBeamConstraint)
+          fitArray[imx] -= planeScat[0]*planeDist[0]*planeDist[0] ;        
+      }
+  }
+
+  int status=gaussjSolve(fitArray,pos,nPlanes) ;
+
+  if(status)
+    {
+      cerr << "Singular matrix in track fitting algorithm ! " << endl;
+      for(int ipl=0;ipl<nPlanes;ipl++)
+        err[ipl]=0. ;
+    }
+  else
+    for(int ipl=0;ipl<nPlanes;ipl++)
+      err[ipl]=sqrt(fitArray[ipl+ipl*nPlanes]);
+
+  return status ;
+}
+
+int TestFitterKernel::gaussjSolve(double *alfa,double *beta,int n)
+{
+  int *ipiv;
+  int *indxr;
+  int *indxc;
+  int i,j,k;
+  int irow=0;
+  int icol=0;
+  double abs,big,help,pivinv;
+
+  ipiv = new int[n];
+  indxr = new int[n];
+  indxc = new int[n];
+
+  for(i=0;i<n;i++)ipiv[i]=0;
+
+  for(i=0;i<n;i++)
+    {
+      big=0.;
+      for(j=0;j<n;j++)
+        {
+          if(ipiv[j]==1)continue;
+          for(k=0;k<n;k++)
+            {
+              if(ipiv[k]!=0)continue;
+              abs=fabs(alfa[n*j+k]);
+              if(abs>big)
+                {
+                  big=abs;
+                  irow=j;
+                  icol=k;
+                }
+            }
+        }
+      ipiv[icol]++;
+
+      if(ipiv[icol]>1){
+	// first clean up then bail out
+	delete[] ipiv;
+	delete[] indxr;
+	delete[] indxc;
+        return 1;
+      }
+
+      if(irow!=icol)
+        {
+          help=beta[irow];
+          beta[irow]=beta[icol];
+          beta[icol]=help;
+          for(j=0;j<n;j++)
+            {
+              help=alfa[n*irow+j];
+              alfa[n*irow+j]=alfa[n*icol+j];
+              alfa[n*icol+j]=help;
+            }
+        }
+      indxr[i]=irow;
+      indxc[i]=icol;
+
+      if(alfa[n*icol+icol]==0.){
+	// first clean up then bail out
+	delete[] ipiv;
+	delete[] indxr;
+	delete[] indxc;
+        return 1;}
+
+      help=alfa[n*icol+icol];
+      pivinv=1./help;
+      alfa[n*icol+icol]=1.;
+      for(j=0;j<n;j++) alfa[n*icol+j]*=pivinv;
+
+      beta[icol]*=pivinv;
+
+      for(j=0;j<n;j++)
+        {
+          if(j==icol)continue;
+          help=alfa[n*j+icol];
+          alfa[n*j+icol]=0.;
+          for(k=0;k<n;k++)
+            alfa[n*j+k]-=alfa[n*icol+k]*help;
+          beta[j]-=beta[icol]*help;
+        }
+    }
+
+  for(i=n-1;i>=0;i--)
+    {
+      if(indxr[i]==indxc[i])continue;
+      for(j=0;j<n;j++)
+        {
+          help=alfa[n*j+indxr[i]];
+          alfa[n*j+indxr[i]]=alfa[n*j+indxc[i]];
+          alfa[n*j+indxc[i]]=help;
+        }
+    }
+
+  delete [] ipiv;
+  delete [] indxr;
+  delete [] indxc;
+
+  return 0;
+}
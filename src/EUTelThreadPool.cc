@@ -0,0 +1,157 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelThreadPool.h"
+
+// lcio includes <.h>
+#include <Exceptions.h>
+
+// system includes <>
+#include <unistd.h>
+#include <exception>
+
+using namespace std;
+using namespace eutelescope;
+
+EUTelThreadPool::EUTelThreadPool( unsigned int nThreads ) :
+  _nThreads( nThreads == 0 ? hardwareConcurrency() : nThreads ),
+  _workers(),
+  _queue(),
+  _nPending(0),
+  _stop(false),
+  _failure(""),
+  _mutex(),
+  _workAvailable(),
+  _workDone() {
+
+  pthread_mutex_init( &_mutex, 0 );
+  pthread_cond_init( &_workAvailable, 0 );
+  pthread_cond_init( &_workDone, 0 );
+
+  if ( _nThreads < 2 ) {
+    _nThreads = 1;
+    return;
+  }
+
+  _workers.reserve( _nThreads );
+  for ( unsigned int i = 0; i < _nThreads; ++i ) {
+    pthread_t thread;
+    if ( pthread_create( &thread, 0, &EUTelThreadPool::workerEntry, this ) != 0 ) break;
+    _workers.push_back( thread );
+  }
+
+  // if the system refused to give us threads, fall back to serial mode
+  if ( _workers.size() < 2 ) {
+    pthread_mutex_lock( &_mutex );
+    _stop = true;
+    pthread_cond_broadcast( &_workAvailable );
+    pthread_mutex_unlock( &_mutex );
+    for ( size_t i = 0; i < _workers.size(); ++i ) pthread_join( _workers[i], 0 );
+    _workers.clear();
+    _stop = false;
+    _nThreads = 1;
+  } else {
+    _nThreads = _workers.size();
+  }
+}
+
+EUTelThreadPool::~EUTelThreadPool() {
+
+  if ( !_workers.empty() ) {
+    pthread_mutex_lock( &_mutex );
+    while ( _nPending > 0 ) pthread_cond_wait( &_workDone, &_mutex );
+    _stop = true;
+    pthread_cond_broadcast( &_workAvailable );
+    pthread_mutex_unlock( &_mutex );
+    for ( size_t i = 0; i < _workers.size(); ++i ) pthread_join( _workers[i], 0 );
+  }
+
+  pthread_cond_destroy( &_workDone );
+  pthread_cond_destroy( &_workAvailable );
+  pthread_mutex_destroy( &_mutex );
+}
+
+unsigned int EUTelThreadPool::hardwareConcurrency() {
+  long nCores = sysconf( _SC_NPROCESSORS_ONLN );
+  return nCores > 0 ? static_cast< unsigned int >( nCores ) : 1;
+}
+
+void EUTelThreadPool::submit( Task * task ) {
+
+  if ( _workers.empty() ) {
+    execute( task );
+    return;
+  }
+
+  pthread_mutex_lock( &_mutex );
+  _queue.push_back( task );
+  ++_nPending;
+  pthread_cond_signal( &_workAvailable );
+  pthread_mutex_unlock( &_mutex );
+}
+
+void EUTelThreadPool::wait() {
+
+  pthread_mutex_lock( &_mutex );
+  while ( _nPending > 0 ) pthread_cond_wait( &_workDone, &_mutex );
+  string failure = _failure;
+  _failure.clear();
+  pthread_mutex_unlock( &_mutex );
+
+  if ( !failure.empty() ) {
+    throw lcio::Exception( "EUTelThreadPool: a task failed: " + failure );
+  }
+}
+
+void * EUTelThreadPool::workerEntry( void * pool ) {
+  static_cast< EUTelThreadPool * >( pool )->workerLoop();
+  return 0;
+}
+
+void EUTelThreadPool::workerLoop() {
+
+  pthread_mutex_lock( &_mutex );
+  while ( true ) {
+    while ( _queue.empty() && !_stop ) pthread_cond_wait( &_workAvailable, &_mutex );
+    if ( _queue.empty() && _stop ) break;
+
+    Task * task = _queue.front();
+    _queue.pop_front();
+    pthread_mutex_unlock( &_mutex );
+
+    execute( task );
+
+    pthread_mutex_lock( &_mutex );
+    if ( --_nPending == 0 ) pthread_cond_broadcast( &_workDone );
+  }
+  pthread_mutex_unlock( &_mutex );
+}
+
+void EUTelThreadPool::execute( Task * task ) {
+
+  string failure;
+  try {
+    task->run();
+  } catch ( std::exception & e ) {
+    failure = e.what();
+  } catch ( ... ) {
+    failure = "unknown exception";
+  }
+
+  if ( failure.empty() ) return;
+
+  if ( _workers.empty() ) {
+    _failure = failure;
+  } else {
+    pthread_mutex_lock( &_mutex );
+    if ( _failure.empty() ) _failure = failure;
+    pthread_mutex_unlock( &_mutex );
+  }
+}
@@ -0,0 +1,252 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// personal includes
+#include "EUTelToyEventGenerator.h"
+#include "EUTelRunHeaderImpl.h"
+#include "EUTelEventImpl.h"
+#include "EUTelGeometryTelescopeGeoDescription.h"
+#include "EUTELESCOPE.h"
+
+// marlin includes
+#include "marlin/Processor.h"
+#include "marlin/DataSourceProcessor.h"
+#include "marlin/ProcessorMgr.h"
+#include "marlin/Exceptions.h"
+
+// lcio includes
+#include <IMPL/LCCollectionVec.h>
+#include <IMPL/LCRunHeaderImpl.h>
+#include <IMPL/TrackerDataImpl.h>
+#include <IMPL/TrackerHitImpl.h>
+#include <UTIL/CellIDEncoder.h>
+#include <UTIL/LCTime.h>
+
+// system includes
+#include <memory>
+#include <string>
+
+using namespace std;
+using namespace lcio;
+using namespace marlin;
+using namespace eutelescope;
+
+EUTelToyEventGenerator::EUTelToyEventGenerator () :
+  DataSourceProcessor  ("EUTelToyEventGenerator"),
+  _runNumber(0),
+  _beamEnergy(4.),
+  _beamSizeX(5.),
+  _beamSizeY(3.),
+  _beamDivergence(1e-4),
+  _tracksPerEvent(1.),
+  _noiseOccupancy(0.),
+  _chargeSpread(0.005),
+  _efficiency(1.),
+  _multipleScattering(true),
+  _randomSeed(4711),
+  _zsDataCollectionName(),
+  _truthHitCollectionName(),
+  _generator(),
+  _nTracks(0)
+{
+
+  _description =
+    "Generates toy telescope events from the GEAR geometry: straight tracks with multiple scattering\n"
+    "in the planes, binary pixel digitization and noise. The events are sent directly through the\n"
+    "processor chain, the number of events is given by MaxRecordNumber";
+
+  registerProcessorParameter("RunNumber", "Run number of the generated events",
+                             _runNumber, static_cast<int> ( 0 ) );
+
+  registerProcessorParameter("BeamEnergy", "Beam momentum [GeV]",
+                             _beamEnergy, static_cast<float> ( 4. ) );
+
+  registerOptionalParameter("BeamSizeX", "Gaussian sigma of the beam profile along x [mm]",
+                            _beamSizeX, static_cast<float> ( 5. ) );
+
+  registerOptionalParameter("BeamSizeY", "Gaussian sigma of the beam profile along y [mm]",
+                            _beamSizeY, static_cast<float> ( 3. ) );
+
+  registerOptionalParameter("BeamDivergence", "Gaussian sigma of the track slopes [rad]",
+                            _beamDivergence, static_cast<float> ( 1e-4 ) );
+
+  registerProcessorParameter("TracksPerEvent", "Mean number of tracks per event (poissonian)",
+                             _tracksPerEvent, static_cast<float> ( 1. ) );
+
+  registerOptionalParameter("NoiseOccupancy", "Probability for a pixel to fire without a track, per event",
+                            _noiseOccupancy, static_cast<float> ( 0. ) );
+
+  registerOptionalParameter("ChargeSpread", "Every pixel within this distance, in x and in y, of the track crossing point fires [mm]",
+                            _chargeSpread, static_cast<float> ( 0.005 ) );
+
+  registerOptionalParameter("Efficiency", "Probability for a plane to detect a track crossing it",
+                            _efficiency, static_cast<float> ( 1. ) );
+
+  registerOptionalParameter("MultipleScattering", "Deflect the tracks in the planes according to Highland's formula",
+                            _multipleScattering, static_cast<bool> ( true ) );
+
+  registerOptionalParameter("RandomSeed", "Seed of the random numbers, the same seed gives the same events",
+                            _randomSeed, static_cast<int> ( 4711 ) );
+
+  registerOutputCollection(LCIO::TRACKERDATA, "ZSDataCollectionName",
+                           "Name of the zero suppressed data collection",
+                           _zsDataCollectionName, string( "original_zsdata" ));
+
+  registerOutputCollection(LCIO::TRACKERHIT, "TruthHitCollectionName",
+                           "Name of the collection with the crossing points of the generated tracks, leave empty for none",
+                           _truthHitCollectionName, string( "truthhit" ));
+
+}
+
+EUTelToyEventGenerator * EUTelToyEventGenerator::newProcessor () {
+  return new EUTelToyEventGenerator;
+}
+
+void EUTelToyEventGenerator::init () {
+  printParameters ();
+
+  EUTelToyGenerator::Config config;
+  config.beamEnergy         = _beamEnergy;
+  config.beamSizeX          = _beamSizeX;
+  config.beamSizeY          = _beamSizeY;
+  config.beamDivergence     = _beamDivergence;
+  config.meanTracks         = _tracksPerEvent;
+  config.noiseOccupancy     = _noiseOccupancy;
+  config.chargeSpread       = _chargeSpread;
+  config.efficiency         = _efficiency;
+  config.multipleScattering = _multipleScattering;
+
+  _generator.setConfig( config );
+  _generator.setSeed( static_cast< uint64_t >( _randomSeed ) );
+  _generator.setGeometry( geo::gGeometry().getSnapshot() );
+
+  _nTracks = 0;
+}
+
+void EUTelToyEventGenerator::sendRunHeader() {
+
+  const vector< EUTelToyGenerator::Sensor > & sensors = _generator.sensors();
+
+  auto_ptr<IMPL::LCRunHeaderImpl> lcHeader ( new IMPL::LCRunHeaderImpl );
+  auto_ptr<EUTelRunHeaderImpl>    eutelRunHeader ( new EUTelRunHeaderImpl (lcHeader.get() ));
+  eutelRunHeader->addProcessor( type() );
+  eutelRunHeader->lcRunHeader()->setRunNumber( _runNumber );
+  eutelRunHeader->setDataType( EUTELESCOPE::SIMULDATA );
+  eutelRunHeader->setDateTime();
+  eutelRunHeader->setSimulSWName( type() );
+  eutelRunHeader->setBeamEnergy( _beamEnergy );
+  eutelRunHeader->setNoOfDetector( sensors.size() );
+
+  IntVec minX, maxX, minY, maxY;
+  for ( size_t iSensor = 0; iSensor < sensors.size(); ++iSensor ) {
+    minX.push_back( 0 );
+    maxX.push_back( sensors[ iSensor ].xPixelNo - 1 );
+    minY.push_back( 0 );
+    maxY.push_back( sensors[ iSensor ].yPixelNo - 1 );
+  }
+  eutelRunHeader->setMinX( minX );
+  eutelRunHeader->setMaxX( maxX );
+  eutelRunHeader->setMinY( minY );
+  eutelRunHeader->setMaxY( maxY );
+
+  ProcessorMgr::instance()->processRunHeader( lcHeader.release() );
+}
+
+void EUTelToyEventGenerator::readDataSource (int numEvents) {
+
+  sendRunHeader();
+
+  int iEvent = 0;
+  for ( ; iEvent < numEvents; ++iEvent ) {
+
+    if ( iEvent % 1000 == 0 ) {
+      streamlog_out ( MESSAGE4 ) << "Generating event " << iEvent << endl;
+    }
+
+    EUTelEventImpl * event = new EUTelEventImpl;
+    event->setRunNumber( _runNumber );
+    event->setEventNumber( iEvent );
+    event->setEventType( kDE );
+    LCTime now;
+    event->setTimeStamp( now.timeStamp() );
+
+    fillEvent( event );
+
+    ProcessorMgr::instance()->processEvent( static_cast<LCEventImpl*> ( event ) );
+    delete event;
+  }
+
+  // add the EORE event
+  EUTelEventImpl * event = new EUTelEventImpl;
+  event->setRunNumber( _runNumber );
+  event->setEventNumber( iEvent );
+  event->setEventType( kEORE );
+  LCTime now;
+  event->setTimeStamp( now.timeStamp() );
+
+  ProcessorMgr::instance()->processEvent( static_cast<LCEventImpl*> ( event ) );
+  delete event;
+}
+
+void EUTelToyEventGenerator::fillEvent( IMPL::LCEventImpl * event ) {
+
+  _generator.generate();
+  _nTracks += _generator.getNTracks();
+
+  // one sparse data element per plane, with the layout
+  // EUTelTrackerDataInterfacerImpl uses for EUTelGenericSparsePixel:
+  // x, y, signal and time.
+  LCCollectionVec * zsDataCollection = new LCCollectionVec( LCIO::TRACKERDATA );
+  CellIDEncoder< TrackerDataImpl > zsDataEncoder( EUTELESCOPE::ZSDATADEFAULTENCODING, zsDataCollection );
+
+  const vector< EUTelToyGenerator::Sensor > & sensors = _generator.sensors();
+  for ( size_t iSensor = 0; iSensor < sensors.size(); ++iSensor ) {
+
+    const EUTelToyGenerator::Sensor & sensor = sensors[ iSensor ];
+    TrackerDataImpl * zsData = new TrackerDataImpl;
+    zsDataEncoder["sensorID"]        = sensor.sensorID;
+    zsDataEncoder["sparsePixelType"] = static_cast< int > ( kEUTelGenericSparsePixel );
+    zsDataEncoder.setCellID( zsData );
+
+    const size_t nElement = 4;
+    FloatVec & chargeValues = zsData->chargeValues();
+    chargeValues.resize( sensor.pixels.size() * nElement );
+    for ( size_t iPixel = 0; iPixel < sensor.pixels.size(); ++iPixel ) {
+      float * pixel = &chargeValues[ iPixel * nElement ];
+      pixel[0] = sensor.pixels[ iPixel ].x;
+      pixel[1] = sensor.pixels[ iPixel ].y;
+      pixel[2] = 1.;
+      pixel[3] = 0.;
+    }
+    zsDataCollection->push_back( zsData );
+  }
+  event->addCollection( zsDataCollection, _zsDataCollectionName );
+
+  if ( _truthHitCollectionName.empty() ) return;
+
+  LCCollectionVec * truthHitCollection = new LCCollectionVec( LCIO::TRACKERHIT );
+  CellIDEncoder< TrackerHitImpl > hitEncoder( EUTELESCOPE::HITENCODING, truthHitCollection );
+
+  const vector< EUTelToyGenerator::TruthHit > & truthHits = _generator.truthHits();
+  for ( size_t iHit = 0; iHit < truthHits.size(); ++iHit ) {
+    TrackerHitImpl * hit = new TrackerHitImpl;
+    hit->setPosition( truthHits[ iHit ].global );
+    hit->setQuality( truthHits[ iHit ].track );
+    hitEncoder["sensorID"]   = truthHits[ iHit ].sensorID;
+    hitEncoder["properties"] = kHitInGlobalCoord | kSimulatedHit;
+    hitEncoder.setCellID( hit );
+    truthHitCollection->push_back( hit );
+  }
+  event->addCollection( truthHitCollection, _truthHitCollectionName );
+}
+
+void EUTelToyEventGenerator::end () {
+  streamlog_out ( MESSAGE4 ) << "Generated " << _nTracks << " tracks" << endl;
+  streamlog_out ( MESSAGE4 ) << "Successfully finished" << endl;
+}
@@ -0,0 +1,257 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelToyGenerator.h"
+
+// system includes <>
+#include <algorithm>
+#include <cmath>
+
+using namespace eutelescope;
+
+namespace {
+
+  bool pixelLess( const EUTelToyGenerator::Pixel & a, const EUTelToyGenerator::Pixel & b ) {
+    return a.y < b.y || ( a.y == b.y && a.x < b.x );
+  }
+
+  bool pixelEqual( const EUTelToyGenerator::Pixel & a, const EUTelToyGenerator::Pixel & b ) {
+    return a.x == b.x && a.y == b.y;
+  }
+
+  // distance from the beginning of the telescope where the tracks start, in mm
+  const double startDistance = 10.;
+
+}
+
+EUTelToyGenerator::Config::Config() :
+  beamEnergy(4.),
+  beamSizeX(5.),
+  beamSizeY(3.),
+  beamDivergence(1e-4),
+  meanTracks(1.),
+  noiseOccupancy(0.),
+  chargeSpread(0.005),
+  efficiency(1.),
+  multipleScattering(true)
+{}
+
+EUTelToyGenerator::EUTelToyGenerator() :
+  _config(),
+  _planes(),
+  _sensors(),
+  _truthHits(),
+  _nTracks(0),
+  _state(0),
+  _hasGauss(false),
+  _nextGauss(0.)
+{
+  setSeed( 4711 );
+}
+
+void EUTelToyGenerator::setConfig( const Config & config ) {
+  _config = config;
+  updateScattering();
+}
+
+void EUTelToyGenerator::setSeed( uint64_t seed ) {
+  // splitmix64 of the seed, xorshift needs a non zero state
+  uint64_t z = seed + 0x9E3779B97F4A7C15UL;
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9UL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBUL;
+  _state = ( z ^ ( z >> 31 ) ) | 1;
+  _hasGauss = false;
+}
+
+void EUTelToyGenerator::setGeometry( const geo::EUTelGeometrySnapshot & snapshot ) {
+
+  _planes.clear();
+  _sensors.clear();
+
+  const std::map< int, int > & zOrderToID = snapshot.zOrderToID();
+  for ( std::map< int, int >::const_iterator it = zOrderToID.begin(); it != zOrderToID.end(); ++it ) {
+
+    const geo::EUTelPlane & layout = snapshot.planes().find( it->second )->second;
+
+    Plane plane;
+    plane.sensorID  = it->second;
+    plane.transform = snapshot.transform( it->second );
+    const double localNormal[3] = { 0., 0., 1. };
+    plane.transform.local2MasterVec( localNormal, plane.normal );
+    plane.halfXSize = layout.xSize / 2.;
+    plane.halfYSize = layout.ySize / 2.;
+    plane.xPitch    = layout.xPitch;
+    plane.yPitch    = layout.yPitch;
+    plane.xPixelNo  = layout.xPixelNo;
+    plane.yPixelNo  = layout.yPixelNo;
+    plane.materialBudget = snapshot.materialBudget( it->second );
+    plane.theta0    = 0.;
+    _planes.push_back( plane );
+
+    Sensor sensor;
+    sensor.sensorID = plane.sensorID;
+    sensor.xPixelNo = plane.xPixelNo;
+    sensor.yPixelNo = plane.yPixelNo;
+    _sensors.push_back( sensor );
+  }
+
+  updateScattering();
+}
+
+void EUTelToyGenerator::updateScattering() {
+  for ( size_t iPlane = 0; iPlane < _planes.size(); ++iPlane ) {
+    Plane & plane = _planes[ iPlane ];
+    plane.theta0 = 0.;
+    if ( _config.multipleScattering && plane.materialBudget > 0. && _config.beamEnergy > 0. ) {
+      // Highland's formula, as Utility::getThetaRMSHighland
+      const double x = plane.materialBudget;
+      plane.theta0 = ( ( 0.0136 * std::sqrt( x ) ) / _config.beamEnergy ) * ( 1.0 + 0.038 * std::log( x ) );
+    }
+  }
+}
+
+double EUTelToyGenerator::uniform() {
+  _state ^= _state >> 12;
+  _state ^= _state << 25;
+  _state ^= _state >> 27;
+  return ( ( _state * 2685821657736338717UL ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+double EUTelToyGenerator::gauss() {
+  // Marsaglia polar method, the second value is kept for the next call
+  if ( _hasGauss ) {
+    _hasGauss = false;
+    return _nextGauss;
+  }
+  double u, v, s;
+  do {
+    u = 2. * uniform() - 1.;
+    v = 2. * uniform() - 1.;
+    s = u * u + v * v;
+  } while ( s >= 1. || s == 0. );
+  const double factor = std::sqrt( -2. * std::log( s ) / s );
+  _nextGauss = v * factor;
+  _hasGauss  = true;
+  return u * factor;
+}
+
+int EUTelToyGenerator::poisson( double mean ) {
+  if ( mean <= 0. ) return 0;
+  if ( mean > 50. ) {
+    // gaussian approximation, good enough for noise and pile up
+    const int n = static_cast< int >( std::floor( mean + std::sqrt( mean ) * gauss() + 0.5 ) );
+    return n < 0 ? 0 : n;
+  }
+  const double limit = std::exp( -mean );
+  int n = 0;
+  double product = uniform();
+  while ( product > limit ) {
+    ++n;
+    product *= uniform();
+  }
+  return n;
+}
+
+void EUTelToyGenerator::generate() {
+
+  _truthHits.clear();
+  for ( size_t iSensor = 0; iSensor < _sensors.size(); ++iSensor ) _sensors[ iSensor ].pixels.clear();
+
+  if ( _planes.empty() ) {
+    _nTracks = 0;
+    return;
+  }
+
+  _nTracks = poisson( _config.meanTracks );
+  for ( int iTrack = 0; iTrack < _nTracks; ++iTrack ) addTrack( iTrack );
+
+  for ( size_t iSensor = 0; iSensor < _sensors.size(); ++iSensor ) {
+    Sensor & sensor = _sensors[ iSensor ];
+    addNoise( sensor );
+    // overlapping clusters and noise fire a pixel only once
+    std::sort( sensor.pixels.begin(), sensor.pixels.end(), pixelLess );
+    sensor.pixels.erase( std::unique( sensor.pixels.begin(), sensor.pixels.end(), pixelEqual ), sensor.pixels.end() );
+  }
+}
+
+void EUTelToyGenerator::addTrack( int track ) {
+
+  // start upstream of the first plane, along the beam axis
+  double position[3];
+  position[0] = _config.beamSizeX * gauss();
+  position[1] = _config.beamSizeY * gauss();
+  position[2] = _planes.front().transform.translation[2] - startDistance;
+
+  double slopeX = _config.beamDivergence * gauss();
+  double slopeY = _config.beamDivergence * gauss();
+
+  for ( size_t iPlane = 0; iPlane < _planes.size(); ++iPlane ) {
+
+    const Plane & plane = _planes[ iPlane ];
+
+    // intersection of the line with the plane
+    const double direction[3] = { slopeX, slopeY, 1. };
+    const double along = plane.normal[0] * direction[0] + plane.normal[1] * direction[1] + plane.normal[2] * direction[2];
+    if ( std::fabs( along ) < 1e-12 ) continue;
+    const double distance = ( plane.normal[0] * ( plane.transform.translation[0] - position[0] )
+                              + plane.normal[1] * ( plane.transform.translation[1] - position[1] )
+                              + plane.normal[2] * ( plane.transform.translation[2] - position[2] ) ) / along;
+    for ( int i = 0; i < 3; ++i ) position[i] += distance * direction[i];
+
+    double local[3];
+    plane.transform.master2Local( position, local );
+    if ( std::fabs( local[0] ) >= plane.halfXSize || std::fabs( local[1] ) >= plane.halfYSize ) continue;
+
+    TruthHit hit;
+    hit.sensorID = plane.sensorID;
+    hit.track    = track;
+    std::copy( local, local + 3, hit.local );
+    std::copy( position, position + 3, hit.global );
+    _truthHits.push_back( hit );
+
+    if ( _config.efficiency >= 1. || uniform() < _config.efficiency ) {
+      addCluster( plane, _sensors[ iPlane ], local[0], local[1] );
+    }
+
+    if ( plane.theta0 > 0. ) {
+      slopeX += plane.theta0 * gauss();
+      slopeY += plane.theta0 * gauss();
+    }
+  }
+}
+
+void EUTelToyGenerator::addCluster( const Plane & plane, Sensor & sensor, double x, double y ) {
+
+  // pixel centres are at ( index + 0.5 ) * pitch - size / 2, as in the hit maker
+  const double spread = std::max( _config.chargeSpread, 0. );
+  const int xMin = std::max( 0, static_cast< int >( std::floor( ( x - spread + plane.halfXSize ) / plane.xPitch ) ) );
+  const int xMax = std::min( plane.xPixelNo - 1, static_cast< int >( std::floor( ( x + spread + plane.halfXSize ) / plane.xPitch ) ) );
+  const int yMin = std::max( 0, static_cast< int >( std::floor( ( y - spread + plane.halfYSize ) / plane.yPitch ) ) );
+  const int yMax = std::min( plane.yPixelNo - 1, static_cast< int >( std::floor( ( y + spread + plane.halfYSize ) / plane.yPitch ) ) );
+
+  Pixel pixel;
+  for ( int iy = yMin; iy <= yMax; ++iy ) {
+    for ( int ix = xMin; ix <= xMax; ++ix ) {
+      pixel.x = static_cast< short >( ix );
+      pixel.y = static_cast< short >( iy );
+      sensor.pixels.push_back( pixel );
+    }
+  }
+}
+
+void EUTelToyGenerator::addNoise( Sensor & sensor ) {
+  const int nNoise = poisson( _config.noiseOccupancy * sensor.xPixelNo * sensor.yPixelNo );
+  Pixel pixel;
+  for ( int iNoise = 0; iNoise < nNoise; ++iNoise ) {
+    pixel.x = static_cast< short >( uniform() * sensor.xPixelNo );
+    pixel.y = static_cast< short >( uniform() * sensor.yPixelNo );
+    sensor.pixels.push_back( pixel );
+  }
+}
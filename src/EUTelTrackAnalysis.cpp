@@ -9,16 +9,16 @@ setBeamEnergy(beamEnergy);
 
 } 
 
-void EUTelTrackAnalysis::plotResidualVsPosition(EUTelTrack track){
+void EUTelTrackAnalysis::plotResidualVsPosition(const EUTelTrack& track){
   streamlog_out(DEBUG2) << " EUTelTrackAnalysis::plotResidualVsPosition------------------------------BEGIN"<< std::endl;
-	std::vector<EUTelState> states = track.getStates();
+	const std::vector<EUTelState>& states = track.getStates();
 	for(size_t i=0; i<states.size();++i){
-		EUTelState state  = states.at(i);
+		const EUTelState& state  = states.at(i);
 		state.print();
 		if(!state.getStateHasHit()){
 			continue;
 		}
-		EUTelHit hit = state.getHit();	
+		const EUTelHit& hit = state.getHit();	
 		const float* statePosition = state.getPosition();
 		const double* hitPosition = hit.getPosition();
 		float residual[2];
@@ -48,19 +48,19 @@ void EUTelTrackAnalysis::plotResidualVsPosition(EUTelTrack track){
   streamlog_out(DEBUG2) << " EUTelTrackAnalysis::plotResidualVsPosition------------------------------END"<< std::endl;
 }
 
-void EUTelTrackAnalysis::plotBeamEnergy(EUTelTrack track){
+void EUTelTrackAnalysis::plotBeamEnergy(const EUTelTrack& track){
   streamlog_out(DEBUG2) << " EUTelTrackAnalysis::plotBeamEnergy------------------------------BEGIN"<< std::endl;
-	std::vector<EUTelState> states = track.getStates();
-	EUTelState state  = states.at(0);
+	const std::vector<EUTelState>& states = track.getStates();
+	const EUTelState& state  = states.at(0);
 	state.print();
 	float omega = -1.0/state.getMomLocal().Mag();	
 	_beamEnergy-> fill(-1.0/omega );
   streamlog_out(DEBUG2) << " EUTelTrackAnalysis::plotBeamEnergy------------------------------END"<< std::endl;
 }
-void EUTelTrackAnalysis::plotPValueVsBeamEnergy(EUTelTrack track){
+void EUTelTrackAnalysis::plotPValueVsBeamEnergy(const EUTelTrack& track){
   streamlog_out(DEBUG2) << " EUTelTrackAnalysis::plotPValueVsBeamEnergy------------------------------BEGIN"<< std::endl;
-	std::vector<EUTelState> states = track.getStates();
-	EUTelState state  = states.at(0);
+	const std::vector<EUTelState>& states = track.getStates();
+	const EUTelState& state  = states.at(0);
 	state.print();
 	float omega = -1.0/state.getMomLocal().Mag();	
 	float pValue = calculatePValueForChi2(track);
@@ -70,11 +70,11 @@ void EUTelTrackAnalysis::plotPValueVsBeamEnergy(EUTelTrack track){
 }
 
 
-void EUTelTrackAnalysis::plotIncidenceAngles(EUTelTrack track){
+void EUTelTrackAnalysis::plotIncidenceAngles(const EUTelTrack& track){
   streamlog_out(DEBUG2) << " EUTelTrackAnalysis::plotIncidenceAngles------------------------------BEGIN"<< std::endl;
-	std::vector<EUTelState> states = track.getStates();
+	const std::vector<EUTelState>& states = track.getStates();
 	for(size_t i=0; i<states.size();++i){
-		EUTelState state  = states.at(i);
+		const EUTelState& state  = states.at(i);
 		state.print();
 		TVectorD stateVec = state.getStateVec();
 		float incidenceXZ = stateVec[1];
@@ -88,7 +88,7 @@ void EUTelTrackAnalysis::plotIncidenceAngles(EUTelTrack track){
 		}
 	} 
 	for(size_t i=0; i<states.size();++i){
-		EUTelState state  = states.at(i);
+		const EUTelState& state  = states.at(i);
 		state.print();
 		TVectorD stateVec = state.getStateVec();
 		float incidenceYZ = stateVec[2];
@@ -103,12 +103,12 @@ void EUTelTrackAnalysis::plotIncidenceAngles(EUTelTrack track){
 	}
   streamlog_out(DEBUG2) << " EUTelTrackAnalysis::plotIncidenceAngles------------------------------END"<< std::endl;
 }
-void EUTelTrackAnalysis::plotPValueWithIncidenceAngles(EUTelTrack track){
+void EUTelTrackAnalysis::plotPValueWithIncidenceAngles(const EUTelTrack& track){
 	streamlog_out(DEBUG2) << " EUTelTrackAnalysis::plotPValueWithIncidenceAngles------------------------------BEGIN"<< std::endl;
 	float pValue = calculatePValueForChi2(track);
-	std::vector<EUTelState> states = track.getStates();
+	const std::vector<EUTelState>& states = track.getStates();
 	for(size_t i=0; i<states.size();++i){
-		EUTelState state  = states.at(i);
+		const EUTelState& state  = states.at(i);
 		state.print();
 		TVectorD stateVec = state.getStateVec();
 		float incidenceXZ = stateVec[1];
@@ -122,7 +122,7 @@ void EUTelTrackAnalysis::plotPValueWithIncidenceAngles(EUTelTrack track){
 		}
 	} 
 	for(size_t i=0; i<states.size();++i){
-		EUTelState state  = states.at(i);
+		const EUTelState& state  = states.at(i);
 		state.print();
 		TVectorD stateVec = state.getStateVec();
 		float incidenceYZ = stateVec[2];
@@ -139,12 +139,12 @@ void EUTelTrackAnalysis::plotPValueWithIncidenceAngles(EUTelTrack track){
 }
 
 
-void EUTelTrackAnalysis::plotPValueWithPosition(EUTelTrack track){
+void EUTelTrackAnalysis::plotPValueWithPosition(const EUTelTrack& track){
   streamlog_out(DEBUG2) << " EUTelTrackAnalysis::plotPValueWithPosition------------------------------BEGIN"<< std::endl;
 	float pValue = calculatePValueForChi2(track);
-	std::vector<EUTelState> states = track.getStates();
+	const std::vector<EUTelState>& states = track.getStates();
 	for(size_t i=0; i<states.size();++i){
-		EUTelState state  = states.at(i);
+		const EUTelState& state  = states.at(i);
 		state.print();
 
 		const float* statePosition = state.getPosition();
@@ -160,7 +160,7 @@ void EUTelTrackAnalysis::plotPValueWithPosition(EUTelTrack track){
 	}
   streamlog_out(DEBUG2) << " EUTelTrackAnalysis::plotPValueWithPosition------------------------------END"<< std::endl;
 }
-float EUTelTrackAnalysis::calculatePValueForChi2(EUTelTrack track){
+float EUTelTrackAnalysis::calculatePValueForChi2(const EUTelTrack& track){
 //    boost::math::chi_squared mydist(track.getNdf());
 //    float pValue = 1 - boost::math::cdf(mydist,track.getChi2());
     return 1.0;
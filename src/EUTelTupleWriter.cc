@@ -0,0 +1,429 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelTupleWriter.h"
+
+// marlin includes ".h"
+#include "streamlog/streamlog.h"
+
+// lcio includes <.h>
+#include <Exceptions.h>
+
+// ROOT includes <>
+#include <RVersion.h>
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+
+// system includes <>
+#include <exception>
+
+using namespace std;
+using namespace eutelescope;
+
+EUTelTupleWriter::ColumnBuffer::ColumnBuffer() :
+  type( kInt ),
+  ints(),
+  longs(),
+  doubles(),
+  ends() {
+}
+
+EUTelTupleWriter::Batch::Batch() :
+  tree( 0 ),
+  nRows( 0 ),
+  columns() {
+}
+
+void EUTelTupleWriter::Batch::clear() {
+  nRows = 0;
+  // keep the capacity, the batch is going to be reused
+  for ( size_t i = 0; i < columns.size(); ++i ) {
+    columns[i].ints.clear();
+    columns[i].longs.clear();
+    columns[i].doubles.clear();
+    columns[i].ends.clear();
+  }
+}
+
+EUTelTupleWriter::Slot::Slot() :
+  type( kInt ),
+  intValue( 0 ),
+  longValue( 0 ),
+  doubleValue( 0 ),
+  intVector( new vector< int > ),
+  doubleVector( new vector< double > ) {
+}
+
+EUTelTupleWriter::Slot::~Slot() {
+  delete intVector;
+  delete doubleVector;
+}
+
+EUTelTupleWriter::Column::Column() :
+  tree( 0 ),
+  index( 0 ),
+  type( kInt ),
+  currentInt( 0 ),
+  currentLong( 0 ),
+  currentDouble( 0 ) {
+}
+
+EUTelTupleWriter::EUTelTupleWriter( const string & fileName, int compressionLevel, int basketSize,
+                                    unsigned int batchSize, bool async ) :
+  _file( 0 ),
+  _basketSize( basketSize ),
+  _batchSize( batchSize == 0 ? 1 : batchSize ),
+  _async( async ),
+  _closed( false ),
+  _trees(),
+  _slots(),
+  _columns(),
+  _treeColumns(),
+  _entries(),
+  _current(),
+  _queue(),
+  _free(),
+  _maxQueued( 4 ),
+  _worker(),
+  _workerStarted( false ),
+  _stop( false ),
+  _failure(""),
+  _mutex(),
+  _queueChanged() {
+
+  pthread_mutex_init( &_mutex, 0 );
+  pthread_cond_init( &_queueChanged, 0 );
+
+  _file = new TFile( fileName.c_str(), "RECREATE" );
+  if ( _file->IsZombie() ) {
+    delete _file;
+    _file = 0;
+    throw lcio::Exception( "EUTelTupleWriter: unable to open " + fileName );
+  }
+  _file->SetCompressionLevel( compressionLevel );
+
+  if ( _async ) {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+    ROOT::EnableThreadSafety();
+    if ( pthread_create( &_worker, 0, &EUTelTupleWriter::workerEntry, this ) == 0 ) {
+      _workerStarted = true;
+    } else {
+      streamlog_out ( WARNING2 ) << "EUTelTupleWriter: unable to start the writer thread, writing "
+                                 << fileName << " synchronously" << endl;
+      _async = false;
+    }
+#else
+    streamlog_out ( WARNING2 ) << "EUTelTupleWriter: this ROOT version is not thread safe, writing "
+                               << fileName << " synchronously" << endl;
+    _async = false;
+#endif
+  }
+}
+
+EUTelTupleWriter::~EUTelTupleWriter() {
+
+  try {
+    close();
+  } catch ( lcio::Exception & e ) {
+    streamlog_out ( ERROR5 ) << e.what() << endl;
+  }
+
+  pthread_cond_destroy( &_queueChanged );
+  pthread_mutex_destroy( &_mutex );
+}
+
+unsigned int EUTelTupleWriter::addTree( const string & name, const string & title ) {
+
+  _file->cd();
+  TTree * tree = new TTree( name.c_str(), title.c_str() );
+  tree->SetDirectory( _file );
+  tree->SetAutoSave( 1000000000 );
+
+  _trees.push_back( tree );
+  _slots.push_back( vector< Slot * >() );
+  _treeColumns.push_back( vector< unsigned int >() );
+  _entries.push_back( 0 );
+  _current.push_back( 0 );
+  return _trees.size() - 1;
+}
+
+unsigned int EUTelTupleWriter::addColumn( unsigned int tree, const string & name, ColumnType type ) {
+
+  Slot * slot = new Slot;
+  slot->type  = type;
+
+  TBranch * branch = 0;
+  switch ( type ) {
+  case kInt:
+    branch = _trees[tree]->Branch( name.c_str(), &slot->intValue, ( name + "/I" ).c_str() );
+    break;
+  case kLong:
+    branch = _trees[tree]->Branch( name.c_str(), &slot->longValue, ( name + "/L" ).c_str() );
+    break;
+  case kDouble:
+    branch = _trees[tree]->Branch( name.c_str(), &slot->doubleValue, ( name + "/D" ).c_str() );
+    break;
+  case kIntVector:
+    branch = _trees[tree]->Branch( name.c_str(), &slot->intVector );
+    break;
+  case kDoubleVector:
+    branch = _trees[tree]->Branch( name.c_str(), &slot->doubleVector );
+    break;
+  }
+  if ( branch != 0 && _basketSize > 0 ) branch->SetBasketSize( _basketSize );
+
+  Column column;
+  column.tree  = tree;
+  column.index = _slots[tree].size();
+  column.type  = type;
+
+  _slots[tree].push_back( slot );
+  _columns.push_back( column );
+  _treeColumns[tree].push_back( _columns.size() - 1 );
+  return _columns.size() - 1;
+}
+
+void EUTelTupleWriter::addFriend( unsigned int tree, unsigned int friendTree ) {
+  _trees[tree]->AddFriend( _trees[friendTree] );
+}
+
+void EUTelTupleWriter::setInt( unsigned int column, int value ) {
+  _columns[column].currentInt = value;
+}
+
+void EUTelTupleWriter::setLong( unsigned int column, long long value ) {
+  _columns[column].currentLong = value;
+}
+
+void EUTelTupleWriter::setDouble( unsigned int column, double value ) {
+  _columns[column].currentDouble = value;
+}
+
+void EUTelTupleWriter::pushInt( unsigned int column, int value ) {
+  const Column & info = _columns[column];
+  currentBatch( info.tree )->columns[ info.index ].ints.push_back( value );
+}
+
+void EUTelTupleWriter::pushDouble( unsigned int column, double value ) {
+  const Column & info = _columns[column];
+  currentBatch( info.tree )->columns[ info.index ].doubles.push_back( value );
+}
+
+void EUTelTupleWriter::fill( unsigned int tree ) {
+
+  Batch * batch = currentBatch( tree );
+  const vector< unsigned int > & columns = _treeColumns[tree];
+
+  for ( size_t i = 0; i < columns.size(); ++i ) {
+    const Column & column = _columns[ columns[i] ];
+    ColumnBuffer & buffer = batch->columns[i];
+    switch ( column.type ) {
+    case kInt:          buffer.ints.push_back( column.currentInt );         break;
+    case kLong:         buffer.longs.push_back( column.currentLong );       break;
+    case kDouble:       buffer.doubles.push_back( column.currentDouble );   break;
+    case kIntVector:    buffer.ends.push_back( buffer.ints.size() );        break;
+    case kDoubleVector: buffer.ends.push_back( buffer.doubles.size() );     break;
+    }
+  }
+
+  ++batch->nRows;
+  ++_entries[tree];
+
+  if ( batch->nRows >= _batchSize ) {
+    _current[tree] = 0;
+    submit( batch );
+  }
+}
+
+void EUTelTupleWriter::discard( unsigned int tree ) {
+
+  Batch * batch = _current[tree];
+  if ( batch == 0 ) return;
+
+  for ( size_t i = 0; i < batch->columns.size(); ++i ) {
+    ColumnBuffer & buffer = batch->columns[i];
+    const size_t rowEnd = buffer.ends.empty() ? 0 : buffer.ends.back();
+    if ( buffer.type == kIntVector )    buffer.ints.resize( rowEnd );
+    if ( buffer.type == kDoubleVector ) buffer.doubles.resize( rowEnd );
+  }
+}
+
+unsigned long long EUTelTupleWriter::getEntries( unsigned int tree ) const {
+  return _entries[tree];
+}
+
+void EUTelTupleWriter::close() {
+
+  if ( _closed ) return;
+  _closed = true;
+
+  // hand over the partially filled batches
+  for ( size_t tree = 0; tree < _current.size(); ++tree ) {
+    Batch * batch = _current[tree];
+    _current[tree] = 0;
+    if ( batch == 0 ) continue;
+    if ( batch->nRows > 0 ) submit( batch );
+    else delete batch;
+  }
+
+  if ( _workerStarted ) {
+    pthread_mutex_lock( &_mutex );
+    _stop = true;
+    pthread_cond_broadcast( &_queueChanged );
+    pthread_mutex_unlock( &_mutex );
+    pthread_join( _worker, 0 );
+    _workerStarted = false;
+  }
+
+  for ( size_t i = 0; i < _free.size(); ++i ) delete _free[i];
+  _free.clear();
+
+  if ( _file != 0 ) {
+    _file->Write();
+    _file->Close();
+    // the trees belong to the file
+    delete _file;
+    _file = 0;
+  }
+  _trees.clear();
+
+  for ( size_t tree = 0; tree < _slots.size(); ++tree ) {
+    for ( size_t i = 0; i < _slots[tree].size(); ++i ) delete _slots[tree][i];
+  }
+  _slots.clear();
+
+  if ( !_failure.empty() ) {
+    throw lcio::Exception( "EUTelTupleWriter: writing failed: " + _failure );
+  }
+}
+
+EUTelTupleWriter::Batch * EUTelTupleWriter::currentBatch( unsigned int tree ) {
+
+  Batch * batch = _current[tree];
+  if ( batch != 0 ) return batch;
+
+  pthread_mutex_lock( &_mutex );
+  if ( !_free.empty() ) {
+    batch = _free.back();
+    _free.pop_back();
+  }
+  pthread_mutex_unlock( &_mutex );
+
+  if ( batch == 0 ) batch = new Batch;
+
+  if ( batch->tree != tree || batch->columns.size() != _slots[tree].size() ) {
+    batch->tree = tree;
+    batch->columns.assign( _slots[tree].size(), ColumnBuffer() );
+    for ( size_t i = 0; i < batch->columns.size(); ++i ) {
+      batch->columns[i].type = _slots[tree][i]->type;
+    }
+  }
+
+  _current[tree] = batch;
+  return batch;
+}
+
+void EUTelTupleWriter::submit( Batch * batch ) {
+
+  if ( !_workerStarted ) {
+    writeAndRecycle( batch );
+    return;
+  }
+
+  pthread_mutex_lock( &_mutex );
+  while ( _queue.size() >= _maxQueued ) pthread_cond_wait( &_queueChanged, &_mutex );
+  _queue.push_back( batch );
+  pthread_cond_broadcast( &_queueChanged );
+  pthread_mutex_unlock( &_mutex );
+}
+
+void EUTelTupleWriter::write( Batch * batch ) {
+
+  TTree * tree = _trees[ batch->tree ];
+  const vector< Slot * > & slots = _slots[ batch->tree ];
+
+  // start of the current row in the vector columns
+  vector< size_t > begin( slots.size(), 0 );
+
+  for ( size_t row = 0; row < batch->nRows; ++row ) {
+    for ( size_t i = 0; i < slots.size(); ++i ) {
+      const ColumnBuffer & buffer = batch->columns[i];
+      Slot * slot = slots[i];
+      switch ( slot->type ) {
+      case kInt:    slot->intValue    = buffer.ints[row];    break;
+      case kLong:   slot->longValue   = buffer.longs[row];   break;
+      case kDouble: slot->doubleValue = buffer.doubles[row]; break;
+      case kIntVector:
+        slot->intVector->assign( buffer.ints.begin() + begin[i], buffer.ints.begin() + buffer.ends[row] );
+        begin[i] = buffer.ends[row];
+        break;
+      case kDoubleVector:
+        slot->doubleVector->assign( buffer.doubles.begin() + begin[i], buffer.doubles.begin() + buffer.ends[row] );
+        begin[i] = buffer.ends[row];
+        break;
+      }
+    }
+    if ( tree->Fill() < 0 ) {
+      throw lcio::Exception( string( "EUTelTupleWriter: unable to fill tree " ) + tree->GetName() );
+    }
+  }
+}
+
+void EUTelTupleWriter::writeAndRecycle( Batch * batch ) {
+
+  string failure;
+  try {
+    write( batch );
+  } catch ( std::exception & e ) {
+    failure = e.what();
+  } catch ( ... ) {
+    failure = "unknown exception";
+  }
+
+  batch->clear();
+
+  pthread_mutex_lock( &_mutex );
+  if ( _failure.empty() ) _failure = failure;
+  _free.push_back( batch );
+  pthread_mutex_unlock( &_mutex );
+}
+
+void * EUTelTupleWriter::workerEntry( void * writer ) {
+  static_cast< EUTelTupleWriter * >( writer )->workerLoop();
+  return 0;
+}
+
+void EUTelTupleWriter::workerLoop() {
+
+  pthread_mutex_lock( &_mutex );
+  while ( true ) {
+    while ( _queue.empty() && !_stop ) pthread_cond_wait( &_queueChanged, &_mutex );
+    if ( _queue.empty() && _stop ) break;
+
+    Batch * batch = _queue.front();
+    _queue.pop_front();
+    pthread_cond_broadcast( &_queueChanged );
+    bool failed = !_failure.empty();
+    pthread_mutex_unlock( &_mutex );
+
+    // after a failure the rows are dropped, close() reports the error
+    if ( failed ) {
+      batch->clear();
+      pthread_mutex_lock( &_mutex );
+      _free.push_back( batch );
+    } else {
+      writeAndRecycle( batch );
+      pthread_mutex_lock( &_mutex );
+    }
+  }
+  pthread_mutex_unlock( &_mutex );
+}
@@ -18,6 +18,7 @@
 #include <EVENT/LCEvent.h>
 
 #include <cstdio>
+#include <fstream>
 
 using namespace std;
 
@@ -465,5 +466,21 @@ namespace eutelescope {
 	  return opoint;
         }
 
+        std::vector< std::string > readMilleManifest( const std::string& manifestFilename ) {
+            std::ifstream manifest( manifestFilename.c_str() );
+            if ( !manifest.is_open() ) {
+                throw lcio::Exception( "Could not open Millepede manifest " + manifestFilename );
+            }
+            std::vector< std::string > binaries;
+            std::string line;
+            while ( std::getline( manifest, line ) ) {
+                const size_t first = line.find_first_not_of( " \t\r" );
+                if ( first == std::string::npos || line[first] == '#' ) continue;
+                const size_t last = line.find_last_not_of( " \t\r" );
+                binaries.push_back( line.substr( first, last - first + 1 ) );
+            }
+            return binaries;
+        }
+
   }
 }
@@ -23,7 +23,8 @@ using namespace std;
 
 // Constructor
 TDSPixelsChargeMap::TDSPixelsChargeMap(const double length, const double width, const double height, const double firstPixelCornerCoordL, const double firstPixelCornerCoordW) :
-  length(length), width(width), height(height), firstPixelCornerCoordL(firstPixelCornerCoordL), firstPixelCornerCoordW(firstPixelCornerCoordW)
+  length(length), width(width), height(height), firstPixelCornerCoordL(firstPixelCornerCoordL), firstPixelCornerCoordW(firstPixelCornerCoordW),
+  pointIMin(0), pointIMax(0), pointJMin(0), pointJMax(0), pointResponse(), batchCharge()
 {
   std::cout << " booking width="<< width << " and length=" << length << std::endl;
   if( height > 0. )
@@ -178,29 +179,27 @@ void TDSPixelsChargeMap::setIntegMaxNumberPixelsAlongW(const unsigned int val)
 }
 
 
-// Function which adds charge contribution to pixels
-void TDSPixelsChargeMap::update(const TDSStep & step)
+// Set up the integration storage for the current pixel and charge distribution parameters
+void TDSPixelsChargeMap::prepareIntegrationStorage()
 {
-  int debug = 0;
-
-  if ( ( ! isPixelLengthSet ) || ( ! isPixelWidthSet ) )
-    {
-      cout << "Error: Pixels' dimensions are not set!" << endl;
-      exit (1);
-    }
-
-  if ( ! isIntegrationInitialized )
-    {
-      cout << "Error: Integration is not initialized!" << endl;
-      exit(1);
-    }
+  TDSIntegrationStorage::ResponseParameters parameters;
+  parameters.pixelLength = pixelLength;
+  parameters.pixelWidth = pixelWidth;
+  parameters.height = height;
+  parameters.lambda = theParamsOfFunChargeDistribution.lambda;
+  parameters.reflectedContribution = theParamsOfFunChargeDistribution.addReflectedContribution ? theParamsOfFunChargeDistribution.reflectedContribution : 0.;
+  unsigned int hash = 5381;
+  const std::string & type = theParamsOfFunChargeDistribution.detectorType;
+  for (size_t i = 0; i < type.size(); i++ ) hash = hash * 33 + static_cast< unsigned char >(type[i]);
+  parameters.detectorTypeHash = hash;
+
+  integrationStorage->configure(parameters, integMaxNumberPixelsAlongL, integMaxNumberPixelsAlongW);
+}
 
-  if (step.geomLength == 0.)    // Return (and take next step)
-    {
-//      cout << "Warning: Step length = 0." << endl;
-//      return;
-    }
 
+// Split a step into integration points
+unsigned int TDSPixelsChargeMap::prepareStepIntegration(const TDSStep & step, double startPoint[3], double & integStep, double & integChargePerStep) const
+{
   if (step.geomLength < 0.)
     {
       cout << "Error: Step length less than 0!" << endl;
@@ -208,198 +207,335 @@ void TDSPixelsChargeMap::update(const TDSStep & step)
     }
 
   // Choose the smallest step -- the greatest number of steps
-  unsigned int integStepsNumber;
   unsigned int temp1 = static_cast< unsigned int >( step.geomLength / integMaxStepInDistance + 0.5);
   unsigned int temp2 = static_cast< unsigned int >( abs(step.charge / integMaxStepInCharge)  + 0.5);
   unsigned int temp  = max(temp1,temp2);
-  integStepsNumber = ( temp > 0 ? temp : 1 );
+  unsigned int integStepsNumber = ( temp > 0 ? temp : 1 );
 
-  double integStep = step.geomLength / integStepsNumber;
-  if(debug>1) cout << "integ: length: " << step.geomLength << " stepnumber: " << integStepsNumber << endl;
+  integStep = step.geomLength / integStepsNumber;
   // Charge per integration step
-  // Charge per integration step
-  double integChargePerStep = step.charge / integStepsNumber;
-  if(debug>1) cout << "integChargePerStep= " << integChargePerStep << ";  integStep= " << integStep << endl;
+  integChargePerStep = step.charge / integStepsNumber;
+
+  // Position before integration loop (one integration point back)
+  startPoint[0] = step.midL - step.dirL*(step.geomLength + integStep)/2.;
+  startPoint[1] = step.midW - step.dirW*(step.geomLength + integStep)/2.;
+  startPoint[2] = step.midH - step.dirH*(step.geomLength + integStep)/2.;
+
+  return integStepsNumber;
+}
+
+
+// Charge sharing of one integration point among the neighbouring pixels
+bool TDSPixelsChargeMap::integratePoint(const double currentPoint[3])
+{
+  // Determine integer coordinates of the main (core) pixel (under which the current point is placed)
+  unsigned long int iL, iW;
+  iL = static_cast< unsigned long int >((currentPoint[0]-firstPixelCornerCoordL)/pixelLength);
+  iW = static_cast< unsigned long int >((currentPoint[1]-firstPixelCornerCoordW)/pixelWidth);
+  if ( iL >= numberPixelsAlongL  || iW >= numberPixelsAlongW )
+    {
+      cout << "Error: Core pixel (and step) outside the boundary of Length-Width plane!" << endl;
+      return false;
+    }
+
+  if (currentPoint[2] > 0.)
+    {
+      cout << "Error: Point outside sensitive volume (Height > 0)!" << endl;
+      streamlog_out(ERROR4) << 
+                              " currentPoint[0] " << currentPoint[0] <<
+                              " currentPoint[1] " << currentPoint[1] <<
+                              " currentPoint[2] " << currentPoint[2] <<
+                                endl;
+      return false;
+    }
+
+  // Set H for funChargeDistribution
+  theParamsOfFunChargeDistribution.H=currentPoint[2];
+
+  // Pixel segment for integration storage
+  unsigned int segmentL=0, segmentW=0, segmentH=0;
+  bool segmentL_reduced = false, segmentW_reduced = false;
+  if (useIntegrationStorage)
+    {
+      // Determine pixel segment for integration results storage
+      // Unreduced segments
+      const unsigned int segmentsL = integrationStorage->integPixelSegmentsAlongL;
+      const unsigned int segmentsW = integrationStorage->integPixelSegmentsAlongW;
+      const unsigned int segmentsH = integrationStorage->integPixelSegmentsAlongH;
+      segmentL = static_cast< unsigned int >( segmentsL * ((currentPoint[0]-firstPixelCornerCoordL-pixelLength*iL ) / pixelLength) );
+      segmentW = static_cast< unsigned int >( segmentsW * ((currentPoint[1]-firstPixelCornerCoordW-pixelWidth *iW ) / pixelWidth ) ) ;
+      segmentH = min( static_cast< unsigned int >( segmentsH * (abs(currentPoint[2]) / abs(height) ) ), segmentsH );
+      // Thanks to symmetry we can reduce L and W segments (we have to reduce pixels then, too!)
+      if (segmentsL > 0 && segmentL >= segmentsL/2)
+        {
+          segmentL = min( segmentsL - segmentL - 1, segmentsL/2 - 1 );
+          segmentL_reduced = true;
+        };
+      if (segmentsW > 0 && segmentW >= segmentsW/2)
+        {
+          segmentW = min( segmentsW - segmentW - 1, segmentsW/2 - 1 );
+          segmentW_reduced = true;
+        }
+    }
+
+  // Indexes of pixels for which contributions will be calculated
+  // Limits take into account borders of the pixel plane (rectangle)
+  long int temp;
+  temp = iL - integMaxNumberPixelsAlongL / 2;
+  temp < 0 ? pointIMin = 0 : pointIMin = temp;
+  temp = iL + integMaxNumberPixelsAlongL / 2;
+  temp >= static_cast< long int >(numberPixelsAlongL) ? pointIMax = numberPixelsAlongL - 1 : pointIMax = temp;
+  temp = iW - integMaxNumberPixelsAlongW / 2;
+  temp < 0 ? pointJMin = 0 : pointJMin = temp;
+  temp = iW + integMaxNumberPixelsAlongW / 2;
+  temp >= static_cast< long int >(numberPixelsAlongW) ? pointJMax = numberPixelsAlongW - 1 : pointJMax = temp;
+
+  pointResponse.resize( (pointIMax - pointIMin + 1) * (pointJMax - pointJMin + 1) );
+
+  // Result of integration and its error
+  double gsl_res, gsl_err;
+
+  /* Tables for 2-dim limits of integration on the Length-Width plane*/
+  double limitsLow[2];
+  double limitsUp[2];
+
+  // Loops over important pixels
+  // (borders of a layer part taken into account - see above)
+  std::vector<double>::iterator response = pointResponse.begin();
+  for (unsigned long int i = pointIMin ; i <= pointIMax ; i++ )
+    {
+      // L limits of integral
+      limitsLow[0] = firstPixelCornerCoordL + i*pixelLength - currentPoint[0];
+      limitsUp[0]  = limitsLow[0] + pixelLength;
+
+      // Relative integer coordinate of pixel from main pixel.
+      // Thanks to symmetry we can reduce L and W pixels indexes. We have to reduce segments simultaneously!
+      unsigned int pixelL = static_cast< long int >(i) - static_cast< long int >(iL) + integMaxNumberPixelsAlongL / 2;
+      if ( segmentL_reduced   &&  i != iL ) pixelL = integMaxNumberPixelsAlongL - pixelL - 1;
 
+      for (unsigned long int j = pointJMin ; j <= pointJMax ; j++, ++response )
+        {
+          // W limits of integral
+          limitsLow[1] = firstPixelCornerCoordW + j*pixelWidth - currentPoint[1];
+          limitsUp[1]  = limitsLow[1] + pixelWidth;
+
+          // Should we use integration-results?
+          if (useIntegrationStorage)
+            {
+              unsigned int pixelW = static_cast< long int >(j) - static_cast< long int >(iW) + integMaxNumberPixelsAlongW / 2;
+              if ( segmentW_reduced   &&  j != iW ) pixelW = integMaxNumberPixelsAlongW - pixelW - 1;
+
+              if ( integrationStorage->isResultStored(segmentL, segmentW, segmentH, pixelL, pixelW) )
+                {
+                  gsl_res = integrationStorage->getResult(segmentL, segmentW, segmentH, pixelL, pixelW);
+                }
+              else
+                {
+                  // Integrate
+                  gsl_monte_miser_integrate (&gsl_funToIntegrate, limitsLow, limitsUp, 2, gsl_calls, gsl_r, gsl_s, &gsl_res, &gsl_err);
+                  // Store integration result
+                  integrationStorage->rememberResult(segmentL, segmentW, segmentH, pixelL, pixelW, gsl_res);
+                };
+            }
+          else
+            {
+              // Integrate (here no storage)
+              gsl_monte_miser_integrate (&gsl_funToIntegrate, limitsLow, limitsUp, 2, gsl_calls, gsl_r, gsl_s, &gsl_res, &gsl_err);
+            };
+
+          *response = gsl_res;
+        }
+    }
+
+  return true;
+}
+
+
+// Function which adds charge contribution to pixels
+void TDSPixelsChargeMap::update(const TDSStep & step)
+{
+  if ( ( ! isPixelLengthSet ) || ( ! isPixelWidthSet ) )
+    {
+      cout << "Error: Pixels' dimensions are not set!" << endl;
+      exit (1);
+    }
+
+  if ( ! isIntegrationInitialized )
+    {
+      cout << "Error: Integration is not initialized!" << endl;
+      exit(1);
+    }
+
+  if (useIntegrationStorage) prepareIntegrationStorage();
 
-  // Initialize position before integration loop (one integration point back)
   double currentPoint[3];
-  currentPoint[0] = step.midL - step.dirL*(step.geomLength + integStep)/2.;
-  currentPoint[1] = step.midW - step.dirW*(step.geomLength + integStep)/2.;
-  currentPoint[2] = step.midH - step.dirH*(step.geomLength + integStep)/2.;
+  double integStep, integChargePerStep;
+  unsigned int integStepsNumber = prepareStepIntegration(step, currentPoint, integStep, integChargePerStep);
 
   // Go through points - integration along the step
   for (unsigned int is = 0; is < integStepsNumber ; is++ )
     {
-
       // new position
       currentPoint[0] += step.dirL*integStep;
       currentPoint[1] += step.dirW*integStep;
       currentPoint[2] += step.dirH*integStep;
 
-      if(debug>1) cout << " currentPoint[0] = " << currentPoint[0] << "  currentPoint[1] = " << currentPoint[1] << " currentPoint[2] = " << currentPoint[2] << endl;
+      if ( ! integratePoint(currentPoint) ) break;
 
-      // Determine integer coordinates of the main (core) pixel (under which the current point is placed)
-      unsigned long int iL, iW;
-      iL = static_cast< unsigned long int >((currentPoint[0]-firstPixelCornerCoordL)/pixelLength);
-      iW = static_cast< unsigned long int >((currentPoint[1]-firstPixelCornerCoordW)/pixelWidth);
-      if(debug>1) cout << "iL: " << iL << " " << static_cast< long unsigned int >((currentPoint[0]-firstPixelCornerCoordL)/pixelLength)  << " " ;
-      if(debug>1) cout << "iW: " << iW << " " << static_cast< long unsigned int >((currentPoint[1]-firstPixelCornerCoordW)/pixelWidth)  << endl;
-      if ( iL >= numberPixelsAlongL  || iW >= numberPixelsAlongW )
+      // I use map<unsigned long long int pixId, double pixCharge> to keep charges collected in pixels.
+      // pixID = 10^10*i + j - key for the pixel (i,j) which is used in map<> container [(i,j) <-> (L,W)]
+      std::vector<double>::const_iterator response = pointResponse.begin();
+      for (unsigned long int i = pointIMin ; i <= pointIMax ; i++ )
         {
-          cout << "Error: Core pixel (and step) outside the boundary of Length-Width plane!" << endl;
-          //      exit(1);
-          break;
+          for (unsigned long int j = pointJMin ; j <= pointJMax ; j++, ++response )
+            {
+              pixelsChargeMap[ tenTo10*i + j ] += ( *response * integChargePerStep );
+            }
         }
+    }
+}
 
 
-      if (currentPoint[2] > 0.)
-        {
-          cout << "Error: Point outside sensitive volume (Height > 0)!" << endl;
-          //      exit(1);
-          streamlog_out(ERROR4) << 
-                                  " currentPoint[0] " << currentPoint[0] <<
-                                  " currentPoint[1] " << currentPoint[1] <<
-                                  " currentPoint[2] " << currentPoint[2] <<
-                                    endl;
-          break;
-        }
+// Function which adds charge contributions of many steps to pixels
+void TDSPixelsChargeMap::update(const std::vector<TDSStep> & steps)
+{
+  if ( steps.empty() ) return;
 
-      // Set H for funChargeDistribution
-      theParamsOfFunChargeDistribution.H=currentPoint[2];
+  if ( ( ! isPixelLengthSet ) || ( ! isPixelWidthSet ) )
+    {
+      cout << "Error: Pixels' dimensions are not set!" << endl;
+      exit (1);
+    }
 
-      // Pixel segment for integration storage
-      unsigned int segmentL=0, segmentW=0, segmentH=0;
-      bool segmentL_reduced = false, segmentW_reduced = false;
-      if (useIntegrationStorage)
+  if ( ! isIntegrationInitialized )
+    {
+      cout << "Error: Integration is not initialized!" << endl;
+      exit(1);
+    }
+
+  // Pixel range reached by the steps: end points of all steps plus the integration range
+  double minL = 0., maxL = 0., minW = 0., maxW = 0.;
+  for (size_t is = 0; is < steps.size(); is++ )
+    {
+      const TDSStep & step = steps[is];
+      const double halfL = abs(step.dirL) * step.geomLength / 2.;
+      const double halfW = abs(step.dirW) * step.geomLength / 2.;
+      if ( is == 0 || step.midL - halfL < minL ) minL = step.midL - halfL;
+      if ( is == 0 || step.midL + halfL > maxL ) maxL = step.midL + halfL;
+      if ( is == 0 || step.midW - halfW < minW ) minW = step.midW - halfW;
+      if ( is == 0 || step.midW + halfW > maxW ) maxW = step.midW + halfW;
+    }
+  long int bufferIMin = static_cast< long int >( floor((minL-firstPixelCornerCoordL)/pixelLength) ) - integMaxNumberPixelsAlongL / 2 - 1;
+  long int bufferIMax = static_cast< long int >( floor((maxL-firstPixelCornerCoordL)/pixelLength) ) + integMaxNumberPixelsAlongL / 2 + 1;
+  long int bufferJMin = static_cast< long int >( floor((minW-firstPixelCornerCoordW)/pixelWidth) ) - integMaxNumberPixelsAlongW / 2 - 1;
+  long int bufferJMax = static_cast< long int >( floor((maxW-firstPixelCornerCoordW)/pixelWidth) ) + integMaxNumberPixelsAlongW / 2 + 1;
+  bufferIMin = max( bufferIMin, 0L );
+  bufferJMin = max( bufferJMin, 0L );
+  bufferIMax = min( bufferIMax, static_cast< long int >(numberPixelsAlongL) - 1 );
+  bufferJMax = min( bufferJMax, static_cast< long int >(numberPixelsAlongW) - 1 );
+
+  // Steps spread over a large part of the sensor are added one by one
+  const long int maxBufferSize = 1L << 20;
+  if ( bufferIMax < bufferIMin || bufferJMax < bufferJMin ||
+       (bufferIMax - bufferIMin + 1) * (bufferJMax - bufferJMin + 1) > maxBufferSize )
+    {
+      for (size_t is = 0; is < steps.size(); is++ ) update(steps[is]);
+      return;
+    }
+
+  if (useIntegrationStorage) prepareIntegrationStorage();
+
+  const unsigned long int bufferNW = bufferJMax - bufferJMin + 1;
+  batchCharge.assign( (bufferIMax - bufferIMin + 1) * bufferNW, 0. );
+
+  for (size_t is = 0; is < steps.size(); is++ )
+    {
+      const TDSStep & step = steps[is];
+      double currentPoint[3];
+      double integStep, integChargePerStep;
+      unsigned int integStepsNumber = prepareStepIntegration(step, currentPoint, integStep, integChargePerStep);
+
+      for (unsigned int ip = 0; ip < integStepsNumber ; ip++ )
         {
-          // Determine pixel segment for integration results storage
-          // Unreduced segments
-          segmentL = static_cast< unsigned int >( integrationStorage->integPixelSegmentsAlongL * ((currentPoint[0]-firstPixelCornerCoordL-pixelLength*iL ) / pixelLength) );
-          segmentW = static_cast< unsigned int >( integrationStorage->integPixelSegmentsAlongW * ((currentPoint[1]-firstPixelCornerCoordW-pixelWidth *iW ) / pixelWidth ) ) ;
-          segmentH = static_cast< unsigned int >( integrationStorage->integPixelSegmentsAlongH * (abs(currentPoint[2]) / abs(height) ) );
-          if(debug>1) std::cout << "segmentH: " << segmentH  << " point2: " << abs(currentPoint[2]) <<
-                    " " << integrationStorage->integPixelSegmentsAlongH << " 1./height:" << 1./height <<  std::endl;
-          // Thanks to symmetry we can reduce L and W segments (we have to reduce pixels then, too!)
-          if (segmentL >= integrationStorage->integPixelSegmentsAlongL/2)
-            {
-              segmentL = integrationStorage->integPixelSegmentsAlongL - segmentL - 1;
-              segmentL_reduced = true;
-            };
-          if (segmentW >= integrationStorage->integPixelSegmentsAlongW/2)
+          currentPoint[0] += step.dirL*integStep;
+          currentPoint[1] += step.dirW*integStep;
+          currentPoint[2] += step.dirH*integStep;
+
+          if ( ! integratePoint(currentPoint) ) break;
+
+          std::vector<double>::const_iterator response = pointResponse.begin();
+          for (unsigned long int i = pointIMin ; i <= pointIMax ; i++ )
             {
-              segmentW = integrationStorage->integPixelSegmentsAlongW - segmentW - 1;
-              segmentW_reduced = true;
+              double * row = &batchCharge[ (i - bufferIMin) * bufferNW + (pointJMin - bufferJMin) ];
+              for (unsigned long int j = pointJMin ; j <= pointJMax ; j++, ++response, ++row )
+                {
+                  *row += *response * integChargePerStep;
+                }
             }
         }
+    }
 
-      // Result of integration and its error
-      double gsl_res, gsl_err;
-
-      /* Tables for 2-dim limits of integration on the Length-Width plane*/
-      double limitsLow[2];
-      double limitsUp[2];
-
-      unsigned long int i,j, imin, imax, jmin, jmax; // Indexes of pixels for which contributions will be calculated
-      // Limits take into account borders of the pixel plane (rectangle)
-      long int temp;
-      temp = iL - integMaxNumberPixelsAlongL / 2;
-      temp < 0 ? imin = 0 : imin = temp;
-      temp = iL + integMaxNumberPixelsAlongL / 2;
-      temp >= static_cast< long int >(numberPixelsAlongL) ? imax = numberPixelsAlongL - 1 : imax = temp;
-      temp = iW - integMaxNumberPixelsAlongW / 2;
-      temp < 0 ? jmin = 0 : jmin = temp;
-      temp = iW + integMaxNumberPixelsAlongW / 2;
-      temp >= static_cast< long int >(numberPixelsAlongW) ? jmax = numberPixelsAlongW - 1 : jmax = temp;
-
-      // Loops over important pixels
-      // (borders of a layer part taken into account - see above)
-      if(debug>2) cout << "iL = " << iL << " iW = " << iW << " imin = " << imin << " imax = " << imax << " jmin = " << jmin << " jmax = " << jmax << endl;
-
-      // I use map<unsigned long long int pixId, double pixCharge> to keep charges collected in pixels.
-      // Machine limit for unsigned long int:
-      // ULLONG_MAX = 18 446 744 073 709 551 615
-      //                           ^           ^
-      // pixID = 10^10*i + j - key for the pixel (i,j) which is used in map<> container [(i,j) <-> (L,W)]
-      type_PixelID pixID;
-
-      for (i = imin ; i <= imax ; i++ )
+  // Add the accumulated charges to the map, once per pixel
+  std::vector<double>::const_iterator charge = batchCharge.begin();
+  for (long int i = bufferIMin ; i <= bufferIMax ; i++ )
+    {
+      for (long int j = bufferJMin ; j <= bufferJMax ; j++, ++charge )
         {
-          if(debug>2) cout << "i = " << i << endl;
-          // L limits of integral
-          limitsLow[0] = firstPixelCornerCoordL + i*pixelLength - currentPoint[0];
-          limitsUp[0]  = limitsLow[0] + pixelLength;
+          if ( *charge != 0. ) pixelsChargeMap[ tenTo10*i + j ] += *charge;
+        }
+    }
+}
 
-          for (j = jmin ; j <= jmax ; j++ )
-            {
-              if(debug>2) cout << "j = " << j << endl;
-              // W limits of integral
-              limitsLow[1] = firstPixelCornerCoordW + j*pixelWidth - currentPoint[1];
-              limitsUp[1]  = limitsLow[1] + pixelWidth;
 
-              if(debug>2) std::cout << "limitsLow " << limitsLow[0] << " " << limitsLow[1] << std::endl; 
-              if(debug>2) std::cout << "limitsUp  " << limitsUp[0] << " " << limitsUp[1] << std::endl; 
- 
-              // Should we use integration-results?
-              if (useIntegrationStorage)
-                {
+// Integrate all segments of the integration storage in advance
+void TDSPixelsChargeMap::fillIntegrationStorage()
+{
+  if ( ! useIntegrationStorage )
+    {
+      cout << "fillIntegrationStorage: No integration storage defined!" << endl;
+      return;
+    }
 
-                  if(debug>2) cout << "Integration-results storage is used!" << endl;
+  if ( ( ! isPixelLengthSet ) || ( ! isPixelWidthSet ) || ( ! isIntegrationInitialized ) )
+    {
+      cout << "Error: Pixels' dimensions or integration are not set!" << endl;
+      exit (1);
+    }
 
-                  // Relative integer coordinates of pixel from main pixel
-                  unsigned int pixelL, pixelW;
-                  // Thanks to symmetry we can reduce L and W pixels indexes. We have to reduce segments simultaneously!
+  prepareIntegrationStorage();
 
-                  if(debug>2) std::cout << " " << i << " " << iL << " " << integMaxNumberPixelsAlongL / 2 << std::endl;
-                  pixelL = static_cast< long int >(i) - static_cast< long int >(iL) + integMaxNumberPixelsAlongL / 2;
-                  if ( segmentL_reduced   &&  i != iL )
-                    {
-                      pixelL = integMaxNumberPixelsAlongL - pixelL - 1;
-                    }
+  const unsigned int segmentsL = integrationStorage->integPixelSegmentsAlongL;
+  const unsigned int segmentsW = integrationStorage->integPixelSegmentsAlongW;
+  const unsigned int segmentsH = integrationStorage->integPixelSegmentsAlongH;
 
-                  if(debug>2) std::cout << " " << j << " " << iW << " " << integMaxNumberPixelsAlongW / 2 << std::endl;
-                  pixelW = static_cast< long int >(j) - static_cast< long int >(iW) + integMaxNumberPixelsAlongW / 2;
-                  if ( segmentW_reduced   &&  j != iW )
-                    {
-                      pixelW = integMaxNumberPixelsAlongW - pixelW - 1;
-                    }
+  double gsl_res, gsl_err;
+  double limitsLow[2];
+  double limitsUp[2];
 
-                  if(debug>2) std::cout << "L: " << segmentL << " W: " << segmentW << " H: " << segmentH << " pixelL:" << pixelL << " pixelW:" << pixelW << std::endl;
-                  unsigned long long int integSegID = integSegmentID(segmentL, segmentW, segmentH, pixelL, pixelW);
+  for (unsigned int segmentL = 0; segmentL < integrationStorage->getStoredSegmentsAlongL(); segmentL++ )
+    {
+      // Point position inside the core pixel: centre of the segment
+      const double offsetL = segmentsL > 0 ? pixelLength * (segmentL + 0.5) / segmentsL : pixelLength / 2.;
+      for (unsigned int segmentW = 0; segmentW < integrationStorage->getStoredSegmentsAlongW(); segmentW++ )
+        {
+          const double offsetW = segmentsW > 0 ? pixelWidth * (segmentW + 0.5) / segmentsW : pixelWidth / 2.;
+          for (unsigned int segmentH = 0; segmentH < integrationStorage->getStoredSegmentsAlongH(); segmentH++ )
+            {
+              theParamsOfFunChargeDistribution.H = segmentsH > 0 ? height * min( (segmentH + 0.5) / segmentsH, 1. ) : height / 2.;
 
-                  if(debug>2) std::cout << " " << pixelL << " " << pixelW << " " << integSegID << std::endl;
-                  if ( integrationStorage->isResultStored(integSegID) )
-                    {
-                      if(debug>2) std::cout << "1here no storage " << std::endl; 
-                      gsl_res = integrationStorage->getResult(integSegID);
-                    }
-                  else
+              for (unsigned int pixelL = 0; pixelL < integMaxNumberPixelsAlongL; pixelL++ )
+                {
+                  limitsLow[0] = ( static_cast< long int >(pixelL) - static_cast< long int >(integMaxNumberPixelsAlongL / 2) ) * pixelLength - offsetL;
+                  limitsUp[0]  = limitsLow[0] + pixelLength;
+                  for (unsigned int pixelW = 0; pixelW < integMaxNumberPixelsAlongW; pixelW++ )
                     {
-                      if(debug>2) std::cout << "2here no storage " << std::endl; 
-                      // Integrate
+                      if ( integrationStorage->isResultStored(segmentL, segmentW, segmentH, pixelL, pixelW) ) continue;
+                      limitsLow[1] = ( static_cast< long int >(pixelW) - static_cast< long int >(integMaxNumberPixelsAlongW / 2) ) * pixelWidth - offsetW;
+                      limitsUp[1]  = limitsLow[1] + pixelWidth;
                       gsl_monte_miser_integrate (&gsl_funToIntegrate, limitsLow, limitsUp, 2, gsl_calls, gsl_r, gsl_s, &gsl_res, &gsl_err);
-                      if(debug>2) std::cout << " integration done    gsl_calls: " << gsl_calls <<
-                                "   r: " << gsl_r << "   s: " << gsl_s << "   res: " << gsl_res << "   err:" << gsl_err << std::endl;
-                      // Store integration result
-                      integrationStorage->rememberResult(integSegID,gsl_res);
-                    };
+                      integrationStorage->rememberResult(segmentL, segmentW, segmentH, pixelL, pixelW, gsl_res);
+                    }
                 }
-              else
-                {
-                  if(debug>2) std::cout << " here no storage " << std::endl; 
-                  // Integrate (here no storage)
-                  gsl_monte_miser_integrate (&gsl_funToIntegrate, limitsLow, limitsUp, 2, gsl_calls, gsl_r, gsl_s, &gsl_res, &gsl_err);
-                };
-
-              if(debug>2)cout << "integChargePerStep " << integChargePerStep << " " << gsl_res << std::endl;
-               
-              // Pixels Charge Map
-              // "code" of the pixel - it serves as a key in the map container of pixels (relations: i <-> L, j <-> W)
-              pixID = 0UL + tenTo10*i + j ;
-              // Add contribution to pixelsChargeMap
-              pixelsChargeMap[ pixID ] = pixelsChargeMap[ pixID ] + ( gsl_res * integChargePerStep );
-              if(debug>2)cout << "charge collected in the pixel " << pixID << " = " << pixelsChargeMap[ pixID ] << endl;
-              if(debug>2)cout << "miser= " << gsl_res << " +- " << gsl_err << endl;
             }
         }
     }
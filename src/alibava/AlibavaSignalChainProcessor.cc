@@ -0,0 +1,304 @@
+/*
+ * Fused pedestal subtraction, common mode correction and charge
+ * calibration for alibava data
+ *  (2015 DESY)
+ */
+
+
+// alibava includes ".h"
+#include "AlibavaSignalChainProcessor.h"
+#include "AlibavaRunHeaderImpl.h"
+#include "AlibavaEventImpl.h"
+#include "ALIBAVA.h"
+
+
+// marlin includes ".h"
+#include "marlin/Processor.h"
+#include "marlin/Exceptions.h"
+#include "marlin/Global.h"
+
+// lcio includes <.h>
+#include <lcio.h>
+#include <UTIL/CellIDEncoder.h>
+#include <UTIL/CellIDDecoder.h>
+#include <IMPL/LCEventImpl.h>
+#include <IMPL/LCCollectionVec.h>
+#include <IMPL/TrackerDataImpl.h>
+
+// system includes <>
+#include <string>
+#include <iostream>
+#include <memory>
+#include <cmath>
+
+
+using namespace std;
+using namespace lcio;
+using namespace marlin;
+using namespace alibava;
+
+
+AlibavaSignalChainProcessor::AlibavaSignalChainProcessor () :
+AlibavaBaseProcessor("AlibavaSignalChainProcessor"),
+_Niteration(3),
+_NoiseDeviation(2.5),
+_chipConstants(),
+_signalBuffer(),
+_selectionBuffer(),
+_applyCalibration(false)
+{
+
+	// modify processor description
+	_description =
+	"AlibavaSignalChainProcessor applies pedestal subtraction, common mode correction, channel masking and charge calibration to the input raw data in a single pass. ";
+
+
+	// first of register the input collection
+	registerInputCollection (LCIO::TRACKERDATA, "InputCollectionName",
+									 "Input raw data collection name",
+									 _inputCollectionName, string("rawdata") );
+
+	registerOutputCollection (LCIO::TRACKERDATA, "OutputCollectionName",
+									  "Output data collection name",
+									  _outputCollectionName, string("recodata_cmmd") );
+
+
+	registerProcessorParameter ("PedestalInputFile",
+										 "The filename where the pedestal and noise values stored",
+										 _pedestalFile , string("pedestal.slcio"));
+
+	// now the optional parameters
+	registerOptionalParameter ("CalibrationInputFile",
+										"The filename where the charge calibration values stored. If not set, no calibration is applied",
+										_calibrationFile , string(ALIBAVA::NOTSET));
+
+	registerOptionalParameter ("PedestalCollectionName",
+										"Pedestal collection name, better not to change",
+										_pedestalCollectionName, string ("pedestal"));
+
+	registerOptionalParameter ("NoiseCollectionName",
+										"Noise collection name, better not to change",
+										_noiseCollectionName, string ("noise"));
+
+	registerOptionalParameter ("ChargeCalibrationCollectionName",
+										"Charge calibration collection name, better not to change",
+										_chargeCalCollectionName, string ("chargeCal"));
+
+	registerOptionalParameter ("CommonModeCalculationIteration",
+										"The number of iteration that should be used in common mode calculation. Set to 0 to switch off common mode correction",
+										_Niteration, int(3) );
+
+	registerOptionalParameter ("NoiseDeviation",
+										"The limit to the deviation of noise. The data exceeds this deviation will be considered as signal and not be included in common mode calculation",
+										_NoiseDeviation, float(2.5) );
+
+}
+
+
+void AlibavaSignalChainProcessor::init () {
+	streamlog_out ( MESSAGE4 ) << "Running init" << endl;
+
+
+	/* To set of channels to be used
+	 ex.The format should be like $ChipNumber:StartChannel-EndChannel$
+	 ex. $0:5-20$ $0:30-100$ $1:50-70$
+	 means from chip 0 channels between 5-20 and 30-100, from chip 1 channels between 50-70 will be used (all numbers included). the rest will be masked and not used
+	 Note that the numbers should be in ascending order and there should be no space between two $ character
+	 */
+	if (Global::parameters->isParameterSet(ALIBAVA::CHANNELSTOBEUSED))
+		Global::parameters->getStringVals(ALIBAVA::CHANNELSTOBEUSED,_channelsToBeUsed);
+	else {
+		streamlog_out ( MESSAGE4 ) << "The Global Parameter "<< ALIBAVA::CHANNELSTOBEUSED <<" is not set!" << endl;
+	}
+
+	/* To choose if processor should skip masked events
+	 ex. Set the value to 0 for false, to 1 for true
+	 */
+	if (Global::parameters->isParameterSet(ALIBAVA::SKIPMASKEDEVENTS))
+		_skipMaskedEvents = bool ( Global::parameters->getIntVal(ALIBAVA::SKIPMASKEDEVENTS) );
+	else {
+		streamlog_out ( MESSAGE4 ) << "The Global Parameter "<< ALIBAVA::SKIPMASKEDEVENTS <<" is not set! Masked events will be used!" << endl;
+	}
+
+	_applyCalibration = ( _calibrationFile != string(ALIBAVA::NOTSET) );
+
+	// this method is called only once even when the rewind is active
+	// usually a good idea to
+	printParameters ();
+
+}
+
+void AlibavaSignalChainProcessor::processRunHeader (LCRunHeader * rdr) {
+	streamlog_out ( MESSAGE4 ) << "Running processRunHeader" << endl;
+
+	// Add processor name to the runheader
+	auto_ptr<AlibavaRunHeaderImpl> arunHeader ( new AlibavaRunHeaderImpl(rdr)) ;
+	arunHeader->addProcessor(type());
+
+	// get and set selected chips
+	setChipSelection(arunHeader->getChipSelection());
+
+	// set channels to be used (if it is defined)
+	setChannelsToBeUsed();
+
+	// set pedestal and noise values
+	setPedestals();
+
+	// set charge calibration values
+	if ( _applyCalibration ) {
+		setCalibration();
+		if ( !_isCalibrationValid ) {
+			streamlog_out ( ERROR5 ) << "Charge calibration values are not valid, no calibration will be applied!" << endl;
+		}
+	}
+
+	prepareChipConstants();
+
+	// set number of skipped events to zero (defined in AlibavaBaseProcessor)
+	_numberOfSkippedEvents = 0;
+}
+
+void AlibavaSignalChainProcessor::prepareChipConstants() {
+
+	_chipConstants.clear();
+
+	const bool useCalibration = _applyCalibration && _isCalibrationValid;
+
+	EVENT::IntVec chipVec = getChipSelection();
+	for ( size_t i = 0; i < chipVec.size(); ++i ) {
+		int chipnum = chipVec[i];
+		ChipConstants & constants = _chipConstants[chipnum];
+
+		const EVENT::FloatVec & pedVec = _pedestalMap[chipnum];
+		const EVENT::FloatVec & calVec = _chargeCalMap[chipnum];
+
+		for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ++ichan ) {
+			constants._pedestal[ichan] = ( ichan < int(pedVec.size()) ) ? pedVec[ichan] : 0;
+			constants._weight[ichan] = isMasked(chipnum, ichan) ? 0 : 1;
+			constants._gain[ichan] = ( useCalibration ) ? calVec[ichan] : 1;
+		}
+	}
+}
+
+float AlibavaSignalChainProcessor::calculateCommonMode(const float * signal, const float * weight) {
+
+	// Same algorithm as in AlibavaConstantCommonModeProcessor, but the
+	// channel selection is expressed as a 0/1 weight so that all loops
+	// are free of branches.
+	double mean_signal=0;
+	double sigma_mean_signal=0;
+
+	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ++ichan )
+		_selectionBuffer[ichan] = weight[ichan];
+
+	for (int i=0; i<_Niteration; i++) {
+
+		// exclude outliers from the previous iteration
+		if ( i > 0 ) {
+			const float mean = mean_signal;
+			const float window = _NoiseDeviation * sigma_mean_signal;
+			for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ++ichan )
+				_selectionBuffer[ichan] = weight[ichan] * ( fabs(signal[ichan] - mean) < window );
+		}
+
+		double nchan=0;
+		double total_signal=0;
+		double total_signal_square=0;
+		for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ++ichan ) {
+			const double sig = _selectionBuffer[ichan] * signal[ichan];
+			nchan += _selectionBuffer[ichan];
+			total_signal += sig;
+			total_signal_square += sig*signal[ichan];
+		}
+
+		// standard deviation = SQRT( E[x^2] - E[x]^2 )
+		if ( nchan > 0 ) {
+			mean_signal = total_signal/nchan;
+			sigma_mean_signal = sqrt(total_signal_square/nchan - mean_signal*mean_signal);
+		}
+	}
+
+	return mean_signal;
+}
+
+void AlibavaSignalChainProcessor::processEvent (LCEvent * anEvent) {
+
+	AlibavaEventImpl * alibavaEvent = static_cast<AlibavaEventImpl*> (anEvent);
+
+	if (_skipMaskedEvents && (alibavaEvent->isEventMasked()) ) {
+		_numberOfSkippedEvents++;
+		return;
+	}
+
+	LCCollectionVec * collectionVec;
+	try
+	{
+		collectionVec = dynamic_cast< LCCollectionVec * > ( alibavaEvent->getCollection( getInputCollectionName() ) ) ;
+	} catch ( lcio::DataNotAvailableException ) {
+		// do nothing again
+		streamlog_out( ERROR5 ) << "Collection ("<<getInputCollectionName()<<") not found! " << endl;
+		return;
+	}
+
+	LCCollectionVec* newDataCollection = new LCCollectionVec(LCIO::TRACKERDATA);
+	CellIDEncoder<TrackerDataImpl> chipIDEncoder(ALIBAVA::ALIBAVADATA_ENCODE,newDataCollection);
+	CellIDDecoder<TrackerDataImpl> chipIDDecoder(ALIBAVA::ALIBAVADATA_ENCODE);
+
+	int noOfChip = collectionVec->getNumberOfElements();
+	for ( int i = 0; i < noOfChip; ++i )
+	{
+		TrackerDataImpl * trkdata = dynamic_cast< TrackerDataImpl * > ( collectionVec->getElementAt( i ) ) ;
+		int chipnum = static_cast<int> ( chipIDDecoder( trkdata )[ALIBAVA::ALIBAVADATA_ENCODE_CHIPNUM] );
+
+		map<int, ChipConstants>::const_iterator constIt = _chipConstants.find(chipnum);
+		if ( constIt == _chipConstants.end() ) {
+			streamlog_out( ERROR5 ) << "Chip "<< chipnum <<" is not in the chip selection, skipping it!" << endl;
+			continue;
+		}
+
+		const FloatVec & datavec = trkdata->getChargeValues();
+		if ( int(datavec.size()) != ALIBAVA::NOOFCHANNELS ) {
+			streamlog_out( ERROR5 ) << "Number of channels in input data is not equal to ALIBAVA::NOOFCHANNELS! Skipping chip "<< chipnum << endl;
+			continue;
+		}
+
+		const ChipConstants & constants = constIt->second;
+		const float * data = &datavec[0];
+
+		// pedestal subtraction
+		for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ++ichan )
+			_signalBuffer[ichan] = data[ichan] - constants._pedestal[ichan];
+
+		// common mode
+		const float commonmode = ( _Niteration > 0 ) ? calculateCommonMode(_signalBuffer, constants._weight) : 0;
+
+		// common mode subtraction, masking and calibration written
+		// directly into the output charge vector
+		TrackerDataImpl * newDataImpl = new TrackerDataImpl();
+		FloatVec & newdatavec = newDataImpl->chargeValues();
+		newdatavec.resize(ALIBAVA::NOOFCHANNELS);
+		float * out = &newdatavec[0];
+		for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ++ichan )
+			out[ichan] = ( _signalBuffer[ichan] - commonmode ) * constants._gain[ichan] * constants._weight[ichan];
+
+		chipIDEncoder[ALIBAVA::ALIBAVADATA_ENCODE_CHIPNUM] = chipnum;
+		chipIDEncoder.setCellID(newDataImpl);
+		newDataCollection->push_back(newDataImpl);
+	}
+
+	alibavaEvent->addCollection(newDataCollection, getOutputCollectionName());
+
+}
+
+void AlibavaSignalChainProcessor::check (LCEvent * /* evt */ ) {
+	// nothing to check here - could be used to fill check plots in reconstruction processor
+}
+
+
+void AlibavaSignalChainProcessor::end() {
+
+	if (_numberOfSkippedEvents > 0)
+		streamlog_out ( MESSAGE5 ) << _numberOfSkippedEvents<<" events skipped since they are masked" << endl;
+	streamlog_out ( MESSAGE4 ) << "Successfully finished" << endl;
+
+}
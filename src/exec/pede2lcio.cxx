@@ -31,6 +31,9 @@
 #include <functional>
 #include <algorithm>
 #include <memory>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
 
 
 #include "TRotation.h"
@@ -293,75 +296,80 @@ int main( int argc, char ** argv ) {
 
     lcio::LCCollectionVec * constantsCollection = new lcio::LCCollectionVec( lcio::LCIO::LCGENERICOBJECT );
 
-    vector< string > tokens;
-    istringstream tokenizer;
-    string line;
-    string buffer;
-    double value = 0.;
-    double err = 0.;
-
-    int sensorID = 0;
-
-    while ( getline( pedeFile, line ) ) {
-
-      bool goodLine = false;
-
-        if ( !line.empty() ) goodLine = true;
-     
-        if( !goodLine ) continue;
-
-        tokens.clear();
-        tokenizer.clear();
-        tokenizer.str( line );
-
-        while ( tokenizer >> skipws >> buffer ) {
-          tokens.push_back( buffer ) ;
-        }
-
-        if ( ( tokens.size() == 5 ) || ( tokens.size() == 6 ) ) goodLine = true;
-
-        if( !goodLine ) continue;
+    // the whole file is read in one go and tokenized in place: the
+    // lines are "index direction type sensorID value [error]"
+    string content;
+    {
+      ostringstream fileBuffer;
+      fileBuffer << pedeFile.rdbuf();
+      content = fileBuffer.str();
+    }
 
-        value =  atof(tokens[4].c_str());
-        sensorID = atoi(tokens[3].c_str());
-        if( tokens.size() == 6 ) err = atof(tokens[5].c_str());
-        if( tokens.size() == 5 ) err = 0.;
-        
-        if( constants_map.find( sensorID ) == constants_map.end() ) {
-            EUTelAlignmentConstant * constant = new EUTelAlignmentConstant;
-            constants_map[sensorID] = constant;
-        }
-        
-        if( tokens[2].compare("shift") == 0 ) {
-            if( tokens[1].compare("X") == 0 ) {
-                constants_map[sensorID]->setXOffset( value );
-                constants_map[sensorID]->setXOffsetError( err ) ;
-            }
-            if( tokens[1].compare("Y") == 0 ) {
-                constants_map[sensorID]->setYOffset( value );
-                constants_map[sensorID]->setYOffsetError( err ) ;
-            }
-            if( tokens[1].compare("Z") == 0 ) {
-                constants_map[sensorID]->setZOffset( value );
-                constants_map[sensorID]->setZOffsetError( err ) ;
-            }
+    const size_t maxTokens = 7;
+    const char * tokenBegin[ maxTokens ];
+    size_t tokenLength[ maxTokens ];
+
+    const char * cursor = content.c_str();
+    const char * const contentEnd = cursor + content.size();
+
+    while ( cursor < contentEnd ) {
+
+      const char * lineEnd = static_cast< const char * >( memchr( cursor, '\n', contentEnd - cursor ) );
+      if ( lineEnd == NULL ) lineEnd = contentEnd;
+
+      size_t nTokens = 0;
+      const char * c = cursor;
+      while ( c < lineEnd && nTokens < maxTokens ) {
+        while ( c < lineEnd && isspace( static_cast< unsigned char >( *c ) ) ) ++c;
+        if ( c == lineEnd ) break;
+        tokenBegin[ nTokens ] = c;
+        while ( c < lineEnd && !isspace( static_cast< unsigned char >( *c ) ) ) ++c;
+        tokenLength[ nTokens ] = c - tokenBegin[ nTokens ];
+        ++nTokens;
+      }
+      cursor = lineEnd + 1;
+
+      if ( ( nTokens != 5 ) && ( nTokens != 6 ) ) continue;
+
+      // strtod / strtol stop at the first white space after the token
+      const double value = strtod( tokenBegin[4], NULL );
+      const int sensorID = static_cast< int >( strtol( tokenBegin[3], NULL, 10 ) );
+      const double err = ( nTokens == 6 ) ? strtod( tokenBegin[5], NULL ) : 0.;
+
+      const string direction( tokenBegin[1], tokenLength[1] );
+      const string type( tokenBegin[2], tokenLength[2] );
+
+      map< int, EUTelAlignmentConstant* >::iterator constIter = constants_map.find( sensorID );
+      if ( constIter == constants_map.end() ) {
+        constIter = constants_map.insert( make_pair( sensorID, new EUTelAlignmentConstant ) ).first;
+      }
+      EUTelAlignmentConstant * constant = constIter->second;
+
+      if( type == "shift" ) {
+        if( direction == "X" ) {
+          constant->setXOffset( value );
+          constant->setXOffsetError( err ) ;
+        } else if( direction == "Y" ) {
+          constant->setYOffset( value );
+          constant->setYOffsetError( err ) ;
+        } else if( direction == "Z" ) {
+          constant->setZOffset( value );
+          constant->setZOffsetError( err ) ;
         }
-        if( tokens[2].compare("rotation") == 0 ) {
-            if( tokens[1].compare("YZ") == 0 ) {
-                constants_map[sensorID]->setAlpha( value );
-                constants_map[sensorID]->setAlphaError( err ) ;
-            }
-            if( tokens[1].compare("XZ") == 0 ) {
-                constants_map[sensorID]->setBeta( value );
-                constants_map[sensorID]->setBetaError( err ) ;
-            }
-            if( tokens[1].compare("XY") == 0 ) {
-                constants_map[sensorID]->setGamma( value );
-                constants_map[sensorID]->setGammaError( err ) ;
-            }
+      } else if( type == "rotation" ) {
+        if( direction == "YZ" ) {
+          constant->setAlpha( value );
+          constant->setAlphaError( err ) ;
+        } else if( direction == "XZ" ) {
+          constant->setBeta( value );
+          constant->setBetaError( err ) ;
+        } else if( direction == "XY" ) {
+          constant->setGamma( value );
+          constant->setGammaError( err ) ;
         }
+      }
 
-        constants_map[sensorID]->setSensorID( sensorID );
+      constant->setSensorID( sensorID );
 
     }
 
@@ -378,6 +386,7 @@ int main( int argc, char ** argv ) {
     delete event;
 
     lcWriter->close();
+    delete lcWriter;
   }
 
 
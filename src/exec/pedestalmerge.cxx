@@ -1,6 +1,7 @@
 // eutelescope includes ""
 #include "anyoption.h"
 #include "EUTELESCOPE.h"
+#include "EUTelGenericSparsePixel.h"
 
 // lcio includes <>
 #include <IO/LCWriter.h>
@@ -14,9 +15,11 @@
 #include <IMPL/TrackerRawDataImpl.h>
 #include <IMPL/TrackerDataImpl.h>
 #include <UTIL/CellIDEncoder.h>
+#include <UTIL/CellIDDecoder.h>
 
 //system includes <>
 #include <glob.h>
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -41,14 +44,23 @@ int main( int argc, char ** argv ) {
     "\n"
     "pedestalmerge [option] -o outputfile.slcio file1.slcio file2.slcio [fileN.slcio]\n"
     "\n"
-    "-h --help         Print this help\n";
+    "-h --help         Print this help\n"
+    "-s --shards       The input files are written by event shards of the same run\n"
+    "                  (jobsub --shards): the elements of a collection with the same\n"
+    "                  cell ID are combined instead of being appended. The pixels of\n"
+    "                  sparse data (hot pixel db) are united, full frames (pedestal,\n"
+    "                  noise) are averaged and for raw data (status) the largest\n"
+    "                  value is kept, so that a pixel bad in one shard stays bad\n";
 
   option->addUsage( usageString.c_str() );
   option->setFlag( "help", 'h');
+  option->setFlag( "shards", 's');
   option->setOption( "output", 'o' );
 
   option->processCommandArgs( argc,  argv );
 
+  const bool shards = option->getFlag('s') || option->getFlag( "shards" );
+
   if ( option->getFlag('h') || option->getFlag( "help" ) ) {
     option->printUsage();
     return 0;
@@ -114,14 +126,17 @@ int main( int argc, char ** argv ) {
   event->setTimeStamp( now->timeStamp() );
   delete now;
 
-  // not all the collections are merged, but only the following types:
-  string acceptedType = "";
-  acceptedType.append( lcio::LCIO::TRACKERRAWDATA );
-  acceptedType.append( lcio::LCIO::TRACKERDATA );
-
-  // we need to loop over input files twice. The first time we need to read all the names of the 
-  // input collections.
+  // every input file is read only once: the collections of accepted
+  // type are booked in the output the first time their name is seen
+  // and their elements are copied immediately.
   map< string , string > collectionNameTypeMap;
+  map< string , lcio::LCCollectionVec *> collectionMap;
+
+  // with shards, the position in the output collection and the number
+  // of inputs of each cell ID of each collection
+  typedef map< pair< int, int >, pair< size_t, int > > CellMap;
+  map< string, CellMap > cellMaps;
+  const unsigned int sparsePixelSize = eutelescope::EUTelGenericSparsePixel().getNoOfElements();
 
   // the reading factory
   lcio::LCReader * lcReader = lcio::LCFactory::getInstance()->createLCReader();
@@ -129,99 +144,127 @@ int main( int argc, char ** argv ) {
   for ( size_t iFile = 0 ; iFile < inputFileNames.size(); ++iFile ) {
 
     try {
+
       lcReader->open( inputFileNames.at( iFile ).c_str() );
 
       lcio::LCEventImpl * inputEvent = dynamic_cast< lcio::LCEventImpl* > ( lcReader->readNextEvent() ) ;
-      vector< string > inputCollectionNames = *inputEvent->getCollectionNames();
+      if ( inputEvent == NULL ) {
+        cerr << "No event found in " << inputFileNames.at( iFile ) << endl;
+        lcReader->close();
+        continue;
+      }
+
+      const vector< string > & inputCollectionNames = *inputEvent->getCollectionNames();
       for ( size_t iCol = 0; iCol < inputCollectionNames.size(); ++iCol ) {
-        lcio::LCCollectionVec * inputCollection = dynamic_cast< lcio::LCCollectionVec* > ( inputEvent->getCollection( inputCollectionNames.at( iCol ).c_str() ) );
+
+        const string & name = inputCollectionNames.at( iCol );
+        lcio::LCCollectionVec * inputCollection = dynamic_cast< lcio::LCCollectionVec* > ( inputEvent->getCollection( name ) );
         string type = inputCollection->getTypeName();
-        if ( acceptedType.find( type ) != string::npos ) {
-          map< string, string >::iterator iter = collectionNameTypeMap.find( inputCollectionNames.at( iCol ) );
-          if ( iter != collectionNameTypeMap.end() ) {
-            if ( iter->second != type ) {
-              cerr << "Error! Collection " << inputCollectionNames.at( iCol ) << " is found to be both " << type << " and " << iter->second << endl;
-              return 4;
-            }
+        // only the TrackerRawData and TrackerData collections are merged
+        if ( type != lcio::LCIO::TRACKERRAWDATA && type != lcio::LCIO::TRACKERDATA ) continue;
+
+        map< string, string >::iterator iter = collectionNameTypeMap.find( name );
+        if ( iter == collectionNameTypeMap.end() ) {
+          collectionNameTypeMap.insert( make_pair ( name, type ) );
+          collectionMap[ name ] = new lcio::LCCollectionVec( type );
+          const string encoding = inputCollection->getParameters().getStringVal( lcio::LCIO::CellIDEncoding );
+          if ( shards && !encoding.empty() ) {
+            collectionMap[ name ]->parameters().setValue( lcio::LCIO::CellIDEncoding, encoding );
+          } else if ( type == lcio::LCIO::TRACKERRAWDATA )  {
+            lcio::CellIDEncoder<TrackerRawDataImpl>    encoderEncoder( eutelescope::EUTELESCOPE::MATRIXDEFAULTENCODING, collectionMap[ name ]);
+          } else if ( type == lcio::LCIO::TRACKERDATA )  {
+            lcio::CellIDEncoder<TrackerDataImpl>       encoderEncoder( eutelescope::EUTELESCOPE::MATRIXDEFAULTENCODING, collectionMap[ name ]);
           }
-          collectionNameTypeMap.insert( make_pair ( inputCollectionNames.at( iCol ), type ) );
+        } else if ( iter->second != type ) {
+          cerr << "Error! Collection " << name << " is found to be both " << type << " and " << iter->second << endl;
+          return 4;
         }
-      }
-
-      lcReader->close();
-
-    } catch ( lcio::IOException& e ) {
-      cerr << e.what() << endl;
-    }
-
-  }
-
-  // print the names of the collections that we will be merging and in the same time prepare a map to store the physical output collections. 
-  map< string , lcio::LCCollectionVec *> collectionMap;
-  map< string , string >::iterator collectionIterator = collectionNameTypeMap.begin();
-
-  cout << "Input collections found: " << endl;
-  while ( collectionIterator != collectionNameTypeMap.end() ) {
-    string name = collectionIterator->first;
-    string type = collectionIterator->second ;
-    cout << "-->\t" << name <<  " (" << type << ")" << endl;
-    collectionMap[ name ] = new lcio::LCCollectionVec( type );
-
-    if ( type == lcio::LCIO::TRACKERRAWDATA )  {
-      lcio::CellIDEncoder<TrackerRawDataImpl>    encoderEncoder( eutelescope::EUTELESCOPE::MATRIXDEFAULTENCODING, collectionMap[ name ]);
-    } else if ( type == lcio::LCIO::TRACKERDATA )  {
-      lcio::CellIDEncoder<TrackerDataImpl>       encoderEncoder( eutelescope::EUTELESCOPE::MATRIXDEFAULTENCODING, collectionMap[ name ]);
-    }
 
+        lcio::LCCollectionVec * outputCollection = collectionMap[ name ];
+        outputCollection->reserve( outputCollection->size() + inputCollection->size() );
 
-    ++collectionIterator;
-  }
-
-  // reloop once again, but this time do the real job! 
-  for ( size_t iFile = 0 ; iFile < inputFileNames.size(); ++iFile ) {
-
-    try {
-
-      lcReader->open( inputFileNames.at( iFile ).c_str() );
+        const bool sparse = inputCollection->getParameters().getStringVal( lcio::LCIO::CellIDEncoding ).find( "sparsePixelType" ) != string::npos;
 
-      lcio::LCEventImpl * inputEvent = dynamic_cast< lcio::LCEventImpl* > ( lcReader->readNextEvent() ) ;
+        for ( size_t iElement = 0 ; iElement < inputCollection->size() ; ++iElement ) {
 
-      // loop over all the expected collection names
-      map< string, string >::iterator mapIter = collectionNameTypeMap.begin() ;
-
-      while ( mapIter != collectionNameTypeMap.end() ) {
-
-        string type = mapIter->second;
-
-        try {
-          lcio::LCCollectionVec * inputCollection = dynamic_cast< lcio::LCCollectionVec * > ( inputEvent->getCollection( mapIter->first ) );
-
-          for ( size_t iElement = 0 ; iElement < inputCollection->size() ; ++iElement ) {
-
-            if ( type == lcio::LCIO::TRACKERRAWDATA ) {
-              lcio::TrackerRawDataImpl * input = dynamic_cast< lcio::TrackerRawDataImpl * > ( inputCollection->getElementAt( iElement ) ) ;
-              lcio::TrackerRawDataImpl * output = new lcio::TrackerRawDataImpl;
-              output->setADCValues( input->getADCValues()  ) ;
-              output->setCellID0  ( input->getCellID0() ) ;
-              output->setCellID1  ( input->getCellID1() ) ;
-              output->setTime     ( input->getTime()    ) ;
-              collectionMap[ mapIter->first]->addElement( output );
-            } else if ( type == lcio::LCIO::TRACKERDATA ) {
-              lcio::TrackerDataImpl * input  = dynamic_cast< lcio::TrackerDataImpl * > ( inputCollection->getElementAt( iElement ) ) ;
-              lcio::TrackerDataImpl * output = new lcio::TrackerDataImpl;
-              output->setChargeValues( input->getChargeValues()  ) ;
-              output->setCellID0  ( input->getCellID0() ) ;
-              output->setCellID1  ( input->getCellID1() ) ;
-              output->setTime     ( input->getTime()    ) ;
-              collectionMap[ mapIter->first]->addElement( output );
+          if ( shards ) {
+            lcio::LCObject * element = inputCollection->getElementAt( iElement );
+            lcio::TrackerRawDataImpl * rawInput = dynamic_cast< lcio::TrackerRawDataImpl * > ( element );
+            lcio::TrackerDataImpl    * input    = dynamic_cast< lcio::TrackerDataImpl * > ( element );
+            if ( ( type == lcio::LCIO::TRACKERRAWDATA && rawInput == NULL ) || ( type == lcio::LCIO::TRACKERDATA && input == NULL ) ) {
+              cerr << "Warning! An element of " << name << " is not a " << type << ", skipped" << endl;
+              continue;
+            }
+            pair< int, int > cellID;
+            if ( rawInput != NULL ) {
+              cellID = make_pair( rawInput->getCellID0(), rawInput->getCellID1() );
+            } else {
+              cellID = make_pair( input->getCellID0(), input->getCellID1() );
             }
 
+            CellMap::iterator cell = cellMaps[ name ].find( cellID );
+            if ( cell != cellMaps[ name ].end() ) {
+              const int nInputs = ++cell->second.second;
+              if ( rawInput != NULL ) {
+                const lcio::ShortVec & inputValues = rawInput->getADCValues();
+                lcio::TrackerRawDataImpl * output = static_cast< lcio::TrackerRawDataImpl * > ( outputCollection->getElementAt( cell->second.first ) );
+                lcio::ShortVec & outputValues = output->adcValues();
+                for ( size_t i = 0; i < inputValues.size() && i < outputValues.size(); ++i ) {
+                  outputValues[ i ] = max( outputValues[ i ], inputValues[ i ] );
+                }
+              } else {
+                const lcio::FloatVec & inputValues = input->getChargeValues();
+                lcio::TrackerDataImpl * output = static_cast< lcio::TrackerDataImpl * > ( outputCollection->getElementAt( cell->second.first ) );
+                lcio::FloatVec & outputValues = output->chargeValues();
+                if ( sparse ) {
+                  lcio::CellIDDecoder< TrackerDataImpl > decoder( inputCollection );
+                  if ( static_cast< int >( decoder( output )["sparsePixelType"] ) != eutelescope::kEUTelGenericSparsePixel ) {
+                    cerr << "Warning! Only " << eutelescope::kEUTelGenericSparsePixel << " sparse pixels can be merged, the pixels of "
+                         << name << " are appended" << endl;
+                    outputValues.insert( outputValues.end(), inputValues.begin(), inputValues.end() );
+                    continue;
+                  }
+                  // add the pixels not yet there
+                  set< pair< float, float > > pixels;
+                  for ( size_t i = 0; i + sparsePixelSize <= outputValues.size(); i += sparsePixelSize ) {
+                    pixels.insert( make_pair( outputValues[ i ], outputValues[ i + 1 ] ) );
+                  }
+                  for ( size_t i = 0; i + sparsePixelSize <= inputValues.size(); i += sparsePixelSize ) {
+                    if ( pixels.insert( make_pair( inputValues[ i ], inputValues[ i + 1 ] ) ).second ) {
+                      outputValues.insert( outputValues.end(), inputValues.begin() + i, inputValues.begin() + i + sparsePixelSize );
+                    }
+                  }
+                } else {
+                  // running mean over the shards
+                  for ( size_t i = 0; i < inputValues.size() && i < outputValues.size(); ++i ) {
+                    outputValues[ i ] += ( inputValues[ i ] - outputValues[ i ] ) / nInputs;
+                  }
+                }
+              }
+              continue;
+            }
+            cellMaps[ name ][ cellID ] = make_pair( outputCollection->size(), 1 );
           }
 
+          if ( type == lcio::LCIO::TRACKERRAWDATA ) {
+            lcio::TrackerRawDataImpl * input = dynamic_cast< lcio::TrackerRawDataImpl * > ( inputCollection->getElementAt( iElement ) ) ;
+            lcio::TrackerRawDataImpl * output = new lcio::TrackerRawDataImpl;
+            output->setADCValues( input->getADCValues()  ) ;
+            output->setCellID0  ( input->getCellID0() ) ;
+            output->setCellID1  ( input->getCellID1() ) ;
+            output->setTime     ( input->getTime()    ) ;
+            outputCollection->addElement( output );
+          } else if ( type == lcio::LCIO::TRACKERDATA ) {
+            lcio::TrackerDataImpl * input  = dynamic_cast< lcio::TrackerDataImpl * > ( inputCollection->getElementAt( iElement ) ) ;
+            lcio::TrackerDataImpl * output = new lcio::TrackerDataImpl;
+            output->setChargeValues( input->getChargeValues()  ) ;
+            output->setCellID0  ( input->getCellID0() ) ;
+            output->setCellID1  ( input->getCellID1() ) ;
+            output->setTime     ( input->getTime()    ) ;
+            outputCollection->addElement( output );
+          }
 
-        } catch ( lcio::DataNotAvailableException& e ) {
         }
-        ++mapIter;
       }
 
       lcReader->close();
@@ -231,6 +274,16 @@ int main( int argc, char ** argv ) {
     }
   }
 
+  delete lcReader;
+
+  // print the names of the collections that we merged
+  cout << "Input collections found: " << endl;
+  map< string , string >::iterator collectionIterator = collectionNameTypeMap.begin();
+  while ( collectionIterator != collectionNameTypeMap.end() ) {
+    cout << "-->\t" << collectionIterator->first <<  " (" << collectionIterator->second << ")" << endl;
+    ++collectionIterator;
+  }
+
   map<string, lcio::LCCollectionVec * >::iterator collectionIter = collectionMap.begin();
   while ( collectionIter != collectionMap.end() ) {
     event->addCollection( collectionIter->second, collectionIter->first );
@@ -241,6 +294,7 @@ int main( int argc, char ** argv ) {
   delete event;
 
   lcWriter->close();
+  delete lcWriter;
 
   return 0;
 
@@ -0,0 +1,601 @@
+// -*- mode: c++; mode: auto-fill; mode: flyspell-prog; -*-
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// Micro-benchmark of the clustering, tracking and fitting hot paths.
+//
+// Events are generated with EUTelToyGenerator on the planes of a GEAR
+// file, at several track multiplicities. The input of every kernel is
+// prepared once, out of the timed loop, then each kernel is run over
+// all the events. For each kernel and multiplicity one line of
+// key=value pairs is printed: events per second, time and heap
+// allocations per item (pixel, hit or track, see the item key).
+//
+// The kernels are the ones the processors run in their processEvent():
+//   generator    EUTelToyGenerator::generate()
+//   calibration  pedestal and common mode subtraction and zero
+//                suppression of a full frame (CalibrationKernel)
+//   sparsecluster  EUTelSparseClusterFinder with EUTelPixelDistanceCut
+//   geocluster   EUTelSparseClusterFinder with EUTelGeometricPixelCut
+//   patrec       EUTelPatternRecognition, seed tracks
+//   patrecpaired the same, with the seeds paired within a slope window
+//   trackio      copy of the seed tracks, written to and read back from
+//                LCIO by EUTelReaderGenericLCIO
+//   dafcluster   daffitter::TrackerSystem::clusterTracker()
+//   daffit       daffitter::TrackerSystem::fitPlanesInfoDaf()
+//   gblfit       EUTelGBLFitter on the pattern recognition tracks
+//   testfitter   TestFitterKernel::analyticFit(), x and y
+//   milletracks  EUTelMilleTrackFinder::findTracks()
+//
+// Usage: eutelbenchmark [gear.xml]
+
+// eutelescope includes
+#include "EUTelToyGenerator.h"
+#include "EUTelCalibrationKernel.h"
+#include "EUTelSparseClusterFinder.h"
+#include "EUTelGenericSparsePixel.h"
+#include "EUTelGeometricPixel.h"
+#include "EUTelPatternRecognition.h"
+#include "EUTelDafTrackerSystem.h"
+#include "EUTelTestFitterKernel.h"
+#include "EUTelMilleTrackFinder.h"
+#include "EUTelReaderGenericLCIO.h"
+#include "EUTelGeometryTelescopeGeoDescription.h"
+#include "EUTELESCOPE.h"
+#ifdef USE_GBL
+#include "EUTelGBLFitter.h"
+#endif
+
+// gear includes
+#include "gearxml/GearXML.h"
+#include "gear/GearMgr.h"
+
+// lcio includes
+#include <IMPL/LCCollectionVec.h>
+#include <IMPL/LCEventImpl.h>
+#include <IMPL/TrackerHitImpl.h>
+#include <UTIL/CellIDEncoder.h>
+
+// other includes
+#include "streamlog/streamlog.h"
+#include "TVector3.h"
+
+// system includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+
+using namespace std;
+using namespace lcio;
+using namespace eutelescope;
+
+const int    nEvent         = 200;
+const double noiseOccupancy = 1e-5;
+const double beamEnergy     = 4.;
+
+// heap allocations, counted by the replacement of the global operator new
+unsigned long gAllocations = 0;
+
+void * operator new( size_t size ) throw( std::bad_alloc ) {
+  ++gAllocations;
+  void * p = malloc( size == 0 ? 1 : size );
+  if ( p == 0 ) throw std::bad_alloc();
+  return p;
+}
+
+void * operator new[]( size_t size ) throw( std::bad_alloc ) {
+  return operator new( size );
+}
+
+void operator delete( void * p ) throw() {
+  free( p );
+}
+
+void operator delete[]( void * p ) throw() {
+  free( p );
+}
+
+double now() {
+  timeval tv;
+  gettimeofday( &tv, 0 );
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+double gauss() {
+  const double u1 = ( rand() + 1. ) / ( RAND_MAX + 2. );
+  const double u2 = rand() / ( RAND_MAX + 1. );
+  return sqrt( -2. * log( u1 ) ) * cos( 2. * M_PI * u2 );
+}
+
+// time and allocations spent between start() and stop(), summed up
+struct Meter {
+  double time;
+  unsigned long allocations;
+  double items;
+  double startTime;
+  unsigned long startAllocations;
+
+  Meter() : time( 0. ), allocations( 0 ), items( 0. ), startTime( 0. ), startAllocations( 0 ) {}
+  void start() { startAllocations = gAllocations; startTime = now(); }
+  void stop()  { time += now() - startTime; allocations += gAllocations - startAllocations; }
+
+  void print( const string & name, int nTracks, const string & item ) const {
+    cout << "benchmark=" << name
+         << " tracks=" << nTracks
+         << " events=" << nEvent
+         << " items=" << items
+         << " item=" << item
+         << " events_per_s=" << ( time > 0. ? nEvent / time : 0. )
+         << " ns_per_item=" << ( items > 0. ? 1e9 * time / items : 0. )
+         << " allocs_per_item=" << ( items > 0. ? allocations / items : 0. ) << endl;
+  }
+};
+
+// a measured hit, smeared crossing point of a track or noise
+struct Hit {
+  int sensorID;
+  int zOrder;
+  double local[3];
+  double global[3];
+};
+
+// one event, as seen by the different kernels
+struct Event {
+  vector< EUTelToyGenerator::Sensor > sensors;
+  vector< Hit > hits;
+};
+
+int main( int argc, char ** argv ) {
+
+  streamlog::out.init( std::cout, "eutelbenchmark" );
+  streamlog::logscope scope( streamlog::out );
+  scope.setLevel< streamlog::WARNING >();
+
+  string gearFile = "jobsub/examples/GBL/noDUTExample/geometry/gear_desy2012_150mm.xml";
+  if ( argc > 1 ) gearFile = argv[1];
+
+  gear::GearXML gearXML( gearFile );
+  gear::GearMgr * gearMgr = gearXML.createGearMgr();
+  string geoFileName = EUTELESCOPE::GEOFILENAME;
+  geo::gGeometry( gearMgr ).initializeTGeoDescription( geoFileName, false );
+  geo::gGeometry().initialisePlanesToExcluded( EVENT::IntVec() );
+
+  const geo::EUTelGeometrySnapshot & snapshot = geo::gGeometry().getSnapshot();
+
+  // the planes along the beam
+  vector< int > sensorIDs;
+  map< int, int > zOrder;
+  for ( map< int, int >::const_iterator it = snapshot.zOrderToID().begin(); it != snapshot.zOrderToID().end(); ++it ) {
+    zOrder[ it->second ] = sensorIDs.size();
+    sensorIDs.push_back( it->second );
+  }
+  const int nPlanes = sensorIDs.size();
+  vector< geo::EUTelPlane > planes;
+  for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) planes.push_back( snapshot.planes().find( sensorIDs[ iPlane ] )->second );
+
+  // Highland angle at normal incidence, for the fitters
+  vector< double > theta0( nPlanes );
+  for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) {
+    const double x = snapshot.materialBudget( sensorIDs[ iPlane ] );
+    theta0[ iPlane ] = x > 0. ? 0.0136 / beamEnergy * sqrt( x ) * ( 1. + 0.038 * log( x ) ) : 0.;
+  }
+
+  // pattern recognition, as set up by EUTelProcessorPatternRecognition
+  EUTelPatternRecognition patrec;
+  patrec.setAllowedMissingHits( 0 );
+  patrec.setAllowedSharedHitsOnTrackCandidate( 0 );
+  patrec.setWindowSize( 10. );
+  patrec.setPlanesToCreateSeedsFrom( EVENT::IntVec() );
+  patrec.setBeamMomentum( beamEnergy );
+  patrec.setBeamCharge( -1. );
+  patrec.setPlaneDimensionsVec( EVENT::IntVec( nPlanes, 2 ) );
+  patrec.setAutoPlanestoCreateSeedsFrom();
+  patrec.testUserInput();
+
+  // the same, only propagating the seeds paired within 5 mrad of the beam
+  EUTelPatternRecognition pairedPatrec;
+  pairedPatrec.setAllowedMissingHits( 0 );
+  pairedPatrec.setAllowedSharedHitsOnTrackCandidate( 0 );
+  pairedPatrec.setWindowSize( 10. );
+  pairedPatrec.setPlanesToCreateSeedsFrom( EVENT::IntVec() );
+  pairedPatrec.setBeamMomentum( beamEnergy );
+  pairedPatrec.setBeamCharge( -1. );
+  pairedPatrec.setPlaneDimensionsVec( EVENT::IntVec( nPlanes, 2 ) );
+  pairedPatrec.setSeedSlopeWindow( EVENT::FloatVec( 2, 0.005 ) );
+  pairedPatrec.setAutoPlanestoCreateSeedsFrom();
+  pairedPatrec.testUserInput();
+  const bool noField = geo::gGeometry().getMagneticField().at( TVector3( 0., 0., 0. ) ).r2() < 1.E-6;
+
+#ifdef USE_GBL
+  // track fit, as set up by EUTelProcessorGBLAlign
+  EUTelGBLFitter gblFitter;
+  gblFitter.setBeamCharge( -1. );
+  gblFitter.setBeamEnergy( beamEnergy );
+  gblFitter.setMEstimatorType( "" );
+  vector< float > xResolution( geo::gGeometry().nPlanes() ), yResolution( geo::gGeometry().nPlanes() );
+  for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) {
+    xResolution[ iPlane ] = planes[ iPlane ].xRes;
+    yResolution[ iPlane ] = planes[ iPlane ].yRes;
+  }
+  gblFitter.setParamterIdXResolutionVec( xResolution );
+  gblFitter.setParamterIdYResolutionVec( yResolution );
+  gblFitter.testUserInput();
+#endif
+
+  // DAF, as set up by EUTelDafBase, in um
+  daffitter::TrackerSystem daf;
+  for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) {
+    daf.addPlane( sensorIDs[ iPlane ], planes[ iPlane ].zPos * 1000., planes[ iPlane ].xRes * 1000., planes[ iPlane ].yRes * 1000.,
+                  theta0[ iPlane ] * theta0[ iPlane ], false );
+  }
+  daf.setClusterRadius( 300. );
+  daf.setNominalXdz( 0. );
+  daf.setNominalYdz( 0. );
+  daf.setChi2OverNdofCut( 9999. );
+  daf.setDAFChi2Cut( 300. );
+  daf.init();
+  for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) {
+    daf.planes[ iPlane ].setRef0( Eigen::Vector3f( 0., 0., planes[ iPlane ].zPos * 1000. ) );
+    daf.planes[ iPlane ].setPlaneNorm( Eigen::Vector3f( 0., 0., 1. ) );
+  }
+
+  // analytic fit, with the arrays of EUTelTestFitter::init()
+  bool * isActive = new bool[ nPlanes ];
+  double * planeDist = new double[ nPlanes ];
+  double * planeScat = new double[ nPlanes ];
+  double * fitArray = new double[ nPlanes * nPlanes ];
+  double * pos = new double[ nPlanes ];
+  double * err = new double[ nPlanes ];
+  for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) {
+    planeDist[ iPlane ] = iPlane + 1 < nPlanes ? 1. / ( planes[ iPlane + 1 ].zPos - planes[ iPlane ].zPos ) : 0.;
+    planeScat[ iPlane ] = theta0[ iPlane ] > 0. ? 1. / ( theta0[ iPlane ] * theta0[ iPlane ] ) : 0.;
+  }
+
+  // Mille track search, 300 um windows between consecutive planes
+  EUTelMilleTrackFinder milleFinder;
+  milleFinder.setAllowedMissingHits( 0 );
+  milleFinder.setResidualCuts( vector< float >( nPlanes, 0. ), vector< float >( nPlanes, 300. ),
+                               vector< float >( nPlanes, 0. ), vector< float >( nPlanes, 300. ) );
+
+  const int multiplicity[] = { 1, 5, 20, 50 };
+  const int nMultiplicity  = sizeof( multiplicity ) / sizeof( multiplicity[0] );
+
+  for ( int iMult = 0; iMult < nMultiplicity; ++iMult ) {
+
+    const int nTracks = multiplicity[ iMult ];
+
+    EUTelToyGenerator generator;
+    EUTelToyGenerator::Config config;
+    config.beamEnergy     = beamEnergy;
+    config.meanTracks     = nTracks;
+    config.noiseOccupancy = noiseOccupancy;
+    generator.setConfig( config );
+    generator.setSeed( 4711 + iMult );
+    generator.setGeometry( snapshot );
+    srand( 4711 + iMult );
+
+    // generation
+    Meter generatorMeter;
+    vector< Event > events( nEvent );
+    for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+      generatorMeter.start();
+      generator.generate();
+      generatorMeter.stop();
+      generatorMeter.items += generator.getNTracks();
+
+      Event & event = events[ iEvent ];
+      event.sensors = generator.sensors();
+      const vector< EUTelToyGenerator::TruthHit > & truthHits = generator.truthHits();
+      for ( size_t iHit = 0; iHit < truthHits.size(); ++iHit ) {
+        Hit hit;
+        hit.sensorID = truthHits[ iHit ].sensorID;
+        hit.zOrder   = zOrder[ hit.sensorID ];
+        const geo::EUTelPlane & plane = planes[ hit.zOrder ];
+        const double dx = plane.xRes * gauss(), dy = plane.yRes * gauss();
+        hit.local[0]  = truthHits[ iHit ].local[0] + dx;
+        hit.local[1]  = truthHits[ iHit ].local[1] + dy;
+        hit.local[2]  = 0.;
+        hit.global[0] = truthHits[ iHit ].global[0] + dx;
+        hit.global[1] = truthHits[ iHit ].global[1] + dy;
+        hit.global[2] = truthHits[ iHit ].global[2];
+        event.hits.push_back( hit );
+      }
+    }
+    generatorMeter.print( "generator", nTracks, "track" );
+
+    // calibration of a full frame per plane: the raw frame is made of
+    // pedestals plus gaussian noise, plus the signal of the fired pixels
+    {
+      Meter meter;
+      for ( size_t iSensor = 0; iSensor < events[0].sensors.size(); ++iSensor ) {
+        const size_t nPixel = events[0].sensors[ iSensor ].xPixelNo * events[0].sensors[ iSensor ].yPixelNo;
+        vector< float > pedestal( nPixel ), threshold( nPixel, 25.f ), goodMask( nPixel, 1.f ), data( nPixel ), signal( nPixel );
+        vector< short > raw( nPixel );
+        vector< int > index( nPixel );
+        for ( size_t iPixel = 0; iPixel < nPixel; ++iPixel ) {
+          pedestal[ iPixel ] = 100.f + 10.f * rand() / RAND_MAX;
+          raw[ iPixel ]      = static_cast< short >( pedestal[ iPixel ] + 5. * gauss() );
+        }
+        for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+          const EUTelToyGenerator::Sensor & sensor = events[ iEvent ].sensors[ iSensor ];
+          vector< short > frame( raw );
+          for ( size_t iPixel = 0; iPixel < sensor.pixels.size(); ++iPixel ) {
+            frame[ sensor.pixels[ iPixel ].x + sensor.pixels[ iPixel ].y * sensor.xPixelNo ] += 200;
+          }
+          meter.start();
+          CalibrationKernel::subtractPedestal( &frame[0], &pedestal[0], &data[0], nPixel );
+          CalibrationKernel::Sum sum = CalibrationKernel::maskedSum( &data[0], &threshold[0], &goodMask[0], nPixel );
+          if ( sum.nGood != 0 ) CalibrationKernel::subtractCommonMode( &data[0], nPixel, sum.sum / sum.nGood );
+          CalibrationKernel::sparsify( &frame[0], &pedestal[0], &threshold[0], nPixel, &index[0], &signal[0] );
+          meter.stop();
+          meter.items += nPixel;
+        }
+      }
+      meter.print( "calibration", nTracks, "pixel" );
+    }
+
+    // sparse clustering on the pixel indices
+    {
+      typedef EUTelSparseClusterFinder< EUTelGenericSparsePixel, EUTelPixelDistanceCut > Finder;
+      Finder finder;
+      finder.setCut( EUTelPixelDistanceCut( 2 ) );
+      Meter meter;
+      for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+        for ( size_t iSensor = 0; iSensor < events[ iEvent ].sensors.size(); ++iSensor ) {
+          const vector< EUTelToyGenerator::Pixel > & pixels = events[ iEvent ].sensors[ iSensor ].pixels;
+          meter.start();
+          finder.pixels().clear();
+          for ( size_t iPixel = 0; iPixel < pixels.size(); ++iPixel ) {
+            finder.pixels().push_back( EUTelGenericSparsePixel( pixels[ iPixel ].x, pixels[ iPixel ].y, 1.f, 0 ) );
+          }
+          finder.run();
+          meter.stop();
+          meter.items += pixels.size();
+        }
+      }
+      meter.print( "sparsecluster", nTracks, "pixel" );
+    }
+
+    // geometric clustering on the pixel centres
+    {
+      typedef EUTelSparseClusterFinder< EUTelGeometricPixel, EUTelGeometricPixelCut > Finder;
+      Finder finder;
+      finder.setCut( EUTelGeometricPixelCut( 0. ) );
+      Meter meter;
+      for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+        for ( size_t iSensor = 0; iSensor < events[ iEvent ].sensors.size(); ++iSensor ) {
+          const EUTelToyGenerator::Sensor & sensor = events[ iEvent ].sensors[ iSensor ];
+          const geo::EUTelPlane & plane = planes[ zOrder[ sensor.sensorID ] ];
+          meter.start();
+          finder.pixels().clear();
+          for ( size_t iPixel = 0; iPixel < sensor.pixels.size(); ++iPixel ) {
+            const short x = sensor.pixels[ iPixel ].x, y = sensor.pixels[ iPixel ].y;
+            finder.pixels().push_back( EUTelGeometricPixel( x, y, 1.f, 0,
+                                                            ( x + 0.5 ) * plane.xPitch - plane.xSize / 2.,
+                                                            ( y + 0.5 ) * plane.yPitch - plane.ySize / 2.,
+                                                            plane.xPitch / 2., plane.yPitch / 2. ) );
+          }
+          finder.run();
+          meter.stop();
+          meter.items += sensor.pixels.size();
+        }
+      }
+      meter.print( "geocluster", nTracks, "pixel" );
+    }
+
+    // hits in local coordinates for the pattern recognition, owned by
+    // one collection per event
+    vector< LCCollectionVec * > hitCollections( nEvent );
+    vector< EVENT::TrackerHitVec > hitVecs( nEvent );
+    for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+      hitCollections[ iEvent ] = new LCCollectionVec( LCIO::TRACKERHIT );
+      CellIDEncoder< TrackerHitImpl > hitEncoder( EUTELESCOPE::HITENCODING, hitCollections[ iEvent ] );
+      for ( size_t iHit = 0; iHit < events[ iEvent ].hits.size(); ++iHit ) {
+        TrackerHitImpl * hit = new TrackerHitImpl;
+        hit->setPosition( events[ iEvent ].hits[ iHit ].local );
+        hitEncoder["sensorID"]   = events[ iEvent ].hits[ iHit ].sensorID;
+        hitEncoder["properties"] = 0;
+        hitEncoder.setCellID( hit );
+        hitCollections[ iEvent ]->push_back( hit );
+        hitVecs[ iEvent ].push_back( hit );
+      }
+    }
+
+    // pattern recognition; the seeds propagated and the tracks found
+    // are printed too, to compare with the paired seeds
+    vector< vector< EUTelTrack > > seedTracks( nEvent );
+    {
+      Meter meter;
+      long nSeeds = 0, nFound = 0;
+      for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+        if ( hitVecs[ iEvent ].empty() ) continue;
+        meter.start();
+        patrec.setEventNumber( iEvent );
+        patrec.clearFinalTracks();
+        patrec.setHitsVec( hitVecs[ iEvent ] );
+        patrec.setHitsVecPerPlane();
+        patrec.initialiseSeeds();
+        patrec.findTrackCandidates();
+        patrec.findTracksWithEnoughHits();
+        patrec.findTrackCandidatesWithSameHitsAndRemove();
+        seedTracks[ iEvent ] = noField ? patrec.getSeedTracks() : patrec.getTracks();
+        meter.stop();
+        meter.items += hitVecs[ iEvent ].size();
+        nSeeds += patrec.getNumberOfSeeds();
+        nFound += seedTracks[ iEvent ].size();
+      }
+      meter.print( "patrec", nTracks, "hit" );
+      cout << "benchmark=patrec tracks=" << nTracks << " seeds_propagated=" << nSeeds << " tracks_found=" << nFound << endl;
+    }
+    {
+      Meter meter;
+      long nSeeds = 0, nFound = 0;
+      for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+        if ( hitVecs[ iEvent ].empty() ) continue;
+        meter.start();
+        pairedPatrec.setEventNumber( iEvent );
+        pairedPatrec.clearFinalTracks();
+        pairedPatrec.setHitsVec( hitVecs[ iEvent ] );
+        pairedPatrec.setHitsVecPerPlane();
+        pairedPatrec.initialiseSeeds();
+        pairedPatrec.findTrackCandidates();
+        pairedPatrec.findTracksWithEnoughHits();
+        pairedPatrec.findTrackCandidatesWithSameHitsAndRemove();
+        meter.stop();
+        meter.items += hitVecs[ iEvent ].size();
+        nSeeds += pairedPatrec.getNumberOfSeeds();
+        nFound += ( noField ? pairedPatrec.getSeedTracks() : pairedPatrec.getTracks() ).size();
+      }
+      meter.print( "patrecpaired", nTracks, "hit" );
+      cout << "benchmark=patrecpaired tracks=" << nTracks << " seeds_propagated=" << nSeeds << " tracks_found=" << nFound << endl;
+    }
+
+    // the tracks between the processors: copied, then written to and
+    // read back from the event
+    {
+      Meter meter;
+      EUTelReaderGenericLCIO reader;
+      for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+        if ( seedTracks[ iEvent ].empty() ) continue;
+        LCEventImpl * event = new LCEventImpl;
+        meter.start();
+        vector< EUTelTrack > tracks( seedTracks[ iEvent ] );
+        reader.getColVec( tracks, event, "benchmark" );
+        vector< EUTelTrack > readTracks = reader.getTracks( event, "benchmark" );
+        meter.stop();
+        meter.items += readTracks.size();
+        delete event;
+      }
+      meter.print( "trackio", nTracks, "track" );
+    }
+
+#ifdef USE_GBL
+    // GBL fit of the pattern recognition tracks
+    {
+      Meter meter;
+      std::map< int, std::vector< double > > corrections;
+      for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+        for ( size_t iTrack = 0; iTrack < seedTracks[ iEvent ].size(); ++iTrack ) {
+          EUTelTrack track = seedTracks[ iEvent ][ iTrack ];
+          meter.start();
+          gblFitter.resetPerTrack();
+          gblFitter.testTrack( track );
+          std::vector< gbl::GblPoint > & pointList = gblFitter.getWorkspace().newPointList();
+          gblFitter.setInformationForGBLPointList( track, pointList );
+          gblFitter.setPairMeasurementStateAndPointLabelVec( pointList );
+          gbl::GblTrajectory * traj = gblFitter.getWorkspace().newTrajectory( !noField );
+          gblFitter.setPairAnyStateAndPointLabelVec( traj );
+          double chi2 = 0.;
+          int ndf = 0, ierr = 0;
+          gblFitter.computeTrajectoryAndFit( traj, &chi2, &ndf, ierr );
+          if ( ierr == 0 ) gblFitter.updateTrackFromGBLTrajectory( traj, track, corrections );
+          meter.stop();
+          meter.items += 1.;
+        }
+      }
+      meter.print( "gblfit", nTracks, "track" );
+    }
+#endif
+
+    for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) delete hitCollections[ iEvent ];
+
+    // DAF track finding and fitting, in um
+    {
+      Meter findMeter, fitMeter;
+      for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+        const vector< Hit > & hits = events[ iEvent ].hits;
+        findMeter.start();
+        daf.clear();
+        for ( size_t iHit = 0; iHit < hits.size(); ++iHit ) {
+          daf.addMeasurement( hits[ iHit ].zOrder, hits[ iHit ].global[0] * 1000., hits[ iHit ].global[1] * 1000.,
+                              hits[ iHit ].global[2] * 1000., true, iHit );
+        }
+        daf.clusterTracker();
+        findMeter.stop();
+        findMeter.items += hits.size();
+
+        fitMeter.start();
+        for ( size_t iTrack = 0; iTrack < daf.getNtracks(); ++iTrack ) daf.fitPlanesInfoDaf( daf.tracks.at( iTrack ) );
+        fitMeter.stop();
+        fitMeter.items += daf.getNtracks();
+      }
+      findMeter.print( "dafcluster", nTracks, "hit" );
+      fitMeter.print( "daffit", nTracks, "track" );
+    }
+
+    // analytic fit of the tracks with a hit on every plane
+    {
+      Meter meter;
+      vector< double > xMeasured( nPlanes ), yMeasured( nPlanes ), xError( nPlanes ), yError( nPlanes );
+      for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+        // the hits of a track are consecutive, one per plane, when it
+        // crossed all of them
+        const vector< Hit > & hits = events[ iEvent ].hits;
+        for ( size_t iHit = 0; iHit + nPlanes <= hits.size(); ) {
+          bool complete = true;
+          for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) complete = complete && hits[ iHit + iPlane ].zOrder == iPlane;
+          if ( !complete ) { ++iHit; continue; }
+          for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) {
+            isActive[ iPlane ]  = true;
+            xMeasured[ iPlane ] = hits[ iHit + iPlane ].global[0];
+            yMeasured[ iPlane ] = hits[ iHit + iPlane ].global[1];
+            xError[ iPlane ]    = planes[ iPlane ].xRes;
+            yError[ iPlane ]    = planes[ iPlane ].yRes;
+          }
+          iHit += nPlanes;
+
+          meter.start();
+          for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) { pos[ iPlane ] = xMeasured[ iPlane ]; err[ iPlane ] = xError[ iPlane ]; }
+          TestFitterKernel::analyticFit( nPlanes, isActive, planeDist, planeScat, false, fitArray, pos, err, 0. );
+          for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) { pos[ iPlane ] = yMeasured[ iPlane ]; err[ iPlane ] = yError[ iPlane ]; }
+          TestFitterKernel::analyticFit( nPlanes, isActive, planeDist, planeScat, false, fitArray, pos, err, 0. );
+          meter.stop();
+          meter.items += 1.;
+        }
+      }
+      meter.print( "testfitter", nTracks, "track" );
+    }
+
+    // Mille track candidates, global positions in um
+    {
+      Meter meter;
+      vector< vector< EUTelMilleTrackFinder::HitsInPlane > > allHitsArray( nPlanes );
+      vector< vector< int > > indexArray;
+      for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+        const vector< Hit > & hits = events[ iEvent ].hits;
+        for ( int iPlane = 0; iPlane < nPlanes; ++iPlane ) allHitsArray[ iPlane ].clear();
+        for ( size_t iHit = 0; iHit < hits.size(); ++iHit ) {
+          allHitsArray[ hits[ iHit ].zOrder ].push_back( EUTelMilleTrackFinder::HitsInPlane( hits[ iHit ].global[0] * 1000.,
+                                                                                              hits[ iHit ].global[1] * 1000.,
+                                                                                              hits[ iHit ].global[2] * 1000. ) );
+        }
+        meter.start();
+        indexArray.clear();
+        milleFinder.findTracks( indexArray, allHitsArray );
+        meter.stop();
+        meter.items += hits.size();
+      }
+      meter.print( "milletracks", nTracks, "hit" );
+    }
+  }
+
+  delete [] isActive;
+  delete [] planeDist;
+  delete [] planeScat;
+  delete [] fitArray;
+  delete [] pos;
+  delete [] err;
+
+  return 0;
+}
@@ -0,0 +1,197 @@
+// -*- mode: c++; mode: auto-fill; mode: flyspell-prog; -*-
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// Micro-benchmark of the hit correlation of EUTelMissingCoordinateEstimator.
+//
+// Events with a given number of straight tracks, plus noise hits, are
+// generated on two reference planes and two strip DUTs (one of them
+// tilted). For every reference hit pair the correlated DUT hits are
+// searched with the loop over all the DUT hits, as the processor used
+// to do, and with EUTelMissingCoordinateMatcher, both as used by the
+// processor (loop below kDefaultSortedSearchMinHits DUT hits) and
+// always with the sorted search. The results are compared and the
+// time per event of each is printed, one line per multiplicity, as
+// key=value pairs.
+
+#include "EUTelMissingCoordinateMatcher.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <sys/time.h>
+
+using namespace std;
+using namespace eutelescope;
+
+const int    nEvent       = 200;
+const double maxResidual  = 0.1;
+const double noiseFraction = 0.2;
+const double minTime       = 0.2; // s
+
+const unsigned int knownHitPos   = 1;
+
+struct Hit {
+  int sensorID;
+  double pos[3];
+};
+
+double uniform( double min, double max ) {
+  return min + ( max - min ) * ( rand() / ( RAND_MAX + 1. ) );
+}
+
+double now() {
+  timeval tv;
+  gettimeofday( &tv, 0 );
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+void makeEvent( int nTrack, vector< Hit > & ref1, vector< Hit > & ref2, vector< Hit > & dut ) {
+
+  const double zRef1 = 0., zRef2 = 300., zDut1 = 140., zDut2 = 160.;
+  const double tilt = 0.3; // dz/dy of the tilted DUT
+
+  ref1.clear(); ref2.clear(); dut.clear();
+  const int nNoise = static_cast< int >( noiseFraction * nTrack ) + 1;
+
+  for ( int iTrack = 0; iTrack < nTrack + nNoise; ++iTrack ) {
+    const bool   noise = iTrack >= nTrack;
+    const double x0 = uniform( -10., 10. ), y0 = uniform( -5., 5. );
+    const double tx = uniform( -1e-3, 1e-3 ), ty = uniform( -1e-3, 1e-3 );
+
+    Hit hit;
+    hit.sensorID = 0;
+    hit.pos[0] = x0 + tx * zRef1; hit.pos[1] = y0 + ty * zRef1; hit.pos[2] = zRef1;
+    ref1.push_back( hit );
+    if ( noise ) { hit.pos[0] = uniform( -10., 10. ); hit.pos[1] = uniform( -5., 5. ); }
+    else         { hit.pos[0] = x0 + tx * zRef2;      hit.pos[1] = y0 + ty * zRef2; }
+    hit.sensorID = 5; hit.pos[2] = zRef2;
+    ref2.push_back( hit );
+
+    // strip DUTs measuring y only
+    hit.sensorID = 20; hit.pos[0] = 0.; hit.pos[1] = y0 + ty * zDut1; hit.pos[2] = zDut1;
+    if ( noise ) hit.pos[1] = uniform( -5., 5. );
+    dut.push_back( hit );
+    hit.sensorID = 21; hit.pos[2] = zDut2 + tilt * hit.pos[1]; hit.pos[1] = y0 + ty * hit.pos[2];
+    if ( noise ) hit.pos[1] = uniform( -5., 5. );
+    dut.push_back( hit );
+  }
+}
+
+// the loop of the processor before EUTelMissingCoordinateMatcher
+void loopMatches( const double * refHit1Pos, const double * refHit2Pos, const vector< Hit > & dut,
+                  vector< unsigned int > & matches ) {
+  matches.clear();
+  for ( unsigned int iDutHit = 0; iDutHit < dut.size(); iDutHit++ ) {
+    const double * dutHitPos = dut[ iDutHit ].pos;
+    double t = ( dutHitPos[2] - refHit1Pos[2] ) / ( refHit2Pos[2] - refHit1Pos[2] );
+    double knownHitPosOnLine = refHit1Pos[ knownHitPos ] + ( refHit2Pos[ knownHitPos ] - refHit1Pos[ knownHitPos ] ) * t;
+    if ( fabs( knownHitPosOnLine - dutHitPos[ knownHitPos ] ) < maxResidual ) matches.push_back( iDutHit );
+  }
+}
+
+int main() {
+
+  const int multiplicity[] = { 1, 5, 10, 20, 30, 50, 100, 200 };
+  const int nMultiplicity  = sizeof( multiplicity ) / sizeof( multiplicity[0] );
+
+  bool allIdentical = true;
+  EUTelMissingCoordinateMatcher matcher;
+  matcher.setKnownCoordinate( knownHitPos );
+  matcher.setMaxResidual( maxResidual );
+
+  for ( int iMult = 0; iMult < nMultiplicity; ++iMult ) {
+
+    vector< vector< Hit > > ref1( nEvent ), ref2( nEvent ), dut( nEvent );
+    srand( 4711 + iMult );
+    for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) makeEvent( multiplicity[ iMult ], ref1[ iEvent ], ref2[ iEvent ], dut[ iEvent ] );
+
+    vector< unsigned int > matches, loopMatch;
+    double nPair = 0.;
+    double nLoopMatch = 0., nMatcherMatch = 0.;
+    bool identical = true;
+
+    // same hits found for every reference pair
+    for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+      matcher.clear();
+      for ( size_t iDut = 0; iDut < dut[ iEvent ].size(); ++iDut ) matcher.addHit( dut[ iEvent ][ iDut ].sensorID, dut[ iEvent ][ iDut ].pos );
+      matcher.prepare();
+      for ( size_t i1 = 0; i1 < ref1[ iEvent ].size(); ++i1 ) {
+        for ( size_t i2 = 0; i2 < ref2[ iEvent ].size(); ++i2 ) {
+          loopMatches( ref1[ iEvent ][ i1 ].pos, ref2[ iEvent ][ i2 ].pos, dut[ iEvent ], loopMatch );
+          matcher.findMatches( ref1[ iEvent ][ i1 ].pos, ref2[ iEvent ][ i2 ].pos, matches );
+          identical = identical && loopMatch == matches;
+          nPair += 1.;
+        }
+      }
+    }
+
+    // each method is repeated for at least minTime, so that the few
+    // tracks configurations are above the timer resolution
+    int nLoopPass = 0;
+    double start = now(), loopTime = 0.;
+    do {
+      nLoopMatch = 0.;
+      for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+        for ( size_t i1 = 0; i1 < ref1[ iEvent ].size(); ++i1 ) {
+          for ( size_t i2 = 0; i2 < ref2[ iEvent ].size(); ++i2 ) {
+            loopMatches( ref1[ iEvent ][ i1 ].pos, ref2[ iEvent ][ i2 ].pos, dut[ iEvent ], matches );
+            nLoopMatch += matches.size();
+          }
+        }
+      }
+      ++nLoopPass;
+      loopTime = now() - start;
+    } while ( loopTime < minTime );
+    loopTime /= nLoopPass;
+
+    double matcherTime[2];
+    for ( int sorted = 0; sorted < 2; ++sorted ) {
+      // the matcher as used by the processor, then always with the sorted search
+      matcher.setSortedSearchMinHits( sorted ? 0 : EUTelMissingCoordinateMatcher::kDefaultSortedSearchMinHits );
+      int nPass = 0;
+      start = now();
+      do {
+        nMatcherMatch = 0.;
+        for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+          matcher.clear();
+          for ( size_t iDut = 0; iDut < dut[ iEvent ].size(); ++iDut ) matcher.addHit( dut[ iEvent ][ iDut ].sensorID, dut[ iEvent ][ iDut ].pos );
+          matcher.prepare();
+          for ( size_t i1 = 0; i1 < ref1[ iEvent ].size(); ++i1 ) {
+            for ( size_t i2 = 0; i2 < ref2[ iEvent ].size(); ++i2 ) {
+              matcher.findMatches( ref1[ iEvent ][ i1 ].pos, ref2[ iEvent ][ i2 ].pos, matches );
+              nMatcherMatch += matches.size();
+            }
+          }
+        }
+        ++nPass;
+        matcherTime[ sorted ] = now() - start;
+      } while ( matcherTime[ sorted ] < minTime );
+      matcherTime[ sorted ] /= nPass;
+      identical = identical && nLoopMatch == nMatcherMatch;
+    }
+
+    allIdentical = allIdentical && identical;
+
+    cout << "benchmark=missingcoordinate"
+         << " tracks=" << multiplicity[ iMult ]
+         << " dutHits=" << dut[0].size()
+         << " matches_per_pair=" << nMatcherMatch / nPair
+         << " loop_events_per_s=" << nEvent / loopTime
+         << " matcher_events_per_s=" << nEvent / matcherTime[0]
+         << " sorted_events_per_s=" << nEvent / matcherTime[1]
+         << " loop_ns_per_pair=" << 1e9 * loopTime / nPair
+         << " matcher_ns_per_pair=" << 1e9 * matcherTime[0] / nPair
+         << " sorted_ns_per_pair=" << 1e9 * matcherTime[1] / nPair
+         << " identical=" << identical << endl;
+  }
+
+  return allIdentical ? 0 : 1;
+}